@@ -0,0 +1,74 @@
+/*
+ *  Copyright (c) 2023 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include "./frame_queue.h"
+
+#if CONFIG_MULTITHREAD
+void frame_queue_init(struct frame_queue *queue) {
+  memset(queue, 0, sizeof(*queue));
+  pthread_mutex_init(&queue->mutex, NULL);
+  pthread_cond_init(&queue->cond, NULL);
+}
+
+void frame_queue_destroy(struct frame_queue *queue) {
+  pthread_cond_destroy(&queue->cond);
+  pthread_mutex_destroy(&queue->mutex);
+}
+
+int frame_queue_get_free(struct frame_queue *queue) {
+  int index = -1;
+
+  pthread_mutex_lock(&queue->mutex);
+  while (queue->count == FRAME_QUEUE_SIZE && !queue->closed)
+    pthread_cond_wait(&queue->cond, &queue->mutex);
+  if (!queue->closed)
+    index = (queue->head + queue->count) % FRAME_QUEUE_SIZE;
+  pthread_mutex_unlock(&queue->mutex);
+  return index;
+}
+
+void frame_queue_push(struct frame_queue *queue) {
+  pthread_mutex_lock(&queue->mutex);
+  assert(queue->count < FRAME_QUEUE_SIZE);
+  queue->count++;
+  pthread_cond_broadcast(&queue->cond);
+  pthread_mutex_unlock(&queue->mutex);
+}
+
+int frame_queue_get_filled(struct frame_queue *queue) {
+  int index = -1;
+
+  pthread_mutex_lock(&queue->mutex);
+  while (queue->count == 0 && !queue->closed)
+    pthread_cond_wait(&queue->cond, &queue->mutex);
+  if (queue->count > 0) index = queue->head;
+  pthread_mutex_unlock(&queue->mutex);
+  return index;
+}
+
+void frame_queue_pop(struct frame_queue *queue) {
+  pthread_mutex_lock(&queue->mutex);
+  assert(queue->count > 0);
+  queue->head = (queue->head + 1) % FRAME_QUEUE_SIZE;
+  queue->count--;
+  pthread_cond_broadcast(&queue->cond);
+  pthread_mutex_unlock(&queue->mutex);
+}
+
+void frame_queue_close(struct frame_queue *queue) {
+  pthread_mutex_lock(&queue->mutex);
+  queue->closed = 1;
+  pthread_cond_broadcast(&queue->cond);
+  pthread_mutex_unlock(&queue->mutex);
+}
+#endif  // CONFIG_MULTITHREAD
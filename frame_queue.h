@@ -0,0 +1,69 @@
+/*
+ *  Copyright (c) 2023 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef VPX_FRAME_QUEUE_H_
+#define VPX_FRAME_QUEUE_H_
+
+#include "./vpx_config.h"
+
+#if CONFIG_MULTITHREAD
+#include "vpx_util/vpx_thread.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Number of slots of the queues between the I/O threads and the codec. */
+#define FRAME_QUEUE_SIZE 8
+
+/* A bounded queue passing the slots of a ring, such as input or output
+ * frames, in order from one producer thread to one consumer thread. The queue
+ * only tracks the slot indices; the slots themselves belong to the caller.
+ */
+struct frame_queue {
+  int head;
+  int count;
+  int closed;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+};
+
+void frame_queue_init(struct frame_queue *queue);
+
+void frame_queue_destroy(struct frame_queue *queue);
+
+/* Returns the index of the next slot to fill, waiting for one to be free, or
+ * -1 if the queue has been closed.
+ */
+int frame_queue_get_free(struct frame_queue *queue);
+
+/* Hands the slot returned by frame_queue_get_free() to the consumer. */
+void frame_queue_push(struct frame_queue *queue);
+
+/* Returns the index of the next filled slot, waiting for one to be pushed, or
+ * -1 once the queue has been closed and all slots pushed before were popped.
+ */
+int frame_queue_get_filled(struct frame_queue *queue);
+
+/* Releases the slot returned by frame_queue_get_filled(). */
+void frame_queue_pop(struct frame_queue *queue);
+
+/* Closes the queue. The producer closes it at the end of its frames and the
+ * consumer to stop the producer early.
+ */
+void frame_queue_close(struct frame_queue *queue);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // CONFIG_MULTITHREAD
+
+#endif  // VPX_FRAME_QUEUE_H_
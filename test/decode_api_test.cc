@@ -12,6 +12,9 @@
 
 #include "./vpx_config.h"
 #include "test/ivf_video_source.h"
+#if CONFIG_WEBM_IO
+#include "test/webm_video_source.h"
+#endif
 #include "vpx/vp8dx.h"
 #include "vpx/vpx_decoder.h"
 
@@ -193,8 +196,80 @@ TEST(DecodeAPI, Vp9PeekStreamInfoTruncated) {
     TestPeekInfo(profile1_data, data_sz, 11);
   }
 }
+#if CONFIG_WEBM_IO
+TEST(DecodeAPI, Vp9DecodeProfile) {
+  // 1440x1080 with 4 tile rows and 4 tile columns.
+  libvpx_test::WebMVideoSource video("vp90-2-08-tile-4x4.webm");
+  video.Init();
+  video.Begin();
+  ASSERT_TRUE(!HasFailure());
+
+  for (int threads = 1; threads <= 4; threads *= 4) {
+    vpx_codec_dec_cfg_t cfg = { static_cast<unsigned int>(threads), 0, 0 };
+    vpx_codec_ctx_t dec;
+    vpx_decode_profile_t profile;
+    EXPECT_EQ(VPX_CODEC_OK,
+              vpx_codec_dec_init(&dec, &vpx_codec_vp9_dx_algo, &cfg, 0));
+    EXPECT_EQ(VPX_CODEC_INVALID_PARAM,
+              vpx_codec_control(&dec, VPXD_GET_DECODE_PROFILE, nullptr));
+    // Nothing has been decoded yet.
+    EXPECT_EQ(VPX_CODEC_ERROR,
+              vpx_codec_control(&dec, VPXD_GET_DECODE_PROFILE, &profile));
+
+    ASSERT_EQ(VPX_CODEC_OK, vpx_codec_decode(&dec, video.cxdata(),
+                                             video.frame_size(), nullptr, 0));
+    vpx_codec_iter_t iter = nullptr;
+    EXPECT_NE(vpx_codec_get_frame(&dec, &iter), nullptr);
+    ASSERT_EQ(VPX_CODEC_OK,
+              vpx_codec_control(&dec, VPXD_GET_DECODE_PROFILE, &profile));
+    EXPECT_EQ(1, profile.frame_count);
+    ASSERT_EQ(16, profile.tile_count);
+    uint32_t tile_bytes = 0;
+    for (int i = 0; i < profile.tile_count; ++i) {
+      EXPECT_GT(profile.tile_bytes[i], 0u) << "tile " << i;
+      tile_bytes += profile.tile_bytes[i];
+    }
+    EXPECT_LT(tile_bytes, video.frame_size());
+    EXPECT_GE(profile.frame_us, profile.header_us);
+    EXPECT_GE(profile.recon_us, 0);
+    EXPECT_GE(profile.loopfilter_us, 0);
+    EXPECT_EQ(VPX_CODEC_OK, vpx_codec_destroy(&dec));
+  }
+}
+#endif  // CONFIG_WEBM_IO
 #endif  // CONFIG_VP9_DECODER
 
+#if CONFIG_VP8_DECODER
+TEST(DecodeAPI, Vp8DecodeProfile) {
+  libvpx_test::IVFVideoSource video("vp80-00-comprehensive-001.ivf");
+  video.Init();
+  video.Begin();
+  ASSERT_TRUE(!HasFailure());
+
+  vpx_codec_ctx_t dec;
+  vpx_decode_profile_t profile;
+  EXPECT_EQ(VPX_CODEC_OK,
+            vpx_codec_dec_init(&dec, &vpx_codec_vp8_dx_algo, nullptr, 0));
+  EXPECT_EQ(VPX_CODEC_INVALID_PARAM,
+            vpx_codec_control(&dec, VPXD_GET_DECODE_PROFILE, nullptr));
+  for (int frame = 0; frame < 3 && video.cxdata() != nullptr; ++frame) {
+    ASSERT_EQ(VPX_CODEC_OK, vpx_codec_decode(&dec, video.cxdata(),
+                                             video.frame_size(), nullptr, 0));
+    vpx_codec_iter_t iter = nullptr;
+    EXPECT_NE(vpx_codec_get_frame(&dec, &iter), nullptr);
+    ASSERT_EQ(VPX_CODEC_OK,
+              vpx_codec_control(&dec, VPXD_GET_DECODE_PROFILE, &profile));
+    EXPECT_EQ(1, profile.frame_count);
+    ASSERT_GE(profile.tile_count, 1);
+    EXPECT_GT(profile.tile_bytes[0], 0u);
+    EXPECT_LT(profile.tile_bytes[0], video.frame_size());
+    EXPECT_GE(profile.frame_us, profile.header_us);
+    video.Next();
+  }
+  EXPECT_EQ(VPX_CODEC_OK, vpx_codec_destroy(&dec));
+}
+#endif  // CONFIG_VP8_DECODER
+
 TEST(DecodeAPI, HighBitDepthCapability) {
 // VP8 should not claim VP9 HBD as a capability.
 #if CONFIG_VP8_DECODER
@@ -110,6 +110,72 @@ TEST_P(DecodePerfTest, PerfTest) {
 INSTANTIATE_TEST_SUITE_P(VP9, DecodePerfTest,
                          ::testing::ValuesIn(kVP9DecodePerfVectors));
 
+// High bitrate vectors, where most of the decoding time goes to parsing the
+// coefficient tokens.
+const char *const kVP9DecodeThroughputVectors[] = {
+  "vp90-2-00-quantizer-00.webm",
+  "vp90-2-00-quantizer-08.webm",
+  "vp90-2-08-tile-4x4.webm",
+  "vp91-2-04-yuv444.webm",
+};
+
+const int kThroughputPasses = 10;
+
+/*
+ DecodeThroughputTest decodes a vector on a single thread kThroughputPasses
+ times and reports the fastest pass as the rate of compressed data consumed.
+ Only the decode calls are timed, not the container parsing.
+ */
+class DecodeThroughputTest : public ::testing::TestWithParam<const char *> {};
+
+TEST_P(DecodeThroughputTest, PerfTest) {
+  const char *const video_name = GetParam();
+  int64_t best_usecs = 0;
+  unsigned frames = 0;
+  size_t bytes = 0;
+
+  for (int pass = 0; pass < kThroughputPasses; ++pass) {
+    libvpx_test::WebMVideoSource video(video_name);
+    video.Init();
+
+    vpx_codec_dec_cfg_t cfg = vpx_codec_dec_cfg_t();
+    cfg.threads = 1;
+    libvpx_test::VP9Decoder decoder(cfg, 0);
+
+    int64_t usecs = 0;
+    bytes = 0;
+    for (video.Begin(); video.cxdata() != nullptr; video.Next()) {
+      vpx_usec_timer t;
+      vpx_usec_timer_start(&t);
+      const vpx_codec_err_t res =
+          decoder.DecodeFrame(video.cxdata(), video.frame_size());
+      vpx_usec_timer_mark(&t);
+      ASSERT_EQ(VPX_CODEC_OK, res) << decoder.DecodeError();
+      usecs += vpx_usec_timer_elapsed(&t);
+      bytes += video.frame_size();
+    }
+    frames = video.frame_number();
+    if (pass == 0 || usecs < best_usecs) best_usecs = usecs;
+  }
+
+  const double elapsed_secs = static_cast<double>(best_usecs) / kUsecsInSec;
+  const double mbps = bytes * 8.0 / 1000000.0 / elapsed_secs;
+
+  printf("{\n");
+  printf("\t\"type\" : \"decode_throughput_test\",\n");
+  printf("\t\"version\" : \"%s\",\n", VERSION_STRING_NOSP);
+  printf("\t\"videoName\" : \"%s\",\n", video_name);
+  printf("\t\"decodeTimeSecs\" : %f,\n", elapsed_secs);
+  printf("\t\"totalFrames\" : %u,\n", frames);
+  printf("\t\"totalBytes\" : %u,\n", static_cast<unsigned>(bytes));
+  printf("\t\"framesPerSecond\" : %f,\n", frames / elapsed_secs);
+  printf("\t\"megabitsPerSecond\" : %f\n", mbps);
+  printf("}\n");
+}
+
+INSTANTIATE_TEST_SUITE_P(VP9, DecodeThroughputTest,
+                         ::testing::ValuesIn(kVP9DecodeThroughputVectors));
+
 class VP9NewEncodeDecodePerfTest
     : public ::libvpx_test::EncoderTest,
       public ::libvpx_test::CodecTestWithParam<libvpx_test::TestMode> {
@@ -11,12 +11,16 @@
 #include <climits>
 #include <cstring>
 #include <initializer_list>
+#include <vector>
 
 #include "third_party/googletest/src/include/gtest/gtest.h"
 
 #include "./vpx_config.h"
+#include "test/acm_random.h"
 #include "test/video_source.h"
 #include "vpx/vp8cx.h"
+#include "vpx/vp8dx.h"
+#include "vpx/vpx_decoder.h"
 #include "vpx/vpx_encoder.h"
 
 namespace {
@@ -360,4 +364,405 @@ TEST(EncodeAPI, ConfigChangeThreadCount) {
   }
 }
 
+// Returns the decoder of the codec of |iface|, or null if it is not built.
+const vpx_codec_iface_t *DecoderFor(const vpx_codec_iface_t *iface) {
+#if CONFIG_VP9_DECODER
+  if (IsVP9(iface)) return &vpx_codec_vp9_dx_algo;
+#endif
+#if CONFIG_VP8_DECODER
+  if (!IsVP9(iface)) return &vpx_codec_vp8_dx_algo;
+#endif
+  (void)iface;
+  return nullptr;
+}
+
+TEST(EncodeAPI, DirtyRects) {
+  constexpr int kWidth = 352;
+  constexpr int kHeight = 288;
+  constexpr int kNumFrames = 10;
+  constexpr int kSquareSize = 32;
+
+  for (const auto *iface : kCodecIfaces) {
+    SCOPED_TRACE(vpx_codec_iface_name(iface));
+    vpx_codec_enc_cfg_t cfg = {};
+    vpx_codec_ctx_t enc = {};
+    const vpx_dirty_rect_t rect = { 0, 0, 16, 16 };
+    vpx_dirty_rects_t rects = { &rect, 1 };
+
+    // The rectangles are only supported without lag, which VP8 only has in
+    // two-pass mode.
+    if (IsVP9(iface)) {
+      ASSERT_EQ(vpx_codec_enc_config_default(iface, &cfg, 0), VPX_CODEC_OK);
+      cfg.g_w = kWidth;
+      cfg.g_h = kHeight;
+      cfg.g_lag_in_frames = 10;
+      ASSERT_EQ(vpx_codec_enc_init(&enc, iface, &cfg, 0), VPX_CODEC_OK);
+      EXPECT_EQ(vpx_codec_control(&enc, VP8E_SET_DIRTY_RECTS, &rects),
+                VPX_CODEC_INVALID_PARAM);
+      EXPECT_EQ(vpx_codec_destroy(&enc), VPX_CODEC_OK);
+    }
+
+    ASSERT_NO_FATAL_FAILURE(InitCodec(*iface, kWidth, kHeight, &enc, &cfg));
+    // Keeps the forced key frame of the noisy background close to the source.
+    cfg.rc_max_quantizer = 20;
+    ASSERT_EQ(vpx_codec_enc_config_set(&enc, &cfg), VPX_CODEC_OK);
+    ASSERT_EQ(vpx_codec_control(&enc, VP8E_SET_CPUUSED, 8), VPX_CODEC_OK);
+    EXPECT_EQ(vpx_codec_control(&enc, VP8E_SET_DIRTY_RECTS,
+                                static_cast<vpx_dirty_rects_t *>(nullptr)),
+              VPX_CODEC_OK);
+    const vpx_codec_iface_t *const dx_iface = DecoderFor(iface);
+    vpx_codec_ctx_t dec = {};
+    if (dx_iface != nullptr) {
+      ASSERT_EQ(vpx_codec_dec_init(&dec, dx_iface, nullptr, 0), VPX_CODEC_OK);
+    }
+
+    // A square moving over a static textured background, with the old and new
+    // positions of the square given as dirty.
+    std::vector<uint8_t> background(kWidth * kHeight);
+    libvpx_test::ACMRandom rnd(libvpx_test::ACMRandom::DeterministicSeed());
+    for (auto &pixel : background) pixel = 64 + (rnd.Rand8() >> 1);
+
+    libvpx_test::DummyVideoSource video;
+    video.SetSize(kWidth, kHeight);
+    video.set_limit(kNumFrames);
+    int frame = 0;
+    for (video.Begin(); video.img() != nullptr; video.Next(), ++frame) {
+      vpx_image_t *const img = video.img();
+      const unsigned int square_x = 40 + 16 * frame;
+      const unsigned int square_y = 64 + 8 * frame;
+      for (int y = 0; y < kHeight; ++y) {
+        uint8_t *const row =
+            img->planes[VPX_PLANE_Y] + y * img->stride[VPX_PLANE_Y];
+        memcpy(row, &background[y * kWidth], kWidth);
+        if (y >= static_cast<int>(square_y) &&
+            y < static_cast<int>(square_y) + kSquareSize) {
+          memset(row + square_x, 235, kSquareSize);
+        }
+      }
+      for (int plane = VPX_PLANE_U; plane <= VPX_PLANE_V; ++plane) {
+        for (int y = 0; y < (kHeight + 1) / 2; ++y) {
+          memset(img->planes[plane] + y * img->stride[plane], 128,
+                 (kWidth + 1) / 2);
+        }
+      }
+
+      const vpx_dirty_rect_t moved[2] = {
+        { square_x - 16, square_y - 8, kSquareSize, kSquareSize },
+        { square_x, square_y, kSquareSize, kSquareSize }
+      };
+      vpx_dirty_rects_t dirty = { moved, 2 };
+      if (frame > 0) {
+        ASSERT_EQ(vpx_codec_control(&enc, VP8E_SET_DIRTY_RECTS, &dirty),
+                  VPX_CODEC_OK);
+      }
+      // The last frame is a key frame, which codes all the blocks from the
+      // source, so the lookahead buffer has to be up to date everywhere.
+      const bool key_frame = frame == kNumFrames - 1;
+      ASSERT_EQ(vpx_codec_encode(&enc, img, video.pts(), video.duration(),
+                                 key_frame ? VPX_EFLAG_FORCE_KF : 0,
+                                 VPX_DL_REALTIME),
+                VPX_CODEC_OK)
+          << vpx_codec_error_detail(&enc);
+
+      vpx_dirty_rect_stats_t stats;
+      ASSERT_EQ(vpx_codec_control(&enc, VP8E_GET_DIRTY_RECT_STATS, &stats),
+                VPX_CODEC_OK);
+      EXPECT_EQ(stats.num_pixels, static_cast<uint64_t>(kWidth) * kHeight);
+      EXPECT_GT(stats.num_blocks, 0u);
+      if (frame == 0 || key_frame) {
+        EXPECT_EQ(stats.num_skipped_blocks, 0u);
+      } else {
+        EXPECT_GT(stats.num_skipped_blocks, stats.num_blocks / 2);
+      }
+      // The first two frames fill lookahead buffers that held no frame yet.
+      if (frame < 2) {
+        EXPECT_EQ(stats.num_copied_pixels, stats.num_pixels);
+      } else {
+        EXPECT_LT(stats.num_copied_pixels, stats.num_pixels / 2);
+      }
+
+      vpx_codec_iter_t iter = nullptr;
+      const vpx_codec_cx_pkt_t *pkt;
+      while ((pkt = vpx_codec_get_cx_data(&enc, &iter)) != nullptr) {
+        if (pkt->kind != VPX_CODEC_CX_FRAME_PKT || dx_iface == nullptr) {
+          continue;
+        }
+        ASSERT_EQ(
+            vpx_codec_decode(&dec, static_cast<uint8_t *>(pkt->data.frame.buf),
+                             static_cast<unsigned int>(pkt->data.frame.sz),
+                             nullptr, 0),
+            VPX_CODEC_OK);
+        vpx_codec_iter_t dec_iter = nullptr;
+        const vpx_image_t *const out = vpx_codec_get_frame(&dec, &dec_iter);
+        ASSERT_NE(out, nullptr);
+        // The square has to be at its new position in the output, so the
+        // pixels of the buffers received earlier were refreshed.
+        int64_t sse = 0;
+        for (int y = 0; y < kHeight; ++y) {
+          const uint8_t *const a =
+              img->planes[VPX_PLANE_Y] + y * img->stride[VPX_PLANE_Y];
+          const uint8_t *const b =
+              out->planes[VPX_PLANE_Y] + y * out->stride[VPX_PLANE_Y];
+          for (int x = 0; x < kWidth; ++x) sse += (a[x] - b[x]) * (a[x] - b[x]);
+        }
+        EXPECT_LT(sse, 100 * kWidth * kHeight) << "frame " << frame;
+      }
+    }
+    if (dx_iface != nullptr) {
+      EXPECT_EQ(vpx_codec_destroy(&dec), VPX_CODEC_OK);
+    }
+    EXPECT_EQ(vpx_codec_destroy(&enc), VPX_CODEC_OK);
+  }
+}
+
+#if CONFIG_VP9_ENCODER
+// Encodes a few frames at |cpu_used| with |deadline| and returns the memory
+// held by the mode decision contexts of the encoder.
+size_t GetModeContextMemory(int cpu_used, unsigned long deadline) {
+  constexpr int kWidth = 352;
+  constexpr int kHeight = 288;
+  vpx_codec_enc_cfg_t cfg = {};
+  vpx_codec_ctx_t enc = {};
+  size_t size = 0;
+
+  EXPECT_NO_FATAL_FAILURE(
+      InitCodec(vpx_codec_vp9_cx_algo, kWidth, kHeight, &enc, &cfg));
+  EXPECT_EQ(vpx_codec_control(&enc, VP8E_SET_CPUUSED, cpu_used), VPX_CODEC_OK);
+  EXPECT_EQ(vpx_codec_control(&enc, VP9E_GET_MODE_CONTEXT_MEMORY, &size),
+            VPX_CODEC_OK);
+  EXPECT_GT(size, 0u);
+
+  libvpx_test::DummyVideoSource video;
+  video.SetSize(kWidth, kHeight);
+  video.set_limit(3);
+  for (video.Begin(); video.img() != nullptr; video.Next()) {
+    EXPECT_EQ(vpx_codec_encode(&enc, video.img(), video.pts(),
+                               video.duration(), /*flags=*/0, deadline),
+              VPX_CODEC_OK)
+        << vpx_codec_error_detail(&enc);
+  }
+  EXPECT_EQ(vpx_codec_control(&enc, VP9E_GET_MODE_CONTEXT_MEMORY, &size),
+            VPX_CODEC_OK);
+  EXPECT_EQ(vpx_codec_control(&enc, VP9E_GET_MODE_CONTEXT_MEMORY,
+                              static_cast<size_t *>(nullptr)),
+            VPX_CODEC_INVALID_PARAM);
+  EXPECT_EQ(vpx_codec_destroy(&enc), VPX_CODEC_OK);
+  return size;
+}
+
+TEST(EncodeAPI, ModeContextMemory) {
+  // The non-rd search of the real-time speeds only uses the buffers of the
+  // root context, so it must hold less than the full rd search.
+  const size_t rt_size = GetModeContextMemory(8, VPX_DL_REALTIME);
+  const size_t good_size = GetModeContextMemory(2, VPX_DL_GOOD_QUALITY);
+  EXPECT_LT(rt_size, good_size);
+}
+
+TEST(EncodeAPI, StageTiming) {
+  constexpr int kWidth = 352;
+  constexpr int kHeight = 288;
+  vpx_codec_enc_cfg_t cfg = {};
+  vpx_codec_ctx_t enc = {};
+  vpx_stage_timing_t timing;
+
+  ASSERT_NO_FATAL_FAILURE(
+      InitCodec(vpx_codec_vp9_cx_algo, kWidth, kHeight, &enc, &cfg));
+  EXPECT_EQ(vpx_codec_control(&enc, VP9E_GET_STAGE_TIMING, &timing),
+            VPX_CODEC_ERROR);
+  ASSERT_EQ(vpx_codec_control(&enc, VP9E_SET_STAGE_TIMING, 1), VPX_CODEC_OK);
+  ASSERT_EQ(vpx_codec_control(&enc, VP9E_GET_STAGE_TIMING, &timing),
+            VPX_CODEC_OK);
+  EXPECT_EQ(timing.frame_start_us, -1);
+
+  libvpx_test::DummyVideoSource video;
+  video.SetSize(kWidth, kHeight);
+  video.set_limit(3);
+  for (video.Begin(); video.img() != nullptr; video.Next()) {
+    ASSERT_EQ(vpx_codec_encode(&enc, video.img(), video.pts(),
+                               video.duration(), /*flags=*/0,
+                               VPX_DL_GOOD_QUALITY),
+              VPX_CODEC_OK);
+    ASSERT_EQ(vpx_codec_control(&enc, VP9E_GET_STAGE_TIMING, &timing),
+              VPX_CODEC_OK);
+    EXPECT_GE(timing.frame_start_us, 0);
+    EXPECT_EQ(timing.frame_count, 1);
+
+    // One pass without lag: no first pass, tpl or alt-ref filtering.
+    int64_t total = 0;
+    for (int i = 0; i < VPX_STAGE_COUNT; ++i) {
+      const bool expected = i != VPX_STAGE_FIRST_PASS && i != VPX_STAGE_TPL &&
+                            i != VPX_STAGE_TEMPORAL_FILTER;
+      EXPECT_EQ(timing.start_us[i] >= 0, expected) << "stage " << i;
+      if (timing.start_us[i] >= 0) {
+        EXPECT_GE(timing.start_us[i], timing.frame_start_us);
+        EXPECT_LE(timing.start_us[i] + timing.duration_us[i],
+                  timing.frame_start_us + timing.frame_duration_us);
+      }
+      total += timing.duration_us[i];
+    }
+    EXPECT_LE(total, timing.frame_duration_us);
+  }
+
+  EXPECT_EQ(vpx_codec_control(&enc, VP9E_GET_STAGE_TIMING,
+                              static_cast<vpx_stage_timing_t *>(nullptr)),
+            VPX_CODEC_INVALID_PARAM);
+  EXPECT_EQ(vpx_codec_destroy(&enc), VPX_CODEC_OK);
+}
+
+// Encodes a panning texture with the sub-pixel cache set to |subpel_cache|
+// and returns the concatenated frame packets.
+std::vector<uint8_t> EncodePanning(int subpel_cache, int cpu_used,
+                                   unsigned long deadline) {
+  constexpr int kWidth = 352;
+  constexpr int kHeight = 288;
+  constexpr int kNumFrames = 6;
+  constexpr int kTextureStride = kWidth + 2 * kNumFrames;
+  vpx_codec_enc_cfg_t cfg = {};
+  vpx_codec_ctx_t enc = {};
+  std::vector<uint8_t> texture(kTextureStride * (kHeight + kNumFrames));
+  std::vector<uint8_t> out;
+  libvpx_test::ACMRandom rnd(libvpx_test::ACMRandom::DeterministicSeed());
+
+  // Smoothed noise, so the sub-pixel positions differ from the full-pel ones.
+  for (auto &pixel : texture) pixel = rnd.Rand8();
+  for (size_t i = 0; i + kTextureStride + 1 < texture.size(); ++i) {
+    texture[i] = (texture[i] + texture[i + 1] + texture[i + kTextureStride] +
+                  texture[i + kTextureStride + 1] + 2) >>
+                 2;
+  }
+
+  EXPECT_NO_FATAL_FAILURE(
+      InitCodec(vpx_codec_vp9_cx_algo, kWidth, kHeight, &enc, &cfg));
+  EXPECT_EQ(vpx_codec_control(&enc, VP8E_SET_CPUUSED, cpu_used), VPX_CODEC_OK);
+  EXPECT_EQ(vpx_codec_control(&enc, VP9E_SET_SUBPEL_CACHE, subpel_cache),
+            VPX_CODEC_OK);
+
+  libvpx_test::DummyVideoSource video;
+  video.SetSize(kWidth, kHeight);
+  video.set_limit(kNumFrames);
+  int frame = 0;
+  for (video.Begin(); video.img() != nullptr; video.Next(), ++frame) {
+    vpx_image_t *const img = video.img();
+    for (int y = 0; y < kHeight; ++y) {
+      memcpy(img->planes[VPX_PLANE_Y] + y * img->stride[VPX_PLANE_Y],
+             &texture[(y + frame) * kTextureStride + 2 * frame], kWidth);
+    }
+    EXPECT_EQ(vpx_codec_encode(&enc, img, video.pts(), video.duration(),
+                               /*flags=*/0, deadline),
+              VPX_CODEC_OK)
+        << vpx_codec_error_detail(&enc);
+    vpx_codec_iter_t iter = nullptr;
+    const vpx_codec_cx_pkt_t *pkt;
+    while ((pkt = vpx_codec_get_cx_data(&enc, &iter)) != nullptr) {
+      if (pkt->kind != VPX_CODEC_CX_FRAME_PKT) continue;
+      const uint8_t *const buf = static_cast<uint8_t *>(pkt->data.frame.buf);
+      out.insert(out.end(), buf, buf + pkt->data.frame.sz);
+    }
+  }
+  EXPECT_EQ(vpx_codec_destroy(&enc), VPX_CODEC_OK);
+  return out;
+}
+
+TEST(EncodeAPI, SubpelCache) {
+  vpx_codec_enc_cfg_t cfg = {};
+  vpx_codec_ctx_t enc = {};
+  ASSERT_NO_FATAL_FAILURE(
+      InitCodec(vpx_codec_vp9_cx_algo, 352, 288, &enc, &cfg));
+  EXPECT_EQ(vpx_codec_control(&enc, VP9E_SET_SUBPEL_CACHE, 3),
+            VPX_CODEC_INVALID_PARAM);
+  EXPECT_EQ(vpx_codec_destroy(&enc), VPX_CODEC_OK);
+
+  // The cached planes hold the same pixels as the bilinear kernels, so the
+  // output does not depend on the cache.
+  const struct {
+    int cpu_used;
+    unsigned long deadline;
+  } kModes[] = { { 2, VPX_DL_GOOD_QUALITY },
+                 { 4, VPX_DL_GOOD_QUALITY },
+                 { 7, VPX_DL_REALTIME } };
+  for (const auto &mode : kModes) {
+    SCOPED_TRACE(mode.cpu_used);
+    const std::vector<uint8_t> ref =
+        EncodePanning(0, mode.cpu_used, mode.deadline);
+    ASSERT_FALSE(ref.empty());
+    EXPECT_EQ(EncodePanning(1, mode.cpu_used, mode.deadline), ref);
+    EXPECT_EQ(EncodePanning(2, mode.cpu_used, mode.deadline), ref);
+  }
+}
+
+#if CONFIG_VP9_DECODER
+// Encodes |img|, or flushes the encoder if it is null, and decodes the frame
+// packets once the call has returned, so the data of all of them must still be
+// valid. Returns the number of frame packets.
+int EncodeAndDecode(vpx_codec_ctx_t *enc, vpx_codec_ctx_t *dec,
+                    const libvpx_test::DummyVideoSource &video,
+                    const vpx_image_t *img, int *frames_out) {
+  EXPECT_EQ(vpx_codec_encode(enc, img, video.pts(), video.duration(),
+                             /*flags=*/0, VPX_DL_GOOD_QUALITY),
+            VPX_CODEC_OK)
+      << vpx_codec_error_detail(enc);
+  vpx_codec_iter_t iter = nullptr;
+  const vpx_codec_cx_pkt_t *pkt;
+  int num_pkts = 0;
+  while ((pkt = vpx_codec_get_cx_data(enc, &iter)) != nullptr) {
+    if (pkt->kind != VPX_CODEC_CX_FRAME_PKT) continue;
+    ++num_pkts;
+    EXPECT_EQ(vpx_codec_decode(dec, static_cast<uint8_t *>(pkt->data.frame.buf),
+                               static_cast<unsigned int>(pkt->data.frame.sz),
+                               nullptr, 0),
+              VPX_CODEC_OK)
+        << vpx_codec_error_detail(dec);
+    vpx_codec_iter_t dec_iter = nullptr;
+    while (vpx_codec_get_frame(dec, &dec_iter) != nullptr) ++*frames_out;
+  }
+  return num_pkts;
+}
+
+TEST(EncodeAPI, LargeSuperframes) {
+  constexpr int kWidth = 352;
+  constexpr int kHeight = 288;
+  constexpr int kNumFrames = 20;
+  vpx_codec_enc_cfg_t cfg = {};
+  vpx_codec_ctx_t enc = {};
+  vpx_codec_ctx_t dec = {};
+  libvpx_test::ACMRandom rnd(libvpx_test::ACMRandom::DeterministicSeed());
+
+  // Noise at the lowest quantizer gives frames close to the raw image size, so
+  // the output buffer has to grow while it holds the invisible frames of a
+  // superframe and the frames already returned by the same call.
+  ASSERT_EQ(vpx_codec_enc_config_default(&vpx_codec_vp9_cx_algo, &cfg, 0),
+            VPX_CODEC_OK);
+  cfg.g_w = kWidth;
+  cfg.g_h = kHeight;
+  cfg.g_lag_in_frames = 16;
+  cfg.rc_end_usage = VPX_Q;
+  cfg.rc_min_quantizer = 0;
+  cfg.rc_max_quantizer = 0;
+  ASSERT_EQ(vpx_codec_enc_init(&enc, &vpx_codec_vp9_cx_algo, &cfg, 0),
+            VPX_CODEC_OK);
+  ASSERT_EQ(vpx_codec_control(&enc, VP8E_SET_CPUUSED, 8), VPX_CODEC_OK);
+  ASSERT_EQ(vpx_codec_control(&enc, VP8E_SET_ENABLEAUTOALTREF, 6),
+            VPX_CODEC_OK);
+  ASSERT_EQ(vpx_codec_dec_init(&dec, &vpx_codec_vp9_dx_algo, nullptr, 0),
+            VPX_CODEC_OK);
+
+  libvpx_test::DummyVideoSource video;
+  video.SetSize(kWidth, kHeight);
+  video.set_limit(kNumFrames);
+  int frames_out = 0;
+  for (video.Begin(); video.img() != nullptr; video.Next()) {
+    vpx_image_t *const img = video.img();
+    const size_t size = static_cast<size_t>(kWidth) * kHeight * 3 / 2;
+    for (size_t i = 0; i < size; ++i) img->img_data[i] = rnd.Rand8();
+    EncodeAndDecode(&enc, &dec, video, img, &frames_out);
+  }
+  while (EncodeAndDecode(&enc, &dec, video, nullptr, &frames_out) > 0) {
+  }
+  EXPECT_EQ(frames_out, kNumFrames);
+  EXPECT_EQ(vpx_codec_destroy(&dec), VPX_CODEC_OK);
+  EXPECT_EQ(vpx_codec_destroy(&enc), VPX_CODEC_OK);
+}
+#endif  // CONFIG_VP9_DECODER
+#endif  // CONFIG_VP9_ENCODER
+
 }  // namespace
@@ -0,0 +1,143 @@
+/*
+ *  Copyright (c) 2023 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <stdio.h>
+
+#include "third_party/googletest/src/include/gtest/gtest.h"
+
+#include "./vpx_config.h"
+#include "./vpx_dsp_rtcd.h"
+#include "test/acm_random.h"
+#include "test/clear_system_state.h"
+#include "test/register_state_check.h"
+#include "vpx_dsp/prob.h"
+#include "vpx_ports/vpx_timer.h"
+
+using libvpx_test::ACMRandom;
+
+namespace {
+
+typedef void (*MergeProbsFunc)(const uint8_t *pre_probs,
+                               const unsigned int *branch_ct, int n,
+                               unsigned int count_sat,
+                               unsigned int max_update_factor, uint8_t *probs);
+
+// The size of the coefficient probabilities of one frame context.
+const int kNumProbs = 4 * 2 * 2 * 6 * 6 * 3;
+
+// Count saturation and update factor pairs used by the VP9 adaptation.
+const unsigned int kUpdateParams[][2] = {
+  { 24, 112 }, { 24, 128 }, { MODE_MV_COUNT_SAT, MODE_MV_MAX_UPDATE_FACTOR }
+};
+
+class MergeProbsTest : public ::testing::TestWithParam<MergeProbsFunc> {
+ public:
+  virtual void SetUp() { func_ = GetParam(); }
+  virtual void TearDown() { libvpx_test::ClearSystemState(); }
+
+ protected:
+  static unsigned int Rand32(ACMRandom *rnd) {
+    return (static_cast<unsigned int>(rnd->Rand16()) << 16) | rnd->Rand16();
+  }
+
+  // Fills the counts with values below |max_count|, with some zero pairs. The
+  // sum of a pair must not wrap around.
+  void FillRandom(ACMRandom *rnd, unsigned int max_count) {
+    for (int i = 0; i < kNumProbs; ++i) {
+      pre_probs_[i] = rnd->Rand8() | 1;
+      if (rnd->Rand8() < 32) {
+        branch_ct_[i][0] = branch_ct_[i][1] = 0;
+      } else {
+        branch_ct_[i][0] = Rand32(rnd) % max_count;
+        branch_ct_[i][1] = Rand32(rnd) % max_count;
+      }
+    }
+  }
+
+  void CheckMerge(int n, unsigned int count_sat,
+                  unsigned int max_update_factor) {
+    uint8_t probs[kNumProbs];
+    for (int i = 0; i < n; ++i) {
+      ref_probs_[i] = merge_probs(pre_probs_[i], branch_ct_[i], count_sat,
+                                  max_update_factor);
+    }
+    ASM_REGISTER_STATE_CHECK(func_(pre_probs_, branch_ct_[0], n, count_sat,
+                                   max_update_factor, probs));
+    for (int i = 0; i < n; ++i) {
+      ASSERT_EQ(ref_probs_[i], probs[i])
+          << "index " << i << " counts " << branch_ct_[i][0] << ", "
+          << branch_ct_[i][1] << " pre " << static_cast<int>(pre_probs_[i]);
+    }
+  }
+
+  MergeProbsFunc func_;
+  uint8_t pre_probs_[kNumProbs];
+  uint8_t ref_probs_[kNumProbs];
+  unsigned int branch_ct_[kNumProbs][2];
+};
+
+TEST_P(MergeProbsTest, MatchesMergeProbs) {
+  ACMRandom rnd(ACMRandom::DeterministicSeed());
+  // Small counts exercise the partial update factors, large ones the
+  // precision of the probability.
+  const unsigned int kMaxCounts[] = { 4, 32, 1 << 12, 1 << 20, 1u << 30 };
+  for (int iter = 0; iter < 20; ++iter) {
+    for (const unsigned int max_count : kMaxCounts) {
+      FillRandom(&rnd, max_count);
+      for (const auto &params : kUpdateParams) {
+        // Odd lengths cover the tail handling.
+        CheckMerge(kNumProbs, params[0], params[1]);
+        CheckMerge(9 + iter % 4, params[0], params[1]);
+      }
+    }
+  }
+}
+
+TEST_P(MergeProbsTest, ExtremeCounts) {
+  const unsigned int kCounts[] = { 0, 1, 2, 23, 24, 25, 0x7fffffffu };
+  const int kNumCounts = sizeof(kCounts) / sizeof(kCounts[0]);
+  int n = 0;
+  for (int i = 0; i < kNumCounts; ++i) {
+    for (int j = 0; j < kNumCounts; ++j) {
+      branch_ct_[n][0] = kCounts[i];
+      branch_ct_[n][1] = kCounts[j];
+      pre_probs_[n] = (n & 1) ? 1 : 255;
+      ++n;
+    }
+  }
+  for (const auto &params : kUpdateParams) CheckMerge(n, params[0], params[1]);
+}
+
+TEST_P(MergeProbsTest, DISABLED_Speed) {
+  const int kNumIters = 100000;
+  ACMRandom rnd(ACMRandom::DeterministicSeed());
+  uint8_t probs[kNumProbs];
+  vpx_usec_timer timer;
+
+  FillRandom(&rnd, 1 << 16);
+  vpx_usec_timer_start(&timer);
+  for (int i = 0; i < kNumIters; ++i) {
+    func_(pre_probs_, branch_ct_[0], kNumProbs, 24, 112, probs);
+  }
+  vpx_usec_timer_mark(&timer);
+  const int elapsed_time = static_cast<int>(vpx_usec_timer_elapsed(&timer));
+  printf("merge_probs %d probs x %d: %d us\n", kNumProbs, kNumIters,
+         elapsed_time);
+}
+
+INSTANTIATE_TEST_SUITE_P(C, MergeProbsTest,
+                         ::testing::Values(&vpx_merge_probs_c));
+
+#if HAVE_SSE2
+INSTANTIATE_TEST_SUITE_P(SSE2, MergeProbsTest,
+                         ::testing::Values(&vpx_merge_probs_sse2));
+#endif  // HAVE_SSE2
+
+}  // namespace
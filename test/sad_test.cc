@@ -62,8 +62,9 @@ typedef void (*SadSkipMxNx4Func)(const uint8_t *src_ptr, int src_stride,
 typedef TestParams<SadSkipMxNx4Func> SadSkipMxNx4Param;
 
 typedef void (*SadMxNx8Func)(const uint8_t *src_ptr, int src_stride,
-                             const uint8_t *ref_ptr, int ref_stride,
+                             const uint8_t *const ref_ptr[], int ref_stride,
                              unsigned int *sad_array);
+typedef TestParams<SadMxNx8Func> SadMxNx8Param;
 
 using libvpx_test::ACMRandom;
 
@@ -327,6 +328,52 @@ class SADx4Test : public SADTestBase<SadMxNx4Param> {
   }
 };
 
+class SADx8Test : public SADTestBase<SadMxNx8Param> {
+ public:
+  SADx8Test() : SADTestBase(GetParam()) {}
+
+ protected:
+  static const int kNumRefs = 8;
+
+  // Two references per block, the second one a pixel to the right, as the
+  // neighboring candidates of a motion search are.
+  int GetRefOffset(int ref) const {
+    return GetBlockRefOffset(ref >> 1) + (ref & 1);
+  }
+
+  void FillRandomRefs() {
+    for (int ref = 0; ref < kNumRefs; ++ref) {
+      FillRandom(GetReferenceFromOffset(GetRefOffset(ref)), reference_stride_);
+    }
+  }
+
+  void FillConstantRefs(uint16_t fill_constant) {
+    for (int ref = 0; ref < kNumRefs; ++ref) {
+      FillConstant(GetReferenceFromOffset(GetRefOffset(ref)), reference_stride_,
+                   fill_constant);
+    }
+  }
+
+  void SADs(unsigned int *results) const {
+    const uint8_t *references[kNumRefs];
+    for (int ref = 0; ref < kNumRefs; ++ref) {
+      references[ref] = GetReferenceFromOffset(GetRefOffset(ref));
+    }
+
+    ASM_REGISTER_STATE_CHECK(params_.func(
+        source_data_, source_stride_, references, reference_stride_, results));
+  }
+
+  void CheckSADs() const {
+    DECLARE_ALIGNED(kDataAlignment, uint32_t, exp_sad[kNumRefs]);
+
+    SADs(exp_sad);
+    for (int ref = 0; ref < kNumRefs; ++ref) {
+      EXPECT_EQ(ReferenceSAD(GetRefOffset(ref)), exp_sad[ref]) << "ref " << ref;
+    }
+  }
+};
+
 class SADSkipx4Test : public SADTestBase<SadMxNx4Param> {
  public:
   SADSkipx4Test() : SADTestBase(GetParam()) {}
@@ -696,6 +743,74 @@ TEST_P(SADx4Test, DISABLED_Speed) {
   reference_stride_ = tmp_stride;
 }
 
+TEST_P(SADx8Test, MaxRef) {
+  FillConstant(source_data_, source_stride_, 0);
+  FillConstantRefs(mask_);
+  CheckSADs();
+}
+
+TEST_P(SADx8Test, MaxSrc) {
+  FillConstant(source_data_, source_stride_, mask_);
+  FillConstantRefs(0);
+  CheckSADs();
+}
+
+TEST_P(SADx8Test, ShortRef) {
+  int tmp_stride = reference_stride_;
+  reference_stride_ >>= 1;
+  FillRandom(source_data_, source_stride_);
+  FillRandomRefs();
+  CheckSADs();
+  reference_stride_ = tmp_stride;
+}
+
+TEST_P(SADx8Test, UnalignedRef) {
+  int tmp_stride = reference_stride_;
+  reference_stride_ -= 1;
+  FillRandom(source_data_, source_stride_);
+  FillRandomRefs();
+  CheckSADs();
+  reference_stride_ = tmp_stride;
+}
+
+TEST_P(SADx8Test, ShortSrc) {
+  int tmp_stride = source_stride_;
+  source_stride_ >>= 1;
+  FillRandom(source_data_, source_stride_);
+  FillRandomRefs();
+  CheckSADs();
+  source_stride_ = tmp_stride;
+}
+
+TEST_P(SADx8Test, SrcAlignedByWidth) {
+  uint8_t *tmp_source_data = source_data_;
+  source_data_ += params_.width;
+  FillRandom(source_data_, source_stride_);
+  FillRandomRefs();
+  CheckSADs();
+  source_data_ = tmp_source_data;
+}
+
+TEST_P(SADx8Test, DISABLED_Speed) {
+  FillRandom(source_data_, source_stride_);
+  FillRandomRefs();
+  // The same number of candidates as the SADx4Test speed test.
+  const int kCountSpeedTestBlock =
+      500000000 / (params_.width * params_.height) / 2;
+  DECLARE_ALIGNED(kDataAlignment, uint32_t, exp_sad[kNumRefs]);
+  vpx_usec_timer timer;
+  vpx_usec_timer_start(&timer);
+  for (int i = 0; i < kCountSpeedTestBlock; ++i) {
+    SADs(exp_sad);
+  }
+  vpx_usec_timer_mark(&timer);
+  CheckSADs();
+  const int elapsed_time =
+      static_cast<int>(vpx_usec_timer_elapsed(&timer) / 1000);
+  printf("sad%dx%dx8 time: %5d ms\n", params_.width, params_.height,
+         elapsed_time);
+}
+
 TEST_P(SADSkipx4Test, MaxRef) {
   FillConstant(source_data_, source_stride_, 0);
   FillConstant(GetReference(0), reference_stride_, mask_);
@@ -1021,6 +1136,23 @@ const SadMxNx4Param x4d_c_tests[] = {
 };
 INSTANTIATE_TEST_SUITE_P(C, SADx4Test, ::testing::ValuesIn(x4d_c_tests));
 
+const SadMxNx8Param x8d_c_tests[] = {
+  SadMxNx8Param(64, 64, &vpx_sad64x64x8d_c),
+  SadMxNx8Param(64, 32, &vpx_sad64x32x8d_c),
+  SadMxNx8Param(32, 64, &vpx_sad32x64x8d_c),
+  SadMxNx8Param(32, 32, &vpx_sad32x32x8d_c),
+  SadMxNx8Param(32, 16, &vpx_sad32x16x8d_c),
+  SadMxNx8Param(16, 32, &vpx_sad16x32x8d_c),
+  SadMxNx8Param(16, 16, &vpx_sad16x16x8d_c),
+  SadMxNx8Param(16, 8, &vpx_sad16x8x8d_c),
+  SadMxNx8Param(8, 16, &vpx_sad8x16x8d_c),
+  SadMxNx8Param(8, 8, &vpx_sad8x8x8d_c),
+  SadMxNx8Param(8, 4, &vpx_sad8x4x8d_c),
+  SadMxNx8Param(4, 8, &vpx_sad4x8x8d_c),
+  SadMxNx8Param(4, 4, &vpx_sad4x4x8d_c),
+};
+INSTANTIATE_TEST_SUITE_P(C, SADx8Test, ::testing::ValuesIn(x8d_c_tests));
+
 const SadSkipMxNx4Param skip_x4d_c_tests[] = {
   SadSkipMxNx4Param(64, 64, &vpx_sad_skip_64x64x4d_c),
   SadSkipMxNx4Param(64, 32, &vpx_sad_skip_64x32x4d_c),
@@ -1301,6 +1433,23 @@ const SadMxNx4Param x4d_neon_tests[] = {
 };
 INSTANTIATE_TEST_SUITE_P(NEON, SADx4Test, ::testing::ValuesIn(x4d_neon_tests));
 
+const SadMxNx8Param x8d_neon_tests[] = {
+  SadMxNx8Param(64, 64, &vpx_sad64x64x8d_neon),
+  SadMxNx8Param(64, 32, &vpx_sad64x32x8d_neon),
+  SadMxNx8Param(32, 64, &vpx_sad32x64x8d_neon),
+  SadMxNx8Param(32, 32, &vpx_sad32x32x8d_neon),
+  SadMxNx8Param(32, 16, &vpx_sad32x16x8d_neon),
+  SadMxNx8Param(16, 32, &vpx_sad16x32x8d_neon),
+  SadMxNx8Param(16, 16, &vpx_sad16x16x8d_neon),
+  SadMxNx8Param(16, 8, &vpx_sad16x8x8d_neon),
+  SadMxNx8Param(8, 16, &vpx_sad8x16x8d_neon),
+  SadMxNx8Param(8, 8, &vpx_sad8x8x8d_neon),
+  SadMxNx8Param(8, 4, &vpx_sad8x4x8d_neon),
+  SadMxNx8Param(4, 8, &vpx_sad4x8x8d_neon),
+  SadMxNx8Param(4, 4, &vpx_sad4x4x8d_neon),
+};
+INSTANTIATE_TEST_SUITE_P(NEON, SADx8Test, ::testing::ValuesIn(x8d_neon_tests));
+
 const SadSkipMxNx4Param skip_x4d_neon_tests[] = {
   SadSkipMxNx4Param(64, 64, &vpx_sad_skip_64x64x4d_neon),
   SadSkipMxNx4Param(64, 32, &vpx_sad_skip_64x32x4d_neon),
@@ -1774,6 +1923,21 @@ const SadMxNx4Param x4d_avx2_tests[] = {
 };
 INSTANTIATE_TEST_SUITE_P(AVX2, SADx4Test, ::testing::ValuesIn(x4d_avx2_tests));
 
+const SadMxNx8Param x8d_avx2_tests[] = {
+  SadMxNx8Param(64, 64, &vpx_sad64x64x8d_avx2),
+  SadMxNx8Param(64, 32, &vpx_sad64x32x8d_avx2),
+  SadMxNx8Param(32, 64, &vpx_sad32x64x8d_avx2),
+  SadMxNx8Param(32, 32, &vpx_sad32x32x8d_avx2),
+  SadMxNx8Param(32, 16, &vpx_sad32x16x8d_avx2),
+  SadMxNx8Param(16, 32, &vpx_sad16x32x8d_avx2),
+  SadMxNx8Param(16, 16, &vpx_sad16x16x8d_avx2),
+  SadMxNx8Param(16, 8, &vpx_sad16x8x8d_avx2),
+  SadMxNx8Param(8, 16, &vpx_sad8x16x8d_avx2),
+  SadMxNx8Param(8, 8, &vpx_sad8x8x8d_avx2),
+  SadMxNx8Param(8, 4, &vpx_sad8x4x8d_avx2),
+};
+INSTANTIATE_TEST_SUITE_P(AVX2, SADx8Test, ::testing::ValuesIn(x8d_avx2_tests));
+
 const SadSkipMxNx4Param skip_x4d_avx2_tests[] = {
   SadSkipMxNx4Param(64, 64, &vpx_sad_skip_64x64x4d_avx2),
   SadSkipMxNx4Param(64, 32, &vpx_sad_skip_64x32x4d_avx2),
@@ -1818,6 +1982,13 @@ const SadMxNx4Param x4d_avx512_tests[] = {
 };
 INSTANTIATE_TEST_SUITE_P(AVX512, SADx4Test,
                          ::testing::ValuesIn(x4d_avx512_tests));
+
+const SadMxNx8Param x8d_avx512_tests[] = {
+  SadMxNx8Param(64, 64, &vpx_sad64x64x8d_avx512),
+  SadMxNx8Param(64, 32, &vpx_sad64x32x8d_avx512),
+};
+INSTANTIATE_TEST_SUITE_P(AVX512, SADx8Test,
+                         ::testing::ValuesIn(x8d_avx512_tests));
 #endif  // HAVE_AVX512
 
 //------------------------------------------------------------------------------
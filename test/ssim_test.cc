@@ -0,0 +1,207 @@
+/*
+ *  Copyright (c) 2023 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <string.h>
+#include <tuple>
+
+#include "third_party/googletest/src/include/gtest/gtest.h"
+
+#include "./vpx_config.h"
+#include "./vpx_dsp_rtcd.h"
+#include "test/acm_random.h"
+#include "test/clear_system_state.h"
+#include "test/register_state_check.h"
+#include "test/util.h"
+#include "vpx_dsp/psnr.h"
+#include "vpx_dsp/ssim.h"
+#include "vpx_dsp/vpx_dsp_common.h"
+#include "vpx_ports/mem.h"
+#include "vpx_scale/yv12config.h"
+
+using libvpx_test::ACMRandom;
+
+namespace {
+
+typedef void (*SsimParmsFunc)(const uint8_t *s, int sp, const uint8_t *r,
+                              int rp, uint32_t *sum_s, uint32_t *sum_r,
+                              uint32_t *sum_sq_s, uint32_t *sum_sq_r,
+                              uint32_t *sum_sxr);
+// <reference, test, block size>
+typedef std::tuple<SsimParmsFunc, SsimParmsFunc, int> SsimParmsParam;
+
+class SsimParmsTest : public ::testing::TestWithParam<SsimParmsParam> {
+ public:
+  virtual ~SsimParmsTest() {}
+  virtual void SetUp() {
+    ref_func_ = GET_PARAM(0);
+    tst_func_ = GET_PARAM(1);
+    size_ = GET_PARAM(2);
+  }
+
+  virtual void TearDown() { libvpx_test::ClearSystemState(); }
+
+ protected:
+  void RunCheck(int extreme) {
+    ACMRandom rnd(ACMRandom::DeterministicSeed());
+    DECLARE_ALIGNED(16, uint8_t, src[64 * 16]);
+    DECLARE_ALIGNED(16, uint8_t, ref[64 * 16]);
+
+    for (int k = 0; k < 1000; ++k) {
+      const int src_stride = size_ + rnd(64 - size_ + 1);
+      const int ref_stride = size_ + rnd(64 - size_ + 1);
+      for (int i = 0; i < 64 * 16; ++i) {
+        src[i] = extreme ? (rnd(2) ? 255 : 0) : rnd.Rand8();
+        ref[i] = extreme ? 255 : rnd.Rand8();
+      }
+
+      // The functions accumulate into the outputs, so start from non-zero
+      // values.
+      uint32_t ref_sums[5] = { 1, 2, 3, 4, 5 };
+      uint32_t tst_sums[5] = { 1, 2, 3, 4, 5 };
+      ref_func_(src, src_stride, ref, ref_stride, &ref_sums[0], &ref_sums[1],
+                &ref_sums[2], &ref_sums[3], &ref_sums[4]);
+      ASM_REGISTER_STATE_CHECK(tst_func_(src, src_stride, ref, ref_stride,
+                                         &tst_sums[0], &tst_sums[1],
+                                         &tst_sums[2], &tst_sums[3],
+                                         &tst_sums[4]));
+      for (int i = 0; i < 5; ++i) {
+        ASSERT_EQ(ref_sums[i], tst_sums[i]) << "sum " << i << " iteration "
+                                            << k;
+      }
+    }
+  }
+
+  SsimParmsFunc ref_func_;
+  SsimParmsFunc tst_func_;
+  int size_;
+};
+GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(SsimParmsTest);
+
+TEST_P(SsimParmsTest, OperationCheck) { RunCheck(0); }
+
+TEST_P(SsimParmsTest, ExtremeValues) { RunCheck(1); }
+
+using std::make_tuple;
+
+#if HAVE_SSE2 && VPX_ARCH_X86_64
+INSTANTIATE_TEST_SUITE_P(
+    SSE2, SsimParmsTest,
+    ::testing::Values(make_tuple(&vpx_ssim_parms_8x8_c,
+                                 &vpx_ssim_parms_8x8_sse2, 8),
+                      make_tuple(&vpx_ssim_parms_16x16_c,
+                                 &vpx_ssim_parms_16x16_sse2, 16)));
+#endif  // HAVE_SSE2 && VPX_ARCH_X86_64
+
+#if HAVE_AVX2
+INSTANTIATE_TEST_SUITE_P(
+    AVX2, SsimParmsTest,
+    ::testing::Values(make_tuple(&vpx_ssim_parms_8x8_c,
+                                 &vpx_ssim_parms_8x8_avx2, 8),
+                      make_tuple(&vpx_ssim_parms_16x16_c,
+                                 &vpx_ssim_parms_16x16_avx2, 16)));
+#endif  // HAVE_AVX2
+
+// Checks that the row-parallel metrics are bit-exact with the
+// single-threaded ones. Param is the number of workers.
+class MetricsMtTest : public ::testing::TestWithParam<int> {
+ protected:
+  virtual void SetUp() {
+    memset(&src_, 0, sizeof(src_));
+    memset(&dst_, 0, sizeof(dst_));
+  }
+
+  virtual void TearDown() {
+    vpx_free_frame_buffer(&src_);
+    vpx_free_frame_buffer(&dst_);
+    libvpx_test::ClearSystemState();
+  }
+
+  void AllocAndFill(int width, int height) {
+    ACMRandom rnd(ACMRandom::DeterministicSeed());
+    YV12_BUFFER_CONFIG *const bufs[2] = { &src_, &dst_ };
+    for (int b = 0; b < 2; ++b) {
+      ASSERT_EQ(0, vpx_alloc_frame_buffer(bufs[b], width, height, 1, 1,
+#if CONFIG_VP9_HIGHBITDEPTH
+                                          0,
+#endif
+                                          32, 32));
+    }
+    FillPlane(&rnd, src_.y_buffer, dst_.y_buffer, src_.y_stride,
+              dst_.y_stride, src_.y_crop_width, src_.y_crop_height);
+    FillPlane(&rnd, src_.u_buffer, dst_.u_buffer, src_.uv_stride,
+              dst_.uv_stride, src_.uv_crop_width, src_.uv_crop_height);
+    FillPlane(&rnd, src_.v_buffer, dst_.v_buffer, src_.uv_stride,
+              dst_.uv_stride, src_.uv_crop_width, src_.uv_crop_height);
+  }
+
+  // Smooth content with small distortion so that SSIM is not saturated.
+  static void FillPlane(ACMRandom *rnd, uint8_t *src, uint8_t *dst,
+                        int src_stride, int dst_stride, int w, int h) {
+    for (int y = 0; y < h; ++y) {
+      for (int x = 0; x < w; ++x) {
+        const int v = (x * 3 + y * 5 + rnd->Rand8() / 8) & 255;
+        src[y * src_stride + x] = v;
+        dst[y * dst_stride + x] = clamp(v + rnd->Rand8() % 9 - 4, 0, 255);
+      }
+    }
+  }
+
+  YV12_BUFFER_CONFIG src_;
+  YV12_BUFFER_CONFIG dst_;
+};
+
+TEST_P(MetricsMtTest, BitExact) {
+  const int num_workers = GetParam();
+  static const int kSizes[][2] = { { 352, 288 }, { 203, 117 }, { 7, 5 } };
+  for (const auto &size : kSizes) {
+    AllocAndFill(size[0], size[1]);
+
+    // PSNR_STATS is only complete as a member of vpx_codec_cx_pkt_t in C++.
+    vpx_codec_cx_pkt_t pkt, pkt_mt;
+    vpx_calc_psnr(&src_, &dst_, reinterpret_cast<PSNR_STATS *>(&pkt.data.psnr));
+    vpx_calc_psnr_mt(&src_, &dst_,
+                     reinterpret_cast<PSNR_STATS *>(&pkt_mt.data.psnr), nullptr,
+                     num_workers);
+    for (int i = 0; i < 4; ++i) {
+      EXPECT_EQ(pkt.data.psnr.sse[i], pkt_mt.data.psnr.sse[i]);
+      EXPECT_EQ(pkt.data.psnr.samples[i], pkt_mt.data.psnr.samples[i]);
+      EXPECT_EQ(pkt.data.psnr.psnr[i], pkt_mt.data.psnr.psnr[i]);
+    }
+
+    double weight, weight_mt;
+    const double ssim = vpx_calc_ssim(&src_, &dst_, &weight);
+    const double ssim_mt =
+        vpx_calc_ssim_mt(&src_, &dst_, &weight_mt, nullptr, num_workers);
+    // Planes smaller than the 8x8 window give NaN in both versions.
+    if (size[0] >= 16 && size[1] >= 16) {
+      EXPECT_EQ(ssim, ssim_mt);
+    }
+    EXPECT_EQ(weight, weight_mt);
+
+    if (size[0] >= 64 && size[1] >= 64) {
+      double y, u, v, y_mt, u_mt, v_mt;
+      const double fastssim =
+          vpx_calc_fastssim(&src_, &dst_, &y, &u, &v, 8, 8);
+      const double fastssim_mt = vpx_calc_fastssim_mt(
+          &src_, &dst_, &y_mt, &u_mt, &v_mt, 8, 8, nullptr, num_workers);
+      EXPECT_EQ(fastssim, fastssim_mt);
+      EXPECT_EQ(y, y_mt);
+      EXPECT_EQ(u, u_mt);
+      EXPECT_EQ(v, v_mt);
+    }
+
+    vpx_free_frame_buffer(&src_);
+    vpx_free_frame_buffer(&dst_);
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(C, MetricsMtTest, ::testing::Values(1, 2, 3, 8));
+
+}  // namespace
@@ -11,6 +11,7 @@
 #include <math.h>
 #include <stdlib.h>
 #include <string.h>
+#include <tuple>
 
 #include "third_party/googletest/src/include/gtest/gtest.h"
 #include "test/acm_random.h"
@@ -28,17 +29,37 @@ using libvpx_test::ACMRandom;
 namespace {
 
 const int kNumPixels = 16 * 16;
-class VP8DenoiserTest : public ::testing::TestWithParam<int> {
+
+typedef int (*Vp8DenoiserFilterFunc)(unsigned char *mc_running_avg_y,
+                                     int mc_avg_y_stride,
+                                     unsigned char *running_avg_y,
+                                     int avg_y_stride, unsigned char *sig,
+                                     int sig_stride,
+                                     unsigned int motion_magnitude,
+                                     int increase_denoising);
+// <increase_denoising, Y filter, UV filter>
+typedef std::tuple<int, Vp8DenoiserFilterFunc, Vp8DenoiserFilterFunc>
+    VP8DenoiserTestParam;
+
+class VP8DenoiserTest
+    : public ::testing::TestWithParam<VP8DenoiserTestParam> {
  public:
   virtual ~VP8DenoiserTest() {}
 
-  virtual void SetUp() { increase_denoising_ = GetParam(); }
+  virtual void SetUp() {
+    increase_denoising_ = GET_PARAM(0);
+    filter_ = GET_PARAM(1);
+    filter_uv_ = GET_PARAM(2);
+  }
 
   virtual void TearDown() { libvpx_test::ClearSystemState(); }
 
  protected:
   int increase_denoising_;
+  Vp8DenoiserFilterFunc filter_;
+  Vp8DenoiserFilterFunc filter_uv_;
 };
+GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(VP8DenoiserTest);
 
 // TODO(https://crbug.com/webm/1718): This test fails with gcc 8-10.
 #if defined(__GNUC__) && __GNUC__ >= 8
@@ -85,9 +106,10 @@ TEST_P(VP8DenoiserTest, BitexactCheck) {
         mc_avg_block, stride, avg_block_c, stride, sig_block_c, stride,
         motion_magnitude_ran, increase_denoising_));
 
-    ASM_REGISTER_STATE_CHECK(vp8_denoiser_filter_sse2(
-        mc_avg_block, stride, avg_block_sse2, stride, sig_block_sse2, stride,
-        motion_magnitude_ran, increase_denoising_));
+    ASM_REGISTER_STATE_CHECK(filter_(mc_avg_block, stride, avg_block_sse2,
+                                     stride, sig_block_sse2, stride,
+                                     motion_magnitude_ran,
+                                     increase_denoising_));
 
     // Check bitexactness.
     for (int h = 0; h < 16; ++h) {
@@ -101,9 +123,10 @@ TEST_P(VP8DenoiserTest, BitexactCheck) {
         mc_avg_block, stride, avg_block_c, stride, sig_block_c, stride,
         motion_magnitude_ran, increase_denoising_));
 
-    ASM_REGISTER_STATE_CHECK(vp8_denoiser_filter_uv_sse2(
-        mc_avg_block, stride, avg_block_sse2, stride, sig_block_sse2, stride,
-        motion_magnitude_ran, increase_denoising_));
+    ASM_REGISTER_STATE_CHECK(filter_uv_(mc_avg_block, stride, avg_block_sse2,
+                                        stride, sig_block_sse2, stride,
+                                        motion_magnitude_ran,
+                                        increase_denoising_));
 
     // Check bitexactness.
     for (int h = 0; h < 16; ++h) {
@@ -114,6 +137,21 @@ TEST_P(VP8DenoiserTest, BitexactCheck) {
   }
 }
 
-// Test for all block size.
-INSTANTIATE_TEST_SUITE_P(SSE2, VP8DenoiserTest, ::testing::Values(0, 1));
+using std::make_tuple;
+
+INSTANTIATE_TEST_SUITE_P(
+    SSE2, VP8DenoiserTest,
+    ::testing::Values(make_tuple(0, &vp8_denoiser_filter_sse2,
+                                 &vp8_denoiser_filter_uv_sse2),
+                      make_tuple(1, &vp8_denoiser_filter_sse2,
+                                 &vp8_denoiser_filter_uv_sse2)));
+
+#if HAVE_AVX2
+INSTANTIATE_TEST_SUITE_P(
+    AVX2, VP8DenoiserTest,
+    ::testing::Values(make_tuple(0, &vp8_denoiser_filter_avx2,
+                                 &vp8_denoiser_filter_uv_avx2),
+                      make_tuple(1, &vp8_denoiser_filter_avx2,
+                                 &vp8_denoiser_filter_uv_avx2)));
+#endif  // HAVE_AVX2
 }  // namespace
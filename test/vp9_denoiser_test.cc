@@ -119,6 +119,21 @@ INSTANTIATE_TEST_SUITE_P(
                       make_tuple(&vp9_denoiser_filter_sse2, BLOCK_64X64)));
 #endif  // HAVE_SSE2
 
+#if HAVE_AVX2
+INSTANTIATE_TEST_SUITE_P(
+    AVX2, VP9DenoiserTest,
+    ::testing::Values(make_tuple(&vp9_denoiser_filter_avx2, BLOCK_8X8),
+                      make_tuple(&vp9_denoiser_filter_avx2, BLOCK_8X16),
+                      make_tuple(&vp9_denoiser_filter_avx2, BLOCK_16X8),
+                      make_tuple(&vp9_denoiser_filter_avx2, BLOCK_16X16),
+                      make_tuple(&vp9_denoiser_filter_avx2, BLOCK_16X32),
+                      make_tuple(&vp9_denoiser_filter_avx2, BLOCK_32X16),
+                      make_tuple(&vp9_denoiser_filter_avx2, BLOCK_32X32),
+                      make_tuple(&vp9_denoiser_filter_avx2, BLOCK_32X64),
+                      make_tuple(&vp9_denoiser_filter_avx2, BLOCK_64X32),
+                      make_tuple(&vp9_denoiser_filter_avx2, BLOCK_64X64)));
+#endif  // HAVE_AVX2
+
 #if HAVE_NEON
 INSTANTIATE_TEST_SUITE_P(
     NEON, VP9DenoiserTest,
@@ -0,0 +1,137 @@
+/*
+ *  Copyright (c) 2023 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <cmath>
+#include <vector>
+
+#include "third_party/googletest/src/include/gtest/gtest.h"
+
+#include "./vp9_rtcd.h"
+#include "./vpx_config.h"
+#include "test/acm_random.h"
+#include "test/clear_system_state.h"
+#include "test/register_state_check.h"
+#include "vp9/encoder/vp9_nn.h"
+
+using libvpx_test::ACMRandom;
+
+namespace {
+
+const int kMaxInputs = 40;
+const int kMaxOutputs = 40;
+const int kMaxSamples = 4;
+
+typedef void (*NnFcLayerFunc)(const float *input, int num_inputs,
+                              int num_samples, const float *weights,
+                              const float *bias, int num_outputs, int relu,
+                              float *output);
+
+float RandFloat(ACMRandom *rnd) {
+  return static_cast<float>(rnd->Rand16()) / 32768.0f - 1.0f;
+}
+
+class NnFcLayerTest : public ::testing::TestWithParam<NnFcLayerFunc> {
+ public:
+  virtual void SetUp() { func_ = GetParam(); }
+  virtual void TearDown() { libvpx_test::ClearSystemState(); }
+
+ protected:
+  NnFcLayerFunc func_;
+};
+GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(NnFcLayerTest);
+
+TEST_P(NnFcLayerTest, MatchesC) {
+  ACMRandom rnd(ACMRandom::DeterministicSeed());
+  std::vector<float> ref(kMaxSamples * kMaxOutputs);
+  std::vector<float> tst(kMaxSamples * kMaxOutputs);
+
+  for (int iter = 0; iter < 500; ++iter) {
+    const int num_inputs = 1 + rnd(kMaxInputs);
+    const int num_outputs = 1 + rnd(kMaxOutputs);
+    const int num_samples = 1 + rnd(kMaxSamples);
+    const int relu = rnd(2);
+    // Exact-size buffers so that reads past the end are caught by ASan.
+    std::vector<float> w(num_inputs * num_outputs);
+    std::vector<float> b(num_outputs);
+    std::vector<float> in(num_inputs * num_samples);
+    for (auto &v : w) v = RandFloat(&rnd);
+    for (auto &v : b) v = RandFloat(&rnd);
+    for (auto &v : in) v = 8.0f * RandFloat(&rnd);
+
+    vp9_nn_fc_layer_c(in.data(), num_inputs, num_samples, w.data(), b.data(),
+                      num_outputs, relu, ref.data());
+    ASM_REGISTER_STATE_CHECK(func_(in.data(), num_inputs, num_samples,
+                                   w.data(), b.data(), num_outputs, relu,
+                                   tst.data()));
+    for (int i = 0; i < num_samples * num_outputs; ++i) {
+      // The SIMD versions sum the products in a different order.
+      EXPECT_NEAR(ref[i], tst[i], 1e-4f * (1.0f + std::fabs(ref[i])))
+          << "iteration " << iter << " output " << i << " inputs "
+          << num_inputs << " outputs " << num_outputs;
+    }
+  }
+}
+
+TEST(NnPredictTest, BatchMatchesSingle) {
+  ACMRandom rnd(ACMRandom::DeterministicSeed());
+  const int kInputs = 7;
+  const int kHidden[2] = { 16, 9 };
+  const int kOutputs = 3;
+  const int kSamples = 2 * NN_MAX_BATCH + 3;
+  std::vector<float> w0(kInputs * kHidden[0]), b0(kHidden[0]);
+  std::vector<float> w1(kHidden[0] * kHidden[1]), b1(kHidden[1]);
+  std::vector<float> w2(kHidden[1] * kOutputs), b2(kOutputs);
+  for (auto *v : { &w0, &b0, &w1, &b1, &w2, &b2 }) {
+    for (auto &f : *v) f = RandFloat(&rnd);
+  }
+
+  NN_CONFIG config = {};
+  config.num_inputs = kInputs;
+  config.num_outputs = kOutputs;
+  config.num_hidden_layers = 2;
+  config.num_hidden_nodes[0] = kHidden[0];
+  config.num_hidden_nodes[1] = kHidden[1];
+  config.weights[0] = w0.data();
+  config.weights[1] = w1.data();
+  config.weights[2] = w2.data();
+  config.bias[0] = b0.data();
+  config.bias[1] = b1.data();
+  config.bias[2] = b2.data();
+
+  std::vector<float> features(kSamples * kInputs);
+  for (auto &f : features) f = 4.0f * RandFloat(&rnd);
+
+  std::vector<float> batch(kSamples * kOutputs);
+  vp9_nn_predict_batch(features.data(), kSamples, &config, batch.data());
+  for (int s = 0; s < kSamples; ++s) {
+    float single[kOutputs];
+    vp9_nn_predict(&features[s * kInputs], &config, single);
+    for (int o = 0; o < kOutputs; ++o) {
+      EXPECT_EQ(single[o], batch[s * kOutputs + o]) << "sample " << s;
+    }
+  }
+}
+
+#if HAVE_SSE2
+INSTANTIATE_TEST_SUITE_P(SSE2, NnFcLayerTest,
+                         ::testing::Values(&vp9_nn_fc_layer_sse2));
+#endif  // HAVE_SSE2
+
+#if HAVE_AVX2
+INSTANTIATE_TEST_SUITE_P(AVX2, NnFcLayerTest,
+                         ::testing::Values(&vp9_nn_fc_layer_avx2));
+#endif  // HAVE_AVX2
+
+#if HAVE_NEON
+INSTANTIATE_TEST_SUITE_P(NEON, NnFcLayerTest,
+                         ::testing::Values(&vp9_nn_fc_layer_neon));
+#endif  // HAVE_NEON
+
+}  // namespace
@@ -0,0 +1,85 @@
+/*
+ *  Copyright (c) 2023 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <vector>
+
+#include "third_party/googletest/src/include/gtest/gtest.h"
+
+#include "./vp9_rtcd.h"
+#include "./vpx_config.h"
+#include "test/acm_random.h"
+#include "test/clear_system_state.h"
+#include "test/register_state_check.h"
+
+using libvpx_test::ACMRandom;
+
+namespace {
+
+// The kernel reads 3 pixels on each side of the filtered row.
+const int kBorder = 3;
+const int kMaxWidth = 64;
+const int kStride = kMaxWidth + 2 * kBorder;
+
+typedef void (*SpatialDenoiseRowFunc)(const uint8_t *src, int src_stride,
+                                      uint8_t *dst, int width, int strength);
+
+class SpatialDenoiseRowTest
+    : public ::testing::TestWithParam<SpatialDenoiseRowFunc> {
+ public:
+  virtual void SetUp() { func_ = GetParam(); }
+  virtual void TearDown() { libvpx_test::ClearSystemState(); }
+
+ protected:
+  void RunCheck(int max_delta) {
+    ACMRandom rnd(ACMRandom::DeterministicSeed());
+    std::vector<uint8_t> src(kStride * (2 * kBorder + 1));
+    const uint8_t *const row = &src[kBorder * kStride + kBorder];
+
+    for (int iter = 0; iter < 1000; ++iter) {
+      const int width = 1 + rnd(kMaxWidth);
+      const int strength = rnd(13);
+      // Noise of limited amplitude around a random level, so that both kernel
+      // sizes and the per-pixel thresholds are exercised.
+      const int base = rnd.Rand8();
+      for (auto &v : src) {
+        v = clamp(base + rnd(2 * max_delta + 1) - max_delta, 0, 255);
+      }
+
+      // Exact-size outputs so that writes past the end are caught by ASan.
+      std::vector<uint8_t> ref(width), tst(width);
+      vp9_spatial_denoise_row_c(row, kStride, ref.data(), width, strength);
+      ASM_REGISTER_STATE_CHECK(
+          func_(row, kStride, tst.data(), width, strength));
+      for (int i = 0; i < width; ++i) {
+        ASSERT_EQ(ref[i], tst[i]) << "iteration " << iter << " col " << i
+                                  << " width " << width << " strength "
+                                  << strength;
+      }
+    }
+  }
+
+  static int clamp(int v, int lo, int hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+  }
+
+  SpatialDenoiseRowFunc func_;
+};
+GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(SpatialDenoiseRowTest);
+
+TEST_P(SpatialDenoiseRowTest, LowNoise) { RunCheck(8); }
+
+TEST_P(SpatialDenoiseRowTest, HighNoise) { RunCheck(255); }
+
+#if HAVE_SSE2
+INSTANTIATE_TEST_SUITE_P(SSE2, SpatialDenoiseRowTest,
+                         ::testing::Values(&vp9_spatial_denoise_row_sse2));
+#endif  // HAVE_SSE2
+
+}  // namespace
@@ -125,11 +125,29 @@ vpxdec_vp9_raw_file() {
   fi
 }
 
+# Ensures reading and writing on separate threads gives the same output.
+vpxdec_vp9_webm_threaded_io() {
+  if [ "$(vpxdec_can_decode_vp9)" = "yes" ] && \
+     [ "$(webm_io_available)" = "yes" ] && \
+     [ "$(vpx_config_option_enabled CONFIG_MULTITHREAD)" = "yes" ]; then
+    local decoder="$(vpx_tool_path vpxdec)"
+    local expected=$(${VPX_TEST_PREFIX} "${decoder}" "${VP9_WEBM_FILE}" \
+      --md5 2>/dev/null)
+    local md5=$(${VPX_TEST_PREFIX} "${decoder}" "${VP9_WEBM_FILE}" \
+      --threaded-io --md5 2>/dev/null)
+    if [ -z "${md5}" ] || [ "${md5}" != "${expected}" ]; then
+      elog "MD5 (${md5}) != expected (${expected})"
+      return 1
+    fi
+  fi
+}
+
 vpxdec_tests="vpxdec_vp8_ivf
               vpxdec_vp8_ivf_pipe_input
               vpxdec_vp9_webm
               vpxdec_vp9_webm_frame_parallel
               vpxdec_vp9_webm_less_than_50_frames
+              vpxdec_vp9_webm_threaded_io
               vpxdec_vp9_raw_file"
 
 run_tests vpxdec_verify_environment "${vpxdec_tests}"
@@ -348,6 +348,70 @@ vpxenc_vp9_webm_2pass() {
   fi
 }
 
+vpxenc_vp9_ivf_2pass_chunks() {
+  if [ "$(vpxenc_can_encode_vp9)" = "yes" ]; then
+    local output="${VPX_TEST_OUTPUT_DIR}/vp9_chunks.ivf"
+    vpxenc $(yuv_input_hantro_collage) \
+      --codec=vp9 \
+      --limit=20 \
+      --ivf \
+      --output="${output}" \
+      --passes=2 \
+      --chunks=2 \
+      --test-decode=off || return 1
+
+    if [ ! -e "${output}" ]; then
+      elog "Output file does not exist."
+      return 1
+    fi
+  fi
+}
+
+vpxenc_vp9_ivf_parallel_streams() {
+  if [ "$(vpxenc_can_encode_vp9)" = "yes" ] && \
+     [ "$(vpx_config_option_enabled CONFIG_MULTITHREAD)" = "yes" ]; then
+    local output="${VPX_TEST_OUTPUT_DIR}/vp9_parallel_streams"
+    vpxenc $(yuv_input_hantro_collage) \
+      --codec=vp9 \
+      --limit="${TEST_FRAMES}" \
+      --parallel-streams \
+      --ivf \
+      --output="${output}_0.ivf" \
+      --target-bitrate=400 \
+      -- \
+      --output="${output}_1.ivf" \
+      --target-bitrate=200 || return 1
+
+    for i in 0 1; do
+      if [ ! -e "${output}_${i}.ivf" ]; then
+        elog "Output file does not exist."
+        return 1
+      fi
+    done
+  fi
+}
+
+# Ensures reading and writing on separate threads gives the same output.
+vpxenc_vp9_ivf_threaded_io() {
+  if [ "$(vpxenc_can_encode_vp9)" = "yes" ] && \
+     [ "$(vpx_config_option_enabled CONFIG_MULTITHREAD)" = "yes" ]; then
+    local output="${VPX_TEST_OUTPUT_DIR}/vp9_threaded_io"
+    for io in "" --threaded-io; do
+      vpxenc $(yuv_input_hantro_collage) \
+        --codec=vp9 \
+        --limit="${TEST_FRAMES}" \
+        --ivf \
+        ${io} \
+        --output="${output}${io}.ivf" || return 1
+    done
+
+    if ! cmp -s "${output}.ivf" "${output}--threaded-io.ivf"; then
+      elog "Output differs with --threaded-io."
+      return 1
+    fi
+  fi
+}
+
 vpxenc_vp9_ivf_lossless() {
   if [ "$(vpxenc_can_encode_vp9)" = "yes" ]; then
     local output="${VPX_TEST_OUTPUT_DIR}/vp9_lossless.ivf"
@@ -469,6 +533,8 @@ vpxenc_tests="vpxenc_vp8_ivf
               vpxenc_vp8_webm_rt
               vpxenc_vp8_ivf_piped_input
               vpxenc_vp9_ivf
+              vpxenc_vp9_ivf_parallel_streams
+              vpxenc_vp9_ivf_threaded_io
               vpxenc_vp9_webm
               vpxenc_vp9_webm_rt
               vpxenc_vp9_webm_rt_multithread_tiled
@@ -483,7 +549,8 @@ if [ "$(vpx_config_option_enabled CONFIG_REALTIME_ONLY)" != "yes" ]; then
   vpxenc_tests="$vpxenc_tests
                 vpxenc_vp8_webm_2pass
                 vpxenc_vp8_webm_lag10_frames20
-                vpxenc_vp9_webm_2pass"
+                vpxenc_vp9_webm_2pass
+                vpxenc_vp9_ivf_2pass_chunks"
 fi
 
 run_tests vpxenc_verify_environment "${vpxenc_tests}"
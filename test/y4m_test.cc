@@ -8,15 +8,19 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <stdio.h>
 #include <string>
+#include <vector>
 
 #include "third_party/googletest/src/include/gtest/gtest.h"
 
 #include "./vpx_config.h"
 #include "./y4menc.h"
+#include "test/acm_random.h"
 #include "test/md5_helper.h"
 #include "test/util.h"
 #include "test/y4m_video_source.h"
+#include "vpx_ports/vpx_timer.h"
 
 namespace {
 
@@ -241,4 +245,44 @@ TEST(Y4MHeaderTest, LongHeader) {
   y4m_input_close(&y4m);
 }
 
+// Measures the throughput of reading 4:2:2 input converted to 4:2:0, as vpxenc
+// reads it for the codecs that only take 4:2:0.
+TEST(Y4MConversionTest, DISABLED_Speed422To420) {
+  const int kWidth1080p = 1920;
+  const int kHeight1080p = 1080;
+  const int kNumFrames = 60;
+  libvpx_test::ACMRandom rnd(libvpx_test::ACMRandom::DeterministicSeed());
+  std::vector<uint8_t> frame(kWidth1080p * kHeight1080p * 2);
+  for (size_t i = 0; i < frame.size(); ++i) frame[i] = rnd.Rand8();
+
+  libvpx_test::TempOutFile f;
+  ASSERT_NE(f.file(), nullptr);
+  fprintf(f.file(), "YUV4MPEG2 W%d H%d F30:1 Ip A0:0 C422jpeg\n", kWidth1080p,
+          kHeight1080p);
+  for (int i = 0; i < kNumFrames; ++i) {
+    fputs("FRAME\n", f.file());
+    fwrite(frame.data(), 1, frame.size(), f.file());
+  }
+  fflush(f.file());
+  EXPECT_EQ(fseek(f.file(), 0, 0), 0);
+
+  y4m_input y4m;
+  ASSERT_EQ(y4m_input_open(&y4m, f.file(), /*skip_buffer=*/nullptr,
+                           /*num_skip=*/0, /*only_420=*/1),
+            0);
+  vpx_image_t img;
+  vpx_usec_timer timer;
+  vpx_usec_timer_start(&timer);
+  for (int i = 0; i < kNumFrames; ++i) {
+    ASSERT_EQ(y4m_input_fetch_frame(&y4m, f.file(), &img), 1);
+  }
+  vpx_usec_timer_mark(&timer);
+  const int elapsed_time = static_cast<int>(vpx_usec_timer_elapsed(&timer));
+  EXPECT_EQ(img.fmt, VPX_IMG_FMT_I420);
+  printf("422jpeg to 420jpeg, %dx%d: %d frames in %d us (%.1f fps)\n",
+         kWidth1080p, kHeight1080p, kNumFrames, elapsed_time,
+         kNumFrames * 1e6 / elapsed_time);
+  y4m_input_close(&y4m);
+}
+
 }  // namespace
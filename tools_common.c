@@ -8,6 +8,7 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <assert.h>
 #include <math.h>
 #include <stdarg.h>
 #include <stdio.h>
@@ -263,6 +264,33 @@ int vpx_img_read(vpx_image_t *img, FILE *file) {
   return 1;
 }
 
+void vpx_img_copy(vpx_image_t *dst, const vpx_image_t *src) {
+  const int bytespp = (src->fmt & VPX_IMG_FMT_HIGHBITDEPTH) ? 2 : 1;
+  int plane;
+
+  assert(dst->fmt == src->fmt && dst->d_w == src->d_w &&
+         dst->d_h == src->d_h);
+  for (plane = 0; plane < 3; ++plane) {
+    const unsigned char *src_buf = src->planes[plane];
+    unsigned char *dst_buf = dst->planes[plane];
+    int w = vpx_img_plane_width(src, plane);
+    const int h = vpx_img_plane_height(src, plane);
+    int y;
+
+    // The U plane of NV12 holds both chroma planes.
+    if (src->fmt == VPX_IMG_FMT_NV12 && plane > 1) break;
+    if (src->fmt == VPX_IMG_FMT_NV12 && plane == 1) w = (w + 1) & ~1;
+    for (y = 0; y < h; ++y) {
+      memcpy(dst_buf, src_buf, w * bytespp);
+      src_buf += src->stride[plane];
+      dst_buf += dst->stride[plane];
+    }
+  }
+  dst->bit_depth = src->bit_depth;
+  dst->cs = src->cs;
+  dst->range = src->range;
+}
+
 // TODO(dkovalev) change sse_to_psnr signature: double -> int64_t
 double sse_to_psnr(double samples, double peak, double sse) {
   static const double kMaxPSNR = 100.0;
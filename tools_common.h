@@ -163,6 +163,9 @@ int vpx_img_plane_width(const vpx_image_t *img, int plane);
 int vpx_img_plane_height(const vpx_image_t *img, int plane);
 void vpx_img_write(const vpx_image_t *img, FILE *file);
 int vpx_img_read(vpx_image_t *img, FILE *file);
+// Copies the pixels, bit depth and color space of |src| to |dst|, which must
+// be of the same format and size.
+void vpx_img_copy(vpx_image_t *dst, const vpx_image_t *src);
 
 double sse_to_psnr(double samples, double peak, double mse);
 
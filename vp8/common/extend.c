@@ -109,10 +109,10 @@ void vp8_copy_and_extend_frame_with_rect(YV12_BUFFER_CONFIG *src,
   int er = dst->border + dst->y_width - src->y_width;
   int src_y_offset = srcy * src->y_stride + srcx;
   int dst_y_offset = srcy * dst->y_stride + srcx;
-  int src_uv_offset = ((srcy * src->uv_stride) >> 1) + (srcx >> 1);
-  int dst_uv_offset = ((srcy * dst->uv_stride) >> 1) + (srcx >> 1);
   // detect nv12 colorspace
   int chroma_step = src->v_buffer - src->u_buffer == 1 ? 2 : 1;
+  int src_uv_offset = (srcy >> 1) * src->uv_stride + (srcx >> 1) * chroma_step;
+  int dst_uv_offset = (srcy >> 1) * dst->uv_stride + (srcx >> 1);
 
   /* If the side is not touching the bounder then don't extend. */
   if (srcy) et = 0;
@@ -124,10 +124,15 @@ void vp8_copy_and_extend_frame_with_rect(YV12_BUFFER_CONFIG *src,
                         dst->y_buffer + dst_y_offset, dst->y_stride, srch, srcw,
                         et, el, eb, er, 1);
 
-  et = (et + 1) >> 1;
-  el = (el + 1) >> 1;
-  eb = (eb + 1) >> 1;
-  er = (er + 1) >> 1;
+  /* Extend the chroma planes as vp8_copy_and_extend_frame() does. */
+  et = srcy ? 0 : dst->border >> 1;
+  el = srcx ? 0 : dst->border >> 1;
+  eb = srcy + srch != src->y_height
+           ? 0
+           : (dst->border >> 1) + dst->uv_height - src->uv_height;
+  er = srcx + srcw != src->y_width
+           ? 0
+           : (dst->border >> 1) + dst->uv_width - src->uv_width;
   srch = (srch + 1) >> 1;
   srcw = (srcw + 1) >> 1;
 
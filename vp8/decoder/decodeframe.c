@@ -31,6 +31,7 @@
 #include "error_concealment.h"
 #endif
 #include "vpx_mem/vpx_mem.h"
+#include "vpx_ports/vpx_timer.h"
 #include "vp8/common/threading.h"
 #include "decoderthreading.h"
 #include "dboolhuff.h"
@@ -484,6 +485,8 @@ static void decode_mb_rows(VP8D_COMP *pbi) {
 
   /* Decode the individual macro block */
   for (mb_row = 0; mb_row < pc->mb_rows; ++mb_row) {
+    struct vpx_usec_timer timer;
+
     if (num_part > 1) {
       xd->current_bc = &pbi->mbc[ibc];
       ibc++;
@@ -604,6 +607,7 @@ static void decode_mb_rows(VP8D_COMP *pbi) {
 
     if (pc->filter_level) {
       if (mb_row > 0) {
+        vpx_usec_timer_start(&timer);
         if (pc->filter_type == NORMAL_LOOPFILTER) {
           vp8_loop_filter_row_normal(pc, lf_mic, mb_row - 1, recon_y_stride,
                                      recon_uv_stride, lf_dst[0], lf_dst[1],
@@ -612,6 +616,8 @@ static void decode_mb_rows(VP8D_COMP *pbi) {
           vp8_loop_filter_row_simple(pc, lf_mic, mb_row - 1, recon_y_stride,
                                      lf_dst[0]);
         }
+        vpx_usec_timer_mark(&timer);
+        pbi->profile.loopfilter_us += vpx_usec_timer_elapsed(&timer);
         if (mb_row > 1) {
           yv12_extend_frame_left_right_c(yv12_fb_new, eb_dst[0], eb_dst[1],
                                          eb_dst[2]);
@@ -640,6 +646,8 @@ static void decode_mb_rows(VP8D_COMP *pbi) {
   }
 
   if (pc->filter_level) {
+    struct vpx_usec_timer timer;
+    vpx_usec_timer_start(&timer);
     if (pc->filter_type == NORMAL_LOOPFILTER) {
       vp8_loop_filter_row_normal(pc, lf_mic, mb_row - 1, recon_y_stride,
                                  recon_uv_stride, lf_dst[0], lf_dst[1],
@@ -648,6 +656,8 @@ static void decode_mb_rows(VP8D_COMP *pbi) {
       vp8_loop_filter_row_simple(pc, lf_mic, mb_row - 1, recon_y_stride,
                                  lf_dst[0]);
     }
+    vpx_usec_timer_mark(&timer);
+    pbi->profile.loopfilter_us += vpx_usec_timer_elapsed(&timer);
 
     yv12_extend_frame_left_right_c(yv12_fb_new, eb_dst[0], eb_dst[1],
                                    eb_dst[2]);
@@ -889,9 +899,12 @@ int vp8_decode_frame(VP8D_COMP *pbi) {
   const int *const mb_feature_data_bits = vp8_mb_feature_data_bits;
   int corrupt_tokens = 0;
   int prev_independent_partitions = pbi->independent_partitions;
+  struct vpx_usec_timer timer;
 
   YV12_BUFFER_CONFIG *yv12_fb_new = pbi->dec_fb_ref[INTRA_FRAME];
 
+  vpx_usec_timer_start(&timer);
+
   /* start with no corruption of current frame */
   xd->corrupted = 0;
   yv12_fb_new->corrupted = 0;
@@ -1078,6 +1091,11 @@ int vp8_decode_frame(VP8D_COMP *pbi) {
 
   setup_token_decoder(pbi, data + first_partition_length_in_bytes);
 
+  pbi->profile.tile_count = (int)pbi->fragments.count - 1;
+  for (i = 0; i < pbi->profile.tile_count; ++i) {
+    pbi->profile.tile_bytes[i] = pbi->fragments.sizes[i + 1];
+  }
+
   xd->current_bc = &pbi->mbc[0];
 
   /* Read the default quantizers. */
@@ -1200,6 +1218,10 @@ int vp8_decode_frame(VP8D_COMP *pbi) {
   /* clear out the coeff buffer */
   memset(xd->qcoeff, 0, sizeof(xd->qcoeff));
 
+  vpx_usec_timer_mark(&timer);
+  pbi->profile.header_us += vpx_usec_timer_elapsed(&timer);
+  vpx_usec_timer_start(&timer);
+
   vp8_decode_mode_mvs(pbi);
 
 #if CONFIG_ERROR_CONCEALMENT
@@ -1211,6 +1233,9 @@ int vp8_decode_frame(VP8D_COMP *pbi) {
   }
 #endif
 
+  vpx_usec_timer_mark(&timer);
+  pbi->profile.parse_us += vpx_usec_timer_elapsed(&timer);
+
   memset(pc->above_context, 0, sizeof(ENTROPY_CONTEXT_PLANES) * pc->mb_cols);
   pbi->frame_corrupt_residual = 0;
 
@@ -1230,7 +1255,13 @@ int vp8_decode_frame(VP8D_COMP *pbi) {
   } else
 #endif
   {
+    const int64_t loopfilter_us = pbi->profile.loopfilter_us;
+    vpx_usec_timer_start(&timer);
     decode_mb_rows(pbi);
+    vpx_usec_timer_mark(&timer);
+    /* The loop filter is run row by row as the rows are decoded. */
+    pbi->profile.recon_us += vpx_usec_timer_elapsed(&timer) -
+                             (pbi->profile.loopfilter_us - loopfilter_us);
     corrupt_tokens |= xd->corrupted;
   }
 
@@ -305,8 +305,11 @@ static int check_fragments_for_errors(VP8D_COMP *pbi) {
 int vp8dx_receive_compressed_data(VP8D_COMP *pbi, int64_t time_stamp) {
   VP8_COMMON *cm = &pbi->common;
   int retcode = -1;
+  struct vpx_usec_timer timer;
 
   pbi->common.error.error_code = VPX_CODEC_OK;
+  memset(&pbi->profile, 0, sizeof(pbi->profile));
+  vpx_usec_timer_start(&timer);
 
   retcode = check_fragments_for_errors(pbi);
   if (retcode <= 0) return retcode;
@@ -369,8 +372,11 @@ int vp8dx_receive_compressed_data(VP8D_COMP *pbi, int64_t time_stamp) {
 
   pbi->ready_for_new_data = 0;
   pbi->last_time_stamp = time_stamp;
+  pbi->profile.frame_count = 1;
 
 decode_exit:
+  vpx_usec_timer_mark(&timer);
+  pbi->profile.frame_us = vpx_usec_timer_elapsed(&timer);
   vpx_clear_system_state();
   return retcode;
 }
@@ -389,7 +395,13 @@ int vp8dx_get_raw_frame(VP8D_COMP *pbi, YV12_BUFFER_CONFIG *sd,
   *time_end_stamp = 0;
 
 #if CONFIG_POSTPROC
-  ret = vp8_post_proc_frame(&pbi->common, sd, flags);
+  {
+    struct vpx_usec_timer timer;
+    vpx_usec_timer_start(&timer);
+    ret = vp8_post_proc_frame(&pbi->common, sd, flags);
+    vpx_usec_timer_mark(&timer);
+    pbi->profile.postproc_us += vpx_usec_timer_elapsed(&timer);
+  }
 #else
   (void)flags;
 
@@ -14,6 +14,7 @@
 #include <assert.h>
 
 #include "vpx_config.h"
+#include "vpx/vp8dx.h"
 #include "vp8/common/onyxd.h"
 #include "treereader.h"
 #include "vp8/common/onyxc_int.h"
@@ -35,6 +36,9 @@ typedef struct {
 
 typedef struct {
   MACROBLOCKD mbd;
+  /* Time in microseconds spent by the thread on the current frame. */
+  int64_t recon_us;
+  int64_t wait_us;
 } MB_ROW_DEC;
 
 typedef struct {
@@ -120,6 +124,9 @@ typedef struct VP8D_COMP {
 
   vpx_decrypt_cb decrypt_cb;
   void *decrypt_state;
+
+  /* Counters of the current decode call. */
+  vpx_decode_profile_t profile;
 #if CONFIG_MULTITHREAD
   // Restart threads on next frame if set to 1.
   // This is set when error happens in multithreaded decoding and all threads
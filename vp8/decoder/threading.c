@@ -246,8 +246,22 @@ static void mt_decode_macroblock(VP8D_COMP *pbi, MACROBLOCKD *xd,
   }
 }
 
+/* Waits for the row above to be decoded far enough, counting the time spent
+ * spinning in |wait_us|. */
+static void spin_wait(int mb_col, const vpx_atomic_int *last_row_current_mb_col,
+                      const int nsync, int64_t *wait_us) {
+  if (mb_col > vpx_atomic_load_acquire(last_row_current_mb_col) - nsync) {
+    struct vpx_usec_timer timer;
+    vpx_usec_timer_start(&timer);
+    vp8_atomic_spin_wait(mb_col, last_row_current_mb_col, nsync);
+    vpx_usec_timer_mark(&timer);
+    *wait_us += vpx_usec_timer_elapsed(&timer);
+  }
+}
+
 static void mt_decode_mb_rows(VP8D_COMP *pbi, MACROBLOCKD *xd,
-                              int start_mb_row) {
+                              int start_mb_row, int64_t *recon_us,
+                              int64_t *wait_us) {
   const vpx_atomic_int *last_row_current_mb_col;
   vpx_atomic_int *current_mb_col;
   int mb_row;
@@ -268,6 +282,10 @@ static void mt_decode_mb_rows(VP8D_COMP *pbi, MACROBLOCKD *xd,
   unsigned char *dst_buffer[3];
   int i;
   int ref_fb_corrupted[MAX_REF_FRAMES];
+  struct vpx_usec_timer timer;
+  int64_t row_wait_us = 0;
+
+  vpx_usec_timer_start(&timer);
 
   ref_fb_corrupted[INTRA_FRAME] = 0;
 
@@ -362,7 +380,7 @@ static void mt_decode_mb_rows(VP8D_COMP *pbi, MACROBLOCKD *xd,
       }
 
       if (mb_row && !(mb_col & (nsync - 1))) {
-        vp8_atomic_spin_wait(mb_col, last_row_current_mb_col, nsync);
+        spin_wait(mb_col, last_row_current_mb_col, nsync, &row_wait_us);
       }
 
       /* Distance of MB to the various image edges.
@@ -573,6 +591,10 @@ static void mt_decode_mb_rows(VP8D_COMP *pbi, MACROBLOCKD *xd,
     xd->mode_info_context += xd->mode_info_stride * pbi->decoding_thread_count;
   }
 
+  vpx_usec_timer_mark(&timer);
+  *recon_us += vpx_usec_timer_elapsed(&timer) - row_wait_us;
+  *wait_us += row_wait_us;
+
   /* signal end of decoding of current thread for current frame */
   if (last_mb_row + (int)pbi->decoding_thread_count + 1 >= pc->mb_rows)
     sem_post(&pbi->h_event_end_decoding);
@@ -600,7 +622,8 @@ static THREAD_FUNCTION thread_decoding_proc(void *p_data) {
           continue;
         }
         xd->error_info.setjmp = 1;
-        mt_decode_mb_rows(pbi, xd, ithread + 1);
+        mt_decode_mb_rows(pbi, xd, ithread + 1, &mbrd->recon_us,
+                          &mbrd->wait_us);
       }
     }
   }
@@ -842,6 +865,7 @@ int vp8mt_decode_mb_rows(VP8D_COMP *pbi, MACROBLOCKD *xd) {
   VP8_COMMON *pc = &pbi->common;
   unsigned int i;
   int j;
+  struct vpx_usec_timer timer;
 
   int filter_level = pc->filter_level;
   YV12_BUFFER_CONFIG *yv12_fb_new = pbi->dec_fb_ref[INTRA_FRAME];
@@ -881,6 +905,8 @@ int vp8mt_decode_mb_rows(VP8D_COMP *pbi, MACROBLOCKD *xd) {
                              pbi->decoding_thread_count);
 
   for (i = 0; i < pbi->decoding_thread_count; ++i) {
+    pbi->mb_row_di[i].recon_us = 0;
+    pbi->mb_row_di[i].wait_us = 0;
     sem_post(&pbi->h_event_start_decoding[i]);
   }
 
@@ -896,10 +922,18 @@ int vp8mt_decode_mb_rows(VP8D_COMP *pbi, MACROBLOCKD *xd) {
   }
 
   xd->error_info.setjmp = 1;
-  mt_decode_mb_rows(pbi, xd, 0);
+  mt_decode_mb_rows(pbi, xd, 0, &pbi->profile.recon_us, &pbi->profile.wait_us);
 
+  vpx_usec_timer_start(&timer);
   for (i = 0; i < pbi->decoding_thread_count + 1; ++i)
     sem_wait(&pbi->h_event_end_decoding); /* add back for each frame */
+  vpx_usec_timer_mark(&timer);
+  pbi->profile.wait_us += vpx_usec_timer_elapsed(&timer);
+
+  for (i = 0; i < pbi->decoding_thread_count; ++i) {
+    pbi->profile.recon_us += pbi->mb_row_di[i].recon_us;
+    pbi->profile.wait_us += pbi->mb_row_di[i].wait_us;
+  }
 
   return 0;
 }
@@ -22,6 +22,7 @@
 #include "vpx_ports/compiler_attributes.h"
 #include "vpx_ports/system_state.h"
 #include "bitstream.h"
+#include "ethreading.h"
 
 #include "defaultcoefcounts.h"
 #include "vp8/common/common.h"
@@ -289,30 +290,40 @@ static void write_partition_size(unsigned char *cx_data, int size) {
   *(cx_data + 2) = csize;
 }
 
+void vp8_pack_token_partition(VP8_COMP *cpi, vp8_writer *w, int part,
+                              int num_part, unsigned char *dest,
+                              unsigned char *dest_end) {
+  int mb_row;
+
+  vp8_start_encode(w, dest, dest_end);
+
+  for (mb_row = part; mb_row < cpi->common.mb_rows; mb_row += num_part) {
+    const TOKENEXTRA *p = cpi->tplist[mb_row].start;
+    const TOKENEXTRA *stop = cpi->tplist[mb_row].stop;
+    int tokens = (int)(stop - p);
+
+    vp8_pack_tokens(w, p, tokens);
+  }
+
+  vp8_stop_encode(w);
+}
+
 static void pack_tokens_into_partitions(VP8_COMP *cpi, unsigned char *cx_data,
                                         unsigned char *cx_data_end,
                                         int num_part) {
   int i;
   unsigned char *ptr = cx_data;
-  unsigned char *ptr_end = cx_data_end;
-  vp8_writer *w;
-
-  for (i = 0; i < num_part; ++i) {
-    int mb_row;
-
-    w = cpi->bc + i + 1;
-
-    vp8_start_encode(w, ptr, ptr_end);
-
-    for (mb_row = i; mb_row < cpi->common.mb_rows; mb_row += num_part) {
-      const TOKENEXTRA *p = cpi->tplist[mb_row].start;
-      const TOKENEXTRA *stop = cpi->tplist[mb_row].stop;
-      int tokens = (int)(stop - p);
 
-      vp8_pack_tokens(w, p, tokens);
-    }
+#if CONFIG_MULTITHREAD
+  if (vpx_atomic_load_acquire(&cpi->b_multi_threaded) &&
+      vp8cx_pack_token_partitions_mt(cpi, cx_data, cx_data_end, num_part)) {
+    return;
+  }
+#endif  // CONFIG_MULTITHREAD
 
-    vp8_stop_encode(w);
+  for (i = 0; i < num_part; ++i) {
+    vp8_writer *const w = cpi->bc + i + 1;
+    vp8_pack_token_partition(cpi, w, i, num_part, ptr, cx_data_end);
     ptr += w->pos;
   }
 }
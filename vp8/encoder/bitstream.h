@@ -19,6 +19,11 @@ extern "C" {
 #include "vp8/encoder/tokenize.h"
 
 void vp8_pack_tokens(vp8_writer *w, const TOKENEXTRA *p, int xcount);
+/* Packs the macroblock rows of token partition |part| into [dest, dest_end)
+ * with |w|. */
+void vp8_pack_token_partition(struct VP8_COMP *cpi, vp8_writer *w, int part,
+                              int num_part, unsigned char *dest,
+                              unsigned char *dest_end);
 void vp8_convert_rfct_to_prob(struct VP8_COMP *const cpi);
 void vp8_calc_ref_frame_costs(int *ref_frame_cost, int prob_intra,
                               int prob_last, int prob_garf);
@@ -442,7 +442,7 @@ static void encode_mb_row(VP8_COMP *cpi, VP8_COMMON *cm, int mb_row,
       xd->mode_info_context->mbmi.segment_id = 0;
     }
 
-    x->active_ptr = cpi->active_map + map_index + mb_col;
+    x->active_ptr = cpi->frame_active_map + map_index + mb_col;
 
     if (cm->frame_type == KEY_FRAME) {
       *totalrate += vp8cx_encode_intra_macroblock(cpi, x, tp);
@@ -8,10 +8,13 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <string.h>
+
 #include "onyx_int.h"
 #include "vp8/common/threading.h"
 #include "vp8/common/common.h"
 #include "vp8/common/extend.h"
+#include "vpx_dsp/vpx_dsp_common.h"
 #include "bitstream.h"
 #include "encodeframe.h"
 #include "ethreading.h"
@@ -41,6 +44,35 @@ static THREAD_FUNCTION thread_loopfilter(void *p_data) {
   return 0;
 }
 
+static void pack_token_partition(VP8_COMP *cpi, int part) {
+  struct vpx_internal_error_info *const error = &cpi->mt_pack_error[part];
+  vp8_writer *const w = &cpi->bc[part + 1];
+  unsigned char *const dest =
+      cpi->mt_pack_dest + part * cpi->mt_pack_slice_size;
+
+  error->error_code = VPX_CODEC_OK;
+  if (setjmp(error->jmp)) {
+    /* The partition did not fit in its slice. */
+    error->setjmp = 0;
+    return;
+  }
+  error->setjmp = 1;
+
+  w->error = error;
+  vp8_pack_token_partition(cpi, w, part, cpi->mt_pack_num_part, dest,
+                           dest + cpi->mt_pack_slice_size);
+  error->setjmp = 0;
+}
+
+static void pack_token_partitions_job(VP8_COMP *cpi, void *data, int thread) {
+  int part;
+  (void)data;
+  for (part = thread; part < cpi->mt_pack_num_part;
+       part += cpi->encoding_thread_count + 1) {
+    pack_token_partition(cpi, part);
+  }
+}
+
 static THREAD_FUNCTION thread_encoding_proc(void *p_data) {
   int ithread = ((ENCODETHREAD_DATA *)p_data)->ithread;
   VP8_COMP *cpi = (VP8_COMP *)(((ENCODETHREAD_DATA *)p_data)->ptr1);
@@ -68,6 +100,12 @@ static THREAD_FUNCTION thread_encoding_proc(void *p_data) {
       /* we're shutting down */
       if (vpx_atomic_load_acquire(&cpi->b_multi_threaded) == 0) break;
 
+      if (cpi->mt_job) {
+        cpi->mt_job(cpi, cpi->mt_job_data, ithread + 1);
+        sem_post(&cpi->h_event_end_encoding[ithread]);
+        continue;
+      }
+
       xd->mode_info_context = cm->mi + cm->mode_info_stride * (ithread + 1);
       xd->mode_info_stride = cm->mode_info_stride;
 
@@ -170,7 +208,7 @@ static THREAD_FUNCTION thread_encoding_proc(void *p_data) {
             xd->mode_info_context->mbmi.segment_id = 0;
           }
 
-          x->active_ptr = cpi->active_map + map_index + mb_col;
+          x->active_ptr = cpi->frame_active_map + map_index + mb_col;
 
           if (cm->frame_type == KEY_FRAME) {
             *totalrate += vp8cx_encode_intra_macroblock(cpi, x, &tp);
@@ -485,6 +523,18 @@ void vp8cx_init_mbrthread_data(VP8_COMP *cpi, MACROBLOCK *x,
   }
 }
 
+void vp8cx_init_mbrthread_search(MACROBLOCK *x, MB_ROW_COMP *mbr_ei,
+                                 int count) {
+  int i;
+
+  for (i = 0; i < count; ++i) {
+    MACROBLOCK *mb = &mbr_ei[i].mb;
+
+    setup_mbby_copy(mb, x);
+    mb->e_mbd.fullpixel_mask = x->e_mbd.fullpixel_mask;
+  }
+}
+
 int vp8cx_create_encoder_threads(VP8_COMP *cpi) {
   const VP8_COMMON *cm = &cpi->common;
 
@@ -604,6 +654,60 @@ int vp8cx_create_encoder_threads(VP8_COMP *cpi) {
   return 0;
 }
 
+void vp8cx_run_mt_job(VP8_COMP *cpi,
+                      void (*job)(VP8_COMP *cpi, void *data, int thread),
+                      void *data, int num_threads) {
+  int i;
+
+  cpi->mt_job = job;
+  cpi->mt_job_data = data;
+
+  for (i = 0; i < num_threads; ++i) {
+    sem_post(&cpi->h_event_start_encoding[i]);
+  }
+
+  job(cpi, data, 0);
+
+  for (i = 0; i < num_threads; ++i) {
+    sem_wait(&cpi->h_event_end_encoding[i]);
+  }
+
+  cpi->mt_job = NULL;
+  cpi->mt_job_data = NULL;
+}
+
+int vp8cx_pack_token_partitions_mt(VP8_COMP *cpi, unsigned char *dest,
+                                   unsigned char *dest_end, int num_part) {
+  /* Partition i is packed by thread i % (encoding_thread_count + 1), where
+   * thread 0 is the calling thread. */
+  const int num_threads = VPXMIN(cpi->encoding_thread_count, num_part - 1);
+  struct vpx_internal_error_info *const error = cpi->bc[1].error;
+  unsigned char *ptr = dest;
+  int i, fits = 1;
+
+  cpi->mt_pack_num_part = num_part;
+  cpi->mt_pack_dest = dest;
+  cpi->mt_pack_slice_size = (size_t)(dest_end - dest) / num_part;
+
+  vp8cx_run_mt_job(cpi, pack_token_partitions_job, NULL, num_threads);
+
+  cpi->mt_pack_num_part = 0;
+
+  for (i = 0; i < num_part; ++i) {
+    vp8_writer *const w = &cpi->bc[i + 1];
+    w->error = error;
+    if (cpi->mt_pack_error[i].error_code != VPX_CODEC_OK) fits = 0;
+    if (!fits) continue;
+
+    /* Each partition starts at or after the end of the previous one. */
+    memmove(ptr, w->buffer, w->pos);
+    w->buffer = ptr;
+    ptr += w->pos;
+  }
+
+  return fits;
+}
+
 void vp8cx_remove_encoder_threads(VP8_COMP *cpi) {
   if (vpx_atomic_load_acquire(&cpi->b_multi_threaded)) {
     /* shutdown other threads */
@@ -25,6 +25,26 @@ void vp8cx_init_mbrthread_data(struct VP8_COMP *cpi, struct macroblock *x,
 int vp8cx_create_encoder_threads(struct VP8_COMP *cpi);
 void vp8cx_remove_encoder_threads(struct VP8_COMP *cpi);
 
+/* Copies the motion search and quantizer state of |x| to the macroblocks of
+ * the |count| encoding threads. */
+void vp8cx_init_mbrthread_search(struct macroblock *x, MB_ROW_COMP *mbr_ei,
+                                 int count);
+
+/* Runs job(cpi, data, t) for t = 0 on the calling thread and for
+ * t = 1..num_threads on the encoding threads, and waits for all of them.
+ * Jobs split their work with a stride of encoding_thread_count + 1. */
+void vp8cx_run_mt_job(struct VP8_COMP *cpi,
+                      void (*job)(struct VP8_COMP *cpi, void *data,
+                                  int thread),
+                      void *data, int num_threads);
+
+/* Packs the |num_part| token partitions on the encoding threads. Partition i
+ * is written with cpi->bc[i + 1] into its own equal slice of [dest, dest_end)
+ * and the partitions are then moved together to the start of dest. Returns 0
+ * if a partition did not fit in its slice. */
+int vp8cx_pack_token_partitions_mt(struct VP8_COMP *cpi, unsigned char *dest,
+                                   unsigned char *dest_end, int num_part);
+
 #ifdef __cplusplus
 }
 #endif
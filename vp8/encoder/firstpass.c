@@ -33,6 +33,8 @@
 #include "vp8/common/quant_common.h"
 #include "encodemv.h"
 #include "encodeframe.h"
+#include "ethreading.h"
+#include "vpx_dsp/vpx_dsp_common.h"
 
 #define OUTPUT_FPF 0
 
@@ -465,37 +467,320 @@ static void first_pass_motion_search(VP8_COMP *cpi, MACROBLOCK *x,
   }
 }
 
-void vp8_first_pass(VP8_COMP *cpi) {
-  int mb_row, mb_col;
-  MACROBLOCK *const x = &cpi->mb;
+static void first_pass_mb_row(VP8_COMP *cpi, MACROBLOCK *x, int mb_row,
+                              FIRSTPASS_ROW_STATS *stats) {
   VP8_COMMON *const cm = &cpi->common;
   MACROBLOCKD *const xd = &x->e_mbd;
-
-  int recon_yoffset, recon_uvoffset;
+  int mb_col;
   YV12_BUFFER_CONFIG *lst_yv12 = &cm->yv12_fb[cm->lst_fb_idx];
   YV12_BUFFER_CONFIG *new_yv12 = &cm->yv12_fb[cm->new_fb_idx];
   YV12_BUFFER_CONFIG *gld_yv12 = &cm->yv12_fb[cm->gld_fb_idx];
-  int recon_y_stride = lst_yv12->y_stride;
-  int recon_uv_stride = lst_yv12->uv_stride;
-  int64_t intra_error = 0;
-  int64_t coded_error = 0;
-
-  int sum_mvr = 0, sum_mvc = 0;
-  int sum_mvr_abs = 0, sum_mvc_abs = 0;
-  int sum_mvrs = 0, sum_mvcs = 0;
-  int mvcount = 0;
-  int intercount = 0;
-  int second_ref_count = 0;
+  int recon_yoffset = mb_row * lst_yv12->y_stride * 16;
+  int recon_uvoffset = mb_row * lst_yv12->uv_stride * 8;
   int intrapenalty = 256;
-  int neutral_count = 0;
-  int new_mv_count = 0;
-  int sum_in_vectors = 0;
   uint32_t lastmv_as_int = 0;
-
+  int_mv best_ref_mv;
   int_mv zero_ref_mv;
 
+#if CONFIG_MULTITHREAD
+  const int nsync = cpi->mt_sync_range;
+  vpx_atomic_int rightmost_col = VPX_ATOMIC_INIT(cm->mb_cols + nsync);
+  const vpx_atomic_int *last_row_current_mb_col;
+  vpx_atomic_int *current_mb_col = NULL;
+
+  if (vpx_atomic_load_acquire(&cpi->b_multi_threaded) != 0) {
+    current_mb_col = &cpi->mt_current_mb_col[mb_row];
+  }
+  if (vpx_atomic_load_acquire(&cpi->b_multi_threaded) != 0 && mb_row != 0) {
+    last_row_current_mb_col = &cpi->mt_current_mb_col[mb_row - 1];
+  } else {
+    last_row_current_mb_col = &rightmost_col;
+  }
+#endif
+
+  memset(stats, 0, sizeof(*stats));
+  best_ref_mv.as_int = 0;
   zero_ref_mv.as_int = 0;
 
+  x->src = *cpi->Source;
+  x->src.y_buffer += 16 * mb_row * x->src.y_stride;
+  x->src.u_buffer += 8 * mb_row * x->src.uv_stride;
+  x->src.v_buffer += 8 * mb_row * x->src.uv_stride;
+  xd->pre = *lst_yv12;
+  xd->dst = *new_yv12;
+
+  /* The mode info is only scratch space in the first pass. */
+  xd->mode_info_context = cm->mi + mb_row * cm->mode_info_stride;
+
+  /* reset above block coeffs */
+  xd->up_available = (mb_row != 0);
+
+  /* Set up limit values for motion vectors to prevent them extending
+   * outside the UMV borders
+   */
+  x->mv_row_min = -((mb_row * 16) + (VP8BORDERINPIXELS - 16));
+  x->mv_row_max = ((cm->mb_rows - 1 - mb_row) * 16) + (VP8BORDERINPIXELS - 16);
+
+  /* for each macroblock col in image */
+  for (mb_col = 0; mb_col < cm->mb_cols; ++mb_col) {
+    int this_error;
+    int gf_motion_error = INT_MAX;
+    int use_dc_pred = (mb_col || mb_row) && (!mb_col || !mb_row);
+
+#if CONFIG_MULTITHREAD
+    if (current_mb_col != NULL) {
+      if (((mb_col - 1) % nsync) == 0) {
+        vpx_atomic_store_release(current_mb_col, mb_col - 1);
+      }
+
+      if (mb_row && !(mb_col & (nsync - 1))) {
+        vp8_atomic_spin_wait(mb_col, last_row_current_mb_col, nsync);
+      }
+    }
+#endif
+
+    xd->dst.y_buffer = new_yv12->y_buffer + recon_yoffset;
+    xd->dst.u_buffer = new_yv12->u_buffer + recon_uvoffset;
+    xd->dst.v_buffer = new_yv12->v_buffer + recon_uvoffset;
+    xd->left_available = (mb_col != 0);
+
+    /* Copy current mb to a buffer */
+    vp8_copy_mem16x16(x->src.y_buffer, x->src.y_stride, x->thismb, 16);
+
+    /* do intra 16x16 prediction */
+    this_error = vp8_encode_intra(x, use_dc_pred);
+
+    /* "intrapenalty" below deals with situations where the intra
+     * and inter error scores are very low (eg a plain black frame)
+     * We do not have special cases in first pass for 0,0 and
+     * nearest etc so all inter modes carry an overhead cost
+     * estimate fot the mv. When the error score is very low this
+     * causes us to pick all or lots of INTRA modes and throw lots
+     * of key frames. This penalty adds a cost matching that of a
+     * 0,0 mv to the intra case.
+     */
+    this_error += intrapenalty;
+
+    /* Cumulative intra error total */
+    stats->intra_error += (int64_t)this_error;
+
+    /* Set up limit values for motion vectors to prevent them
+     * extending outside the UMV borders
+     */
+    x->mv_col_min = -((mb_col * 16) + (VP8BORDERINPIXELS - 16));
+    x->mv_col_max =
+        ((cm->mb_cols - 1 - mb_col) * 16) + (VP8BORDERINPIXELS - 16);
+
+    /* Other than for the first frame do a motion search */
+    if (cm->current_video_frame > 0) {
+      BLOCKD *d = &x->e_mbd.block[0];
+      MV tmp_mv = { 0, 0 };
+      int tmp_err;
+      int motion_error = INT_MAX;
+      int raw_motion_error = INT_MAX;
+
+      /* Simple 0,0 motion with no mv overhead */
+      zz_motion_search(x, cpi->last_frame_unscaled_source, &raw_motion_error,
+                       lst_yv12, &motion_error, recon_yoffset);
+      d->bmi.mv.as_mv.row = 0;
+      d->bmi.mv.as_mv.col = 0;
+
+      if (raw_motion_error < cpi->oxcf.encode_breakout) {
+        goto skip_motion_search;
+      }
+
+      /* Test last reference frame using the previous best mv as the
+       * starting point (best reference) for the search
+       */
+      first_pass_motion_search(cpi, x, &best_ref_mv, &d->bmi.mv.as_mv,
+                               lst_yv12, &motion_error, recon_yoffset);
+
+      /* If the current best reference mv is not centred on 0,0
+       * then do a 0,0 based search as well
+       */
+      if (best_ref_mv.as_int) {
+        tmp_err = INT_MAX;
+        first_pass_motion_search(cpi, x, &zero_ref_mv, &tmp_mv, lst_yv12,
+                                 &tmp_err, recon_yoffset);
+
+        if (tmp_err < motion_error) {
+          motion_error = tmp_err;
+          d->bmi.mv.as_mv.row = tmp_mv.row;
+          d->bmi.mv.as_mv.col = tmp_mv.col;
+        }
+      }
+
+      /* Experimental search in a second reference frame ((0,0)
+       * based only)
+       */
+      if (cm->current_video_frame > 1) {
+        first_pass_motion_search(cpi, x, &zero_ref_mv, &tmp_mv, gld_yv12,
+                                 &gf_motion_error, recon_yoffset);
+
+        if ((gf_motion_error < motion_error) &&
+            (gf_motion_error < this_error)) {
+          stats->second_ref_count++;
+        }
+
+        /* Reset to last frame as reference buffer */
+        xd->pre.y_buffer = lst_yv12->y_buffer + recon_yoffset;
+        xd->pre.u_buffer = lst_yv12->u_buffer + recon_uvoffset;
+        xd->pre.v_buffer = lst_yv12->v_buffer + recon_uvoffset;
+      }
+
+    skip_motion_search:
+      /* Intra assumed best */
+      best_ref_mv.as_int = 0;
+
+      if (motion_error <= this_error) {
+        /* Keep a count of cases where the inter and intra were
+         * very close and very low. This helps with scene cut
+         * detection for example in cropped clips with black bars
+         * at the sides or top and bottom.
+         */
+        if ((((this_error - intrapenalty) * 9) <= (motion_error * 10)) &&
+            (this_error < (2 * intrapenalty))) {
+          stats->neutral_count++;
+        }
+
+        d->bmi.mv.as_mv.row *= 8;
+        d->bmi.mv.as_mv.col *= 8;
+        this_error = motion_error;
+        vp8_set_mbmode_and_mvs(x, NEWMV, &d->bmi.mv);
+        vp8_encode_inter16x16y(x);
+        stats->sum_mvr += d->bmi.mv.as_mv.row;
+        stats->sum_mvr_abs += abs(d->bmi.mv.as_mv.row);
+        stats->sum_mvc += d->bmi.mv.as_mv.col;
+        stats->sum_mvc_abs += abs(d->bmi.mv.as_mv.col);
+        stats->sum_mvrs += d->bmi.mv.as_mv.row * d->bmi.mv.as_mv.row;
+        stats->sum_mvcs += d->bmi.mv.as_mv.col * d->bmi.mv.as_mv.col;
+        stats->intercount++;
+
+        best_ref_mv.as_int = d->bmi.mv.as_int;
+
+        /* Was the vector non-zero */
+        if (d->bmi.mv.as_int) {
+          if (!stats->mvcount) stats->first_mv = d->bmi.mv.as_int;
+          stats->mvcount++;
+
+          /* Was it different from the last non zero vector */
+          if (d->bmi.mv.as_int != lastmv_as_int) stats->new_mv_count++;
+          lastmv_as_int = d->bmi.mv.as_int;
+
+          /* Does the Row vector point inwards or outwards */
+          if (mb_row < cm->mb_rows / 2) {
+            if (d->bmi.mv.as_mv.row > 0) {
+              stats->sum_in_vectors--;
+            } else if (d->bmi.mv.as_mv.row < 0) {
+              stats->sum_in_vectors++;
+            }
+          } else if (mb_row > cm->mb_rows / 2) {
+            if (d->bmi.mv.as_mv.row > 0) {
+              stats->sum_in_vectors++;
+            } else if (d->bmi.mv.as_mv.row < 0) {
+              stats->sum_in_vectors--;
+            }
+          }
+
+          /* Does the Row vector point inwards or outwards */
+          if (mb_col < cm->mb_cols / 2) {
+            if (d->bmi.mv.as_mv.col > 0) {
+              stats->sum_in_vectors--;
+            } else if (d->bmi.mv.as_mv.col < 0) {
+              stats->sum_in_vectors++;
+            }
+          } else if (mb_col > cm->mb_cols / 2) {
+            if (d->bmi.mv.as_mv.col > 0) {
+              stats->sum_in_vectors++;
+            } else if (d->bmi.mv.as_mv.col < 0) {
+              stats->sum_in_vectors--;
+            }
+          }
+        }
+      }
+    }
+
+    stats->coded_error += (int64_t)this_error;
+
+    /* adjust to the next column of macroblocks */
+    x->src.y_buffer += 16;
+    x->src.u_buffer += 8;
+    x->src.v_buffer += 8;
+
+    recon_yoffset += 16;
+    recon_uvoffset += 8;
+  }
+
+  stats->last_mv = lastmv_as_int;
+
+  /* extend the recon for intra prediction */
+  vp8_extend_mb_row(new_yv12, xd->dst.y_buffer + 16, xd->dst.u_buffer + 8,
+                    xd->dst.v_buffer + 8);
+
+#if CONFIG_MULTITHREAD
+  if (current_mb_col != NULL) {
+    vpx_atomic_store_release(current_mb_col,
+                             vpx_atomic_load_acquire(&rightmost_col));
+  }
+#endif
+
+  vpx_clear_system_state();
+}
+
+/* Adds the statistics of the next row in raster order to |total|. */
+static void accumulate_row_stats(FIRSTPASS_ROW_STATS *total,
+                                 const FIRSTPASS_ROW_STATS *row) {
+  total->intra_error += row->intra_error;
+  total->coded_error += row->coded_error;
+  total->sum_mvr += row->sum_mvr;
+  total->sum_mvc += row->sum_mvc;
+  total->sum_mvr_abs += row->sum_mvr_abs;
+  total->sum_mvc_abs += row->sum_mvc_abs;
+  total->sum_mvrs += row->sum_mvrs;
+  total->sum_mvcs += row->sum_mvcs;
+  total->intercount += row->intercount;
+  total->second_ref_count += row->second_ref_count;
+  total->neutral_count += row->neutral_count;
+  total->sum_in_vectors += row->sum_in_vectors;
+
+  if (row->mvcount) {
+    /* The first vector of the row is only new if it differs from the last
+     * non-zero vector of the rows above. */
+    total->new_mv_count += row->new_mv_count;
+    if (total->mvcount && row->first_mv == total->last_mv) {
+      total->new_mv_count--;
+    }
+    total->mvcount += row->mvcount;
+    total->last_mv = row->last_mv;
+  }
+}
+
+#if CONFIG_MULTITHREAD
+static void first_pass_job(VP8_COMP *cpi, void *data, int thread) {
+  MACROBLOCK *const x = thread ? &cpi->mb_row_ei[thread - 1].mb : &cpi->mb;
+  int mb_row;
+  (void)data;
+
+  for (mb_row = thread; mb_row < cpi->common.mb_rows;
+       mb_row += cpi->encoding_thread_count + 1) {
+    first_pass_mb_row(cpi, x, mb_row, &cpi->mt_fp_row_stats[mb_row]);
+  }
+}
+#endif
+
+void vp8_first_pass(VP8_COMP *cpi) {
+  int mb_row;
+  MACROBLOCK *const x = &cpi->mb;
+  VP8_COMMON *const cm = &cpi->common;
+  MACROBLOCKD *const xd = &x->e_mbd;
+
+  YV12_BUFFER_CONFIG *lst_yv12 = &cm->yv12_fb[cm->lst_fb_idx];
+  YV12_BUFFER_CONFIG *new_yv12 = &cm->yv12_fb[cm->new_fb_idx];
+  YV12_BUFFER_CONFIG *gld_yv12 = &cm->yv12_fb[cm->gld_fb_idx];
+  FIRSTPASS_ROW_STATS total;
+
+  memset(&total, 0, sizeof(total));
+
   vpx_clear_system_state();
 
   x->src = *cpi->Source;
@@ -534,210 +819,37 @@ void vp8_first_pass(VP8_COMP *cpi) {
                                    (const MV_CONTEXT *)cm->fc.mvc, flag);
   }
 
-  /* for each macroblock row in image */
-  for (mb_row = 0; mb_row < cm->mb_rows; ++mb_row) {
-    int_mv best_ref_mv;
-
-    best_ref_mv.as_int = 0;
-
-    /* reset above block coeffs */
-    xd->up_available = (mb_row != 0);
-    recon_yoffset = (mb_row * recon_y_stride * 16);
-    recon_uvoffset = (mb_row * recon_uv_stride * 8);
-
-    /* Set up limit values for motion vectors to prevent them extending
-     * outside the UMV borders
-     */
-    x->mv_row_min = -((mb_row * 16) + (VP8BORDERINPIXELS - 16));
-    x->mv_row_max =
-        ((cm->mb_rows - 1 - mb_row) * 16) + (VP8BORDERINPIXELS - 16);
-
-    /* for each macroblock col in image */
-    for (mb_col = 0; mb_col < cm->mb_cols; ++mb_col) {
-      int this_error;
-      int gf_motion_error = INT_MAX;
-      int use_dc_pred = (mb_col || mb_row) && (!mb_col || !mb_row);
-
-      xd->dst.y_buffer = new_yv12->y_buffer + recon_yoffset;
-      xd->dst.u_buffer = new_yv12->u_buffer + recon_uvoffset;
-      xd->dst.v_buffer = new_yv12->v_buffer + recon_uvoffset;
-      xd->left_available = (mb_col != 0);
-
-      /* Copy current mb to a buffer */
-      vp8_copy_mem16x16(x->src.y_buffer, x->src.y_stride, x->thismb, 16);
-
-      /* do intra 16x16 prediction */
-      this_error = vp8_encode_intra(x, use_dc_pred);
-
-      /* "intrapenalty" below deals with situations where the intra
-       * and inter error scores are very low (eg a plain black frame)
-       * We do not have special cases in first pass for 0,0 and
-       * nearest etc so all inter modes carry an overhead cost
-       * estimate fot the mv. When the error score is very low this
-       * causes us to pick all or lots of INTRA modes and throw lots
-       * of key frames. This penalty adds a cost matching that of a
-       * 0,0 mv to the intra case.
-       */
-      this_error += intrapenalty;
-
-      /* Cumulative intra error total */
-      intra_error += (int64_t)this_error;
-
-      /* Set up limit values for motion vectors to prevent them
-       * extending outside the UMV borders
-       */
-      x->mv_col_min = -((mb_col * 16) + (VP8BORDERINPIXELS - 16));
-      x->mv_col_max =
-          ((cm->mb_cols - 1 - mb_col) * 16) + (VP8BORDERINPIXELS - 16);
-
-      /* Other than for the first frame do a motion search */
-      if (cm->current_video_frame > 0) {
-        BLOCKD *d = &x->e_mbd.block[0];
-        MV tmp_mv = { 0, 0 };
-        int tmp_err;
-        int motion_error = INT_MAX;
-        int raw_motion_error = INT_MAX;
-
-        /* Simple 0,0 motion with no mv overhead */
-        zz_motion_search(x, cpi->last_frame_unscaled_source, &raw_motion_error,
-                         lst_yv12, &motion_error, recon_yoffset);
-        d->bmi.mv.as_mv.row = 0;
-        d->bmi.mv.as_mv.col = 0;
-
-        if (raw_motion_error < cpi->oxcf.encode_breakout) {
-          goto skip_motion_search;
-        }
-
-        /* Test last reference frame using the previous best mv as the
-         * starting point (best reference) for the search
-         */
-        first_pass_motion_search(cpi, x, &best_ref_mv, &d->bmi.mv.as_mv,
-                                 lst_yv12, &motion_error, recon_yoffset);
-
-        /* If the current best reference mv is not centred on 0,0
-         * then do a 0,0 based search as well
-         */
-        if (best_ref_mv.as_int) {
-          tmp_err = INT_MAX;
-          first_pass_motion_search(cpi, x, &zero_ref_mv, &tmp_mv, lst_yv12,
-                                   &tmp_err, recon_yoffset);
-
-          if (tmp_err < motion_error) {
-            motion_error = tmp_err;
-            d->bmi.mv.as_mv.row = tmp_mv.row;
-            d->bmi.mv.as_mv.col = tmp_mv.col;
-          }
-        }
-
-        /* Experimental search in a second reference frame ((0,0)
-         * based only)
-         */
-        if (cm->current_video_frame > 1) {
-          first_pass_motion_search(cpi, x, &zero_ref_mv, &tmp_mv, gld_yv12,
-                                   &gf_motion_error, recon_yoffset);
-
-          if ((gf_motion_error < motion_error) &&
-              (gf_motion_error < this_error)) {
-            second_ref_count++;
-          }
-
-          /* Reset to last frame as reference buffer */
-          xd->pre.y_buffer = lst_yv12->y_buffer + recon_yoffset;
-          xd->pre.u_buffer = lst_yv12->u_buffer + recon_uvoffset;
-          xd->pre.v_buffer = lst_yv12->v_buffer + recon_uvoffset;
-        }
-
-      skip_motion_search:
-        /* Intra assumed best */
-        best_ref_mv.as_int = 0;
-
-        if (motion_error <= this_error) {
-          /* Keep a count of cases where the inter and intra were
-           * very close and very low. This helps with scene cut
-           * detection for example in cropped clips with black bars
-           * at the sides or top and bottom.
-           */
-          if ((((this_error - intrapenalty) * 9) <= (motion_error * 10)) &&
-              (this_error < (2 * intrapenalty))) {
-            neutral_count++;
-          }
-
-          d->bmi.mv.as_mv.row *= 8;
-          d->bmi.mv.as_mv.col *= 8;
-          this_error = motion_error;
-          vp8_set_mbmode_and_mvs(x, NEWMV, &d->bmi.mv);
-          vp8_encode_inter16x16y(x);
-          sum_mvr += d->bmi.mv.as_mv.row;
-          sum_mvr_abs += abs(d->bmi.mv.as_mv.row);
-          sum_mvc += d->bmi.mv.as_mv.col;
-          sum_mvc_abs += abs(d->bmi.mv.as_mv.col);
-          sum_mvrs += d->bmi.mv.as_mv.row * d->bmi.mv.as_mv.row;
-          sum_mvcs += d->bmi.mv.as_mv.col * d->bmi.mv.as_mv.col;
-          intercount++;
-
-          best_ref_mv.as_int = d->bmi.mv.as_int;
-
-          /* Was the vector non-zero */
-          if (d->bmi.mv.as_int) {
-            mvcount++;
-
-            /* Was it different from the last non zero vector */
-            if (d->bmi.mv.as_int != lastmv_as_int) new_mv_count++;
-            lastmv_as_int = d->bmi.mv.as_int;
-
-            /* Does the Row vector point inwards or outwards */
-            if (mb_row < cm->mb_rows / 2) {
-              if (d->bmi.mv.as_mv.row > 0) {
-                sum_in_vectors--;
-              } else if (d->bmi.mv.as_mv.row < 0) {
-                sum_in_vectors++;
-              }
-            } else if (mb_row > cm->mb_rows / 2) {
-              if (d->bmi.mv.as_mv.row > 0) {
-                sum_in_vectors++;
-              } else if (d->bmi.mv.as_mv.row < 0) {
-                sum_in_vectors--;
-              }
-            }
+#if CONFIG_MULTITHREAD
+  if (vpx_atomic_load_acquire(&cpi->b_multi_threaded)) {
+    /* Rows are processed in a wavefront as the intra prediction reads the
+     * reconstruction of the row above. */
+    int i;
 
-            /* Does the Row vector point inwards or outwards */
-            if (mb_col < cm->mb_cols / 2) {
-              if (d->bmi.mv.as_mv.col > 0) {
-                sum_in_vectors--;
-              } else if (d->bmi.mv.as_mv.col < 0) {
-                sum_in_vectors++;
-              }
-            } else if (mb_col > cm->mb_cols / 2) {
-              if (d->bmi.mv.as_mv.col > 0) {
-                sum_in_vectors++;
-              } else if (d->bmi.mv.as_mv.col < 0) {
-                sum_in_vectors--;
-              }
-            }
-          }
-        }
-      }
+    vp8cx_init_mbrthread_data(cpi, x, cpi->mb_row_ei,
+                              cpi->encoding_thread_count);
+    for (i = 0; i < cpi->encoding_thread_count; ++i) {
+      MACROBLOCK *const mb = &cpi->mb_row_ei[i].mb;
+      mb->e_mbd.mode_info_context = xd->mode_info_context;
+      vp8cx_mb_init_quantizer(cpi, mb, 0);
+    }
 
-      coded_error += (int64_t)this_error;
+    for (mb_row = 0; mb_row < cm->mb_rows; ++mb_row)
+      vpx_atomic_store_release(&cpi->mt_current_mb_col[mb_row], -1);
 
-      /* adjust to the next column of macroblocks */
-      x->src.y_buffer += 16;
-      x->src.u_buffer += 8;
-      x->src.v_buffer += 8;
+    vp8cx_run_mt_job(cpi, first_pass_job, NULL,
+                     VPXMIN(cpi->encoding_thread_count, cm->mb_rows - 1));
 
-      recon_yoffset += 16;
-      recon_uvoffset += 8;
+    for (mb_row = 0; mb_row < cm->mb_rows; ++mb_row)
+      accumulate_row_stats(&total, &cpi->mt_fp_row_stats[mb_row]);
+  } else
+#endif
+  {
+    /* for each macroblock row in image */
+    for (mb_row = 0; mb_row < cm->mb_rows; ++mb_row) {
+      FIRSTPASS_ROW_STATS row_stats;
+      first_pass_mb_row(cpi, x, mb_row, &row_stats);
+      accumulate_row_stats(&total, &row_stats);
     }
-
-    /* adjust to the next row of mbs */
-    x->src.y_buffer += 16 * x->src.y_stride - 16 * cm->mb_cols;
-    x->src.u_buffer += 8 * x->src.uv_stride - 8 * cm->mb_cols;
-    x->src.v_buffer += 8 * x->src.uv_stride - 8 * cm->mb_cols;
-
-    /* extend the recon for intra prediction */
-    vp8_extend_mb_row(new_yv12, xd->dst.y_buffer + 16, xd->dst.u_buffer + 8,
-                      xd->dst.v_buffer + 8);
-    vpx_clear_system_state();
   }
 
   vpx_clear_system_state();
@@ -747,8 +859,8 @@ void vp8_first_pass(VP8_COMP *cpi) {
     FIRSTPASS_STATS fps;
 
     fps.frame = cm->current_video_frame;
-    fps.intra_error = (double)(intra_error >> 8);
-    fps.coded_error = (double)(coded_error >> 8);
+    fps.intra_error = (double)(total.intra_error >> 8);
+    fps.coded_error = (double)(total.coded_error >> 8);
     weight = simple_weight(cpi->Source);
 
     if (weight < 0.1) weight = 0.1;
@@ -767,23 +879,25 @@ void vp8_first_pass(VP8_COMP *cpi) {
     fps.new_mv_count = 0.0;
     fps.count = 1.0;
 
-    fps.pcnt_inter = 1.0 * (double)intercount / cm->MBs;
-    fps.pcnt_second_ref = 1.0 * (double)second_ref_count / cm->MBs;
-    fps.pcnt_neutral = 1.0 * (double)neutral_count / cm->MBs;
-
-    if (mvcount > 0) {
-      fps.MVr = (double)sum_mvr / (double)mvcount;
-      fps.mvr_abs = (double)sum_mvr_abs / (double)mvcount;
-      fps.MVc = (double)sum_mvc / (double)mvcount;
-      fps.mvc_abs = (double)sum_mvc_abs / (double)mvcount;
-      fps.MVrv = ((double)sum_mvrs - (fps.MVr * fps.MVr / (double)mvcount)) /
-                 (double)mvcount;
-      fps.MVcv = ((double)sum_mvcs - (fps.MVc * fps.MVc / (double)mvcount)) /
-                 (double)mvcount;
-      fps.mv_in_out_count = (double)sum_in_vectors / (double)(mvcount * 2);
-      fps.new_mv_count = new_mv_count;
-
-      fps.pcnt_motion = 1.0 * (double)mvcount / cpi->common.MBs;
+    fps.pcnt_inter = 1.0 * (double)total.intercount / cm->MBs;
+    fps.pcnt_second_ref = 1.0 * (double)total.second_ref_count / cm->MBs;
+    fps.pcnt_neutral = 1.0 * (double)total.neutral_count / cm->MBs;
+
+    if (total.mvcount > 0) {
+      const double mvcount = (double)total.mvcount;
+      fps.MVr = (double)total.sum_mvr / mvcount;
+      fps.mvr_abs = (double)total.sum_mvr_abs / mvcount;
+      fps.MVc = (double)total.sum_mvc / mvcount;
+      fps.mvc_abs = (double)total.sum_mvc_abs / mvcount;
+      fps.MVrv =
+          ((double)total.sum_mvrs - (fps.MVr * fps.MVr / mvcount)) / mvcount;
+      fps.MVcv =
+          ((double)total.sum_mvcs - (fps.MVc * fps.MVc / mvcount)) / mvcount;
+      fps.mv_in_out_count =
+          (double)total.sum_in_vectors / (double)(total.mvcount * 2);
+      fps.new_mv_count = total.new_mv_count;
+
+      fps.pcnt_motion = 1.0 * mvcount / cpi->common.MBs;
     }
 
     /* TODO:  handle the case when duration is set to 0, or something less
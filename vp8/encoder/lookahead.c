@@ -9,9 +9,11 @@
  */
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 #include "vpx_config.h"
 #include "lookahead.h"
 #include "vp8/common/extend.h"
+#include "vpx_dsp/vpx_dsp_common.h"
 
 #define MAX_LAG_BUFFERS (CONFIG_REALTIME_ONLY ? 1 : 25)
 
@@ -21,6 +23,9 @@ struct lookahead_ctx {
   unsigned int read_idx;       /* Read index */
   unsigned int write_idx;      /* Write index */
   struct lookahead_entry *buf; /* Buffer list */
+  int mb_rows;                 /* Size of the stale maps */
+  int mb_cols;
+  int64_t copied_pixels; /* Luma pixels copied by the last push */
 };
 
 /* Return the buffer at the given absolute index and increment the index */
@@ -42,6 +47,7 @@ void vp8_lookahead_destroy(struct lookahead_ctx *ctx) {
 
       for (i = 0; i < ctx->max_sz; ++i) {
         vp8_yv12_de_alloc_frame_buffer(&ctx->buf[i].img);
+        free(ctx->buf[i].stale_map);
       }
       free(ctx->buf);
     }
@@ -73,6 +79,8 @@ struct lookahead_ctx *vp8_lookahead_init(unsigned int width,
   ctx = calloc(1, sizeof(*ctx));
   if (ctx) {
     ctx->max_sz = depth;
+    ctx->mb_rows = height >> 4;
+    ctx->mb_cols = width >> 4;
     ctx->buf = calloc(depth, sizeof(*ctx->buf));
     if (!ctx->buf) goto bail;
     for (i = 0; i < depth; ++i) {
@@ -80,6 +88,9 @@ struct lookahead_ctx *vp8_lookahead_init(unsigned int width,
                                       VP8BORDERINPIXELS)) {
         goto bail;
       }
+      ctx->buf[i].stale_map = calloc(ctx->mb_rows * ctx->mb_cols, 1);
+      if (!ctx->buf[i].stale_map) goto bail;
+      ctx->buf[i].all_stale = 1;
     }
   }
   return ctx;
@@ -88,56 +99,93 @@ bail:
   return NULL;
 }
 
+/* Copy the runs of stale macroblocks of each macroblock row, and return the
+ * number of luma pixels copied.
+ */
+static int64_t copy_stale_macroblocks(const struct lookahead_ctx *ctx,
+                                      YV12_BUFFER_CONFIG *src,
+                                      YV12_BUFFER_CONFIG *dst,
+                                      const unsigned char *stale_map) {
+  int64_t copied_pixels = 0;
+  int row, col, stale_end;
+
+  for (row = 0; row < ctx->mb_rows; ++row) {
+    const int y = row << 4;
+    const int h = VPXMIN(16, src->y_height - y);
+    col = 0;
+
+    while (1) {
+      int x, w;
+
+      /* Find the first stale macroblock in this row. */
+      for (; col < ctx->mb_cols; ++col) {
+        if (stale_map[col]) break;
+      }
+
+      /* No more stale macroblock in this row. */
+      if (col == ctx->mb_cols) break;
+
+      /* Find the end of stale region in this row. */
+      for (stale_end = col; stale_end < ctx->mb_cols; ++stale_end) {
+        if (!stale_map[stale_end]) break;
+      }
+
+      /* Only copy this stale region. */
+      x = col << 4;
+      w = VPXMIN(stale_end << 4, src->y_width) - x;
+      vp8_copy_and_extend_frame_with_rect(src, dst, y, x, h, w);
+      copied_pixels += w * h;
+
+      /* Start again from the end of this stale region. */
+      col = stale_end;
+    }
+
+    stale_map += ctx->mb_cols;
+  }
+  return copied_pixels;
+}
+
 int vp8_lookahead_push(struct lookahead_ctx *ctx, YV12_BUFFER_CONFIG *src,
                        int64_t ts_start, int64_t ts_end, unsigned int flags,
-                       unsigned char *active_map) {
+                       const unsigned char *dirty_map) {
   struct lookahead_entry *buf;
-  int row, col, active_end;
-  int mb_rows = (src->y_height + 15) >> 4;
-  int mb_cols = (src->y_width + 15) >> 4;
+  const int num_mbs = ctx->mb_rows * ctx->mb_cols;
+  unsigned int i;
+  int j;
 
   if (ctx->sz + 2 > ctx->max_sz) return 1;
   ctx->sz++;
   buf = pop(ctx, &ctx->write_idx);
 
-  /* Only do this partial copy if the following conditions are all met:
-   * 1. Lookahead queue has has size of 1.
-   * 2. Active map is provided.
-   * 3. This is not a key frame, golden nor altref frame.
-   */
-  if (ctx->max_sz == 1 && active_map && !flags) {
-    for (row = 0; row < mb_rows; ++row) {
-      col = 0;
-
-      while (1) {
-        /* Find the first active macroblock in this row. */
-        for (; col < mb_cols; ++col) {
-          if (active_map[col]) break;
-        }
-
-        /* No more active macroblock in this row. */
-        if (col == mb_cols) break;
-
-        /* Find the end of active region in this row. */
-        active_end = col;
-
-        for (; active_end < mb_cols; ++active_end) {
-          if (!active_map[active_end]) break;
-        }
-
-        /* Only copy this active region. */
-        vp8_copy_and_extend_frame_with_rect(src, &buf->img, row << 4, col << 4,
-                                            16, (active_end - col) << 4);
-
-        /* Start again from the end of this active region. */
-        col = active_end;
-      }
+  /* The dirty map only applies to frames of the size of the stale maps. */
+  if (((src->y_height + 15) >> 4) != ctx->mb_rows ||
+      ((src->y_width + 15) >> 4) != ctx->mb_cols) {
+    dirty_map = NULL;
+  }
 
-      active_map += mb_cols;
+  /* The other buffers now hold older frames than this one. */
+  for (i = 0; i < ctx->max_sz; ++i) {
+    struct lookahead_entry *const entry = &ctx->buf[i];
+    if (entry == buf || entry->all_stale) continue;
+    if (dirty_map == NULL) {
+      entry->all_stale = 1;
+    } else {
+      for (j = 0; j < num_mbs; ++j) entry->stale_map[j] |= dirty_map[j];
     }
+  }
+
+  /* Only copy the macroblocks that changed since the frame in the buffer. */
+  if (dirty_map != NULL && !buf->all_stale) {
+    for (j = 0; j < num_mbs; ++j) buf->stale_map[j] |= dirty_map[j];
+    ctx->copied_pixels =
+        copy_stale_macroblocks(ctx, src, &buf->img, buf->stale_map);
   } else {
     vp8_copy_and_extend_frame(src, &buf->img);
+    ctx->copied_pixels = (int64_t)src->y_width * src->y_height;
   }
+  memset(buf->stale_map, 0, num_mbs);
+  buf->all_stale = 0;
+
   buf->ts_start = ts_start;
   buf->ts_end = ts_end;
   buf->flags = flags;
@@ -182,3 +230,7 @@ struct lookahead_entry *vp8_lookahead_peek(struct lookahead_ctx *ctx,
 }
 
 unsigned int vp8_lookahead_depth(struct lookahead_ctx *ctx) { return ctx->sz; }
+
+int64_t vp8_lookahead_copied_pixels(const struct lookahead_ctx *ctx) {
+  return ctx->copied_pixels;
+}
@@ -21,6 +21,11 @@ struct lookahead_entry {
   int64_t ts_start;
   int64_t ts_end;
   unsigned int flags;
+  /* 1 for each macroblock of img that may differ from the last frame pushed,
+   * unless all_stale is set.
+   */
+  unsigned char *stale_map;
+  int all_stale;
 };
 
 struct lookahead_ctx;
@@ -46,19 +51,26 @@ void vp8_lookahead_destroy(struct lookahead_ctx *ctx);
  * This function will copy the source image into a new framebuffer with
  * the expected stride/border.
  *
- * If active_map is non-NULL and there is only one frame in the queue, then copy
- * only active macroblocks.
+ * If dirty_map is non-NULL, only the macroblocks it marks and the macroblocks
+ * in which the framebuffer is older than the last frame pushed are copied.
  *
  * \param[in] ctx         Pointer to the lookahead context
  * \param[in] src         Pointer to the image to enqueue
  * \param[in] ts_start    Timestamp for the start of this frame
  * \param[in] ts_end      Timestamp for the end of this frame
  * \param[in] flags       Flags set on this frame
- * \param[in] active_map  Map that specifies which macroblock is active
+ * \param[in] dirty_map   Map that specifies which macroblock may differ from
+ *                        the last frame pushed
  */
 int vp8_lookahead_push(struct lookahead_ctx *ctx, YV12_BUFFER_CONFIG *src,
                        int64_t ts_start, int64_t ts_end, unsigned int flags,
-                       unsigned char *active_map);
+                       const unsigned char *dirty_map);
+
+/**\brief Get the number of luma pixels copied by the last push
+ *
+ * \param[in] ctx       Pointer to the lookahead context
+ */
+int64_t vp8_lookahead_copied_pixels(const struct lookahead_ctx *ctx);
 
 /**\brief Get the next source buffer to encode
  *
@@ -422,6 +422,14 @@ static void dealloc_compressor_data(VP8_COMP *cpi) {
 
   vpx_free(cpi->active_map);
   cpi->active_map = 0;
+  vpx_free(cpi->dirty_active_map);
+  cpi->dirty_active_map = 0;
+  vpx_free(cpi->dirty_rects);
+  cpi->dirty_rects = 0;
+  vpx_free(cpi->dirty_map);
+  cpi->dirty_map = 0;
+  vpx_free(cpi->dirty_stale_map);
+  cpi->dirty_stale_map = 0;
 
   vp8_de_alloc_frame_buffers(&cpi->common);
 
@@ -446,6 +454,8 @@ static void dealloc_compressor_data(VP8_COMP *cpi) {
 #if CONFIG_MULTITHREAD
   vpx_free(cpi->mt_current_mb_col);
   cpi->mt_current_mb_col = NULL;
+  vpx_free(cpi->mt_fp_row_stats);
+  cpi->mt_fp_row_stats = NULL;
 #endif
 }
 
@@ -1210,6 +1220,10 @@ void vp8_alloc_compressor_data(VP8_COMP *cpi) {
   CHECK_MEM_ERROR(cpi->active_map, vpx_calloc(cm->mb_rows * cm->mb_cols,
                                               sizeof(*cpi->active_map)));
   memset(cpi->active_map, 1, (cm->mb_rows * cm->mb_cols));
+  vpx_free(cpi->dirty_active_map);
+  CHECK_MEM_ERROR(cpi->dirty_active_map,
+                  vpx_calloc(cm->mb_rows * cm->mb_cols,
+                             sizeof(*cpi->dirty_active_map)));
 
 #if CONFIG_MULTITHREAD
   if (width < 640) {
@@ -1230,6 +1244,10 @@ void vp8_alloc_compressor_data(VP8_COMP *cpi) {
                     vpx_malloc(sizeof(*cpi->mt_current_mb_col) * cm->mb_rows));
     for (i = 0; i < cm->mb_rows; ++i)
       vpx_atomic_init(&cpi->mt_current_mb_col[i], 0);
+
+    vpx_free(cpi->mt_fp_row_stats);
+    CHECK_MEM_ERROR(cpi->mt_fp_row_stats,
+                    vpx_malloc(sizeof(*cpi->mt_fp_row_stats) * cm->mb_rows));
   }
 
 #endif
@@ -3194,6 +3212,33 @@ void vp8_loopfilter_frame(VP8_COMP *cpi, VP8_COMMON *cm) {
   vp8_yv12_extend_frame_borders(cm->frame_to_show);
 }
 
+/* Turn off the macroblocks outside of the dirty rectangles in the active map
+ * of the frame, when they can be copied from LAST.
+ */
+static void setup_frame_active_map(VP8_COMP *cpi) {
+  const VP8_COMMON *const cm = &cpi->common;
+  const int num_mbs = cm->mb_rows * cm->mb_cols;
+  int i;
+
+  cpi->frame_active_map = cpi->active_map;
+  cpi->frame_active_map_enabled = cpi->active_map_enabled;
+  cpi->dirty_rect_stats.num_skipped_blocks = 0;
+  if (!cpi->dirty_map_enabled || cm->frame_type == KEY_FRAME ||
+      !(cpi->ref_frame_flags & VP8_LAST_FRAME) || cm->horiz_scale != 0 ||
+      cm->vert_scale != 0 || cpi->dirty_mb_rows != cm->mb_rows ||
+      cpi->dirty_mb_cols != cm->mb_cols) {
+    return;
+  }
+
+  for (i = 0; i < num_mbs; ++i) {
+    cpi->dirty_active_map[i] =
+        cpi->dirty_map[i] && (!cpi->active_map_enabled || cpi->active_map[i]);
+    cpi->dirty_rect_stats.num_skipped_blocks += !cpi->dirty_active_map[i];
+  }
+  cpi->frame_active_map = cpi->dirty_active_map;
+  cpi->frame_active_map_enabled = 1;
+}
+
 static void encode_frame_to_data_rate(VP8_COMP *cpi, size_t *size,
                                       unsigned char *dest,
                                       unsigned char *dest_end,
@@ -3912,6 +3957,8 @@ static void encode_frame_to_data_rate(VP8_COMP *cpi, size_t *size,
       vp8_setup_key_frame(cpi);
     }
 
+    setup_frame_active_map(cpi);
+
 #if CONFIG_REALTIME_ONLY & CONFIG_ONTHEFLY_BITPACKING
     {
       if (cpi->oxcf.error_resilient_mode) cm->refresh_entropy_probs = 0;
@@ -4401,6 +4448,12 @@ static void encode_frame_to_data_rate(VP8_COMP *cpi, size_t *size,
 
   update_reference_frames(cpi);
 
+  /* LAST now holds the frame the next dirty rectangles are relative to. */
+  if (cm->refresh_last_frame && cpi->dirty_stale_map != NULL) {
+    memset(cpi->dirty_stale_map, 0, cpi->dirty_mb_rows * cpi->dirty_mb_cols);
+    cpi->dirty_all_stale = 0;
+  }
+
 #ifdef OUTPUT_YUV_DENOISED
   vpx_write_yuv_frame(yuv_denoised_file,
                       &cpi->denoiser.yv12_running_avg[INTRA_FRAME]);
@@ -4766,11 +4819,93 @@ static void Pass2Encode(VP8_COMP *cpi, size_t *size, unsigned char *dest,
 }
 #endif
 
+/* Build the map of the macroblocks of sd in the pending dirty rectangles, and
+ * return it, or NULL if the whole frame is dirty.
+ */
+static const unsigned char *setup_dirty_map(VP8_COMP *cpi,
+                                            const YV12_BUFFER_CONFIG *sd) {
+  const int width = sd->y_width;
+  const int height = sd->y_height;
+  const int mb_rows = (height + 15) >> 4;
+  const int mb_cols = (width + 15) >> 4;
+  const int pending = cpi->dirty_rects_pending;
+  int i, r;
+
+  cpi->dirty_rects_pending = 0;
+  cpi->dirty_map_enabled = 0;
+  cpi->dirty_rect_stats.num_blocks = mb_rows * mb_cols;
+  cpi->dirty_rect_stats.num_skipped_blocks = 0;
+  cpi->dirty_rect_stats.num_pixels = (uint64_t)width * height;
+  cpi->dirty_rect_stats.num_copied_pixels = cpi->dirty_rect_stats.num_pixels;
+
+  if (mb_rows != cpi->dirty_mb_rows || mb_cols != cpi->dirty_mb_cols) {
+    vpx_free(cpi->dirty_map);
+    cpi->dirty_map = NULL;
+    vpx_free(cpi->dirty_stale_map);
+    cpi->dirty_stale_map = NULL;
+    cpi->dirty_mb_rows = 0;
+    cpi->dirty_mb_cols = 0;
+    /* The frame is received outside of the error handling of the encoder, so
+     * it is copied whole if the maps cannot be allocated.
+     */
+    cpi->dirty_map = vpx_calloc(mb_rows * mb_cols, 1);
+    cpi->dirty_stale_map = vpx_calloc(mb_rows * mb_cols, 1);
+    if (cpi->dirty_map == NULL || cpi->dirty_stale_map == NULL) {
+      vpx_free(cpi->dirty_map);
+      cpi->dirty_map = NULL;
+      vpx_free(cpi->dirty_stale_map);
+      cpi->dirty_stale_map = NULL;
+      return NULL;
+    }
+    cpi->dirty_mb_rows = mb_rows;
+    cpi->dirty_mb_cols = mb_cols;
+    cpi->dirty_all_stale = 1;
+  }
+
+  if (!pending || cpi->oxcf.lag_in_frames > 0) {
+    cpi->dirty_all_stale = 1;
+    return NULL;
+  }
+
+  memset(cpi->dirty_map, 0, mb_rows * mb_cols);
+  for (i = 0; i < cpi->num_dirty_rects; ++i) {
+    const vpx_dirty_rect_t *const rect = &cpi->dirty_rects[i];
+    int col_start, col_end, row_start, row_end;
+    if (rect->w == 0 || rect->h == 0 || rect->x >= (unsigned int)width ||
+        rect->y >= (unsigned int)height) {
+      continue;
+    }
+    col_start = (int)rect->x >> 4;
+    row_start = (int)rect->y >> 4;
+    col_end = (int)(rect->x + VPXMIN(rect->w, width - rect->x) - 1) >> 4;
+    row_end = (int)(rect->y + VPXMIN(rect->h, height - rect->y) - 1) >> 4;
+    for (r = row_start; r <= row_end; ++r) {
+      memset(cpi->dirty_map + r * mb_cols + col_start, 1,
+             col_end - col_start + 1);
+    }
+  }
+  return cpi->dirty_map;
+}
+
+/* Add to the dirty map of the frame received the macroblocks that changed
+ * since the frame in LAST.
+ */
+static void merge_stale_dirty_map(VP8_COMP *cpi, int has_dirty_map) {
+  const int num_mbs = cpi->dirty_mb_rows * cpi->dirty_mb_cols;
+  int i;
+
+  if (!has_dirty_map || cpi->dirty_all_stale) return;
+  for (i = 0; i < num_mbs; ++i) cpi->dirty_map[i] |= cpi->dirty_stale_map[i];
+  memcpy(cpi->dirty_stale_map, cpi->dirty_map, num_mbs);
+  cpi->dirty_map_enabled = 1;
+}
+
 int vp8_receive_raw_frame(VP8_COMP *cpi, unsigned int frame_flags,
                           YV12_BUFFER_CONFIG *sd, int64_t time_stamp,
                           int64_t end_time) {
   struct vpx_usec_timer timer;
   int res = 0;
+  const unsigned char *dirty_map;
 
   vpx_usec_timer_start(&timer);
 
@@ -4781,10 +4916,19 @@ int vp8_receive_raw_frame(VP8_COMP *cpi, unsigned int frame_flags,
     alloc_raw_frame_buffers(cpi);
   }
 
+  dirty_map = setup_dirty_map(cpi, sd);
+
+  /* The source is denoised in place when noise_sensitivity is set, so the
+   * buffers of the lookahead no longer hold what was copied into them.
+   */
   if (vp8_lookahead_push(cpi->lookahead, sd, time_stamp, end_time, frame_flags,
-                         cpi->active_map_enabled ? cpi->active_map : NULL)) {
+                         cpi->oxcf.noise_sensitivity > 0 ? NULL : dirty_map)) {
     res = -1;
+  } else {
+    cpi->dirty_rect_stats.num_copied_pixels =
+        vp8_lookahead_copied_pixels(cpi->lookahead);
   }
+  merge_stale_dirty_map(cpi, dirty_map != NULL);
   vpx_usec_timer_mark(&timer);
   cpi->time_receive_data += vpx_usec_timer_elapsed(&timer);
 
@@ -5361,6 +5505,37 @@ int vp8_set_roimap(VP8_COMP *cpi, unsigned char *map, unsigned int rows,
   return 0;
 }
 
+int vp8_set_dirty_rects(VP8_COMP *cpi, const vpx_dirty_rects_t *rects) {
+  if (rects == NULL) {
+    cpi->dirty_rects_pending = 0;
+    return 0;
+  }
+  /* The rectangles are relative to the previous frame received, which is only
+   * the previous frame encoded without lag.
+   */
+  if (cpi->oxcf.lag_in_frames > 0) return -1;
+  if (rects->num_rects > 0 && rects->rects == NULL) return -1;
+
+  if ((int)rects->num_rects > cpi->dirty_rects_size) {
+    vpx_free(cpi->dirty_rects);
+    cpi->dirty_rects_size = 0;
+    cpi->dirty_rects = (vpx_dirty_rect_t *)vpx_malloc(
+        rects->num_rects * sizeof(*cpi->dirty_rects));
+    if (cpi->dirty_rects == NULL) {
+      cpi->dirty_rects_pending = 0;
+      return -1;
+    }
+    cpi->dirty_rects_size = (int)rects->num_rects;
+  }
+  if (rects->num_rects > 0) {
+    memcpy(cpi->dirty_rects, rects->rects,
+           rects->num_rects * sizeof(*cpi->dirty_rects));
+  }
+  cpi->num_dirty_rects = (int)rects->num_rects;
+  cpi->dirty_rects_pending = 1;
+  return 0;
+}
+
 int vp8_set_active_map(VP8_COMP *cpi, unsigned char *map, unsigned int rows,
                        unsigned int cols) {
   if ((int)rows == cpi->common.mb_rows && (int)cols == cpi->common.mb_cols) {
@@ -193,6 +193,25 @@ typedef struct {
   TOKENEXTRA *stop;
 } TOKENLIST;
 
+/* First pass statistics of one macroblock row. first_mv and last_mv are the
+ * first and last non-zero vectors of the row, and new_mv_count counts
+ * first_mv as new so that the rows can be chained in raster order. */
+typedef struct {
+  int64_t intra_error;
+  int64_t coded_error;
+  int sum_mvr, sum_mvc;
+  int sum_mvr_abs, sum_mvc_abs;
+  int sum_mvrs, sum_mvcs;
+  int mvcount;
+  int intercount;
+  int second_ref_count;
+  int neutral_count;
+  int new_mv_count;
+  int sum_in_vectors;
+  uint32_t first_mv;
+  uint32_t last_mv;
+} FIRSTPASS_ROW_STATS;
+
 typedef struct {
   int ithread;
   void *ptr1;
@@ -490,6 +509,33 @@ typedef struct VP8_COMP {
   unsigned char *active_map;
   unsigned int active_map_enabled;
 
+  /* The active map of the frame being encoded: active_map, or
+   * dirty_active_map when the frame came with dirty rectangles.
+   */
+  unsigned char *frame_active_map;
+  unsigned int frame_active_map_enabled;
+  unsigned char *dirty_active_map;
+
+  /* The dirty rectangles of the next frame received, given with
+   * VP8E_SET_DIRTY_RECTS.
+   */
+  vpx_dirty_rect_t *dirty_rects;
+  int num_dirty_rects;
+  int dirty_rects_size;
+  int dirty_rects_pending;
+  /* 1 for each macroblock of the source that may differ from the LAST
+   * reference, i.e. that is dirty in this frame or in one received since
+   * LAST was refreshed. The stale map is the same for the next frame,
+   * before its own rectangles are added, unless dirty_all_stale is set.
+   */
+  unsigned char *dirty_map;
+  unsigned char *dirty_stale_map;
+  int dirty_all_stale;
+  int dirty_map_enabled;
+  int dirty_mb_rows;
+  int dirty_mb_cols;
+  vpx_dirty_rect_stats_t dirty_rect_stats;
+
   /* Video conferencing cyclic refresh mode flags. This is a mode
    * designed to clean up the background over time in live encoding
    * scenarious. It uses segmentation.
@@ -543,6 +589,20 @@ typedef struct VP8_COMP {
   sem_t *h_event_end_encoding;
   sem_t h_event_start_lpf;
   sem_t h_event_end_lpf;
+
+  /* Work given to the encoding threads instead of encoding macroblock rows,
+   * see vp8cx_run_mt_job(). */
+  void (*mt_job)(struct VP8_COMP *cpi, void *data, int thread);
+  void *mt_job_data;
+
+  /* Token partition packing on the encoding threads. */
+  int mt_pack_num_part;
+  unsigned char *mt_pack_dest;
+  size_t mt_pack_slice_size;
+  struct vpx_internal_error_info mt_pack_error[MAX_PARTITIONS - 1];
+
+  /* Per row statistics of the multithreaded first pass. */
+  FIRSTPASS_ROW_STATS *mt_fp_row_stats;
 #endif
 
   TOKENLIST *tplist;
@@ -470,7 +470,7 @@ static int evaluate_inter_mode(unsigned int *sse, int rate2, int *distortion2,
   int denoise_aggressive = 0;
   /* Exit early and don't compute the distortion if this macroblock
    * is marked inactive. */
-  if (cpi->active_map_enabled && x->active_ptr[0] == 0) {
+  if (cpi->frame_active_map_enabled && x->active_ptr[0] == 0) {
     *sse = 0;
     *distortion2 = 0;
     x->skip = 1;
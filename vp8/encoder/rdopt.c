@@ -1591,7 +1591,7 @@ static int evaluate_inter_mode_rd(int mdcounts[4], RATE_DISTORTION *rd,
   int distortion;
   vp8_build_inter16x16_predictors_mby(&x->e_mbd, x->e_mbd.predictor, 16);
 
-  if (cpi->active_map_enabled && x->active_ptr[0] == 0) {
+  if (cpi->frame_active_map_enabled && x->active_ptr[0] == 0) {
     x->skip = 1;
   } else if (x->encode_breakout) {
     unsigned int sse;
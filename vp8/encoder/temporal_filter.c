@@ -25,6 +25,8 @@
 #include "vp8/common/swapyv12buffer.h"
 #include "vp8/common/threading.h"
 #include "vpx_ports/vpx_timer.h"
+#include "vpx_dsp/vpx_dsp_common.h"
+#include "ethreading.h"
 
 #include <math.h>
 #include <limits.h>
@@ -110,11 +112,11 @@ void vp8_temporal_filter_apply_c(unsigned char *frame1, unsigned int stride,
 #if ALT_REF_MC_ENABLED
 
 static int vp8_temporal_filter_find_matching_mb_c(VP8_COMP *cpi,
+                                                  MACROBLOCK *x,
                                                   YV12_BUFFER_CONFIG *arf_frame,
                                                   YV12_BUFFER_CONFIG *frame_ptr,
                                                   int mb_offset,
                                                   int error_thresh) {
-  MACROBLOCK *x = &cpi->mb;
   int step_param;
   int sadpb = x->sadperbit16;
   int bestsme = INT_MAX;
@@ -185,158 +187,202 @@ static int vp8_temporal_filter_find_matching_mb_c(VP8_COMP *cpi,
 }
 #endif
 
-static void vp8_temporal_filter_iterate_c(VP8_COMP *cpi, int frame_count,
-                                          int alt_ref_index, int strength) {
+typedef struct {
+  int frame_count;
+  int alt_ref_index;
+  int strength;
+} TEMPORAL_FILTER_JOB;
+
+static void vp8_temporal_filter_mb_row(VP8_COMP *cpi, MACROBLOCK *x,
+                                       const TEMPORAL_FILTER_JOB *job,
+                                       int mb_row) {
   int byte;
   int frame;
-  int mb_col, mb_row;
+  int mb_col;
   unsigned int filter_weight;
   int mb_cols = cpi->common.mb_cols;
-  int mb_rows = cpi->common.mb_rows;
-  int mb_y_offset = 0;
-  int mb_uv_offset = 0;
   DECLARE_ALIGNED(16, unsigned int, accumulator[16 * 16 + 8 * 8 + 8 * 8]);
   DECLARE_ALIGNED(16, unsigned short, count[16 * 16 + 8 * 8 + 8 * 8]);
-  MACROBLOCKD *mbd = &cpi->mb.e_mbd;
-  YV12_BUFFER_CONFIG *f = cpi->frames[alt_ref_index];
+  MACROBLOCKD *mbd = &x->e_mbd;
+  YV12_BUFFER_CONFIG *f = cpi->frames[job->alt_ref_index];
+  int mb_y_offset = mb_row * 16 * f->y_stride;
+  int mb_uv_offset = mb_row * 8 * f->uv_stride;
   unsigned char *dst1, *dst2;
   DECLARE_ALIGNED(16, unsigned char, predictor[16 * 16 + 8 * 8 + 8 * 8]);
 
-  /* Save input state */
-  unsigned char *y_buffer = mbd->pre.y_buffer;
-  unsigned char *u_buffer = mbd->pre.u_buffer;
-  unsigned char *v_buffer = mbd->pre.v_buffer;
-
-  for (mb_row = 0; mb_row < mb_rows; ++mb_row) {
 #if ALT_REF_MC_ENABLED
-    /* Source frames are extended to 16 pixels.  This is different than
-     *  L/A/G reference frames that have a border of 32 (VP8BORDERINPIXELS)
-     * A 6 tap filter is used for motion search.  This requires 2 pixels
-     *  before and 3 pixels after.  So the largest Y mv on a border would
-     *  then be 16 - 3.  The UV blocks are half the size of the Y and
-     *  therefore only extended by 8.  The largest mv that a UV block
-     *  can support is 8 - 3.  A UV mv is half of a Y mv.
-     *  (16 - 3) >> 1 == 6 which is greater than 8 - 3.
-     * To keep the mv in play for both Y and UV planes the max that it
-     *  can be on a border is therefore 16 - 5.
-     */
-    cpi->mb.mv_row_min = -((mb_row * 16) + (16 - 5));
-    cpi->mb.mv_row_max = ((cpi->common.mb_rows - 1 - mb_row) * 16) + (16 - 5);
+  /* Source frames are extended to 16 pixels.  This is different than
+   *  L/A/G reference frames that have a border of 32 (VP8BORDERINPIXELS)
+   * A 6 tap filter is used for motion search.  This requires 2 pixels
+   *  before and 3 pixels after.  So the largest Y mv on a border would
+   *  then be 16 - 3.  The UV blocks are half the size of the Y and
+   *  therefore only extended by 8.  The largest mv that a UV block
+   *  can support is 8 - 3.  A UV mv is half of a Y mv.
+   *  (16 - 3) >> 1 == 6 which is greater than 8 - 3.
+   * To keep the mv in play for both Y and UV planes the max that it
+   *  can be on a border is therefore 16 - 5.
+   */
+  x->mv_row_min = -((mb_row * 16) + (16 - 5));
+  x->mv_row_max = ((cpi->common.mb_rows - 1 - mb_row) * 16) + (16 - 5);
 #endif
 
-    for (mb_col = 0; mb_col < mb_cols; ++mb_col) {
-      int i, j, k;
-      int stride;
+  for (mb_col = 0; mb_col < mb_cols; ++mb_col) {
+    int i, j, k;
+    int stride;
 
-      memset(accumulator, 0, 384 * sizeof(unsigned int));
-      memset(count, 0, 384 * sizeof(unsigned short));
+    memset(accumulator, 0, 384 * sizeof(unsigned int));
+    memset(count, 0, 384 * sizeof(unsigned short));
 
 #if ALT_REF_MC_ENABLED
-      cpi->mb.mv_col_min = -((mb_col * 16) + (16 - 5));
-      cpi->mb.mv_col_max = ((cpi->common.mb_cols - 1 - mb_col) * 16) + (16 - 5);
+    x->mv_col_min = -((mb_col * 16) + (16 - 5));
+    x->mv_col_max = ((cpi->common.mb_cols - 1 - mb_col) * 16) + (16 - 5);
 #endif
 
-      for (frame = 0; frame < frame_count; ++frame) {
-        if (cpi->frames[frame] == NULL) continue;
+    for (frame = 0; frame < job->frame_count; ++frame) {
+      if (cpi->frames[frame] == NULL) continue;
 
-        mbd->block[0].bmi.mv.as_mv.row = 0;
-        mbd->block[0].bmi.mv.as_mv.col = 0;
+      mbd->block[0].bmi.mv.as_mv.row = 0;
+      mbd->block[0].bmi.mv.as_mv.col = 0;
 
-        if (frame == alt_ref_index) {
-          filter_weight = 2;
-        } else {
-          int err = 0;
+      if (frame == job->alt_ref_index) {
+        filter_weight = 2;
+      } else {
+        int err = 0;
 #if ALT_REF_MC_ENABLED
 #define THRESH_LOW 10000
 #define THRESH_HIGH 20000
-          /* Find best match in this frame by MC */
-          err = vp8_temporal_filter_find_matching_mb_c(
-              cpi, cpi->frames[alt_ref_index], cpi->frames[frame], mb_y_offset,
-              THRESH_LOW);
+        /* Find best match in this frame by MC */
+        err = vp8_temporal_filter_find_matching_mb_c(
+            cpi, x, cpi->frames[job->alt_ref_index], cpi->frames[frame],
+            mb_y_offset, THRESH_LOW);
 #endif
-          /* Assign higher weight to matching MB if it's error
-           * score is lower. If not applying MC default behavior
-           * is to weight all MBs equal.
-           */
-          filter_weight = err < THRESH_LOW ? 2 : err < THRESH_HIGH ? 1 : 0;
-        }
-
-        if (filter_weight != 0) {
-          /* Construct the predictors */
-          vp8_temporal_filter_predictors_mb_c(
-              mbd, cpi->frames[frame]->y_buffer + mb_y_offset,
-              cpi->frames[frame]->u_buffer + mb_uv_offset,
-              cpi->frames[frame]->v_buffer + mb_uv_offset,
-              cpi->frames[frame]->y_stride, mbd->block[0].bmi.mv.as_mv.row,
-              mbd->block[0].bmi.mv.as_mv.col, predictor);
-
-          /* Apply the filter (YUV) */
-          vp8_temporal_filter_apply(f->y_buffer + mb_y_offset, f->y_stride,
-                                    predictor, 16, strength, filter_weight,
-                                    accumulator, count);
-
-          vp8_temporal_filter_apply(f->u_buffer + mb_uv_offset, f->uv_stride,
-                                    predictor + 256, 8, strength, filter_weight,
-                                    accumulator + 256, count + 256);
-
-          vp8_temporal_filter_apply(f->v_buffer + mb_uv_offset, f->uv_stride,
-                                    predictor + 320, 8, strength, filter_weight,
-                                    accumulator + 320, count + 320);
-        }
+        /* Assign higher weight to matching MB if it's error
+         * score is lower. If not applying MC default behavior
+         * is to weight all MBs equal.
+         */
+        filter_weight = err < THRESH_LOW ? 2 : err < THRESH_HIGH ? 1 : 0;
       }
 
-      /* Normalize filter output to produce AltRef frame */
-      dst1 = cpi->alt_ref_buffer.y_buffer;
-      stride = cpi->alt_ref_buffer.y_stride;
-      byte = mb_y_offset;
-      for (i = 0, k = 0; i < 16; ++i) {
-        for (j = 0; j < 16; j++, k++) {
-          unsigned int pval = accumulator[k] + (count[k] >> 1);
-          pval *= cpi->fixed_divide[count[k]];
-          pval >>= 19;
+      if (filter_weight != 0) {
+        /* Construct the predictors */
+        vp8_temporal_filter_predictors_mb_c(
+            mbd, cpi->frames[frame]->y_buffer + mb_y_offset,
+            cpi->frames[frame]->u_buffer + mb_uv_offset,
+            cpi->frames[frame]->v_buffer + mb_uv_offset,
+            cpi->frames[frame]->y_stride, mbd->block[0].bmi.mv.as_mv.row,
+            mbd->block[0].bmi.mv.as_mv.col, predictor);
+
+        /* Apply the filter (YUV) */
+        vp8_temporal_filter_apply(f->y_buffer + mb_y_offset, f->y_stride,
+                                  predictor, 16, job->strength, filter_weight,
+                                  accumulator, count);
+
+        vp8_temporal_filter_apply(f->u_buffer + mb_uv_offset, f->uv_stride,
+                                  predictor + 256, 8, job->strength,
+                                  filter_weight, accumulator + 256,
+                                  count + 256);
+
+        vp8_temporal_filter_apply(f->v_buffer + mb_uv_offset, f->uv_stride,
+                                  predictor + 320, 8, job->strength,
+                                  filter_weight, accumulator + 320,
+                                  count + 320);
+      }
+    }
 
-          dst1[byte] = (unsigned char)pval;
+    /* Normalize filter output to produce AltRef frame */
+    dst1 = cpi->alt_ref_buffer.y_buffer;
+    stride = cpi->alt_ref_buffer.y_stride;
+    byte = mb_y_offset;
+    for (i = 0, k = 0; i < 16; ++i) {
+      for (j = 0; j < 16; j++, k++) {
+        unsigned int pval = accumulator[k] + (count[k] >> 1);
+        pval *= cpi->fixed_divide[count[k]];
+        pval >>= 19;
 
-          /* move to next pixel */
-          byte++;
-        }
+        dst1[byte] = (unsigned char)pval;
 
-        byte += stride - 16;
+        /* move to next pixel */
+        byte++;
       }
 
-      dst1 = cpi->alt_ref_buffer.u_buffer;
-      dst2 = cpi->alt_ref_buffer.v_buffer;
-      stride = cpi->alt_ref_buffer.uv_stride;
-      byte = mb_uv_offset;
-      for (i = 0, k = 256; i < 8; ++i) {
-        for (j = 0; j < 8; j++, k++) {
-          int m = k + 64;
-
-          /* U */
-          unsigned int pval = accumulator[k] + (count[k] >> 1);
-          pval *= cpi->fixed_divide[count[k]];
-          pval >>= 19;
-          dst1[byte] = (unsigned char)pval;
-
-          /* V */
-          pval = accumulator[m] + (count[m] >> 1);
-          pval *= cpi->fixed_divide[count[m]];
-          pval >>= 19;
-          dst2[byte] = (unsigned char)pval;
-
-          /* move to next pixel */
-          byte++;
-        }
-
-        byte += stride - 8;
+      byte += stride - 16;
+    }
+
+    dst1 = cpi->alt_ref_buffer.u_buffer;
+    dst2 = cpi->alt_ref_buffer.v_buffer;
+    stride = cpi->alt_ref_buffer.uv_stride;
+    byte = mb_uv_offset;
+    for (i = 0, k = 256; i < 8; ++i) {
+      for (j = 0; j < 8; j++, k++) {
+        int m = k + 64;
+
+        /* U */
+        unsigned int pval = accumulator[k] + (count[k] >> 1);
+        pval *= cpi->fixed_divide[count[k]];
+        pval >>= 19;
+        dst1[byte] = (unsigned char)pval;
+
+        /* V */
+        pval = accumulator[m] + (count[m] >> 1);
+        pval *= cpi->fixed_divide[count[m]];
+        pval >>= 19;
+        dst2[byte] = (unsigned char)pval;
+
+        /* move to next pixel */
+        byte++;
       }
 
-      mb_y_offset += 16;
-      mb_uv_offset += 8;
+      byte += stride - 8;
     }
 
-    mb_y_offset += 16 * (f->y_stride - mb_cols);
-    mb_uv_offset += 8 * (f->uv_stride - mb_cols);
+    mb_y_offset += 16;
+    mb_uv_offset += 8;
+  }
+}
+
+#if CONFIG_MULTITHREAD
+/* Every macroblock is filtered independently, so the rows are simply
+ * interleaved between the threads. */
+static void temporal_filter_job(VP8_COMP *cpi, void *data, int thread) {
+  MACROBLOCK *const x = thread ? &cpi->mb_row_ei[thread - 1].mb : &cpi->mb;
+  int mb_row;
+
+  for (mb_row = thread; mb_row < cpi->common.mb_rows;
+       mb_row += cpi->encoding_thread_count + 1) {
+    vp8_temporal_filter_mb_row(cpi, x, (const TEMPORAL_FILTER_JOB *)data,
+                               mb_row);
+  }
+}
+#endif
+
+static void vp8_temporal_filter_iterate_c(VP8_COMP *cpi, int frame_count,
+                                          int alt_ref_index, int strength) {
+  MACROBLOCKD *mbd = &cpi->mb.e_mbd;
+  TEMPORAL_FILTER_JOB job;
+  int mb_row;
+
+  /* Save input state */
+  unsigned char *y_buffer = mbd->pre.y_buffer;
+  unsigned char *u_buffer = mbd->pre.u_buffer;
+  unsigned char *v_buffer = mbd->pre.v_buffer;
+
+  job.frame_count = frame_count;
+  job.alt_ref_index = alt_ref_index;
+  job.strength = strength;
+
+#if CONFIG_MULTITHREAD
+  if (vpx_atomic_load_acquire(&cpi->b_multi_threaded)) {
+    vp8cx_init_mbrthread_search(&cpi->mb, cpi->mb_row_ei,
+                                cpi->encoding_thread_count);
+    vp8cx_run_mt_job(
+        cpi, temporal_filter_job, &job,
+        VPXMIN(cpi->encoding_thread_count, cpi->common.mb_rows - 1));
+  } else
+#endif
+  {
+    for (mb_row = 0; mb_row < cpi->common.mb_rows; ++mb_row) {
+      vp8_temporal_filter_mb_row(cpi, &cpi->mb, &job, mb_row);
+    }
   }
 
   /* Restore input state */
@@ -0,0 +1,291 @@
+/*
+ *  Copyright (c) 2023 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "vp8/encoder/denoising.h"
+#include "vp8/common/reconinter.h"
+#include "vpx/vpx_integer.h"
+#include "vp8_rtcd.h"
+
+#include <immintrin.h>
+#include <stdlib.h>
+
+/* Load 2 rows of 16 pixels. */
+static INLINE __m256i load_16x2(const unsigned char *p, int stride) {
+  return _mm256_inserti128_si256(
+      _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)p)),
+      _mm_loadu_si128((const __m128i *)(p + stride)), 1);
+}
+
+static INLINE void store_16x2(unsigned char *p, int stride, const __m256i v) {
+  _mm_storeu_si128((__m128i *)p, _mm256_castsi256_si128(v));
+  _mm_storeu_si128((__m128i *)(p + stride), _mm256_extracti128_si256(v, 1));
+}
+
+/* Load 4 rows of 8 pixels. */
+static INLINE __m256i load_8x4(const unsigned char *p, int stride) {
+  const __m128i lo =
+      _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)p),
+                         _mm_loadl_epi64((const __m128i *)(p + stride)));
+  const __m128i hi =
+      _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)(p + 2 * stride)),
+                         _mm_loadl_epi64((const __m128i *)(p + 3 * stride)));
+  return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+}
+
+static INLINE void store_8x4(unsigned char *p, int stride, const __m256i v) {
+  const __m128i lo = _mm256_castsi256_si128(v);
+  const __m128i hi = _mm256_extracti128_si256(v, 1);
+  _mm_storel_epi64((__m128i *)p, lo);
+  _mm_storel_epi64((__m128i *)(p + stride), _mm_srli_si128(lo, 8));
+  _mm_storel_epi64((__m128i *)(p + 2 * stride), hi);
+  _mm_storel_epi64((__m128i *)(p + 3 * stride), _mm_srli_si128(hi, 8));
+}
+
+typedef struct {
+  __m256i k_4;
+  __m256i k_8;
+  __m256i k_16;
+  __m256i l3;
+  __m256i l32;
+  __m256i l21;
+} DenoiserLevels;
+
+static INLINE void init_levels(DenoiserLevels *lv,
+                               unsigned int motion_magnitude,
+                               unsigned int motion_thresh,
+                               int increase_denoising) {
+  const int shift_inc =
+      (increase_denoising && motion_magnitude <= motion_thresh) ? 1 : 0;
+  lv->k_4 = _mm256_set1_epi8(4 + shift_inc);
+  lv->k_8 = _mm256_set1_epi8(8);
+  lv->k_16 = _mm256_set1_epi8(16);
+  /* Modify each level's adjustment according to motion_magnitude. */
+  lv->l3 = _mm256_set1_epi8((motion_magnitude <= motion_thresh) ? 7 + shift_inc
+                                                                 : 6);
+  /* Difference between level 3 and level 2 is 2. */
+  lv->l32 = _mm256_set1_epi8(2);
+  /* Difference between level 2 and level 1 is 1. */
+  lv->l21 = _mm256_set1_epi8(1);
+}
+
+/* Denoise 32 pixels. The adjustments are returned in |padj_out| and
+ * |nadj_out|. */
+static INLINE __m256i denoiser_32x1(const __m256i v_sig, const __m256i v_mc,
+                                    const DenoiserLevels *lv, __m256i *padj_out,
+                                    __m256i *nadj_out) {
+  const __m256i pdiff = _mm256_subs_epu8(v_mc, v_sig);
+  const __m256i ndiff = _mm256_subs_epu8(v_sig, v_mc);
+  /* Obtain the sign. FF if diff is negative. */
+  const __m256i diff_sign = _mm256_cmpeq_epi8(pdiff, _mm256_setzero_si256());
+  /* Clamp absolute difference to 16 to be used to get mask. Doing this
+   * allows us to use _mm256_cmpgt_epi8, which operates on signed byte. */
+  const __m256i clamped_absdiff =
+      _mm256_min_epu8(_mm256_or_si256(pdiff, ndiff), lv->k_16);
+  /* Get masks for l2 l1 and l0 adjustments */
+  const __m256i mask2 = _mm256_cmpgt_epi8(lv->k_16, clamped_absdiff);
+  const __m256i mask1 = _mm256_cmpgt_epi8(lv->k_8, clamped_absdiff);
+  const __m256i mask0 = _mm256_cmpgt_epi8(lv->k_4, clamped_absdiff);
+  /* Get adjustments for l2, l1, and l0 */
+  const __m256i adj2 = _mm256_add_epi8(_mm256_and_si256(mask2, lv->l32),
+                                       _mm256_and_si256(mask1, lv->l21));
+  const __m256i adj0 = _mm256_and_si256(mask0, clamped_absdiff);
+  /* Combine the adjustments and get absolute adjustments. */
+  const __m256i adj = _mm256_or_si256(
+      _mm256_andnot_si256(mask0, _mm256_sub_epi8(lv->l3, adj2)), adj0);
+
+  /* Restore the sign and get positive and negative adjustments. */
+  *padj_out = _mm256_andnot_si256(diff_sign, adj);
+  *nadj_out = _mm256_and_si256(diff_sign, adj);
+  return _mm256_subs_epu8(_mm256_adds_epu8(v_sig, *padj_out), *nadj_out);
+}
+
+/* Move 32 denoised pixels back towards the source by at most |k_delta|. */
+static INLINE __m256i denoiser_adj_32x1(const __m256i v_sig,
+                                        const __m256i v_mc,
+                                        const __m256i v_avg,
+                                        const __m256i k_delta,
+                                        __m256i *padj_out, __m256i *nadj_out) {
+  const __m256i pdiff = _mm256_subs_epu8(v_mc, v_sig);
+  const __m256i ndiff = _mm256_subs_epu8(v_sig, v_mc);
+  /* Obtain the sign. FF if diff is negative. */
+  const __m256i diff_sign = _mm256_cmpeq_epi8(pdiff, _mm256_setzero_si256());
+  /* Clamp absolute difference to delta to get the adjustment. */
+  const __m256i adj = _mm256_min_epu8(_mm256_or_si256(pdiff, ndiff), k_delta);
+  /* The signal is brought back, so the adjustments change sign. */
+  *padj_out = _mm256_and_si256(diff_sign, adj);
+  *nadj_out = _mm256_andnot_si256(diff_sign, adj);
+  return _mm256_adds_epu8(_mm256_subs_epu8(v_avg, *nadj_out), *padj_out);
+}
+
+/* Add the per column sums of the two 16 pixel rows held in |acc| to the 16
+ * bit column sums, and clip them at 127 like the C version. */
+static INLINE __m256i update_col_sum(__m256i col_sum, const __m256i acc) {
+  col_sum = _mm256_add_epi16(
+      col_sum, _mm256_cvtepi8_epi16(_mm256_castsi256_si128(acc)));
+  col_sum = _mm256_add_epi16(
+      col_sum, _mm256_cvtepi8_epi16(_mm256_extracti128_si256(acc, 1)));
+  return _mm256_min_epi16(col_sum, _mm256_set1_epi16(127));
+}
+
+static INLINE int sum_epi16(const __m256i v) {
+  const __m256i sum32 = _mm256_madd_epi16(v, _mm256_set1_epi16(1));
+  __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(sum32),
+                              _mm256_extracti128_si256(sum32, 1));
+  sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 8));
+  sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 4));
+  return _mm_cvtsi128_si32(sum);
+}
+
+int vp8_denoiser_filter_avx2(unsigned char *mc_running_avg_y,
+                             int mc_avg_y_stride, unsigned char *running_avg_y,
+                             int avg_y_stride, unsigned char *sig,
+                             int sig_stride, unsigned int motion_magnitude,
+                             int increase_denoising) {
+  unsigned int sum_diff_thresh;
+  unsigned int abs_sum_diff;
+  int r;
+  /* Each byte of acc_diff holds the sum over 8 rows of one column, so it
+   * cannot saturate. */
+  __m256i acc_diff = _mm256_setzero_si256();
+  __m256i col_sum = _mm256_setzero_si256();
+  DenoiserLevels lv;
+  init_levels(&lv, motion_magnitude, MOTION_MAGNITUDE_THRESHOLD,
+              increase_denoising);
+
+  for (r = 0; r < 16; r += 2) {
+    __m256i padj, nadj;
+    const __m256i v_running_avg_y = denoiser_32x1(
+        load_16x2(sig + r * sig_stride, sig_stride),
+        load_16x2(mc_running_avg_y + r * mc_avg_y_stride, mc_avg_y_stride),
+        &lv, &padj, &nadj);
+    store_16x2(running_avg_y + r * avg_y_stride, avg_y_stride,
+               v_running_avg_y);
+    acc_diff = _mm256_sub_epi8(_mm256_add_epi8(acc_diff, padj), nadj);
+  }
+
+  col_sum = update_col_sum(col_sum, acc_diff);
+  abs_sum_diff = abs(sum_epi16(col_sum));
+  sum_diff_thresh = SUM_DIFF_THRESHOLD;
+  if (increase_denoising) sum_diff_thresh = SUM_DIFF_THRESHOLD_HIGH;
+  if (abs_sum_diff > sum_diff_thresh) {
+    // Before returning to copy the block (i.e., apply no denoising),
+    // check if we can still apply some (weaker) temporal filtering to
+    // this block, that would otherwise not be denoised at all. The delta is
+    // set by the excess of absolute pixel diff over the threshold.
+    int delta = ((abs_sum_diff - sum_diff_thresh) >> 8) + 1;
+    // Only apply the adjustment for max delta up to 3.
+    if (delta < 4) {
+      const __m256i k_delta = _mm256_set1_epi8(delta);
+      acc_diff = _mm256_setzero_si256();
+      for (r = 0; r < 16; r += 2) {
+        unsigned char *const avg_ptr = running_avg_y + r * avg_y_stride;
+        __m256i padj, nadj;
+        const __m256i v_running_avg_y = denoiser_adj_32x1(
+            load_16x2(sig + r * sig_stride, sig_stride),
+            load_16x2(mc_running_avg_y + r * mc_avg_y_stride, mc_avg_y_stride),
+            load_16x2(avg_ptr, avg_y_stride), k_delta, &padj, &nadj);
+        store_16x2(avg_ptr, avg_y_stride, v_running_avg_y);
+        acc_diff = _mm256_sub_epi8(_mm256_add_epi8(acc_diff, padj), nadj);
+      }
+      col_sum = update_col_sum(col_sum, acc_diff);
+      abs_sum_diff = abs(sum_epi16(col_sum));
+      if (abs_sum_diff > sum_diff_thresh) {
+        return COPY_BLOCK;
+      }
+    } else {
+      return COPY_BLOCK;
+    }
+  }
+
+  vp8_copy_mem16x16(running_avg_y, avg_y_stride, sig, sig_stride);
+  return FILTER_BLOCK;
+}
+
+int vp8_denoiser_filter_uv_avx2(unsigned char *mc_running_avg,
+                                int mc_avg_stride, unsigned char *running_avg,
+                                int avg_stride, unsigned char *sig,
+                                int sig_stride, unsigned int motion_magnitude,
+                                int increase_denoising) {
+  const __m256i k_0 = _mm256_setzero_si256();
+  unsigned int sum_diff_thresh;
+  unsigned int abs_sum_diff;
+  int r;
+  __m256i sum_diff = _mm256_setzero_si256();
+  DenoiserLevels lv;
+  init_levels(&lv, motion_magnitude, MOTION_MAGNITUDE_THRESHOLD_UV,
+              increase_denoising);
+
+  {
+    // Avoid denoising color signal if its close to average level.
+    const __m256i sad = _mm256_add_epi64(
+        _mm256_sad_epu8(load_8x4(sig, sig_stride), k_0),
+        _mm256_sad_epu8(load_8x4(sig + 4 * sig_stride, sig_stride), k_0));
+    const __m128i sum = _mm_add_epi64(_mm256_castsi256_si128(sad),
+                                      _mm256_extracti128_si256(sad, 1));
+    const int sum_block =
+        _mm_cvtsi128_si32(_mm_add_epi64(sum, _mm_srli_si128(sum, 8)));
+    if (abs(sum_block - (128 * 8 * 8)) < SUM_DIFF_FROM_AVG_THRESH_UV) {
+      return COPY_BLOCK;
+    }
+  }
+
+  for (r = 0; r < 8; r += 4) {
+    __m256i padj, nadj;
+    const __m256i v_running_avg = denoiser_32x1(
+        load_8x4(sig + r * sig_stride, sig_stride),
+        load_8x4(mc_running_avg + r * mc_avg_stride, mc_avg_stride), &lv,
+        &padj, &nadj);
+    store_8x4(running_avg + r * avg_stride, avg_stride, v_running_avg);
+    sum_diff = _mm256_sub_epi8(_mm256_add_epi8(sum_diff, padj), nadj);
+  }
+
+  {
+    /* Each byte holds the sum of 2 adjustments of at most 8. */
+    const __m256i sum_diff_16 = _mm256_add_epi16(
+        _mm256_cvtepi8_epi16(_mm256_castsi256_si128(sum_diff)),
+        _mm256_cvtepi8_epi16(_mm256_extracti128_si256(sum_diff, 1)));
+    abs_sum_diff = abs(sum_epi16(sum_diff_16));
+    sum_diff_thresh = SUM_DIFF_THRESHOLD_UV;
+    if (increase_denoising) sum_diff_thresh = SUM_DIFF_THRESHOLD_HIGH_UV;
+    if (abs_sum_diff > sum_diff_thresh) {
+      // The delta is set by the excess of absolute pixel diff over the
+      // threshold.
+      int delta = ((abs_sum_diff - sum_diff_thresh) >> 8) + 1;
+      // Only apply the adjustment for max delta up to 3.
+      if (delta < 4) {
+        const __m256i k_delta = _mm256_set1_epi8(delta);
+        __m256i acc_diff = _mm256_setzero_si256();
+        for (r = 0; r < 8; r += 4) {
+          unsigned char *const avg_ptr = running_avg + r * avg_stride;
+          __m256i padj, nadj;
+          const __m256i v_running_avg = denoiser_adj_32x1(
+              load_8x4(sig + r * sig_stride, sig_stride),
+              load_8x4(mc_running_avg + r * mc_avg_stride, mc_avg_stride),
+              load_8x4(avg_ptr, avg_stride), k_delta, &padj, &nadj);
+          store_8x4(avg_ptr, avg_stride, v_running_avg);
+          acc_diff = _mm256_sub_epi8(_mm256_add_epi8(acc_diff, padj), nadj);
+        }
+        abs_sum_diff = abs(
+            sum_epi16(sum_diff_16) +
+            sum_epi16(_mm256_add_epi16(
+                _mm256_cvtepi8_epi16(_mm256_castsi256_si128(acc_diff)),
+                _mm256_cvtepi8_epi16(_mm256_extracti128_si256(acc_diff, 1)))));
+        if (abs_sum_diff > sum_diff_thresh) {
+          return COPY_BLOCK;
+        }
+      } else {
+        return COPY_BLOCK;
+      }
+    }
+  }
+
+  vp8_copy_mem8x8(running_avg, avg_stride, sig, sig_stride);
+  return FILTER_BLOCK;
+}
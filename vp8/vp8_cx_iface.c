@@ -1217,6 +1217,23 @@ static vpx_codec_err_t vp8e_set_activemap(vpx_codec_alg_priv_t *ctx,
   }
 }
 
+static vpx_codec_err_t vp8e_set_dirty_rects(vpx_codec_alg_priv_t *ctx,
+                                            va_list args) {
+  const vpx_dirty_rects_t *const rects = va_arg(args, vpx_dirty_rects_t *);
+
+  if (vp8_set_dirty_rects(ctx->cpi, rects)) return VPX_CODEC_INVALID_PARAM;
+  return VPX_CODEC_OK;
+}
+
+static vpx_codec_err_t vp8e_get_dirty_rect_stats(vpx_codec_alg_priv_t *ctx,
+                                                 va_list args) {
+  vpx_dirty_rect_stats_t *const stats = va_arg(args, vpx_dirty_rect_stats_t *);
+
+  if (stats == NULL) return VPX_CODEC_INVALID_PARAM;
+  *stats = ctx->cpi->dirty_rect_stats;
+  return VPX_CODEC_OK;
+}
+
 static vpx_codec_err_t vp8e_set_scalemode(vpx_codec_alg_priv_t *ctx,
                                           va_list args) {
   vpx_scaling_mode_t *data = va_arg(args, vpx_scaling_mode_t *);
@@ -1247,6 +1264,7 @@ static vpx_codec_ctrl_fn_map_t vp8e_ctf_maps[] = {
   { VP8E_SET_TEMPORAL_LAYER_ID, vp8e_set_temporal_layer_id },
   { VP8E_SET_ROI_MAP, vp8e_set_roi_map },
   { VP8E_SET_ACTIVEMAP, vp8e_set_activemap },
+  { VP8E_SET_DIRTY_RECTS, vp8e_set_dirty_rects },
   { VP8E_SET_SCALEMODE, vp8e_set_scalemode },
   { VP8E_SET_CPUUSED, set_cpu_used },
   { VP8E_SET_NOISE_SENSITIVITY, set_noise_sensitivity },
@@ -1256,6 +1274,7 @@ static vpx_codec_ctrl_fn_map_t vp8e_ctf_maps[] = {
   { VP8E_SET_TOKEN_PARTITIONS, set_token_partitions },
   { VP8E_GET_LAST_QUANTIZER, get_quantizer },
   { VP8E_GET_LAST_QUANTIZER_64, get_quantizer64 },
+  { VP8E_GET_DIRTY_RECT_STATS, vp8e_get_dirty_rect_stats },
   { VP8E_SET_ARNR_MAXFRAMES, set_arnr_max_frames },
   { VP8E_SET_ARNR_STRENGTH, set_arnr_strength },
   { VP8E_SET_ARNR_TYPE, set_arnr_type },
@@ -601,6 +601,16 @@ static vpx_codec_err_t vp8_get_quantizer(vpx_codec_alg_priv_t *ctx,
   return VPX_CODEC_OK;
 }
 
+static vpx_codec_err_t vp8_get_decode_profile(vpx_codec_alg_priv_t *ctx,
+                                              va_list args) {
+  vpx_decode_profile_t *const arg = va_arg(args, vpx_decode_profile_t *);
+  VP8D_COMP *pbi = ctx->yv12_frame_buffers.pbi[0];
+  if (arg == NULL) return VPX_CODEC_INVALID_PARAM;
+  if (pbi == NULL) return VPX_CODEC_ERROR;
+  *arg = pbi->profile;
+  return VPX_CODEC_OK;
+}
+
 static vpx_codec_err_t vp8_set_postproc(vpx_codec_alg_priv_t *ctx,
                                         va_list args) {
 #if CONFIG_POSTPROC
@@ -697,6 +707,7 @@ static vpx_codec_ctrl_fn_map_t vp8_ctf_maps[] = {
   { VP8D_GET_FRAME_CORRUPTED, vp8_get_frame_corrupted },
   { VP8D_GET_LAST_REF_USED, vp8_get_last_ref_frame },
   { VPXD_GET_LAST_QUANTIZER, vp8_get_quantizer },
+  { VPXD_GET_DECODE_PROFILE, vp8_get_decode_profile },
   { VPXD_SET_DECRYPTOR, vp8_set_decryptor },
   { -1, NULL },
 };
@@ -93,6 +93,7 @@ VP8_CX_SRCS-$(HAVE_SSE4_1) += encoder/x86/quantize_sse4.c
 
 ifeq ($(CONFIG_TEMPORAL_DENOISING),yes)
 VP8_CX_SRCS-$(HAVE_SSE2) += encoder/x86/denoising_sse2.c
+VP8_CX_SRCS-$(HAVE_AVX2) += encoder/x86/denoising_avx2.c
 endif
 
 VP8_CX_SRCS-$(HAVE_SSE2) += encoder/x86/block_error_sse2.asm
@@ -8,6 +8,7 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include "./vpx_dsp_rtcd.h"
 #include "vpx_mem/vpx_mem.h"
 
 #include "vp9/common/vp9_onyxc_int.h"
@@ -337,75 +338,93 @@ static void init_mode_probs(FRAME_CONTEXT *fc) {
 const vpx_tree_index vp9_switchable_interp_tree[TREE_SIZE(
     SWITCHABLE_FILTERS)] = { -EIGHTTAP, 2, -EIGHTTAP_SMOOTH, -EIGHTTAP_SHARP };
 
+void vp9_mode_mv_merge_probs(const vpx_prob *pre_probs,
+                             const unsigned int *branch_ct, int n,
+                             vpx_prob *probs) {
+  vpx_merge_probs(pre_probs, branch_ct, n, MODE_MV_COUNT_SAT,
+                  MODE_MV_MAX_UPDATE_FACTOR, probs);
+}
+
+void vp9_tree_merge_probs(const vpx_tree_index *tree, int num_nodes,
+                          const vpx_prob *pre_probs,
+                          const unsigned int *counts, int n, vpx_prob *probs) {
+  // Large enough for the uv mode probabilities, the biggest set.
+  unsigned int branch_ct[INTRA_MODES * (INTRA_MODES - 1)][2];
+  int i;
+
+  assert(n * num_nodes <= (int)(sizeof(branch_ct) / sizeof(branch_ct[0])));
+  for (i = 0; i < n; ++i) {
+    vpx_tree_branch_counts(tree, counts + i * (num_nodes + 1),
+                           branch_ct[i * num_nodes]);
+  }
+  vp9_mode_mv_merge_probs(pre_probs, branch_ct[0], n * num_nodes, probs);
+}
+
 void vp9_adapt_mode_probs(VP9_COMMON *cm) {
-  int i, j;
+  int i;
   FRAME_CONTEXT *fc = cm->fc;
   const FRAME_CONTEXT *pre_fc = &cm->frame_contexts[cm->frame_context_idx];
   const FRAME_COUNTS *counts = &cm->counts;
 
-  for (i = 0; i < INTRA_INTER_CONTEXTS; i++)
-    fc->intra_inter_prob[i] = mode_mv_merge_probs(pre_fc->intra_inter_prob[i],
-                                                  counts->intra_inter[i]);
-  for (i = 0; i < COMP_INTER_CONTEXTS; i++)
-    fc->comp_inter_prob[i] =
-        mode_mv_merge_probs(pre_fc->comp_inter_prob[i], counts->comp_inter[i]);
-  for (i = 0; i < REF_CONTEXTS; i++)
-    fc->comp_ref_prob[i] =
-        mode_mv_merge_probs(pre_fc->comp_ref_prob[i], counts->comp_ref[i]);
-  for (i = 0; i < REF_CONTEXTS; i++)
-    for (j = 0; j < 2; j++)
-      fc->single_ref_prob[i][j] = mode_mv_merge_probs(
-          pre_fc->single_ref_prob[i][j], counts->single_ref[i][j]);
-
-  for (i = 0; i < INTER_MODE_CONTEXTS; i++)
-    vpx_tree_merge_probs(vp9_inter_mode_tree, pre_fc->inter_mode_probs[i],
-                         counts->inter_mode[i], fc->inter_mode_probs[i]);
-
-  for (i = 0; i < BLOCK_SIZE_GROUPS; i++)
-    vpx_tree_merge_probs(vp9_intra_mode_tree, pre_fc->y_mode_prob[i],
-                         counts->y_mode[i], fc->y_mode_prob[i]);
-
-  for (i = 0; i < INTRA_MODES; ++i)
-    vpx_tree_merge_probs(vp9_intra_mode_tree, pre_fc->uv_mode_prob[i],
-                         counts->uv_mode[i], fc->uv_mode_prob[i]);
-
-  for (i = 0; i < PARTITION_CONTEXTS; i++)
-    vpx_tree_merge_probs(vp9_partition_tree, pre_fc->partition_prob[i],
-                         counts->partition[i], fc->partition_prob[i]);
+  // The binary probabilities have their counts stored as branch counts.
+  vp9_mode_mv_merge_probs(pre_fc->intra_inter_prob, counts->intra_inter[0],
+                          INTRA_INTER_CONTEXTS, fc->intra_inter_prob);
+  vp9_mode_mv_merge_probs(pre_fc->comp_inter_prob, counts->comp_inter[0],
+                          COMP_INTER_CONTEXTS, fc->comp_inter_prob);
+  vp9_mode_mv_merge_probs(pre_fc->comp_ref_prob, counts->comp_ref[0],
+                          REF_CONTEXTS, fc->comp_ref_prob);
+  vp9_mode_mv_merge_probs(pre_fc->single_ref_prob[0], counts->single_ref[0][0],
+                          REF_CONTEXTS * 2, fc->single_ref_prob[0]);
+
+  vp9_tree_merge_probs(vp9_inter_mode_tree, INTER_MODES - 1,
+                       pre_fc->inter_mode_probs[0], counts->inter_mode[0],
+                       INTER_MODE_CONTEXTS, fc->inter_mode_probs[0]);
+
+  vp9_tree_merge_probs(vp9_intra_mode_tree, INTRA_MODES - 1,
+                       pre_fc->y_mode_prob[0], counts->y_mode[0],
+                       BLOCK_SIZE_GROUPS, fc->y_mode_prob[0]);
+
+  vp9_tree_merge_probs(vp9_intra_mode_tree, INTRA_MODES - 1,
+                       pre_fc->uv_mode_prob[0], counts->uv_mode[0],
+                       INTRA_MODES, fc->uv_mode_prob[0]);
+
+  vp9_tree_merge_probs(vp9_partition_tree, PARTITION_TYPES - 1,
+                       pre_fc->partition_prob[0], counts->partition[0],
+                       PARTITION_CONTEXTS, fc->partition_prob[0]);
 
   if (cm->interp_filter == SWITCHABLE) {
-    for (i = 0; i < SWITCHABLE_FILTER_CONTEXTS; i++)
-      vpx_tree_merge_probs(
-          vp9_switchable_interp_tree, pre_fc->switchable_interp_prob[i],
-          counts->switchable_interp[i], fc->switchable_interp_prob[i]);
+    vp9_tree_merge_probs(vp9_switchable_interp_tree, SWITCHABLE_FILTERS - 1,
+                         pre_fc->switchable_interp_prob[0],
+                         counts->switchable_interp[0],
+                         SWITCHABLE_FILTER_CONTEXTS,
+                         fc->switchable_interp_prob[0]);
   }
 
   if (cm->tx_mode == TX_MODE_SELECT) {
-    unsigned int branch_ct_8x8p[TX_SIZES - 3][2];
-    unsigned int branch_ct_16x16p[TX_SIZES - 2][2];
-    unsigned int branch_ct_32x32p[TX_SIZES - 1][2];
+    unsigned int branch_ct_8x8p[TX_SIZE_CONTEXTS][TX_SIZES - 3][2];
+    unsigned int branch_ct_16x16p[TX_SIZE_CONTEXTS][TX_SIZES - 2][2];
+    unsigned int branch_ct_32x32p[TX_SIZE_CONTEXTS][TX_SIZES - 1][2];
 
     for (i = 0; i < TX_SIZE_CONTEXTS; ++i) {
-      tx_counts_to_branch_counts_8x8(counts->tx.p8x8[i], branch_ct_8x8p);
-      for (j = 0; j < TX_SIZES - 3; ++j)
-        fc->tx_probs.p8x8[i][j] =
-            mode_mv_merge_probs(pre_fc->tx_probs.p8x8[i][j], branch_ct_8x8p[j]);
-
-      tx_counts_to_branch_counts_16x16(counts->tx.p16x16[i], branch_ct_16x16p);
-      for (j = 0; j < TX_SIZES - 2; ++j)
-        fc->tx_probs.p16x16[i][j] = mode_mv_merge_probs(
-            pre_fc->tx_probs.p16x16[i][j], branch_ct_16x16p[j]);
-
-      tx_counts_to_branch_counts_32x32(counts->tx.p32x32[i], branch_ct_32x32p);
-      for (j = 0; j < TX_SIZES - 1; ++j)
-        fc->tx_probs.p32x32[i][j] = mode_mv_merge_probs(
-            pre_fc->tx_probs.p32x32[i][j], branch_ct_32x32p[j]);
+      tx_counts_to_branch_counts_8x8(counts->tx.p8x8[i], branch_ct_8x8p[i]);
+      tx_counts_to_branch_counts_16x16(counts->tx.p16x16[i],
+                                       branch_ct_16x16p[i]);
+      tx_counts_to_branch_counts_32x32(counts->tx.p32x32[i],
+                                       branch_ct_32x32p[i]);
     }
+    vp9_mode_mv_merge_probs(pre_fc->tx_probs.p8x8[0], branch_ct_8x8p[0][0],
+                            TX_SIZE_CONTEXTS * (TX_SIZES - 3),
+                            fc->tx_probs.p8x8[0]);
+    vp9_mode_mv_merge_probs(pre_fc->tx_probs.p16x16[0], branch_ct_16x16p[0][0],
+                            TX_SIZE_CONTEXTS * (TX_SIZES - 2),
+                            fc->tx_probs.p16x16[0]);
+    vp9_mode_mv_merge_probs(pre_fc->tx_probs.p32x32[0], branch_ct_32x32p[0][0],
+                            TX_SIZE_CONTEXTS * (TX_SIZES - 1),
+                            fc->tx_probs.p32x32[0]);
   }
 
-  for (i = 0; i < SKIP_CONTEXTS; ++i)
-    fc->skip_probs[i] =
-        mode_mv_merge_probs(pre_fc->skip_probs[i], counts->skip[i]);
+  vp9_mode_mv_merge_probs(pre_fc->skip_probs, counts->skip[0], SKIP_CONTEXTS,
+                          fc->skip_probs);
 }
 
 static void set_default_lf_deltas(struct loopfilter *lf) {
@@ -93,6 +93,18 @@ void vp9_setup_past_independence(struct VP9Common *cm);
 
 void vp9_adapt_mode_probs(struct VP9Common *cm);
 
+// Adapts |n| probabilities with the mode and mv update rate. |branch_ct| holds
+// a pair of branch counts for each probability.
+void vp9_mode_mv_merge_probs(const vpx_prob *pre_probs,
+                             const unsigned int *branch_ct, int n,
+                             vpx_prob *probs);
+
+// Adapts the probabilities of |n| consecutive trees of |num_nodes| nodes, the
+// batched form of vpx_tree_merge_probs().
+void vp9_tree_merge_probs(const vpx_tree_index *tree, int num_nodes,
+                          const vpx_prob *pre_probs,
+                          const unsigned int *counts, int n, vpx_prob *probs);
+
 void tx_counts_to_branch_counts_32x32(const unsigned int *tx_count_32x32p,
                                       unsigned int (*ct_32x32p)[2]);
 void tx_counts_to_branch_counts_16x16(const unsigned int *tx_count_16x16p,
@@ -152,14 +152,14 @@ void vp9_inc_mv(const MV *mv, nmv_context_counts *counts) {
 }
 
 void vp9_adapt_mv_probs(VP9_COMMON *cm, int allow_hp) {
-  int i, j;
+  int i;
 
   nmv_context *fc = &cm->fc->nmvc;
   const nmv_context *pre_fc = &cm->frame_contexts[cm->frame_context_idx].nmvc;
   const nmv_context_counts *counts = &cm->counts.mv;
 
-  vpx_tree_merge_probs(vp9_mv_joint_tree, pre_fc->joints, counts->joints,
-                       fc->joints);
+  vp9_tree_merge_probs(vp9_mv_joint_tree, MV_JOINTS - 1, pre_fc->joints,
+                       counts->joints, 1, fc->joints);
 
   for (i = 0; i < 2; ++i) {
     nmv_component *comp = &fc->comps[i];
@@ -167,19 +167,16 @@ void vp9_adapt_mv_probs(VP9_COMMON *cm, int allow_hp) {
     const nmv_component_counts *c = &counts->comps[i];
 
     comp->sign = mode_mv_merge_probs(pre_comp->sign, c->sign);
-    vpx_tree_merge_probs(vp9_mv_class_tree, pre_comp->classes, c->classes,
-                         comp->classes);
-    vpx_tree_merge_probs(vp9_mv_class0_tree, pre_comp->class0, c->class0,
-                         comp->class0);
-
-    for (j = 0; j < MV_OFFSET_BITS; ++j)
-      comp->bits[j] = mode_mv_merge_probs(pre_comp->bits[j], c->bits[j]);
-
-    for (j = 0; j < CLASS0_SIZE; ++j)
-      vpx_tree_merge_probs(vp9_mv_fp_tree, pre_comp->class0_fp[j],
-                           c->class0_fp[j], comp->class0_fp[j]);
-
-    vpx_tree_merge_probs(vp9_mv_fp_tree, pre_comp->fp, c->fp, comp->fp);
+    vp9_tree_merge_probs(vp9_mv_class_tree, MV_CLASSES - 1, pre_comp->classes,
+                         c->classes, 1, comp->classes);
+    vp9_tree_merge_probs(vp9_mv_class0_tree, CLASS0_SIZE - 1, pre_comp->class0,
+                         c->class0, 1, comp->class0);
+    vp9_mode_mv_merge_probs(pre_comp->bits, c->bits[0], MV_OFFSET_BITS,
+                            comp->bits);
+    vp9_tree_merge_probs(vp9_mv_fp_tree, MV_FP_SIZE - 1, pre_comp->class0_fp[0],
+                         c->class0_fp[0], CLASS0_SIZE, comp->class0_fp[0]);
+    vp9_tree_merge_probs(vp9_mv_fp_tree, MV_FP_SIZE - 1, pre_comp->fp, c->fp,
+                         1, comp->fp);
 
     if (allow_hp) {
       comp->class0_hp = mode_mv_merge_probs(pre_comp->class0_hp, c->class0_hp);
@@ -250,14 +250,8 @@ void vp9_loop_filter_init(VP9_COMMON *cm) {
 }
 
 void vp9_loop_filter_frame_init(VP9_COMMON *cm, int default_filt_lvl) {
-  int seg_id;
-  // n_shift is the multiplier for lf_deltas
-  // the multiplier is 1 for when filter_lvl is between 0 and 31;
-  // 2 when filter_lvl is between 32 and 63
-  const int scale = 1 << (default_filt_lvl >> 5);
   loop_filter_info_n *const lfi = &cm->lf_info;
   struct loopfilter *const lf = &cm->lf;
-  const struct segmentation *const seg = &cm->seg;
 
   // update limits if sharpness has changed
   if (lf->last_sharpness_level != lf->sharpness_level) {
@@ -265,6 +259,19 @@ void vp9_loop_filter_frame_init(VP9_COMMON *cm, int default_filt_lvl) {
     lf->last_sharpness_level = lf->sharpness_level;
   }
 
+  vp9_loop_filter_set_levels(cm, default_filt_lvl, lfi);
+}
+
+void vp9_loop_filter_set_levels(const VP9_COMMON *cm, int default_filt_lvl,
+                                loop_filter_info_n *lfi) {
+  int seg_id;
+  // n_shift is the multiplier for lf_deltas
+  // the multiplier is 1 for when filter_lvl is between 0 and 31;
+  // 2 when filter_lvl is between 32 and 63
+  const int scale = 1 << (default_filt_lvl >> 5);
+  const struct loopfilter *const lf = &cm->lf;
+  const struct segmentation *const seg = &cm->seg;
+
   for (seg_id = 0; seg_id < MAX_SEGMENTS; seg_id++) {
     int lvl_seg = default_filt_lvl;
     if (segfeature_active(seg, seg_id, SEG_LVL_ALT_LF)) {
@@ -882,8 +889,15 @@ void vp9_adjust_mask(VP9_COMMON *const cm, const int mi_row, const int mi_col,
 void vp9_setup_mask(VP9_COMMON *const cm, const int mi_row, const int mi_col,
                     MODE_INFO **mi8x8, const int mode_info_stride,
                     LOOP_FILTER_MASK *lfm) {
+  vp9_setup_mask_lfi(cm, &cm->lf_info, mi_row, mi_col, mi8x8, mode_info_stride,
+                     lfm);
+}
+
+void vp9_setup_mask_lfi(const VP9_COMMON *const cm,
+                        const loop_filter_info_n *const lfi_n,
+                        const int mi_row, const int mi_col, MODE_INFO **mi8x8,
+                        const int mode_info_stride, LOOP_FILTER_MASK *lfm) {
   int idx_32, idx_16, idx_8;
-  const loop_filter_info_n *const lfi_n = &cm->lf_info;
   MODE_INFO **mip = mi8x8;
   MODE_INFO **mip2 = mi8x8;
 
@@ -100,6 +100,13 @@ void vp9_setup_mask(struct VP9Common *const cm, const int mi_row,
                     const int mi_col, MODE_INFO **mi8x8,
                     const int mode_info_stride, LOOP_FILTER_MASK *lfm);
 
+// Same as vp9_setup_mask() but takes the filter levels from |lfi_n| instead
+// of cm->lf_info.
+void vp9_setup_mask_lfi(const struct VP9Common *const cm,
+                        const loop_filter_info_n *const lfi_n,
+                        const int mi_row, const int mi_col, MODE_INFO **mi8x8,
+                        const int mode_info_stride, LOOP_FILTER_MASK *lfm);
+
 void vp9_filter_block_plane_ss00(struct VP9Common *const cm,
                                  struct macroblockd_plane *const plane,
                                  int mi_row, LOOP_FILTER_MASK *lfm);
@@ -119,6 +126,11 @@ void vp9_loop_filter_init(struct VP9Common *cm);
 // calls this function directly.
 void vp9_loop_filter_frame_init(struct VP9Common *cm, int default_filt_lvl);
 
+// Fills lfi->lvl for |default_filt_lvl| using the segmentation and the
+// reference/mode deltas of |cm|. The limits in lfi->lfthr are left untouched.
+void vp9_loop_filter_set_levels(const struct VP9Common *cm,
+                                int default_filt_lvl, loop_filter_info_n *lfi);
+
 void vp9_loop_filter_frame(YV12_BUFFER_CONFIG *frame, struct VP9Common *cm,
                            struct macroblockd *xd, int frame_filter_level,
                            int y_only, int partial_frame);
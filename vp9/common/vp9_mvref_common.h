@@ -242,6 +242,19 @@ static INLINE int_mv scale_mv(const MODE_INFO *mi, int ref,
   return mv;
 }
 
+// Same as scale_mv() for an entry of a MV_REF plane.
+static INLINE int_mv scale_frame_mv(const MV_REF *frame_mv, int ref,
+                                    const MV_REFERENCE_FRAME this_ref_frame,
+                                    const int *ref_sign_bias) {
+  int_mv mv = frame_mv->mv[ref];
+  if (ref_sign_bias[frame_mv->ref_frame[ref]] !=
+      ref_sign_bias[this_ref_frame]) {
+    mv.as_mv.row *= -1;
+    mv.as_mv.col *= -1;
+  }
+  return mv;
+}
+
 // This macro is used to add a motion vector mv_ref list if it isn't
 // already in the list.  If it's the second motion vector it will also
 // skip all additional processing and jump to Done!
@@ -121,7 +121,7 @@ if (vpx_config("CONFIG_VP9_ENCODER") eq "yes") {
 #
 if (vpx_config("CONFIG_VP9_TEMPORAL_DENOISING") eq "yes") {
   add_proto qw/int vp9_denoiser_filter/, "const uint8_t *sig, int sig_stride, const uint8_t *mc_avg, int mc_avg_stride, uint8_t *avg, int avg_stride, int increase_denoising, BLOCK_SIZE bs, int motion_magnitude";
-  specialize qw/vp9_denoiser_filter neon sse2/;
+  specialize qw/vp9_denoiser_filter neon sse2 avx2/;
 }
 
 add_proto qw/int64_t vp9_block_error/, "const tran_low_t *coeff, const tran_low_t *dqcoeff, intptr_t block_size, int64_t *ssz";
@@ -168,6 +168,18 @@ if (vpx_config("CONFIG_VP9_HIGHBITDEPTH") ne "yes") {
   specialize qw/vp9_fwht4x4 msa/;
 }
 
+#
+# Spatial denoiser for key frames
+#
+add_proto qw/void vp9_spatial_denoise_row/, "const uint8_t *src, int src_stride, uint8_t *dst, int width, int strength";
+specialize qw/vp9_spatial_denoise_row sse2/;
+
+#
+# Neural network inference
+#
+add_proto qw/void vp9_nn_fc_layer/, "const float *input, int num_inputs, int num_samples, const float *weights, const float *bias, int num_outputs, int relu, float *output";
+specialize qw/vp9_nn_fc_layer sse2 avx2 neon/;
+
 #
 # Motion search
 #
@@ -21,6 +21,7 @@
 #include "vpx_mem/vpx_mem.h"
 #include "vpx_ports/mem.h"
 #include "vpx_ports/mem_ops.h"
+#include "vpx_ports/vpx_timer.h"
 #include "vpx_scale/vpx_scale.h"
 #include "vpx_util/vpx_thread.h"
 #if CONFIG_BITSTREAM_DEBUG || CONFIG_MISMATCH_DEBUG
@@ -1685,6 +1686,8 @@ static void get_tile_buffers(VP9Decoder *pbi, const uint8_t *data,
                              TileBuffer (*tile_buffers)[1 << 6]) {
   int r, c;
 
+  assert(tile_rows * tile_cols <= VPX_DECODE_PROFILE_MAX_TILES);
+  pbi->profile.tile_count = tile_rows * tile_cols;
   for (r = 0; r < tile_rows; ++r) {
     for (c = 0; c < tile_cols; ++c) {
       const int is_last = (r == tile_rows - 1) && (c == tile_cols - 1);
@@ -1692,10 +1695,41 @@ static void get_tile_buffers(VP9Decoder *pbi, const uint8_t *data,
       buf->col = c;
       get_tile_buffer(data_end, is_last, &pbi->common.error, &data,
                       pbi->decrypt_cb, pbi->decrypt_state, buf);
+      pbi->profile.tile_bytes[r * tile_cols + c] = (uint32_t)buf->size;
     }
   }
 }
 
+static void add_decode_times(vpx_decode_profile_t *profile,
+                             const VP9DecodeTimes *times) {
+  profile->parse_us += times->parse_us;
+  profile->recon_us += times->recon_us;
+  profile->loopfilter_us += times->loopfilter_us;
+  profile->wait_us += times->wait_us;
+}
+
+// Waits for |worker| to finish, counting the time blocked as waiting.
+static int sync_worker(VP9Decoder *pbi, VPxWorker *worker) {
+  struct vpx_usec_timer timer;
+  int ok;
+  vpx_usec_timer_start(&timer);
+  ok = vpx_get_worker_interface()->sync(worker);
+  vpx_usec_timer_mark(&timer);
+  pbi->profile.wait_us += vpx_usec_timer_elapsed(&timer);
+  return ok;
+}
+
+static int dec_loop_filter_worker(void *arg1, void *arg2) {
+  VP9Decoder *const pbi = (VP9Decoder *)arg2;
+  struct vpx_usec_timer timer;
+  int ret;
+  vpx_usec_timer_start(&timer);
+  ret = vp9_loop_filter_worker(arg1, NULL);
+  vpx_usec_timer_mark(&timer);
+  pbi->profile.loopfilter_us += vpx_usec_timer_elapsed(&timer);
+  return ret;
+}
+
 static void map_write(RowMTWorkerData *const row_mt_worker_data, int map_idx,
                       int sync_idx) {
 #if CONFIG_MULTITHREAD
@@ -1711,20 +1745,27 @@ static void map_write(RowMTWorkerData *const row_mt_worker_data, int map_idx,
 }
 
 static void map_read(RowMTWorkerData *const row_mt_worker_data, int map_idx,
-                     int sync_idx) {
+                     int sync_idx, int64_t *wait_us) {
 #if CONFIG_MULTITHREAD
   volatile int8_t *map = row_mt_worker_data->recon_map + map_idx;
   pthread_mutex_t *const mutex =
       &row_mt_worker_data->recon_sync_mutex[sync_idx];
   pthread_mutex_lock(mutex);
-  while (!(*map)) {
-    pthread_cond_wait(&row_mt_worker_data->recon_sync_cond[sync_idx], mutex);
+  if (!(*map)) {
+    struct vpx_usec_timer timer;
+    vpx_usec_timer_start(&timer);
+    while (!(*map)) {
+      pthread_cond_wait(&row_mt_worker_data->recon_sync_cond[sync_idx], mutex);
+    }
+    vpx_usec_timer_mark(&timer);
+    *wait_us += vpx_usec_timer_elapsed(&timer);
   }
   pthread_mutex_unlock(mutex);
 #else
   (void)row_mt_worker_data;
   (void)map_idx;
   (void)sync_idx;
+  (void)wait_us;
 #endif  // CONFIG_MULTITHREAD
 }
 
@@ -1785,7 +1826,7 @@ static void vp9_jobq_alloc(VP9Decoder *pbi) {
 
 static void recon_tile_row(TileWorkerData *tile_data, VP9Decoder *pbi,
                            int mi_row, int is_last_row, VP9LfSync *lf_sync,
-                           int cur_tile_col) {
+                           int cur_tile_col, int64_t *wait_us) {
   VP9_COMMON *const cm = &pbi->common;
   RowMTWorkerData *const row_mt_worker_data = pbi->row_mt_worker_data;
   const int tile_cols = 1 << cm->log2_tile_cols;
@@ -1806,7 +1847,7 @@ static void recon_tile_row(TileWorkerData *tile_data, VP9Decoder *pbi,
     // Top Dependency
     if (cur_sb_row) {
       map_read(row_mt_worker_data, ((cur_sb_row - 1) * sb_cols) + c,
-               ((cur_sb_row - 1) * tile_cols) + cur_tile_col);
+               ((cur_sb_row - 1) * tile_cols) + cur_tile_col, wait_us);
     }
 
     for (plane = 0; plane < MAX_MB_PLANE; ++plane) {
@@ -1890,6 +1931,17 @@ static void parse_tile_row(TileWorkerData *tile_data, VP9Decoder *pbi,
   }
 }
 
+static int dequeue_job(RowMTWorkerData *row_mt_worker_data, Job *job,
+                       VP9DecodeTimes *times) {
+  struct vpx_usec_timer timer;
+  int ret;
+  vpx_usec_timer_start(&timer);
+  ret = vp9_jobq_dequeue(&row_mt_worker_data->jobq, job, sizeof(*job), 1);
+  vpx_usec_timer_mark(&timer);
+  times->wait_us += vpx_usec_timer_elapsed(&timer);
+  return ret;
+}
+
 static int row_decode_worker_hook(void *arg1, void *arg2) {
   ThreadData *const thread_data = (ThreadData *)arg1;
   uint8_t **data_end = (uint8_t **)arg2;
@@ -1903,10 +1955,11 @@ static int row_decode_worker_hook(void *arg1, void *arg2) {
   Job job;
   LFWorkerData *lf_data = thread_data->lf_data;
   VP9LfSync *lf_sync = thread_data->lf_sync;
+  VP9DecodeTimes *const times = &thread_data->times;
   volatile int corrupted = 0;
   TileWorkerData *volatile tile_data_recon = NULL;
 
-  while (!vp9_jobq_dequeue(&row_mt_worker_data->jobq, &job, sizeof(job), 1)) {
+  while (!dequeue_job(row_mt_worker_data, &job, times)) {
     int mi_col;
     const int mi_row = job.row_num;
 
@@ -1916,7 +1969,11 @@ static int row_decode_worker_hook(void *arg1, void *arg2) {
 
       if (cm->lf.filter_level && !cm->skip_loop_filter &&
           mi_row < cm->mi_rows) {
+        struct vpx_usec_timer timer;
+        vpx_usec_timer_start(&timer);
         vp9_loopfilter_job(lf_data, lf_sync);
+        vpx_usec_timer_mark(&timer);
+        times->loopfilter_us += vpx_usec_timer_elapsed(&timer);
       }
     } else if (job.job_type == RECON_JOB) {
       const int cur_sb_row = mi_row >> MI_BLOCK_SIZE_LOG2;
@@ -1951,8 +2008,16 @@ static int row_decode_worker_hook(void *arg1, void *arg2) {
       tile_data_recon->error_info.setjmp = 1;
       tile_data_recon->xd.error_info = &tile_data_recon->error_info;
 
-      recon_tile_row(tile_data_recon, pbi, mi_row, is_last_row, lf_sync,
-                     job.tile_col);
+      {
+        struct vpx_usec_timer timer;
+        int64_t wait_us = 0;
+        vpx_usec_timer_start(&timer);
+        recon_tile_row(tile_data_recon, pbi, mi_row, is_last_row, lf_sync,
+                       job.tile_col, &wait_us);
+        vpx_usec_timer_mark(&timer);
+        times->recon_us += vpx_usec_timer_elapsed(&timer) - wait_us;
+        times->wait_us += wait_us;
+      }
 
       if (corrupted)
         vpx_internal_error(&tile_data_recon->error_info,
@@ -1978,7 +2043,13 @@ static int row_decode_worker_hook(void *arg1, void *arg2) {
 
       tile_data->error_info.setjmp = 1;
 
-      parse_tile_row(tile_data, pbi, mi_row, job.tile_col, data_end);
+      {
+        struct vpx_usec_timer timer;
+        vpx_usec_timer_start(&timer);
+        parse_tile_row(tile_data, pbi, mi_row, job.tile_col, data_end);
+        vpx_usec_timer_mark(&timer);
+        times->parse_us += vpx_usec_timer_elapsed(&timer);
+      }
 
       corrupted |= tile_data->xd.corrupted;
       if (corrupted)
@@ -2022,12 +2093,15 @@ static const uint8_t *decode_tiles(VP9Decoder *pbi, const uint8_t *data,
   int tile_row, tile_col;
   int mi_row, mi_col;
   TileWorkerData *tile_data = NULL;
+  struct vpx_usec_timer timer;
+  int64_t parse_us = 0;
 
   if (cm->lf.filter_level && !cm->skip_loop_filter &&
       pbi->lf_worker.data1 == NULL) {
     CHECK_MEM_ERROR(cm, pbi->lf_worker.data1,
                     vpx_memalign(32, sizeof(LFWorkerData)));
-    pbi->lf_worker.hook = vp9_loop_filter_worker;
+    pbi->lf_worker.hook = dec_loop_filter_worker;
+    pbi->lf_worker.data2 = pbi;
     if (pbi->max_threads > 1 && !winterface->reset(&pbi->lf_worker)) {
       vpx_internal_error(&cm->error, VPX_CODEC_ERROR,
                          "Loop filter thread creation failed");
@@ -2037,7 +2111,7 @@ static const uint8_t *decode_tiles(VP9Decoder *pbi, const uint8_t *data,
   if (cm->lf.filter_level && !cm->skip_loop_filter) {
     LFWorkerData *const lf_data = (LFWorkerData *)pbi->lf_worker.data1;
     // Be sure to sync as we might be resuming after a failed frame decode.
-    winterface->sync(&pbi->lf_worker);
+    sync_worker(pbi, &pbi->lf_worker);
     vp9_loop_filter_data_reset(lf_data, get_frame_new_buffer(cm), cm,
                                pbi->mb.plane);
   }
@@ -2087,19 +2161,24 @@ static const uint8_t *decode_tiles(VP9Decoder *pbi, const uint8_t *data,
         vp9_tile_set_col(&tile, cm, col);
         vp9_zero(tile_data->xd.left_context);
         vp9_zero(tile_data->xd.left_seg_context);
+        vpx_usec_timer_start(&timer);
         for (mi_col = tile.mi_col_start; mi_col < tile.mi_col_end;
              mi_col += MI_BLOCK_SIZE) {
           if (pbi->row_mt == 1) {
             int plane;
             RowMTWorkerData *const row_mt_worker_data = pbi->row_mt_worker_data;
+            struct vpx_usec_timer parse_timer;
             for (plane = 0; plane < MAX_MB_PLANE; ++plane) {
               tile_data->xd.plane[plane].eob = row_mt_worker_data->eob[plane];
               tile_data->xd.plane[plane].dqcoeff =
                   row_mt_worker_data->dqcoeff[plane];
             }
             tile_data->xd.partition = row_mt_worker_data->partition;
+            vpx_usec_timer_start(&parse_timer);
             process_partition(tile_data, pbi, mi_row, mi_col, BLOCK_64X64, 4,
                               PARSE, parse_block);
+            vpx_usec_timer_mark(&parse_timer);
+            parse_us += vpx_usec_timer_elapsed(&parse_timer);
 
             for (plane = 0; plane < MAX_MB_PLANE; ++plane) {
               tile_data->xd.plane[plane].eob = row_mt_worker_data->eob[plane];
@@ -2113,6 +2192,8 @@ static const uint8_t *decode_tiles(VP9Decoder *pbi, const uint8_t *data,
             decode_partition(tile_data, pbi, mi_row, mi_col, BLOCK_64X64, 4);
           }
         }
+        vpx_usec_timer_mark(&timer);
+        pbi->profile.recon_us += vpx_usec_timer_elapsed(&timer);
         pbi->mb.corrupted |= tile_data->xd.corrupted;
         if (pbi->mb.corrupted)
           vpx_internal_error(&cm->error, VPX_CODEC_CORRUPT_FRAME,
@@ -2129,7 +2210,7 @@ static const uint8_t *decode_tiles(VP9Decoder *pbi, const uint8_t *data,
         // decoding has completed: finish up the loop filter in this thread.
         if (mi_row + MI_BLOCK_SIZE >= cm->mi_rows) continue;
 
-        winterface->sync(&pbi->lf_worker);
+        sync_worker(pbi, &pbi->lf_worker);
         lf_data->start = lf_start;
         lf_data->stop = mi_row;
         if (pbi->max_threads > 1) {
@@ -2144,12 +2225,16 @@ static const uint8_t *decode_tiles(VP9Decoder *pbi, const uint8_t *data,
   // Loopfilter remaining rows in the frame.
   if (cm->lf.filter_level && !cm->skip_loop_filter) {
     LFWorkerData *const lf_data = (LFWorkerData *)pbi->lf_worker.data1;
-    winterface->sync(&pbi->lf_worker);
+    sync_worker(pbi, &pbi->lf_worker);
     lf_data->start = lf_data->stop;
     lf_data->stop = cm->mi_rows;
     winterface->execute(&pbi->lf_worker);
   }
 
+  // The separate parsing passes were counted as reconstruction above.
+  pbi->profile.parse_us += parse_us;
+  pbi->profile.recon_us -= parse_us;
+
   // Get last tile data.
   tile_data = pbi->tile_worker_data + tile_cols * tile_rows - 1;
 
@@ -2229,12 +2314,16 @@ static int tile_worker_hook(void *arg1, void *arg2) {
 
     for (mi_row = tile->mi_row_start; mi_row < tile->mi_row_end;
          mi_row += MI_BLOCK_SIZE) {
+      struct vpx_usec_timer timer;
       vp9_zero(tile_data->xd.left_context);
       vp9_zero(tile_data->xd.left_seg_context);
+      vpx_usec_timer_start(&timer);
       for (mi_col = tile->mi_col_start; mi_col < tile->mi_col_end;
            mi_col += MI_BLOCK_SIZE) {
         decode_partition(tile_data, pbi, mi_row, mi_col, BLOCK_64X64, 4);
       }
+      vpx_usec_timer_mark(&timer);
+      tile_data->times.recon_us += vpx_usec_timer_elapsed(&timer);
       if (pbi->lpf_mt_opt && cm->lf.filter_level && !cm->skip_loop_filter) {
         const int aligned_rows = mi_cols_aligned_to_sb(cm->mi_rows);
         const int sb_rows = (aligned_rows >> MI_BLOCK_SIZE_LOG2);
@@ -2262,7 +2351,11 @@ static int tile_worker_hook(void *arg1, void *arg2) {
 
   if (pbi->lpf_mt_opt && !tile_data->xd.corrupted && cm->lf.filter_level &&
       !cm->skip_loop_filter) {
+    struct vpx_usec_timer timer;
+    vpx_usec_timer_start(&timer);
     vp9_loopfilter_rows(lf_data, lf_sync);
+    vpx_usec_timer_mark(&timer);
+    tile_data->times.loopfilter_us += vpx_usec_timer_elapsed(&timer);
   }
 
   tile_data->data_end = bit_reader_end;
@@ -2357,6 +2450,7 @@ static const uint8_t *decode_tiles_row_wise_mt(VP9Decoder *pbi,
     }
 
     thread_data->pbi = pbi;
+    vp9_zero(thread_data->times);
 
     worker->hook = row_decode_worker_hook;
     worker->data1 = thread_data;
@@ -2412,7 +2506,9 @@ static const uint8_t *decode_tiles_row_wise_mt(VP9Decoder *pbi,
     // its vpx_internal_error_info which could be propagated to the main info
     // in cm. Additionally once the threads have been synced and an error is
     // detected, there's no point in continuing to decode tiles.
-    corrupted |= !winterface->sync(worker);
+    corrupted |= !sync_worker(pbi, worker);
+    add_decode_times(&pbi->profile,
+                     &pbi->row_mt_worker_data->thread_data[n - 1].times);
   }
 
   pbi->mb.corrupted = corrupted;
@@ -2469,6 +2565,7 @@ static const uint8_t *decode_tiles_mt(VP9Decoder *pbi, const uint8_t *data,
     tile_data->xd = pbi->mb;
     tile_data->xd.counts =
         cm->frame_parallel_decoding_mode ? NULL : &tile_data->counts;
+    vp9_zero(tile_data->times);
     worker->hook = tile_worker_hook;
     worker->data1 = tile_data;
     worker->data2 = pbi;
@@ -2546,7 +2643,8 @@ static const uint8_t *decode_tiles_mt(VP9Decoder *pbi, const uint8_t *data,
       // its vpx_internal_error_info which could be propagated to the main info
       // in cm. Additionally once the threads have been synced and an error is
       // detected, there's no point in continuing to decode tiles.
-      pbi->mb.corrupted |= !winterface->sync(worker);
+      pbi->mb.corrupted |= !sync_worker(pbi, worker);
+      add_decode_times(&pbi->profile, &tile_data->times);
       if (!bit_reader_end) bit_reader_end = tile_data->data_end;
     }
   }
@@ -2944,6 +3042,27 @@ BITSTREAM_PROFILE vp9_read_profile(struct vpx_read_bit_buffer *rb) {
   return (BITSTREAM_PROFILE)profile;
 }
 
+// Adapts the probabilities to the counts of the frame just decoded and stores
+// the result in the frame context it refreshes.
+static int adapt_frame_context(void *arg1, void *unused) {
+  VP9_COMMON *const cm = (VP9_COMMON *)arg1;
+  (void)unused;
+
+  if (!cm->error_resilient_mode && !cm->frame_parallel_decoding_mode) {
+    vp9_adapt_coef_probs(cm);
+
+    if (!frame_is_intra_only(cm)) {
+      vp9_adapt_mode_probs(cm);
+      vp9_adapt_mv_probs(cm, cm->allow_high_precision_mv);
+    }
+  }
+
+  // Non frame parallel update frame context here.
+  if (cm->refresh_frame_context)
+    cm->frame_contexts[cm->frame_context_idx] = *cm->fc;
+  return 1;
+}
+
 void vp9_decode_frame(VP9Decoder *pbi, const uint8_t *data,
                       const uint8_t *data_end, const uint8_t **p_data_end) {
   VP9_COMMON *const cm = &pbi->common;
@@ -2951,11 +3070,17 @@ void vp9_decode_frame(VP9Decoder *pbi, const uint8_t *data,
   struct vpx_read_bit_buffer rb;
   int context_updated = 0;
   uint8_t clear_data[MAX_VP9_HEADER_SIZE];
-  const size_t first_partition_size = read_uncompressed_header(
+  struct vpx_usec_timer timer;
+  size_t first_partition_size;
+  int tile_rows, tile_cols;
+  YV12_BUFFER_CONFIG *new_fb;
+
+  vpx_usec_timer_start(&timer);
+  first_partition_size = read_uncompressed_header(
       pbi, init_read_bit_buffer(pbi, &rb, data, data_end, clear_data));
-  const int tile_rows = 1 << cm->log2_tile_rows;
-  const int tile_cols = 1 << cm->log2_tile_cols;
-  YV12_BUFFER_CONFIG *const new_fb = get_frame_new_buffer(cm);
+  tile_rows = 1 << cm->log2_tile_rows;
+  tile_cols = 1 << cm->log2_tile_cols;
+  new_fb = get_frame_new_buffer(cm);
 #if CONFIG_BITSTREAM_DEBUG || CONFIG_MISMATCH_DEBUG
   bitstream_queue_set_frame_read(cm->current_video_frame * 2 + cm->show_frame);
 #endif
@@ -2993,6 +3118,8 @@ void vp9_decode_frame(VP9Decoder *pbi, const uint8_t *data,
     vpx_internal_error(&cm->error, VPX_CODEC_CORRUPT_FRAME,
                        "Decode failed. Frame data header is corrupted.");
 
+  vp9_setup_token_probs(&pbi->token_probs, cm->fc, cm->tx_mode);
+
   if (cm->lf.filter_level && !cm->skip_loop_filter) {
     vp9_loop_filter_frame_init(cm, cm->lf.filter_level);
   }
@@ -3002,14 +3129,20 @@ void vp9_decode_frame(VP9Decoder *pbi, const uint8_t *data,
     const int num_tile_workers =
         tile_cols * tile_rows + ((pbi->max_threads > 1) ? pbi->max_threads : 0);
     const size_t twd_size = num_tile_workers * sizeof(*pbi->tile_worker_data);
+    int i;
     // Ensure tile data offsets will be properly aligned. This may fail on
     // platforms without DECLARE_ALIGNED().
     assert((sizeof(*pbi->tile_worker_data) % 16) == 0);
     vpx_free(pbi->tile_worker_data);
     CHECK_MEM_ERROR(cm, pbi->tile_worker_data, vpx_memalign(32, twd_size));
     pbi->total_tiles = tile_rows * tile_cols;
+    for (i = 0; i < num_tile_workers; ++i)
+      pbi->tile_worker_data[i].token_probs = &pbi->token_probs;
   }
 
+  vpx_usec_timer_mark(&timer);
+  pbi->profile.header_us += vpx_usec_timer_elapsed(&timer);
+
   if (pbi->max_threads > 1 && tile_rows == 1 &&
       (tile_cols > 1 || pbi->row_mt == 1)) {
     if (pbi->row_mt == 1) {
@@ -3023,9 +3156,12 @@ void vp9_decode_frame(VP9Decoder *pbi, const uint8_t *data,
           if (!cm->skip_loop_filter) {
             // If multiple threads are used to decode tiles, then we use those
             // threads to do parallel loopfiltering.
+            vpx_usec_timer_start(&timer);
             vp9_loop_filter_frame_mt(
                 new_fb, cm, pbi->mb.plane, cm->lf.filter_level, 0, 0,
                 pbi->tile_workers, pbi->num_tile_workers, &pbi->lf_row_sync);
+            vpx_usec_timer_mark(&timer);
+            pbi->profile.loopfilter_us += vpx_usec_timer_elapsed(&timer);
           }
         } else {
           vpx_internal_error(&cm->error, VPX_CODEC_CORRUPT_FRAME,
@@ -3037,21 +3173,24 @@ void vp9_decode_frame(VP9Decoder *pbi, const uint8_t *data,
     *p_data_end = decode_tiles(pbi, data + first_partition_size, data_end);
   }
 
-  if (!xd->corrupted) {
-    if (!cm->error_resilient_mode && !cm->frame_parallel_decoding_mode) {
-      vp9_adapt_coef_probs(cm);
-
-      if (!frame_is_intra_only(cm)) {
-        vp9_adapt_mode_probs(cm);
-        vp9_adapt_mv_probs(cm, cm->allow_high_precision_mv);
-      }
-    }
-  } else {
+  if (xd->corrupted) {
     vpx_internal_error(&cm->error, VPX_CODEC_CORRUPT_FRAME,
                        "Decode failed. Frame data is corrupted.");
   }
 
-  // Non frame parallel update frame context here.
-  if (cm->refresh_frame_context && !context_updated)
-    cm->frame_contexts[cm->frame_context_idx] = *cm->fc;
+  if (!context_updated) {
+    const VPxWorkerInterface *const winterface = vpx_get_worker_interface();
+    VPxWorker *const worker = &pbi->adapt_worker;
+    worker->hook = adapt_frame_context;
+    worker->data1 = cm;
+    worker->data2 = NULL;
+    // With threads the adaptation overlaps the output of this frame and the
+    // setup of the next one. vp9_receive_compressed_data() waits for it before
+    // the next frame header is read.
+    if (pbi->max_threads > 1 && winterface->reset(worker)) {
+      winterface->launch(worker);
+    } else {
+      winterface->execute(worker);
+    }
+  }
 }
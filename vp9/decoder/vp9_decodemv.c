@@ -465,17 +465,20 @@ static int read_is_inter_block(VP9_COMMON *const cm, MACROBLOCKD *const xd,
 
 // If either reference frame is different, not INTRA, and they
 // are different from each other scale and add the mv to our list.
-#define IF_DIFF_REF_FRAME_ADD_MV_EB(mbmi, ref_frame, ref_sign_bias,       \
+#define IF_DIFF_REF_FRAME_ADD_MV_EB(frame_mv, ref_frame, ref_sign_bias,   \
                                     refmv_count, mv_ref_list, Done)       \
   do {                                                                    \
-    if (is_inter_block(mbmi)) {                                           \
-      if ((mbmi)->ref_frame[0] != ref_frame)                              \
-        ADD_MV_REF_LIST_EB(scale_mv((mbmi), 0, ref_frame, ref_sign_bias), \
-                           refmv_count, mv_ref_list, Done);               \
-      if (has_second_ref(mbmi) && (mbmi)->ref_frame[1] != ref_frame &&    \
-          (mbmi)->mv[1].as_int != (mbmi)->mv[0].as_int)                   \
-        ADD_MV_REF_LIST_EB(scale_mv((mbmi), 1, ref_frame, ref_sign_bias), \
-                           refmv_count, mv_ref_list, Done);               \
+    if ((frame_mv)->ref_frame[0] > INTRA_FRAME) {                         \
+      if ((frame_mv)->ref_frame[0] != ref_frame)                          \
+        ADD_MV_REF_LIST_EB(                                               \
+            scale_frame_mv((frame_mv), 0, ref_frame, ref_sign_bias),      \
+            refmv_count, mv_ref_list, Done);                              \
+      if ((frame_mv)->ref_frame[1] > INTRA_FRAME &&                       \
+          (frame_mv)->ref_frame[1] != ref_frame &&                        \
+          (frame_mv)->mv[1].as_int != (frame_mv)->mv[0].as_int)           \
+        ADD_MV_REF_LIST_EB(                                               \
+            scale_frame_mv((frame_mv), 1, ref_frame, ref_sign_bias),      \
+            refmv_count, mv_ref_list, Done);                              \
     }                                                                     \
   } while (0)
 
@@ -493,6 +496,13 @@ static int dec_find_mv_refs(const VP9_COMMON *cm, const MACROBLOCKD *xd,
       cm->use_prev_frame_mvs
           ? cm->prev_frame->mvs + mi_row * cm->mi_cols + mi_col
           : NULL;
+  // Apart from the sub8x8 candidates, which need the bmi of the neighbor, the
+  // neighbors are read from the MV_REF plane of the current frame that
+  // vp9_read_mode_info() fills as the blocks are parsed. It holds the
+  // reference frames and mvs of each 8x8 in raster order, so the search does
+  // not have to chase mi_grid pointers into the much larger MODE_INFOs.
+  const MV_REF *const frame_mvs =
+      cm->cur_frame->mvs + mi_row * cm->mi_cols + mi_col;
   const TileInfo *const tile = &xd->tile;
   // If mode is nearestmv or newmv (uses nearestmv as a reference) then stop
   // searching after the first mv is found.
@@ -530,8 +540,8 @@ static int dec_find_mv_refs(const VP9_COMMON *cm, const MACROBLOCKD *xd,
   for (; i < MVREF_NEIGHBOURS; ++i) {
     const POSITION *const mv_ref = &mv_ref_search[i];
     if (is_inside(tile, mi_col, mi_row, cm->mi_rows, mv_ref)) {
-      const MODE_INFO *const candidate =
-          xd->mi[mv_ref->col + mv_ref->row * xd->mi_stride];
+      const MV_REF *const candidate =
+          frame_mvs + mv_ref->row * cm->mi_cols + mv_ref->col;
       different_ref_found = 1;
 
       if (candidate->ref_frame[0] == ref_frame)
@@ -557,8 +567,8 @@ static int dec_find_mv_refs(const VP9_COMMON *cm, const MACROBLOCKD *xd,
     for (i = 0; i < MVREF_NEIGHBOURS; ++i) {
       const POSITION *mv_ref = &mv_ref_search[i];
       if (is_inside(tile, mi_col, mi_row, cm->mi_rows, mv_ref)) {
-        const MODE_INFO *const candidate =
-            xd->mi[mv_ref->col + mv_ref->row * xd->mi_stride];
+        const MV_REF *const candidate =
+            frame_mvs + mv_ref->row * cm->mi_cols + mv_ref->col;
 
         // If the candidate is INTRA we don't want to consider its mv.
         IF_DIFF_REF_FRAME_ADD_MV_EB(candidate, ref_frame, ref_sign_bias,
@@ -209,6 +209,7 @@ VP9Decoder *vp9_decoder_create(BufferPool *const pool) {
   cm->error.setjmp = 0;
 
   vpx_get_worker_interface()->init(&pbi->lf_worker);
+  vpx_get_worker_interface()->init(&pbi->adapt_worker);
 
   return pbi;
 }
@@ -220,6 +221,7 @@ void vp9_decoder_remove(VP9Decoder *pbi) {
 
   vpx_get_worker_interface()->end(&pbi->lf_worker);
   vpx_free(pbi->lf_worker.data1);
+  vpx_get_worker_interface()->end(&pbi->adapt_worker);
 
   for (i = 0; i < pbi->num_tile_workers; ++i) {
     VPxWorker *const worker = &pbi->tile_workers[i];
@@ -411,6 +413,7 @@ int vp9_receive_compressed_data(VP9Decoder *pbi, size_t size,
   RefCntBuffer *volatile const frame_bufs = cm->buffer_pool->frame_bufs;
   const uint8_t *source = *psource;
   int retcode = 0;
+  struct vpx_usec_timer timer;
   cm->error.error_code = VPX_CODEC_OK;
 
   if (size == 0) {
@@ -430,6 +433,12 @@ int vp9_receive_compressed_data(VP9Decoder *pbi, size_t size,
 
   pbi->ready_for_new_data = 0;
 
+  // The previous frame may still be adapting the frame contexts.
+  vpx_usec_timer_start(&timer);
+  vpx_get_worker_interface()->sync(&pbi->adapt_worker);
+  vpx_usec_timer_mark(&timer);
+  pbi->profile.wait_us += vpx_usec_timer_elapsed(&timer);
+
   // Check if the previous frame was a frame without any references to it.
   if (cm->new_fb_idx >= 0 && frame_bufs[cm->new_fb_idx].ref_count == 0 &&
       !frame_bufs[cm->new_fb_idx].released) {
@@ -486,6 +495,7 @@ int vp9_receive_compressed_data(VP9Decoder *pbi, size_t size,
   if (cm->show_frame) {
     cm->current_video_frame++;
   }
+  ++pbi->profile.frame_count;
 
   cm->error.setjmp = 0;
   return retcode;
@@ -510,7 +520,11 @@ int vp9_get_raw_frame(VP9Decoder *pbi, YV12_BUFFER_CONFIG *sd,
 
 #if CONFIG_VP9_POSTPROC
   if (!cm->show_existing_frame) {
+    struct vpx_usec_timer timer;
+    vpx_usec_timer_start(&timer);
     ret = vp9_post_proc_frame(cm, sd, flags, cm->width);
+    vpx_usec_timer_mark(&timer);
+    pbi->profile.postproc_us += vpx_usec_timer_elapsed(&timer);
   } else {
     *sd = *cm->frame_to_show;
     ret = 0;
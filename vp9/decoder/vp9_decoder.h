@@ -13,6 +13,7 @@
 
 #include "./vpx_config.h"
 
+#include "vpx/vp8dx.h"
 #include "vpx/vpx_codec.h"
 #include "vpx_dsp/bitreader.h"
 #include "vpx_scale/yv12config.h"
@@ -31,12 +32,31 @@ extern "C" {
 #define DQCOEFFS_PER_SB_LOG2 12
 #define PARTITIONS_PER_SB 85
 
+// The 11 token probabilities of a coefficient context are padded to 16 bytes
+// so that the detokenizer finds all of them in a single cache line.
+#define TOKEN_PROBS_STRIDE 16
+
+// Full token probabilities of every coefficient context of the current frame,
+// expanded from the model probabilities once per frame.
+typedef vpx_prob VP9TokenProbs[TX_SIZES][PLANE_TYPES][REF_TYPES][COEF_BANDS]
+                              [COEFF_CONTEXTS][TOKEN_PROBS_STRIDE];
+
 typedef enum JobType { PARSE_JOB, RECON_JOB, LPF_JOB } JobType;
 
+// Time in microseconds spent by one thread on its share of the tile decoding.
+// It is added to the decoder profile once the thread has been synced.
+typedef struct VP9DecodeTimes {
+  int64_t parse_us;
+  int64_t recon_us;
+  int64_t loopfilter_us;
+  int64_t wait_us;
+} VP9DecodeTimes;
+
 typedef struct ThreadData {
   struct VP9Decoder *pbi;
   LFWorkerData *lf_data;
   VP9LfSync *lf_sync;
+  VP9DecodeTimes times;
 } ThreadData;
 
 typedef struct TileBuffer {
@@ -49,9 +69,11 @@ typedef struct TileWorkerData {
   const uint8_t *data_end;
   int buf_start, buf_end;  // pbi->tile_buffers to decode, inclusive
   vpx_reader bit_reader;
+  VP9TokenProbs *token_probs;
   FRAME_COUNTS counts;
   LFWorkerData *lf_data;
   VP9LfSync *lf_sync;
+  VP9DecodeTimes times;
   DECLARE_ALIGNED(16, MACROBLOCKD, xd);
   /* dqcoeff are shared by all the planes. So planes must be decoded serially */
   DECLARE_ALIGNED(16, tran_low_t, dqcoeff[32 * 32]);
@@ -96,6 +118,8 @@ typedef struct VP9Decoder {
 
   DECLARE_ALIGNED(16, VP9_COMMON, common);
 
+  DECLARE_ALIGNED(16, VP9TokenProbs, token_probs);
+
   int ready_for_new_data;
 
   int refresh_frame_flags;
@@ -105,6 +129,7 @@ typedef struct VP9Decoder {
   RefCntBuffer *cur_buf;  //  Current decoding frame buffer.
 
   VPxWorker lf_worker;
+  VPxWorker adapt_worker;  // Adapts the probabilities after each frame.
   VPxWorker *tile_workers;
   TileWorkerData *tile_worker_data;
   TileBuffer tile_buffers[64];
@@ -124,6 +149,8 @@ typedef struct VP9Decoder {
   int row_mt;
   int lpf_mt_opt;
   RowMTWorkerData *row_mt_worker_data;
+
+  vpx_decode_profile_t profile;  // Counters of the current decode call.
 } VP9Decoder;
 
 int vp9_receive_compressed_data(struct VP9Decoder *pbi, size_t size,
@@ -29,6 +29,14 @@
     if (counts) ++coef_counts[band][ctx][token]; \
   } while (0)
 
+static INLINE void refill(vpx_reader *r, BD_VALUE *value, int *count) {
+  r->value = *value;
+  r->count = *count;
+  vpx_reader_fill_fast(r);
+  *value = r->value;
+  *count = r->count;
+}
+
 static INLINE int read_bool(vpx_reader *r, int prob, BD_VALUE *value,
                             int *count, unsigned int *range) {
   const unsigned int split = (*range * prob + (256 - prob)) >> CHAR_BIT;
@@ -48,13 +56,7 @@ static INLINE int read_bool(vpx_reader *r, int prob, BD_VALUE *value,
   }
 #endif
 
-  if (*count < 0) {
-    r->value = *value;
-    r->count = *count;
-    vpx_reader_fill(r);
-    *value = r->value;
-    *count = r->count;
-  }
+  if (*count < 0) refill(r, value, count);
 
   if (*value >= bigsplit) {
     *range = *range - split;
@@ -104,32 +106,59 @@ static INLINE int read_bool(vpx_reader *r, int prob, BD_VALUE *value,
   return 0;
 }
 
+#if CONFIG_BITSTREAM_DEBUG
+#define read_bool_nobranch read_bool
+#else
+// Same as read_bool() without a data dependent branch. The sign and the extra
+// bits of a coefficient are close to equiprobable, so a branch on their value
+// would be mispredicted about half of the time.
+static INLINE int read_bool_nobranch(vpx_reader *r, int prob, BD_VALUE *value,
+                                     int *count, unsigned int *range) {
+  const unsigned int split = (*range * prob + (256 - prob)) >> CHAR_BIT;
+  const BD_VALUE bigsplit = (BD_VALUE)split << (BD_VALUE_SIZE - CHAR_BIT);
+  int bit, shift;
+
+  if (*count < 0) refill(r, value, count);
+
+  bit = *value >= bigsplit;
+  // range - split for a 1, split for a 0.
+  *range = split + ((*range - 2 * split) & (0u - bit));
+  *value -= bigsplit & ((BD_VALUE)0 - bit);
+  shift = vpx_norm[*range];
+  *range <<= shift;
+  *value <<= shift;
+  *count -= shift;
+  return bit;
+}
+#endif  // CONFIG_BITSTREAM_DEBUG
+
 static INLINE int read_coeff(vpx_reader *r, const vpx_prob *probs, int n,
                              BD_VALUE *value, int *count, unsigned int *range) {
   int i, val = 0;
   for (i = 0; i < n; ++i)
-    val = (val << 1) | read_bool(r, probs[i], value, count, range);
+    val = (val << 1) | read_bool_nobranch(r, probs[i], value, count, range);
   return val;
 }
 
 static int decode_coefs(const MACROBLOCKD *xd, PLANE_TYPE type,
                         tran_low_t *dqcoeff, TX_SIZE tx_size, const int16_t *dq,
                         int ctx, const int16_t *scan, const int16_t *nb,
-                        vpx_reader *r) {
+                        VP9TokenProbs *token_probs, vpx_reader *r) {
   FRAME_COUNTS *counts = xd->counts;
   const int max_eob = 16 << (tx_size << 1);
-  const FRAME_CONTEXT *const fc = xd->fc;
   const int ref = is_inter_block(xd->mi[0]);
   int band, c = 0;
-  const vpx_prob(*coef_probs)[COEFF_CONTEXTS][UNCONSTRAINED_NODES] =
-      fc->coef_probs[tx_size][type][ref];
+  // The model probabilities are followed by the pareto probabilities that
+  // they select, so each context is a single lookup.
+  vpx_prob(*coef_probs)[COEFF_CONTEXTS][TOKEN_PROBS_STRIDE] =
+      (*token_probs)[tx_size][type][ref];
   const vpx_prob *prob;
   unsigned int(*coef_counts)[COEFF_CONTEXTS][UNCONSTRAINED_NODES + 1];
   unsigned int(*eob_branch_count)[COEFF_CONTEXTS];
   uint8_t token_cache[32 * 32];
   const uint8_t *band_translate = get_band_translate(tx_size);
   const int dq_shift = (tx_size == TX_32X32);
-  int v;
+  int v, sign;
   int16_t dqv = dq[0];
   const uint8_t *const cat6_prob =
 #if CONFIG_VP9_HIGHBITDEPTH
@@ -183,7 +212,7 @@ static int decode_coefs(const MACROBLOCKD *xd, PLANE_TYPE type,
     }
 
     if (read_bool(r, prob[ONE_CONTEXT_NODE], &value, &count, &range)) {
-      const vpx_prob *p = vp9_pareto8_full[prob[PIVOT_NODE] - 1];
+      const vpx_prob *p = prob + UNCONSTRAINED_NODES;
       INCREMENT_COUNT(TWO_TOKEN);
       if (read_bool(r, p[0], &value, &count, &range)) {
         if (read_bool(r, p[3], &value, &count, &range)) {
@@ -222,7 +251,8 @@ static int decode_coefs(const MACROBLOCKD *xd, PLANE_TYPE type,
       } else {
         if (read_bool(r, p[1], &value, &count, &range)) {
           token_cache[scan[c]] = 3;
-          v = ((3 + read_bool(r, p[2], &value, &count, &range)) * dqv) >>
+          v = ((3 + read_bool_nobranch(r, p[2], &value, &count, &range)) *
+               dqv) >>
               dq_shift;
         } else {
           token_cache[scan[c]] = 2;
@@ -234,20 +264,17 @@ static int decode_coefs(const MACROBLOCKD *xd, PLANE_TYPE type,
       token_cache[scan[c]] = 1;
       v = dqv >> dq_shift;
     }
+    sign = read_bool_nobranch(r, 128, &value, &count, &range);
+    // Negate v without a branch when the sign bit is set.
+    v = (v ^ -sign) + sign;
 #if CONFIG_COEFFICIENT_RANGE_CHECKING
 #if CONFIG_VP9_HIGHBITDEPTH
-    dqcoeff[scan[c]] = highbd_check_range(
-        read_bool(r, 128, &value, &count, &range) ? -v : v, xd->bd);
+    dqcoeff[scan[c]] = highbd_check_range(v, xd->bd);
 #else
-    dqcoeff[scan[c]] =
-        check_range(read_bool(r, 128, &value, &count, &range) ? -v : v);
+    dqcoeff[scan[c]] = check_range(v);
 #endif  // CONFIG_VP9_HIGHBITDEPTH
 #else
-    if (read_bool(r, 128, &value, &count, &range)) {
-      dqcoeff[scan[c]] = (tran_low_t)-v;
-    } else {
-      dqcoeff[scan[c]] = (tran_low_t)v;
-    }
+    dqcoeff[scan[c]] = (tran_low_t)v;
 #endif  // CONFIG_COEFFICIENT_RANGE_CHECKING
     ++c;
     ctx = get_coef_context(nb, token_cache, c);
@@ -260,6 +287,21 @@ static int decode_coefs(const MACROBLOCKD *xd, PLANE_TYPE type,
   return c;
 }
 
+void vp9_setup_token_probs(VP9TokenProbs *token_probs, const FRAME_CONTEXT *fc,
+                           TX_MODE tx_mode) {
+  const TX_SIZE max_tx_size = tx_mode_to_biggest_tx_size[tx_mode];
+  TX_SIZE tx_size;
+  int i, j, k, l;
+
+  for (tx_size = TX_4X4; tx_size <= max_tx_size; ++tx_size)
+    for (i = 0; i < PLANE_TYPES; ++i)
+      for (j = 0; j < REF_TYPES; ++j)
+        for (k = 0; k < COEF_BANDS; ++k)
+          for (l = 0; l < BAND_COEFF_CONTEXTS(k); ++l)
+            vp9_model_to_full_probs(fc->coef_probs[tx_size][i][j][k][l],
+                                    (*token_probs)[tx_size][i][j][k][l]);
+}
+
 static void get_ctx_shift(MACROBLOCKD *xd, int *ctx_shift_a, int *ctx_shift_l,
                           int x, int y, unsigned int tx_size_in_blocks) {
   if (xd->max_blocks_wide) {
@@ -290,7 +332,8 @@ int vp9_decode_block_tokens(TileWorkerData *twd, int plane, const ScanOrder *sc,
       ctx = a[0] != 0;
       ctx += l[0] != 0;
       eob = decode_coefs(xd, get_plane_type(plane), pd->dqcoeff, tx_size,
-                         dequant, ctx, sc->scan, sc->neighbors, r);
+                         dequant, ctx, sc->scan, sc->neighbors,
+                         twd->token_probs, r);
       a[0] = l[0] = (eob > 0);
       break;
     case TX_8X8:
@@ -298,7 +341,8 @@ int vp9_decode_block_tokens(TileWorkerData *twd, int plane, const ScanOrder *sc,
       ctx = !!*(const uint16_t *)a;
       ctx += !!*(const uint16_t *)l;
       eob = decode_coefs(xd, get_plane_type(plane), pd->dqcoeff, tx_size,
-                         dequant, ctx, sc->scan, sc->neighbors, r);
+                         dequant, ctx, sc->scan, sc->neighbors,
+                         twd->token_probs, r);
       *(uint16_t *)a = ((eob > 0) * 0x0101) >> ctx_shift_a;
       *(uint16_t *)l = ((eob > 0) * 0x0101) >> ctx_shift_l;
       break;
@@ -307,7 +351,8 @@ int vp9_decode_block_tokens(TileWorkerData *twd, int plane, const ScanOrder *sc,
       ctx = !!*(const uint32_t *)a;
       ctx += !!*(const uint32_t *)l;
       eob = decode_coefs(xd, get_plane_type(plane), pd->dqcoeff, tx_size,
-                         dequant, ctx, sc->scan, sc->neighbors, r);
+                         dequant, ctx, sc->scan, sc->neighbors,
+                         twd->token_probs, r);
       *(uint32_t *)a = ((eob > 0) * 0x01010101) >> ctx_shift_a;
       *(uint32_t *)l = ((eob > 0) * 0x01010101) >> ctx_shift_l;
       break;
@@ -319,7 +364,8 @@ int vp9_decode_block_tokens(TileWorkerData *twd, int plane, const ScanOrder *sc,
       ctx = !!*(const uint64_t *)a;
       ctx += !!*(const uint64_t *)l;
       eob = decode_coefs(xd, get_plane_type(plane), pd->dqcoeff, tx_size,
-                         dequant, ctx, sc->scan, sc->neighbors, r);
+                         dequant, ctx, sc->scan, sc->neighbors,
+                         twd->token_probs, r);
       *(uint64_t *)a = ((eob > 0) * 0x0101010101010101ULL) >> ctx_shift_a;
       *(uint64_t *)l = ((eob > 0) * 0x0101010101010101ULL) >> ctx_shift_l;
       break;
@@ -19,6 +19,11 @@
 extern "C" {
 #endif
 
+// Expands the coefficient probabilities of |fc| for the transform sizes allowed
+// by |tx_mode| into |token_probs|.
+void vp9_setup_token_probs(VP9TokenProbs *token_probs, const FRAME_CONTEXT *fc,
+                           TX_MODE tx_mode);
+
 int vp9_decode_block_tokens(TileWorkerData *twd, int plane, const ScanOrder *sc,
                             int x, int y, TX_SIZE tx_size, int seg_id);
 
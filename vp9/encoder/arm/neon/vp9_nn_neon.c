@@ -0,0 +1,89 @@
+/*
+ *  Copyright (c) 2023 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <arm_neon.h>
+
+#include "./vp9_rtcd.h"
+#include "./vpx_config.h"
+#include "vpx_dsp/vpx_dsp_common.h"
+
+// Returns the sums of the lanes of |a0|, |a1|, |a2| and |a3| in lanes 0 to 3.
+static INLINE float32x4_t hadd4_f32(const float32x4_t a0, const float32x4_t a1,
+                                    const float32x4_t a2,
+                                    const float32x4_t a3) {
+#if VPX_ARCH_AARCH64
+  return vpaddq_f32(vpaddq_f32(a0, a1), vpaddq_f32(a2, a3));
+#else
+  const float32x2_t s0 = vpadd_f32(vget_low_f32(a0), vget_high_f32(a0));
+  const float32x2_t s1 = vpadd_f32(vget_low_f32(a1), vget_high_f32(a1));
+  const float32x2_t s2 = vpadd_f32(vget_low_f32(a2), vget_high_f32(a2));
+  const float32x2_t s3 = vpadd_f32(vget_low_f32(a3), vget_high_f32(a3));
+  return vcombine_f32(vpadd_f32(s0, s1), vpadd_f32(s2, s3));
+#endif
+}
+
+static INLINE float hadd_f32(const float32x4_t a) {
+#if VPX_ARCH_AARCH64
+  return vaddvq_f32(a);
+#else
+  const float32x2_t s = vpadd_f32(vget_low_f32(a), vget_high_f32(a));
+  return vget_lane_f32(vpadd_f32(s, s), 0);
+#endif
+}
+
+void vp9_nn_fc_layer_neon(const float *input, int num_inputs, int num_samples,
+                          const float *weights, const float *bias,
+                          int num_outputs, int relu, float *output) {
+  const float32x4_t zero = vdupq_n_f32(0.0f);
+  int s, node, i;
+  for (s = 0; s < num_samples; ++s) {
+    // Four output nodes at a time.
+    for (node = 0; node + 4 <= num_outputs; node += 4) {
+      const float *w0 = weights + node * num_inputs;
+      const float *w1 = w0 + num_inputs;
+      const float *w2 = w1 + num_inputs;
+      const float *w3 = w2 + num_inputs;
+      float32x4_t acc0 = zero, acc1 = zero, acc2 = zero, acc3 = zero;
+      float32x4_t val;
+      float tail[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+      for (i = 0; i + 4 <= num_inputs; i += 4) {
+        const float32x4_t in = vld1q_f32(input + i);
+        acc0 = vmlaq_f32(acc0, vld1q_f32(w0 + i), in);
+        acc1 = vmlaq_f32(acc1, vld1q_f32(w1 + i), in);
+        acc2 = vmlaq_f32(acc2, vld1q_f32(w2 + i), in);
+        acc3 = vmlaq_f32(acc3, vld1q_f32(w3 + i), in);
+      }
+      for (; i < num_inputs; ++i) {
+        tail[0] += w0[i] * input[i];
+        tail[1] += w1[i] * input[i];
+        tail[2] += w2[i] * input[i];
+        tail[3] += w3[i] * input[i];
+      }
+      val = vaddq_f32(hadd4_f32(acc0, acc1, acc2, acc3), vld1q_f32(tail));
+      val = vaddq_f32(val, vld1q_f32(bias + node));
+      if (relu) val = vmaxq_f32(val, zero);
+      vst1q_f32(output + node, val);
+    }
+    for (; node < num_outputs; ++node) {
+      const float *w = weights + node * num_inputs;
+      float32x4_t acc = zero;
+      float val;
+      for (i = 0; i + 4 <= num_inputs; i += 4) {
+        acc = vmlaq_f32(acc, vld1q_f32(w + i), vld1q_f32(input + i));
+      }
+      val = hadd_f32(acc);
+      for (; i < num_inputs; ++i) val += w[i] * input[i];
+      val += bias[node];
+      output[node] = relu ? VPXMAX(val, 0.0f) : val;
+    }
+    input += num_inputs;
+    output += num_outputs;
+  }
+}
@@ -499,18 +499,31 @@ static void write_modes(VP9_COMP *cpi, MACROBLOCKD *const xd,
 
   for (mi_row = tile->mi_row_start; mi_row < tile->mi_row_end;
        mi_row += MI_BLOCK_SIZE) {
+    const TOKENLIST *tplist;
+    TokenChunk *chunk;
     tile_sb_row = mi_cols_aligned_to_sb(mi_row - tile->mi_row_start) >>
                   MI_BLOCK_SIZE_LOG2;
-    tok = cpi->tplist[tile_row][tile_col][tile_sb_row].start;
-    tok_end = tok + cpi->tplist[tile_row][tile_col][tile_sb_row].count;
+    tplist = &cpi->tplist[tile_row][tile_col][tile_sb_row];
+    chunk = tplist->chunk;
+    tok = tplist->start;
+    tok_end = chunk == tplist->stop_chunk ? tplist->stop : chunk->stop;
 
     vp9_zero(xd->left_seg_context);
     for (mi_col = tile->mi_col_start; mi_col < tile->mi_col_end;
-         mi_col += MI_BLOCK_SIZE)
+         mi_col += MI_BLOCK_SIZE) {
+      // Every block ends with a token, so the end of a chunk is only reached
+      // when the next superblock was written to the next chunk.
+      if (tok == tok_end) {
+        assert(chunk != tplist->stop_chunk);
+        chunk = chunk->next;
+        tok = chunk->tokens;
+        tok_end = chunk == tplist->stop_chunk ? tplist->stop : chunk->stop;
+      }
       write_modes_sb(cpi, xd, tile, w, &tok, tok_end, mi_row, mi_col,
                      BLOCK_64X64, max_mv_magnitude, interp_filter_selected);
+    }
 
-    assert(tok == cpi->tplist[tile_row][tile_col][tile_sb_row].stop);
+    assert(tok == tplist->stop);
   }
 }
 
@@ -1354,6 +1367,8 @@ void vp9_pack_bitstream(VP9_COMP *cpi, uint8_t *dest, size_t *size) {
   struct vpx_write_bit_buffer wb = { data, 0 };
   struct vpx_write_bit_buffer saved_wb;
 
+  start_stage_timing(cpi, VPX_STAGE_PACK_BITSTREAM);
+
 #if CONFIG_BITSTREAM_DEBUG
   bitstream_queue_reset_write();
 #endif
@@ -1365,6 +1380,7 @@ void vp9_pack_bitstream(VP9_COMP *cpi, uint8_t *dest, size_t *size) {
     uncompressed_hdr_size = vpx_wb_bytes_written(&wb);
     data += uncompressed_hdr_size;
     *size = data - dest;
+    end_stage_timing(cpi, VPX_STAGE_PACK_BITSTREAM);
     return;
   }
 
@@ -1384,4 +1400,5 @@ void vp9_pack_bitstream(VP9_COMP *cpi, uint8_t *dest, size_t *size) {
   data += encode_tiles(cpi, data);
 
   *size = data - dest;
+  end_stage_timing(cpi, VPX_STAGE_PACK_BITSTREAM);
 }
@@ -172,6 +172,10 @@ struct macroblock {
   // Used to store sub partition's choices.
   MV pred_mv[MAX_REF_FRAMES];
 
+  // The motion relative to LAST predicted from the previous frame, used as
+  // the start of the motion search when mv_best_ref_index[LAST_FRAME] is 3.
+  MV temporal_pred_mv;
+
   // Strong color activity detection. Used in RTC coding mode to enhance
   // the visual quality at the boundary of moving color objects.
   uint8_t color_sensitivity[2];
@@ -216,6 +220,9 @@ struct macroblock {
   DECLARE_ALIGNED(16, uint8_t, est_pred[64 * 64]);
 
   struct scale_factors *me_sf;
+
+  // Interpolated reference planes read by the sub-pixel motion search.
+  struct SubpelCache *subpel_cache;
 };
 
 #ifdef __cplusplus
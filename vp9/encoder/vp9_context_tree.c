@@ -18,62 +18,61 @@ static const BLOCK_SIZE square[] = {
   BLOCK_64X64,
 };
 
-static void alloc_mode_context(VP9_COMMON *cm, int num_4x4_blk,
-                               PICK_MODE_CONTEXT *ctx) {
-  const int num_blk = (num_4x4_blk < 4 ? 4 : num_4x4_blk);
+static void init_mode_context(int num_4x4_blk, PICK_MODE_CONTEXT *ctx) {
+  ctx->num_4x4_blk = (num_4x4_blk < 4 ? 4 : num_4x4_blk);
+}
+
+// Returns the size of the allocation backing the coefficient buffers of a
+// context covering |num_blk| 4x4 blocks.
+static size_t mode_context_buf_size(int num_blk) {
+  const size_t num_pix = (size_t)num_blk << 4;
+  return MAX_MB_PLANE * 3 *
+             (3 * num_pix * sizeof(tran_low_t) + num_blk * sizeof(uint16_t)) +
+         num_blk * sizeof(uint8_t);
+}
+
+void vp9_alloc_mode_context_buffers(VP9_COMMON *cm, PICK_MODE_CONTEXT *ctx) {
+  const int num_blk = ctx->num_4x4_blk;
   const int num_pix = num_blk << 4;
+  tran_low_t *coeff;
+  uint16_t *eobs;
   int i, k;
-  ctx->num_4x4_blk = num_blk;
 
-  CHECK_MEM_ERROR(cm, ctx->zcoeff_blk, vpx_calloc(num_blk, sizeof(uint8_t)));
+  if (ctx->buf != NULL) return;
+
+  CHECK_MEM_ERROR(cm, ctx->buf,
+                  vpx_memalign(32, mode_context_buf_size(num_blk)));
+  // Each coefficient buffer is a multiple of 32 bytes, so all of them stay
+  // aligned. The eobs and the zcoeff flags follow them.
+  coeff = (tran_low_t *)ctx->buf;
+  eobs = (uint16_t *)(coeff + MAX_MB_PLANE * 3 * 3 * num_pix);
   for (i = 0; i < MAX_MB_PLANE; ++i) {
     for (k = 0; k < 3; ++k) {
-      CHECK_MEM_ERROR(cm, ctx->coeff[i][k],
-                      vpx_memalign(32, num_pix * sizeof(*ctx->coeff[i][k])));
-      CHECK_MEM_ERROR(cm, ctx->qcoeff[i][k],
-                      vpx_memalign(32, num_pix * sizeof(*ctx->qcoeff[i][k])));
-      CHECK_MEM_ERROR(cm, ctx->dqcoeff[i][k],
-                      vpx_memalign(32, num_pix * sizeof(*ctx->dqcoeff[i][k])));
-      CHECK_MEM_ERROR(cm, ctx->eobs[i][k],
-                      vpx_memalign(32, num_blk * sizeof(*ctx->eobs[i][k])));
-      ctx->coeff_pbuf[i][k] = ctx->coeff[i][k];
-      ctx->qcoeff_pbuf[i][k] = ctx->qcoeff[i][k];
-      ctx->dqcoeff_pbuf[i][k] = ctx->dqcoeff[i][k];
-      ctx->eobs_pbuf[i][k] = ctx->eobs[i][k];
+      ctx->coeff_pbuf[i][k] = coeff;
+      ctx->qcoeff_pbuf[i][k] = coeff + num_pix;
+      ctx->dqcoeff_pbuf[i][k] = coeff + 2 * num_pix;
+      ctx->eobs_pbuf[i][k] = eobs;
+      coeff += 3 * num_pix;
+      eobs += num_blk;
     }
   }
+  ctx->zcoeff_blk = (uint8_t *)eobs;
 }
 
 static void free_mode_context(PICK_MODE_CONTEXT *ctx) {
-  int i, k;
-  vpx_free(ctx->zcoeff_blk);
-  ctx->zcoeff_blk = 0;
-  for (i = 0; i < MAX_MB_PLANE; ++i) {
-    for (k = 0; k < 3; ++k) {
-      vpx_free(ctx->coeff[i][k]);
-      ctx->coeff[i][k] = 0;
-      vpx_free(ctx->qcoeff[i][k]);
-      ctx->qcoeff[i][k] = 0;
-      vpx_free(ctx->dqcoeff[i][k]);
-      ctx->dqcoeff[i][k] = 0;
-      vpx_free(ctx->eobs[i][k]);
-      ctx->eobs[i][k] = 0;
-    }
-  }
+  vpx_free(ctx->buf);
+  ctx->buf = NULL;
+  ctx->zcoeff_blk = NULL;
 }
 
-static void alloc_tree_contexts(VP9_COMMON *cm, PC_TREE *tree,
-                                int num_4x4_blk) {
-  alloc_mode_context(cm, num_4x4_blk, &tree->none);
-  alloc_mode_context(cm, num_4x4_blk / 2, &tree->horizontal[0]);
-  alloc_mode_context(cm, num_4x4_blk / 2, &tree->vertical[0]);
+static void init_tree_contexts(PC_TREE *tree, int num_4x4_blk) {
+  init_mode_context(num_4x4_blk, &tree->none);
+  init_mode_context(num_4x4_blk / 2, &tree->horizontal[0]);
+  init_mode_context(num_4x4_blk / 2, &tree->vertical[0]);
 
   if (num_4x4_blk > 4) {
-    alloc_mode_context(cm, num_4x4_blk / 2, &tree->horizontal[1]);
-    alloc_mode_context(cm, num_4x4_blk / 2, &tree->vertical[1]);
-  } else {
-    memset(&tree->horizontal[1], 0, sizeof(tree->horizontal[1]));
-    memset(&tree->vertical[1], 0, sizeof(tree->vertical[1]));
+    init_mode_context(num_4x4_blk / 2, &tree->horizontal[1]);
+    init_mode_context(num_4x4_blk / 2, &tree->vertical[1]);
   }
 }
 
@@ -85,10 +84,16 @@ static void free_tree_contexts(PC_TREE *tree) {
   free_mode_context(&tree->vertical[1]);
 }
 
+static size_t mode_context_mem_usage(const PICK_MODE_CONTEXT *ctx) {
+  return ctx->buf != NULL ? mode_context_buf_size(ctx->num_4x4_blk) : 0;
+}
+
 // This function sets up a tree of contexts such that at each square
 // partition level. There are contexts for none, horizontal, vertical, and
 // split.  Along with a block_size value and a selected block_size which
-// represents the state of our search.
+// represents the state of our search. The coefficient buffers of a context
+// are only allocated once a search uses it, see
+// vp9_alloc_mode_context_buffers().
 void vp9_setup_pc_tree(VP9_COMMON *cm, ThreadData *td) {
   int i, j;
   const int leaf_nodes = 64;
@@ -99,10 +104,9 @@ void vp9_setup_pc_tree(VP9_COMMON *cm, ThreadData *td) {
   int square_index = 1;
   int nodes;
 
-  vpx_free(td->leaf_tree);
+  vp9_free_pc_tree(td);
   CHECK_MEM_ERROR(cm, td->leaf_tree,
                   vpx_calloc(leaf_nodes, sizeof(*td->leaf_tree)));
-  vpx_free(td->pc_tree);
   CHECK_MEM_ERROR(cm, td->pc_tree,
                   vpx_calloc(tree_nodes, sizeof(*td->pc_tree)));
 
@@ -111,13 +115,13 @@ void vp9_setup_pc_tree(VP9_COMMON *cm, ThreadData *td) {
 
   // 4x4 blocks smaller than 8x8 but in the same 8x8 block share the same
   // context so we only need to allocate 1 for each 8x8 block.
-  for (i = 0; i < leaf_nodes; ++i) alloc_mode_context(cm, 1, &td->leaf_tree[i]);
+  for (i = 0; i < leaf_nodes; ++i) init_mode_context(1, &td->leaf_tree[i]);
 
   // Sets up all the leaf nodes in the tree.
   for (pc_tree_index = 0; pc_tree_index < leaf_nodes; ++pc_tree_index) {
     PC_TREE *const tree = &td->pc_tree[pc_tree_index];
     tree->block_size = square[0];
-    alloc_tree_contexts(cm, tree, 4);
+    init_tree_contexts(tree, 4);
     tree->leaf_split[0] = this_leaf++;
     for (j = 1; j < 4; j++) tree->leaf_split[j] = tree->leaf_split[0];
   }
@@ -127,7 +131,7 @@ void vp9_setup_pc_tree(VP9_COMMON *cm, ThreadData *td) {
   for (nodes = 16; nodes > 0; nodes >>= 2) {
     for (i = 0; i < nodes; ++i) {
       PC_TREE *const tree = &td->pc_tree[pc_tree_index];
-      alloc_tree_contexts(cm, tree, 4 << (2 * square_index));
+      init_tree_contexts(tree, 4 << (2 * square_index));
       tree->block_size = square[square_index];
       for (j = 0; j < 4; j++) tree->split[j] = this_pc++;
       ++pc_tree_index;
@@ -136,6 +140,10 @@ void vp9_setup_pc_tree(VP9_COMMON *cm, ThreadData *td) {
   }
   td->pc_root = &td->pc_tree[tree_nodes - 1];
   td->pc_root[0].none.best_mode_index = 2;
+
+  // The root context provides the coefficient buffers of the non-rd search
+  // and the first pass, which use no other context.
+  vp9_alloc_mode_context_buffers(cm, &td->pc_root->none);
 }
 
 void vp9_free_pc_tree(ThreadData *td) {
@@ -158,3 +166,27 @@ void vp9_free_pc_tree(ThreadData *td) {
     td->pc_tree = NULL;
   }
 }
+
+size_t vp9_pc_tree_mem_usage(const ThreadData *td) {
+  const int tree_nodes = 64 + 16 + 4 + 1;
+  size_t size = 0;
+  int i;
+
+  if (td->leaf_tree != NULL) {
+    size += 64 * sizeof(*td->leaf_tree);
+    for (i = 0; i < 64; ++i) size += mode_context_mem_usage(&td->leaf_tree[i]);
+  }
+
+  if (td->pc_tree != NULL) {
+    size += tree_nodes * sizeof(*td->pc_tree);
+    for (i = 0; i < tree_nodes; ++i) {
+      const PC_TREE *const tree = &td->pc_tree[i];
+      size += mode_context_mem_usage(&tree->none);
+      size += mode_context_mem_usage(&tree->horizontal[0]);
+      size += mode_context_mem_usage(&tree->horizontal[1]);
+      size += mode_context_mem_usage(&tree->vertical[0]);
+      size += mode_context_mem_usage(&tree->vertical[1]);
+    }
+  }
+  return size;
+}
@@ -26,11 +26,10 @@ struct ThreadData;
 typedef struct {
   MODE_INFO mic;
   MB_MODE_INFO_EXT mbmi_ext;
+  // Single allocation backing zcoeff_blk and the coefficient buffers, made on
+  // the first use of the context by vp9_alloc_mode_context_buffers().
+  void *buf;
   uint8_t *zcoeff_blk;
-  tran_low_t *coeff[MAX_MB_PLANE][3];
-  tran_low_t *qcoeff[MAX_MB_PLANE][3];
-  tran_low_t *dqcoeff[MAX_MB_PLANE][3];
-  uint16_t *eobs[MAX_MB_PLANE][3];
 
   // dual buffer pointers, 0: in use, 1: best in store
   tran_low_t *coeff_pbuf[MAX_MB_PLANE][3];
@@ -94,11 +93,24 @@ typedef struct PC_TREE {
   // Obtained from a simple motion search. Used by the ML based partition search
   // speed feature.
   MV mv;
+  // Partition predicted by the ML based variance partitioning model when it
+  // was evaluated in a batch with the sibling blocks. Only valid while
+  // ml_var_part_ready is set.
+  int ml_var_part;
+  int ml_var_part_ready;
 } PC_TREE;
 
 void vp9_setup_pc_tree(struct VP9Common *cm, struct ThreadData *td);
 void vp9_free_pc_tree(struct ThreadData *td);
 
+// Allocates the coefficient buffers of |ctx| if it has none yet. Must be
+// called before a search writes coefficients to the context.
+void vp9_alloc_mode_context_buffers(struct VP9Common *cm,
+                                    PICK_MODE_CONTEXT *ctx);
+
+// Returns the number of bytes held by the context tree of |td|.
+size_t vp9_pc_tree_mem_usage(const struct ThreadData *td);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -56,6 +56,7 @@
 #include "vp9/encoder/vp9_rd.h"
 #include "vp9/encoder/vp9_rdopt.h"
 #include "vp9/encoder/vp9_segmentation.h"
+#include "vp9/encoder/vp9_temporal_mv.h"
 #include "vp9/encoder/vp9_tokenize.h"
 
 static void encode_superblock(VP9_COMP *cpi, ThreadData *td, TOKENEXTRA **t,
@@ -217,8 +218,8 @@ static void set_segment_index(VP9_COMP *cpi, MACROBLOCK *const x, int mi_row,
       break;
   }
 
-  // Set segment index if ROI map or active_map is enabled.
-  if (cpi->roi.enabled || cpi->active_map.enabled)
+  // Set segment index if ROI map, active_map or dirty map is enabled.
+  if (cpi->roi.enabled || cpi->active_map.enabled || cpi->dirty_map.applied)
     mi->segment_id = get_segment_id(cm, map, bsize, mi_row, mi_col);
 
   vp9_init_plane_quantizers(cpi, x);
@@ -892,10 +893,11 @@ static void set_low_temp_var_flag(VP9_COMP *cpi, MACROBLOCK *x, MACROBLOCKD *xd,
 }
 
 static void copy_partitioning_helper(VP9_COMP *cpi, MACROBLOCK *x,
-                                     MACROBLOCKD *xd, BLOCK_SIZE bsize,
-                                     int mi_row, int mi_col) {
+                                     MACROBLOCKD *xd,
+                                     const BLOCK_SIZE *prev_part,
+                                     BLOCK_SIZE bsize, int mi_row,
+                                     int mi_col) {
   VP9_COMMON *const cm = &cpi->common;
-  BLOCK_SIZE *prev_part = cpi->prev_partition;
   int start_pos = mi_row * cm->mi_stride + mi_col;
 
   const int bsl = b_width_log2_lookup[bsize];
@@ -925,10 +927,14 @@ static void copy_partitioning_helper(VP9_COMP *cpi, MACROBLOCK *x,
         break;
       default:
         assert(partition == PARTITION_SPLIT);
-        copy_partitioning_helper(cpi, x, xd, subsize, mi_row, mi_col);
-        copy_partitioning_helper(cpi, x, xd, subsize, mi_row + bs, mi_col);
-        copy_partitioning_helper(cpi, x, xd, subsize, mi_row, mi_col + bs);
-        copy_partitioning_helper(cpi, x, xd, subsize, mi_row + bs, mi_col + bs);
+        copy_partitioning_helper(cpi, x, xd, prev_part, subsize, mi_row,
+                                 mi_col);
+        copy_partitioning_helper(cpi, x, xd, prev_part, subsize, mi_row + bs,
+                                 mi_col);
+        copy_partitioning_helper(cpi, x, xd, prev_part, subsize, mi_row,
+                                 mi_col + bs);
+        copy_partitioning_helper(cpi, x, xd, prev_part, subsize, mi_row + bs,
+                                 mi_col + bs);
         break;
     }
   }
@@ -953,7 +959,8 @@ static int copy_partitioning(VP9_COMP *cpi, MACROBLOCK *x, MACROBLOCKD *xd,
       cpi->prev_segment_id[sb_offset] == CR_SEGMENT_ID_BASE &&
       cpi->copied_frame_cnt[sb_offset] < cpi->max_copied_frame) {
     if (cpi->prev_partition != NULL) {
-      copy_partitioning_helper(cpi, x, xd, BLOCK_64X64, mi_row, mi_col);
+      copy_partitioning_helper(cpi, x, xd, cpi->prev_partition, BLOCK_64X64,
+                               mi_row, mi_col);
       cpi->copied_frame_cnt[sb_offset] += 1;
       memcpy(x->variance_low, &(cpi->prev_variance_low[sb_offset * 25]),
              sizeof(x->variance_low));
@@ -1118,10 +1125,10 @@ static void update_partition_svc(VP9_COMP *cpi, BLOCK_SIZE bsize, int mi_row,
   }
 }
 
-static void update_prev_partition_helper(VP9_COMP *cpi, BLOCK_SIZE bsize,
-                                         int mi_row, int mi_col) {
+static void update_prev_partition_helper(VP9_COMP *cpi, BLOCK_SIZE *prev_part,
+                                         BLOCK_SIZE bsize, int mi_row,
+                                         int mi_col) {
   VP9_COMMON *const cm = &cpi->common;
-  BLOCK_SIZE *prev_part = cpi->prev_partition;
   int start_pos = mi_row * cm->mi_stride + mi_col;
   const int bsl = b_width_log2_lookup[bsize];
   const int bs = (1 << bsl) >> 2;
@@ -1150,10 +1157,13 @@ static void update_prev_partition_helper(VP9_COMP *cpi, BLOCK_SIZE bsize,
         break;
       default:
         assert(partition == PARTITION_SPLIT);
-        update_prev_partition_helper(cpi, subsize, mi_row, mi_col);
-        update_prev_partition_helper(cpi, subsize, mi_row + bs, mi_col);
-        update_prev_partition_helper(cpi, subsize, mi_row, mi_col + bs);
-        update_prev_partition_helper(cpi, subsize, mi_row + bs, mi_col + bs);
+        update_prev_partition_helper(cpi, prev_part, subsize, mi_row, mi_col);
+        update_prev_partition_helper(cpi, prev_part, subsize, mi_row + bs,
+                                     mi_col);
+        update_prev_partition_helper(cpi, prev_part, subsize, mi_row,
+                                     mi_col + bs);
+        update_prev_partition_helper(cpi, prev_part, subsize, mi_row + bs,
+                                     mi_col + bs);
         break;
     }
   }
@@ -1161,7 +1171,8 @@ static void update_prev_partition_helper(VP9_COMP *cpi, BLOCK_SIZE bsize,
 
 static void update_prev_partition(VP9_COMP *cpi, MACROBLOCK *x, int segment_id,
                                   int mi_row, int mi_col, int sb_offset) {
-  update_prev_partition_helper(cpi, BLOCK_64X64, mi_row, mi_col);
+  update_prev_partition_helper(cpi, cpi->prev_partition, BLOCK_64X64, mi_row,
+                               mi_col);
   cpi->prev_segment_id[sb_offset] = segment_id;
   memcpy(&(cpi->prev_variance_low[sb_offset * 25]), x->variance_low,
          sizeof(x->variance_low));
@@ -1255,6 +1266,45 @@ static uint64_t avg_source_sad(VP9_COMP *cpi, MACROBLOCK *x, int shift,
   return tmp_sad;
 }
 
+// Moves the superblock to the motion predicted for it from the previous frame
+// if it matches better than its current motion, found by a search that is
+// limited in range or skipped at the highest speeds. Returns the sad of the
+// motion kept.
+static unsigned int temporal_sb_motion(VP9_COMP *cpi, MACROBLOCK *x,
+                                       int mi_row, int mi_col,
+                                       unsigned int y_sad) {
+  MACROBLOCKD *const xd = &x->e_mbd;
+  MODE_INFO *const mi = xd->mi[0];
+  const int pre_stride = xd->plane[0].pre[0].stride;
+  const int_mv mv =
+      vp9_temporal_mv_get_sb(&cpi->temporal_mv_map, mi_row, mi_col);
+  MV full_mv;
+  unsigned int sad;
+
+  if (mv.as_int == INVALID_MV) return y_sad;
+  full_mv.row = (mv.as_mv.row + 4) >> 3;
+  full_mv.col = (mv.as_mv.col + 4) >> 3;
+  clamp_mv(&full_mv, x->mv_limits.col_min, x->mv_limits.col_max,
+           x->mv_limits.row_min, x->mv_limits.row_max);
+  if (full_mv.row * 8 == mi->mv[0].as_mv.row &&
+      full_mv.col * 8 == mi->mv[0].as_mv.col)
+    return y_sad;
+
+  sad = cpi->fn_ptr[BLOCK_64X64].sdf(
+      x->plane[0].src.buf, x->plane[0].src.stride,
+      xd->plane[0].pre[0].buf + full_mv.row * pre_stride + full_mv.col,
+      pre_stride);
+  if (sad >= y_sad) return y_sad;
+
+  mi->mv[0].as_mv.row = full_mv.row * 8;
+  mi->mv[0].as_mv.col = full_mv.col * 8;
+  if (x->sb_use_mv_part) {
+    x->sb_mvrow_part = mi->mv[0].as_mv.row;
+    x->sb_mvcol_part = mi->mv[0].as_mv.col;
+  }
+  return sad;
+}
+
 // This function chooses partitioning based on the variance between source and
 // reconstructed last, where variance is computed for down-sampled inputs.
 static int choose_partitioning(VP9_COMP *cpi, const TileInfo *const tile,
@@ -1472,6 +1522,9 @@ static int choose_partitioning(VP9_COMP *cpi, const TileInfo *const tile,
       }
     }
 
+    if (cpi->temporal_mv_map.valid && mi->ref_frame[0] == LAST_FRAME)
+      y_sad = temporal_sb_motion(cpi, x, mi_row, mi_col, y_sad);
+
     y_sad_last = y_sad;
     // Pick ref frame for partitioning, bias last frame when y_sad_g and y_sad
     // are close if short_circuit_low_temp_var is on.
@@ -1991,6 +2044,7 @@ static void rd_pick_sb_modes(VP9_COMP *cpi, TileDataEnc *tile_data,
   mi = xd->mi[0];
   mi->sb_type = bsize;
 
+  vp9_alloc_mode_context_buffers(cm, ctx);
   for (i = 0; i < MAX_MB_PLANE; ++i) {
     p[i].coeff = ctx->coeff_pbuf[i][0];
     p[i].qcoeff = ctx->qcoeff_pbuf[i][0];
@@ -2518,7 +2572,7 @@ static void update_state_rt(VP9_COMP *cpi, ThreadData *td,
   *(x->mbmi_ext) = ctx->mbmi_ext;
 
   if (seg->enabled && (cpi->oxcf.aq_mode != NO_AQ || cpi->roi.enabled ||
-                       cpi->active_map.enabled)) {
+                       cpi->active_map.enabled || cpi->dirty_map.applied)) {
     // Setting segmentation map for cyclic_refresh.
     if (cpi->oxcf.aq_mode == CYCLIC_REFRESH_AQ &&
         cpi->cyclic_refresh->content_mode) {
@@ -2546,6 +2600,7 @@ static void update_state_rt(VP9_COMP *cpi, ThreadData *td,
   }
 
   if (cm->use_prev_frame_mvs || !cm->error_resilient_mode ||
+      cpi->sf.temporal_mv_pred ||
       (cpi->svc.use_base_mv && cpi->svc.number_spatial_layers > 1 &&
        cpi->svc.spatial_layer_id != cpi->svc.number_spatial_layers - 1)) {
     MV_REF *const frame_mvs =
@@ -3099,53 +3154,6 @@ static INLINE void load_pred_mv(MACROBLOCK *x, PICK_MODE_CONTEXT *ctx) {
   memcpy(x->pred_mv, ctx->pred_mv, sizeof(x->pred_mv));
 }
 
-// Calculate prediction based on the given input features and neural net config.
-// Assume there are no more than NN_MAX_NODES_PER_LAYER nodes in each hidden
-// layer.
-static void nn_predict(const float *features, const NN_CONFIG *nn_config,
-                       float *output) {
-  int num_input_nodes = nn_config->num_inputs;
-  int buf_index = 0;
-  float buf[2][NN_MAX_NODES_PER_LAYER];
-  const float *input_nodes = features;
-
-  // Propagate hidden layers.
-  const int num_layers = nn_config->num_hidden_layers;
-  int layer, node, i;
-  assert(num_layers <= NN_MAX_HIDDEN_LAYERS);
-  for (layer = 0; layer < num_layers; ++layer) {
-    const float *weights = nn_config->weights[layer];
-    const float *bias = nn_config->bias[layer];
-    float *output_nodes = buf[buf_index];
-    const int num_output_nodes = nn_config->num_hidden_nodes[layer];
-    assert(num_output_nodes < NN_MAX_NODES_PER_LAYER);
-    for (node = 0; node < num_output_nodes; ++node) {
-      float val = 0.0f;
-      for (i = 0; i < num_input_nodes; ++i) val += weights[i] * input_nodes[i];
-      val += bias[node];
-      // ReLU as activation function.
-      val = VPXMAX(val, 0.0f);
-      output_nodes[node] = val;
-      weights += num_input_nodes;
-    }
-    num_input_nodes = num_output_nodes;
-    input_nodes = output_nodes;
-    buf_index = 1 - buf_index;
-  }
-
-  // Final output layer.
-  {
-    const float *weights = nn_config->weights[num_layers];
-    for (node = 0; node < nn_config->num_outputs; ++node) {
-      const float *bias = nn_config->bias[num_layers];
-      float val = 0.0f;
-      for (i = 0; i < num_input_nodes; ++i) val += weights[i] * input_nodes[i];
-      output[node] = val + bias[node];
-      weights += num_input_nodes;
-    }
-  }
-}
-
 #if !CONFIG_REALTIME_ONLY
 #define FEATURES 7
 // Machine-learning based partition search early termination.
@@ -3231,7 +3239,7 @@ static int ml_pruning_partition(VP9_COMMON *const cm, MACROBLOCKD *const xd,
   if (linear_score > 0.1f) return 0;
 
   // Predict using neural net model.
-  nn_predict(features, nn_config, &nn_score);
+  vp9_nn_predict(features, nn_config, &nn_score);
 
   if (linear_score < -0.0f && nn_score < 0.1f) return 1;
   if (nn_score < -0.0f && linear_score < 0.1f) return 1;
@@ -3394,7 +3402,7 @@ static void ml_prune_rect_partition(VP9_COMP *const cpi, MACROBLOCK *const x,
     }
 
     assert(feature_index == FEATURES);
-    nn_predict(features, nn_config, score);
+    vp9_nn_predict(features, nn_config, score);
   }
 
   // Make decisions based on the model score.
@@ -3590,7 +3598,7 @@ static void ml_predict_var_rd_paritioning(const VP9_COMP *const cpi,
     assert(feature_idx == FEATURES);
 
     // Feed the features into the model to get the confidence score.
-    nn_predict(features, nn_config, &score);
+    vp9_nn_predict(features, nn_config, &score);
 
     // Higher score means that the model has higher confidence that the split
     // partition is better than the non-split partition. So if the score is
@@ -3962,6 +3970,19 @@ static void store_superblock_info(
 }
 #endif  // CONFIG_RATE_CTRL
 
+// Moves |*tp| to a new token chunk if the current one has no room left for the
+// tokens of a superblock.
+static INLINE void reserve_sb_tokens(VP9_COMP *cpi, ThreadData *td,
+                                     TOKENEXTRA **tp) {
+  TokenChunk *const chunk = td->tok_chunk;
+  if (chunk->tokens + TOKEN_CHUNK_SIZE - *tp < MAX_SB_TOKENS) {
+    chunk->stop = *tp;
+    chunk->next = vp9_token_pool_get_chunk(&cpi->token_pool, &cpi->common);
+    td->tok_chunk = chunk->next;
+    *tp = chunk->next->tokens;
+  }
+}
+
 #if !CONFIG_REALTIME_ONLY
 // TODO(jingning,jimbankoski,rbultje): properly skip partition types that are
 // unlikely to be selected depending on previous rate-distortion optimization
@@ -4496,6 +4517,7 @@ static void encode_rd_sb_row(VP9_COMP *cpi, ThreadData *td,
     vp9_rd_cost_reset(&dummy_rdc);
     (*(cpi->row_mt_sync_read_ptr))(&tile_data->row_mt_sync, sb_row,
                                    sb_col_in_tile);
+    reserve_sb_tokens(cpi, td, tp);
 
     if (sf->adaptive_pred_interp_filter) {
       for (i = 0; i < 64; ++i) td->leaf_tree[i].pred_interp_filter = SWITCHABLE;
@@ -4561,8 +4583,22 @@ static void encode_rd_sb_row(VP9_COMP *cpi, ThreadData *td,
 #if CONFIG_COLLECT_COMPONENT_TIMING
       start_timing(cpi, rd_pick_partition_time);
 #endif
-      rd_pick_partition(cpi, td, tile_data, tp, mi_row, mi_col, BLOCK_64X64,
-                        &dummy_rdc, dummy_rdc, td->pc_root);
+      if (cpi->recode_partition_reuse) {
+        // Recode iteration close in q to the last full search: keep its
+        // partitioning and only redo the mode decisions within it.
+        copy_partitioning_helper(cpi, x, xd, cpi->recode_partition,
+                                 BLOCK_64X64, mi_row, mi_col);
+        rd_use_partition(cpi, td, tile_data, mi, tp, mi_row, mi_col,
+                         BLOCK_64X64, &dummy_rate, &dummy_dist, 1,
+                         td->pc_root);
+      } else {
+        rd_pick_partition(cpi, td, tile_data, tp, mi_row, mi_col, BLOCK_64X64,
+                          &dummy_rdc, dummy_rdc, td->pc_root);
+        if (cpi->recode_partition != NULL) {
+          update_prev_partition_helper(cpi, cpi->recode_partition, BLOCK_64X64,
+                                       mi_row, mi_col);
+        }
+      }
 #if CONFIG_COLLECT_COMPONENT_TIMING
       end_timing(cpi, rd_pick_partition_time);
 #endif
@@ -4820,69 +4856,123 @@ static void pred_pixel_ready_reset(PC_TREE *pc_tree, BLOCK_SIZE bsize) {
 
 #define FEATURES 6
 #define LABELS 2
-static int ml_predict_var_paritioning(VP9_COMP *cpi, MACROBLOCK *x,
-                                      BLOCK_SIZE bsize, int mi_row,
-                                      int mi_col) {
-  VP9_COMMON *const cm = &cpi->common;
-  const NN_CONFIG *nn_config = NULL;
-
+static const NN_CONFIG *get_var_part_nnconfig(BLOCK_SIZE bsize) {
   switch (bsize) {
-    case BLOCK_64X64: nn_config = &vp9_var_part_nnconfig_64; break;
-    case BLOCK_32X32: nn_config = &vp9_var_part_nnconfig_32; break;
-    case BLOCK_16X16: nn_config = &vp9_var_part_nnconfig_16; break;
-    case BLOCK_8X8: break;
-    default: assert(0 && "Unexpected block size."); return -1;
+    case BLOCK_64X64: return &vp9_var_part_nnconfig_64;
+    case BLOCK_32X32: return &vp9_var_part_nnconfig_32;
+    case BLOCK_16X16: return &vp9_var_part_nnconfig_16;
+    case BLOCK_8X8: return NULL;
+    default: assert(0 && "Unexpected block size."); return NULL;
   }
+}
+
+static void get_var_part_features(VP9_COMP *cpi, MACROBLOCK *x,
+                                  BLOCK_SIZE bsize, int mi_row, int mi_col,
+                                  float *features) {
+  VP9_COMMON *const cm = &cpi->common;
+  const int dc_q = vp9_dc_quant(cm->base_qindex, 0, cm->bit_depth);
+  int feature_idx = 0;
+
+  features[feature_idx++] = logf((float)(dc_q * dc_q) / 256.0f + 1.0f);
+  vp9_setup_src_planes(x, cpi->Source, mi_row, mi_col);
+  {
+    const int bs = 4 * num_4x4_blocks_wide_lookup[bsize];
+    const BLOCK_SIZE subsize = get_subsize(bsize, PARTITION_SPLIT);
+    const int sb_offset_row = 8 * (mi_row & 7);
+    const int sb_offset_col = 8 * (mi_col & 7);
+    const uint8_t *pred = x->est_pred + sb_offset_row * 64 + sb_offset_col;
+    const uint8_t *src = x->plane[0].src.buf;
+    const int src_stride = x->plane[0].src.stride;
+    const int pred_stride = 64;
+    unsigned int sse;
+    int i;
+    // Variance of whole block.
+    const unsigned int var =
+        cpi->fn_ptr[bsize].vf(src, src_stride, pred, pred_stride, &sse);
+    const float factor = (var == 0) ? 1.0f : (1.0f / (float)var);
+
+    features[feature_idx++] = logf((float)var + 1.0f);
+    for (i = 0; i < 4; ++i) {
+      const int x_idx = (i & 1) * bs / 2;
+      const int y_idx = (i >> 1) * bs / 2;
+      const int src_offset = y_idx * src_stride + x_idx;
+      const int pred_offset = y_idx * pred_stride + x_idx;
+      // Variance of quarter block.
+      const unsigned int sub_var =
+          cpi->fn_ptr[subsize].vf(src + src_offset, src_stride,
+                                  pred + pred_offset, pred_stride, &sse);
+      const float var_ratio = (var == 0) ? 1.0f : factor * (float)sub_var;
+      features[feature_idx++] = var_ratio;
+    }
+  }
+  assert(feature_idx == FEATURES);
+}
+
+static int get_var_part_decision(const VP9_COMP *cpi, float score) {
+  const float thresh = cpi->oxcf.speed <= 5 ? 1.25f : 0.0f;
+  if (score > thresh) return PARTITION_SPLIT;
+  if (score < -thresh) return PARTITION_NONE;
+  return -1;
+}
+
+static int ml_predict_var_paritioning(VP9_COMP *cpi, MACROBLOCK *x,
+                                      PC_TREE *pc_tree, BLOCK_SIZE bsize,
+                                      int mi_row, int mi_col) {
+  const NN_CONFIG *nn_config = get_var_part_nnconfig(bsize);
+  float features[FEATURES] = { 0.0f };
+  float score[LABELS];
 
   if (!nn_config) return -1;
 
+  // Already evaluated together with the sibling blocks.
+  if (pc_tree->ml_var_part_ready) return pc_tree->ml_var_part;
+
   vpx_clear_system_state();
 
-  {
-    const float thresh = cpi->oxcf.speed <= 5 ? 1.25f : 0.0f;
-    float features[FEATURES] = { 0.0f };
-    const int dc_q = vp9_dc_quant(cm->base_qindex, 0, cm->bit_depth);
-    int feature_idx = 0;
-    float score[LABELS];
+  get_var_part_features(cpi, x, bsize, mi_row, mi_col, features);
+  vp9_nn_predict(features, nn_config, score);
+  return get_var_part_decision(cpi, score[0]);
+}
 
-    features[feature_idx++] = logf((float)(dc_q * dc_q) / 256.0f + 1.0f);
-    vp9_setup_src_planes(x, cpi->Source, mi_row, mi_col);
-    {
-      const int bs = 4 * num_4x4_blocks_wide_lookup[bsize];
-      const BLOCK_SIZE subsize = get_subsize(bsize, PARTITION_SPLIT);
-      const int sb_offset_row = 8 * (mi_row & 7);
-      const int sb_offset_col = 8 * (mi_col & 7);
-      const uint8_t *pred = x->est_pred + sb_offset_row * 64 + sb_offset_col;
-      const uint8_t *src = x->plane[0].src.buf;
-      const int src_stride = x->plane[0].src.stride;
-      const int pred_stride = 64;
-      unsigned int sse;
-      int i;
-      // Variance of whole block.
-      const unsigned int var =
-          cpi->fn_ptr[bsize].vf(src, src_stride, pred, pred_stride, &sse);
-      const float factor = (var == 0) ? 1.0f : (1.0f / (float)var);
+// Evaluates the model for the square sub-blocks of a block that is going to
+// be split in one batch. The predictions are stored in the sub-block PC_TREE
+// nodes and picked up by ml_predict_var_paritioning().
+static void ml_predict_var_paritioning_split(VP9_COMP *cpi, MACROBLOCK *x,
+                                             PC_TREE *pc_tree,
+                                             BLOCK_SIZE bsize, int mi_row,
+                                             int mi_col) {
+  VP9_COMMON *const cm = &cpi->common;
+  const BLOCK_SIZE subsize = get_subsize(bsize, PARTITION_SPLIT);
+  const NN_CONFIG *nn_config = get_var_part_nnconfig(subsize);
+  const int ms = num_8x8_blocks_wide_lookup[bsize] / 2;
+  const int sub_ms = ms / 2;
+  float features[4][FEATURES];
+  float score[4];
+  int idx[4];
+  int num_blocks = 0;
+  int i;
 
-      features[feature_idx++] = logf((float)var + 1.0f);
-      for (i = 0; i < 4; ++i) {
-        const int x_idx = (i & 1) * bs / 2;
-        const int y_idx = (i >> 1) * bs / 2;
-        const int src_offset = y_idx * src_stride + x_idx;
-        const int pred_offset = y_idx * pred_stride + x_idx;
-        // Variance of quarter block.
-        const unsigned int sub_var =
-            cpi->fn_ptr[subsize].vf(src + src_offset, src_stride,
-                                    pred + pred_offset, pred_stride, &sse);
-        const float var_ratio = (var == 0) ? 1.0f : factor * (float)sub_var;
-        features[feature_idx++] = var_ratio;
-      }
-    }
+  if (!nn_config) return;
 
-    assert(feature_idx == FEATURES);
-    nn_predict(features, nn_config, score);
-    if (score[0] > thresh) return PARTITION_SPLIT;
-    if (score[0] < -thresh) return PARTITION_NONE;
-    return -1;
+  vpx_clear_system_state();
+
+  for (i = 0; i < 4; ++i) {
+    const int sub_mi_row = mi_row + (i >> 1) * ms;
+    const int sub_mi_col = mi_col + (i & 1) * ms;
+    // Only the sub-blocks that fit in the frame use the model.
+    if (sub_mi_row + sub_ms >= cm->mi_rows ||
+        sub_mi_col + sub_ms >= cm->mi_cols)
+      continue;
+    get_var_part_features(cpi, x, subsize, sub_mi_row, sub_mi_col,
+                          features[num_blocks]);
+    idx[num_blocks++] = i;
+  }
+
+  vp9_nn_predict_batch(&features[0][0], num_blocks, nn_config, score);
+  for (i = 0; i < num_blocks; ++i) {
+    PC_TREE *const sub_tree = pc_tree->split[idx[i]];
+    sub_tree->ml_var_part = get_var_part_decision(cpi, score[i]);
+    sub_tree->ml_var_part_ready = 1;
   }
 }
 #undef FEATURES
@@ -4919,6 +5009,7 @@ static void nonrd_pick_partition(VP9_COMP *cpi, ThreadData *td,
       !force_horz_split && xss <= yss && bsize >= BLOCK_8X8;
   const int use_ml_based_partitioning =
       sf->partition_search_type == ML_BASED_PARTITION;
+  int ml_predicted_partition = -1;
 
   (void)*tp_orig;
 
@@ -4953,8 +5044,8 @@ static void nonrd_pick_partition(VP9_COMP *cpi, ThreadData *td,
   if (use_ml_based_partitioning) {
     if (partition_none_allowed || do_split) do_rect = 0;
     if (partition_none_allowed && do_split) {
-      const int ml_predicted_partition =
-          ml_predict_var_paritioning(cpi, x, bsize, mi_row, mi_col);
+      ml_predicted_partition =
+          ml_predict_var_paritioning(cpi, x, pc_tree, bsize, mi_row, mi_col);
       if (ml_predicted_partition == PARTITION_NONE) do_split = 0;
       if (ml_predicted_partition == PARTITION_SPLIT) partition_none_allowed = 0;
     }
@@ -5008,6 +5099,10 @@ static void nonrd_pick_partition(VP9_COMP *cpi, ThreadData *td,
     sum_rdc.rate += cpi->partition_cost[pl][PARTITION_SPLIT];
     sum_rdc.rdcost = RDCOST(x->rdmult, x->rddiv, sum_rdc.rate, sum_rdc.dist);
     subsize = get_subsize(bsize, PARTITION_SPLIT);
+    // With PARTITION_NONE skipped all the sub-blocks are normally searched,
+    // so their model predictions can be computed together.
+    if (ml_predicted_partition == PARTITION_SPLIT)
+      ml_predict_var_paritioning_split(cpi, x, pc_tree, bsize, mi_row, mi_col);
     for (i = 0; i < 4 && sum_rdc.rdcost < best_rdc.rdcost; ++i) {
       const int x_idx = (i & 1) * ms;
       const int y_idx = (i >> 1) * ms;
@@ -5028,6 +5123,10 @@ static void nonrd_pick_partition(VP9_COMP *cpi, ThreadData *td,
       }
     }
 
+    if (ml_predicted_partition == PARTITION_SPLIT) {
+      for (i = 0; i < 4; ++i) pc_tree->split[i]->ml_var_part_ready = 0;
+    }
+
     if (sum_rdc.rdcost < best_rdc.rdcost) {
       best_rdc = sum_rdc;
       pc_tree->partitioning = PARTITION_SPLIT;
@@ -5524,6 +5623,7 @@ static void encode_nonrd_sb_row(VP9_COMP *cpi, ThreadData *td,
 
     (*(cpi->row_mt_sync_read_ptr))(&tile_data->row_mt_sync, sb_row,
                                    sb_col_in_tile);
+    reserve_sb_tokens(cpi, td, tp);
 
     if (cpi->use_skin_detection) {
       vp9_compute_skin_sb(cpi, BLOCK_16X16, mi_row, mi_col);
@@ -5815,10 +5915,9 @@ void vp9_init_tile_data(VP9_COMP *cpi) {
   const int tile_cols = 1 << cm->log2_tile_cols;
   const int tile_rows = 1 << cm->log2_tile_rows;
   int tile_col, tile_row;
-  TOKENEXTRA *pre_tok = cpi->tile_tok[0][0];
   TOKENLIST *tplist = cpi->tplist[0][0];
-  int tile_tok = 0;
   int tplist_count = 0;
+  int i;
 
   if (cpi->tile_data == NULL || cpi->allocated_tiles < tile_cols * tile_rows) {
     if (cpi->tile_data != NULL) vpx_free(cpi->tile_data);
@@ -5854,15 +5953,17 @@ void vp9_init_tile_data(VP9_COMP *cpi) {
         vp9_row_mt_alloc_rd_thresh(cpi, this_tile);
       vp9_tile_init(tile_info, cm, tile_row, tile_col);
 
-      cpi->tile_tok[tile_row][tile_col] = pre_tok + tile_tok;
-      pre_tok = cpi->tile_tok[tile_row][tile_col];
-      tile_tok = allocated_tokens(*tile_info);
-
       cpi->tplist[tile_row][tile_col] = tplist + tplist_count;
       tplist = cpi->tplist[tile_row][tile_col];
       tplist_count = get_num_vert_units(*tile_info, MI_BLOCK_SIZE_LOG2);
     }
   }
+
+  // The tokens of the previous encode are no longer needed.
+  vp9_token_pool_reset(&cpi->token_pool);
+  cpi->td.tok_chunk = NULL;
+  for (i = 0; i < cpi->num_workers; ++i)
+    cpi->tile_thr_data[i].td->tok_chunk = NULL;
 }
 
 void vp9_encode_sb_row(VP9_COMP *cpi, ThreadData *td, int tile_row,
@@ -5871,14 +5972,17 @@ void vp9_encode_sb_row(VP9_COMP *cpi, ThreadData *td, int tile_row,
   const int tile_cols = 1 << cm->log2_tile_cols;
   TileDataEnc *this_tile = &cpi->tile_data[tile_row * tile_cols + tile_col];
   const TileInfo *const tile_info = &this_tile->tile_info;
-  TOKENEXTRA *tok = NULL;
-  int tile_sb_row;
-  int tile_mb_cols = (tile_info->mi_col_end - tile_info->mi_col_start + 1) >> 1;
-
-  tile_sb_row = mi_cols_aligned_to_sb(mi_row - tile_info->mi_row_start) >>
-                MI_BLOCK_SIZE_LOG2;
-  get_start_tok(cpi, tile_row, tile_col, mi_row, &tok);
-  cpi->tplist[tile_row][tile_col][tile_sb_row].start = tok;
+  const int tile_sb_row =
+      mi_cols_aligned_to_sb(mi_row - tile_info->mi_row_start) >>
+      MI_BLOCK_SIZE_LOG2;
+  TOKENLIST *const tplist = &cpi->tplist[tile_row][tile_col][tile_sb_row];
+  TOKENEXTRA *tok;
+
+  if (td->tok_chunk == NULL)
+    td->tok_chunk = vp9_token_pool_get_chunk(&cpi->token_pool, cm);
+  tok = td->tok_chunk->stop;
+  tplist->start = tok;
+  tplist->chunk = td->tok_chunk;
 
 #if CONFIG_REALTIME_ONLY
   assert(cpi->sf.use_nonrd_pick_mode);
@@ -5890,14 +5994,9 @@ void vp9_encode_sb_row(VP9_COMP *cpi, ThreadData *td, int tile_row,
     encode_rd_sb_row(cpi, td, this_tile, mi_row, &tok);
 #endif
 
-  cpi->tplist[tile_row][tile_col][tile_sb_row].stop = tok;
-  cpi->tplist[tile_row][tile_col][tile_sb_row].count =
-      (unsigned int)(cpi->tplist[tile_row][tile_col][tile_sb_row].stop -
-                     cpi->tplist[tile_row][tile_col][tile_sb_row].start);
-  assert(tok - cpi->tplist[tile_row][tile_col][tile_sb_row].start <=
-         get_token_alloc(MI_BLOCK_SIZE >> 1, tile_mb_cols));
-
-  (void)tile_mb_cols;
+  td->tok_chunk->stop = tok;
+  tplist->stop = tok;
+  tplist->stop_chunk = td->tok_chunk;
 }
 
 void vp9_encode_tile(VP9_COMP *cpi, ThreadData *td, int tile_row,
@@ -6028,6 +6127,28 @@ void vp9_kmeans(double *ctr_ls, double *boundary_ls, int *count_ls, int k,
   }
 }
 
+// Points the sub-pixel cache at the buffers the motion search reads for each
+// reference, the scaled ones when the reference is scaled.
+static void setup_subpel_cache(VP9_COMP *cpi) {
+  VP9_COMMON *const cm = &cpi->common;
+  const YV12_BUFFER_CONFIG *refs[SUBPEL_CACHE_MAX_REFS];
+  MV_REFERENCE_FRAME ref_frame;
+  int num_refs = 0;
+
+  if (!frame_is_intra_only(cm)) {
+    for (ref_frame = LAST_FRAME; ref_frame <= ALTREF_FRAME; ++ref_frame) {
+      const YV12_BUFFER_CONFIG *const scaled_ref =
+          vp9_get_scaled_ref_frame(cpi, ref_frame);
+      if (!(cpi->ref_frame_flags & ref_frame_to_flag(ref_frame))) continue;
+      refs[num_refs++] = scaled_ref != NULL
+                             ? scaled_ref
+                             : get_ref_frame_buffer(cpi, ref_frame);
+    }
+  }
+  vp9_subpel_cache_setup(&cpi->subpel_cache, cpi->oxcf.subpel_cache, refs,
+                         num_refs, cm);
+}
+
 static void encode_frame_internal(VP9_COMP *cpi) {
   SPEED_FEATURES *const sf = &cpi->sf;
   ThreadData *const td = &cpi->td;
@@ -6074,6 +6195,7 @@ static void encode_frame_internal(VP9_COMP *cpi) {
   // context cannot be used.
   cm->prev_mi =
       cm->use_prev_frame_mvs ? cm->prev_mip + cm->mi_stride + 1 : NULL;
+  vp9_temporal_mv_map_build(cpi);
 
   x->quant_fp = cpi->sf.use_quant_fp;
   vp9_zero(x->skip_txfm);
@@ -6131,6 +6253,7 @@ static void encode_frame_internal(VP9_COMP *cpi) {
     struct vpx_usec_timer emr_timer;
     vpx_usec_timer_start(&emr_timer);
 
+    setup_subpel_cache(cpi);
     if (!cpi->row_mt) {
       cpi->row_mt_sync_read_ptr = vp9_row_mt_sync_read_dummy;
       cpi->row_mt_sync_write_ptr = vp9_row_mt_sync_write_dummy;
@@ -6145,6 +6268,7 @@ static void encode_frame_internal(VP9_COMP *cpi) {
       cpi->row_mt_sync_write_ptr = vp9_row_mt_sync_write;
       vp9_encode_tiles_row_mt(cpi);
     }
+    vp9_subpel_cache_clear(&cpi->subpel_cache);
 
     vpx_usec_timer_mark(&emr_timer);
     cpi->time_encode_sb_row += vpx_usec_timer_elapsed(&emr_timer);
@@ -6225,6 +6349,7 @@ static void restore_encode_params(VP9_COMP *cpi) {
 void vp9_encode_frame(VP9_COMP *cpi) {
   VP9_COMMON *const cm = &cpi->common;
 
+  start_stage_timing(cpi, VPX_STAGE_ENCODE_FRAME);
   restore_encode_params(cpi);
 
 #if CONFIG_MISMATCH_DEBUG
@@ -6378,6 +6503,7 @@ void vp9_encode_frame(VP9_COMP *cpi) {
       (cm->seg.update_map || cm->seg.update_data)) {
     cm->seg.aq_av_offset = compute_frame_aq_offset(cpi);
   }
+  end_stage_timing(cpi, VPX_STAGE_ENCODE_FRAME);
 }
 
 static void sum_intra_stats(FRAME_COUNTS *counts, const MODE_INFO *mi) {
@@ -74,6 +74,7 @@
 #include "vp9/encoder/vp9_resize.h"
 #include "vp9/encoder/vp9_segmentation.h"
 #include "vp9/encoder/vp9_skin_detection.h"
+#include "vp9/encoder/vp9_spatial_denoise.h"
 #include "vp9/encoder/vp9_speed_features.h"
 #include "vp9/encoder/vp9_svc_layercontext.h"
 #include "vp9/encoder/vp9_temporal_filter.h"
@@ -519,7 +520,8 @@ static INLINE void Scale2Ratio(VPX_SCALING_MODE mode, int *hr, int *hs) {
 static void suppress_active_map(VP9_COMP *cpi) {
   unsigned char *const seg_map = cpi->segmentation_map;
 
-  if (cpi->active_map.enabled || cpi->active_map.update) {
+  if (cpi->active_map.enabled || cpi->active_map.update ||
+      cpi->dirty_map.applied) {
     const int rows = cpi->common.mi_rows;
     const int cols = cpi->common.mi_cols;
     int i;
@@ -530,10 +532,54 @@ static void suppress_active_map(VP9_COMP *cpi) {
   }
 }
 
+// Whether the blocks outside of the dirty rectangles can be copied from LAST.
+static int dirty_map_applies(VP9_COMP *cpi) {
+  const VP9_COMMON *const cm = &cpi->common;
+  const YV12_BUFFER_CONFIG *last;
+
+  if (!cpi->dirty_map.enabled || frame_is_intra_only(cm) ||
+      !(cpi->ref_frame_flags & VP9_LAST_FLAG) ||
+      cm->width != cpi->un_scaled_source->y_crop_width ||
+      cm->height != cpi->un_scaled_source->y_crop_height)
+    return 0;
+  last = get_ref_frame_buffer(cpi, LAST_FRAME);
+  return last != NULL && last->y_crop_width == cm->width &&
+         last->y_crop_height == cm->height;
+}
+
+// Counts the superblocks coded as skipped without any search.
+static int count_inactive_superblocks(const VP9_COMP *cpi) {
+  const VP9_COMMON *const cm = &cpi->common;
+  const unsigned char *const seg_map = cpi->segmentation_map;
+  int mi_row, mi_col, r, c;
+  int count = 0;
+
+  for (mi_row = 0; mi_row < cm->mi_rows; mi_row += MI_BLOCK_SIZE) {
+    for (mi_col = 0; mi_col < cm->mi_cols; mi_col += MI_BLOCK_SIZE) {
+      const int rows = VPXMIN(MI_BLOCK_SIZE, cm->mi_rows - mi_row);
+      const int cols = VPXMIN(MI_BLOCK_SIZE, cm->mi_cols - mi_col);
+      int inactive = 1;
+      for (r = 0; r < rows && inactive; ++r) {
+        for (c = 0; c < cols; ++c) {
+          if (seg_map[(mi_row + r) * cm->mi_cols + mi_col + c] !=
+              AM_SEGMENT_ID_INACTIVE) {
+            inactive = 0;
+            break;
+          }
+        }
+      }
+      count += inactive;
+    }
+  }
+  return count;
+}
+
 static void apply_active_map(VP9_COMP *cpi) {
   struct segmentation *const seg = &cpi->common.seg;
   unsigned char *const seg_map = cpi->segmentation_map;
   const unsigned char *const active_map = cpi->active_map.map;
+  const unsigned char *const dirty_map = cpi->dirty_map.map;
+  const int use_dirty_map = dirty_map_applies(cpi);
   int i;
 
   assert(AM_SEGMENT_ID_ACTIVE == CR_SEGMENT_ID_BASE);
@@ -543,10 +589,21 @@ static void apply_active_map(VP9_COMP *cpi) {
     cpi->active_map.update = 1;
   }
 
+  // The dirty map changes with every frame.
+  if (use_dirty_map || cpi->dirty_map.applied) cpi->active_map.update = 1;
+  cpi->dirty_map.applied = use_dirty_map;
+
   if (cpi->active_map.update) {
-    if (cpi->active_map.enabled) {
-      for (i = 0; i < cpi->common.mi_rows * cpi->common.mi_cols; ++i)
-        if (seg_map[i] == AM_SEGMENT_ID_ACTIVE) seg_map[i] = active_map[i];
+    if (cpi->active_map.enabled || use_dirty_map) {
+      for (i = 0; i < cpi->common.mi_rows * cpi->common.mi_cols; ++i) {
+        // The clean blocks are skipped whatever segment the AQ gave them.
+        if (use_dirty_map && !dirty_map[i])
+          seg_map[i] = AM_SEGMENT_ID_INACTIVE;
+        else if (cpi->active_map.enabled && seg_map[i] == AM_SEGMENT_ID_ACTIVE)
+          seg_map[i] = active_map[i];
+      }
+      cpi->dirty_map.stats.num_skipped_blocks =
+          count_inactive_superblocks(cpi);
       vp9_enable_segmentation(seg);
       vp9_enable_segfeature(seg, AM_SEGMENT_ID_INACTIVE, SEG_LVL_SKIP);
       vp9_enable_segfeature(seg, AM_SEGMENT_ID_INACTIVE, SEG_LVL_ALT_LF);
@@ -787,6 +844,38 @@ int vp9_get_active_map(VP9_COMP *cpi, unsigned char *new_map_16x16, int rows,
   }
 }
 
+int vp9_set_dirty_rects(VP9_COMP *cpi, const vpx_dirty_rects_t *rects) {
+  DirtyMap *const dirty = &cpi->dirty_map;
+
+  if (rects == NULL) {
+    dirty->pending = 0;
+    return 0;
+  }
+  // The rectangles are relative to the previous frame received, which is only
+  // the previous frame encoded without lag and spatial layers.
+  if (cpi->oxcf.lag_in_frames > 0 || cpi->use_svc) return -1;
+  if (rects->num_rects > 0 && rects->rects == NULL) return -1;
+
+  if ((int)rects->num_rects > dirty->rects_size) {
+    vpx_free(dirty->rects);
+    dirty->rects_size = 0;
+    dirty->rects = (vpx_dirty_rect_t *)vpx_malloc(rects->num_rects *
+                                                  sizeof(*dirty->rects));
+    if (dirty->rects == NULL) {
+      dirty->pending = 0;
+      return -1;
+    }
+    dirty->rects_size = (int)rects->num_rects;
+  }
+  if (rects->num_rects > 0) {
+    memcpy(dirty->rects, rects->rects,
+           rects->num_rects * sizeof(*dirty->rects));
+  }
+  dirty->num_rects = (int)rects->num_rects;
+  dirty->pending = 1;
+  return 0;
+}
+
 void vp9_set_high_precision_mv(VP9_COMP *cpi, int allow_high_precision_mv) {
   MACROBLOCK *const mb = &cpi->td.mb;
   cpi->common.allow_high_precision_mv = allow_high_precision_mv;
@@ -974,6 +1063,9 @@ static void dealloc_compressor_data(VP9_COMP *cpi) {
   vpx_free(cpi->prev_partition);
   cpi->prev_partition = NULL;
 
+  vpx_free(cpi->recode_partition);
+  cpi->recode_partition = NULL;
+
   vpx_free(cpi->svc.prev_partition_svc);
   cpi->svc.prev_partition_svc = NULL;
 
@@ -1000,6 +1092,13 @@ static void dealloc_compressor_data(VP9_COMP *cpi) {
   vpx_free(cpi->active_map.map);
   cpi->active_map.map = NULL;
 
+  vpx_free(cpi->dirty_map.rects);
+  cpi->dirty_map.rects = NULL;
+  vpx_free(cpi->dirty_map.map);
+  cpi->dirty_map.map = NULL;
+  vpx_free(cpi->dirty_map.stale_map);
+  cpi->dirty_map.stale_map = NULL;
+
   vpx_free(cpi->roi.roi_map);
   cpi->roi.roi_map = NULL;
 
@@ -1027,7 +1126,6 @@ static void dealloc_compressor_data(VP9_COMP *cpi) {
 #endif
   vp9_free_context_buffers(cm);
 
-  vpx_free_frame_buffer(&cpi->last_frame_uf);
   vpx_free_frame_buffer(&cpi->scaled_source);
   vpx_free_frame_buffer(&cpi->scaled_last_source);
   vpx_free_frame_buffer(&cpi->alt_ref_buffer);
@@ -1038,9 +1136,6 @@ static void dealloc_compressor_data(VP9_COMP *cpi) {
 
   vp9_lookahead_destroy(cpi->lookahead);
 
-  vpx_free(cpi->tile_tok[0][0]);
-  cpi->tile_tok[0][0] = 0;
-
   vpx_free(cpi->tplist[0][0]);
   cpi->tplist[0][0] = NULL;
 
@@ -1117,6 +1212,9 @@ static void restore_coding_context(VP9_COMP *cpi) {
          MV_VALS * sizeof(*cc->nmvcosts_hp[0]));
   memcpy(cpi->nmvcosts_hp[1], cc->nmvcosts_hp[1],
          MV_VALS * sizeof(*cc->nmvcosts_hp[1]));
+  // The restored tables may not match the probabilities they were last built
+  // from.
+  cpi->rd.cost_cache.mv_costs_valid = 0;
 
   vp9_copy(cm->seg.pred_probs, cc->segment_pred_probs);
 
@@ -1300,16 +1398,6 @@ static void alloc_raw_frame_buffers(VP9_COMP *cpi) {
 
 static void alloc_util_frame_buffers(VP9_COMP *cpi) {
   VP9_COMMON *const cm = &cpi->common;
-  if (vpx_realloc_frame_buffer(&cpi->last_frame_uf, cm->width, cm->height,
-                               cm->subsampling_x, cm->subsampling_y,
-#if CONFIG_VP9_HIGHBITDEPTH
-                               cm->use_highbitdepth,
-#endif
-                               VP9_ENC_BORDER_IN_PIXELS, cm->byte_alignment,
-                               NULL, NULL, NULL))
-    vpx_internal_error(&cm->error, VPX_CODEC_MEM_ERROR,
-                       "Failed to allocate last frame buffer");
-
   if (vpx_realloc_frame_buffer(&cpi->scaled_source, cm->width, cm->height,
                                cm->subsampling_x, cm->subsampling_y,
 #if CONFIG_VP9_HIGHBITDEPTH
@@ -1388,14 +1476,6 @@ static void alloc_compressor_data(VP9_COMP *cpi) {
 
   alloc_context_buffers_ext(cpi);
 
-  vpx_free(cpi->tile_tok[0][0]);
-
-  {
-    unsigned int tokens = get_token_alloc(cm->mb_rows, cm->mb_cols);
-    CHECK_MEM_ERROR(cm, cpi->tile_tok[0][0],
-                    vpx_calloc(tokens, sizeof(*cpi->tile_tok[0][0])));
-  }
-
   sb_rows = mi_cols_aligned_to_sb(cm->mi_rows) >> MI_BLOCK_SIZE_LOG2;
   vpx_free(cpi->tplist[0][0]);
   CHECK_MEM_ERROR(
@@ -1403,6 +1483,10 @@ static void alloc_compressor_data(VP9_COMP *cpi) {
       vpx_calloc(sb_rows * 4 * (1 << 6), sizeof(*cpi->tplist[0][0])));
 
   vp9_setup_pc_tree(&cpi->common, &cpi->td);
+
+  // Reallocated at the new frame size on its next use.
+  vpx_free(cpi->recode_partition);
+  cpi->recode_partition = NULL;
 }
 
 void vp9_new_framerate(VP9_COMP *cpi, double framerate) {
@@ -1569,7 +1653,8 @@ void vp9_set_rc_buffer_sizes(VP9_COMP *cpi) {
   cpi->fn_ptr[BT].svf = SVF;                                            \
   cpi->fn_ptr[BT].svaf = SVAF;                                          \
   cpi->fn_ptr[BT].sdx4df = SDX4DF;                                      \
-  cpi->fn_ptr[BT].sdsx4df = SDSX4DF;
+  cpi->fn_ptr[BT].sdsx4df = SDSX4DF;                                    \
+  cpi->fn_ptr[BT].sdx8df = NULL;
 
 #define MAKE_BFP_SAD_WRAPPER(fnname)                                           \
   static unsigned int fnname##_bits8(const uint8_t *src_ptr,                   \
@@ -2365,6 +2450,9 @@ VP9_COMP *vp9_create_compressor(const VP9EncoderConfig *oxcf,
   }
 
   cm->error.setjmp = 1;
+  vp9_token_pool_init(&cpi->token_pool);
+  vp9_subpel_cache_init(&cpi->subpel_cache);
+  cpi->td.mb.subpel_cache = &cpi->subpel_cache;
   cm->alloc_mi = vp9_enc_alloc_mi;
   cm->free_mi = vp9_enc_free_mi;
   cm->setup_mi = vp9_enc_setup_mi;
@@ -2484,6 +2572,7 @@ VP9_COMP *vp9_create_compressor(const VP9EncoderConfig *oxcf,
 #endif
 
   cpi->first_time_stamp_ever = INT64_MAX;
+  vp9_set_stage_timing(cpi, 0);
 
   /*********************************************************************
    * Warning: Read the comments around 'cal_nmvjointsadcost' and       *
@@ -2632,67 +2721,77 @@ VP9_COMP *vp9_create_compressor(const VP9EncoderConfig *oxcf,
                   vpx_calloc(cm->MBs, sizeof(cpi->source_diff_var)));
   cpi->source_var_thresh = 0;
   cpi->frames_till_next_var_check = 0;
-#define BFP(BT, SDF, SDSF, SDAF, VF, SVF, SVAF, SDX4DF, SDSX4DF) \
-  cpi->fn_ptr[BT].sdf = SDF;                                     \
-  cpi->fn_ptr[BT].sdsf = SDSF;                                   \
-  cpi->fn_ptr[BT].sdaf = SDAF;                                   \
-  cpi->fn_ptr[BT].vf = VF;                                       \
-  cpi->fn_ptr[BT].svf = SVF;                                     \
-  cpi->fn_ptr[BT].svaf = SVAF;                                   \
-  cpi->fn_ptr[BT].sdx4df = SDX4DF;                               \
-  cpi->fn_ptr[BT].sdsx4df = SDSX4DF;
+#define BFP(BT, SDF, SDSF, SDAF, VF, SVF, SVAF, SDX4DF, SDSX4DF, SDX8DF) \
+  cpi->fn_ptr[BT].sdf = SDF;                                             \
+  cpi->fn_ptr[BT].sdsf = SDSF;                                           \
+  cpi->fn_ptr[BT].sdaf = SDAF;                                           \
+  cpi->fn_ptr[BT].vf = VF;                                               \
+  cpi->fn_ptr[BT].svf = SVF;                                             \
+  cpi->fn_ptr[BT].svaf = SVAF;                                           \
+  cpi->fn_ptr[BT].sdx4df = SDX4DF;                                       \
+  cpi->fn_ptr[BT].sdsx4df = SDSX4DF;                                     \
+  cpi->fn_ptr[BT].sdx8df = SDX8DF;
 
   BFP(BLOCK_32X16, vpx_sad32x16, vpx_sad_skip_32x16, vpx_sad32x16_avg,
       vpx_variance32x16, vpx_sub_pixel_variance32x16,
-      vpx_sub_pixel_avg_variance32x16, vpx_sad32x16x4d, vpx_sad_skip_32x16x4d)
+      vpx_sub_pixel_avg_variance32x16, vpx_sad32x16x4d, vpx_sad_skip_32x16x4d,
+      vpx_sad32x16x8d)
 
   BFP(BLOCK_16X32, vpx_sad16x32, vpx_sad_skip_16x32, vpx_sad16x32_avg,
       vpx_variance16x32, vpx_sub_pixel_variance16x32,
-      vpx_sub_pixel_avg_variance16x32, vpx_sad16x32x4d, vpx_sad_skip_16x32x4d)
+      vpx_sub_pixel_avg_variance16x32, vpx_sad16x32x4d, vpx_sad_skip_16x32x4d,
+      vpx_sad16x32x8d)
 
   BFP(BLOCK_64X32, vpx_sad64x32, vpx_sad_skip_64x32, vpx_sad64x32_avg,
       vpx_variance64x32, vpx_sub_pixel_variance64x32,
-      vpx_sub_pixel_avg_variance64x32, vpx_sad64x32x4d, vpx_sad_skip_64x32x4d)
+      vpx_sub_pixel_avg_variance64x32, vpx_sad64x32x4d, vpx_sad_skip_64x32x4d,
+      vpx_sad64x32x8d)
 
   BFP(BLOCK_32X64, vpx_sad32x64, vpx_sad_skip_32x64, vpx_sad32x64_avg,
       vpx_variance32x64, vpx_sub_pixel_variance32x64,
-      vpx_sub_pixel_avg_variance32x64, vpx_sad32x64x4d, vpx_sad_skip_32x64x4d)
+      vpx_sub_pixel_avg_variance32x64, vpx_sad32x64x4d, vpx_sad_skip_32x64x4d,
+      vpx_sad32x64x8d)
 
   BFP(BLOCK_32X32, vpx_sad32x32, vpx_sad_skip_32x32, vpx_sad32x32_avg,
       vpx_variance32x32, vpx_sub_pixel_variance32x32,
-      vpx_sub_pixel_avg_variance32x32, vpx_sad32x32x4d, vpx_sad_skip_32x32x4d)
+      vpx_sub_pixel_avg_variance32x32, vpx_sad32x32x4d, vpx_sad_skip_32x32x4d,
+      vpx_sad32x32x8d)
 
   BFP(BLOCK_64X64, vpx_sad64x64, vpx_sad_skip_64x64, vpx_sad64x64_avg,
       vpx_variance64x64, vpx_sub_pixel_variance64x64,
-      vpx_sub_pixel_avg_variance64x64, vpx_sad64x64x4d, vpx_sad_skip_64x64x4d)
+      vpx_sub_pixel_avg_variance64x64, vpx_sad64x64x4d, vpx_sad_skip_64x64x4d,
+      vpx_sad64x64x8d)
 
   BFP(BLOCK_16X16, vpx_sad16x16, vpx_sad_skip_16x16, vpx_sad16x16_avg,
       vpx_variance16x16, vpx_sub_pixel_variance16x16,
-      vpx_sub_pixel_avg_variance16x16, vpx_sad16x16x4d, vpx_sad_skip_16x16x4d)
+      vpx_sub_pixel_avg_variance16x16, vpx_sad16x16x4d, vpx_sad_skip_16x16x4d,
+      vpx_sad16x16x8d)
 
   BFP(BLOCK_16X8, vpx_sad16x8, vpx_sad_skip_16x8, vpx_sad16x8_avg,
       vpx_variance16x8, vpx_sub_pixel_variance16x8,
-      vpx_sub_pixel_avg_variance16x8, vpx_sad16x8x4d, vpx_sad_skip_16x8x4d)
+      vpx_sub_pixel_avg_variance16x8, vpx_sad16x8x4d, vpx_sad_skip_16x8x4d,
+      vpx_sad16x8x8d)
 
   BFP(BLOCK_8X16, vpx_sad8x16, vpx_sad_skip_8x16, vpx_sad8x16_avg,
       vpx_variance8x16, vpx_sub_pixel_variance8x16,
-      vpx_sub_pixel_avg_variance8x16, vpx_sad8x16x4d, vpx_sad_skip_8x16x4d)
+      vpx_sub_pixel_avg_variance8x16, vpx_sad8x16x4d, vpx_sad_skip_8x16x4d,
+      vpx_sad8x16x8d)
 
   BFP(BLOCK_8X8, vpx_sad8x8, vpx_sad_skip_8x8, vpx_sad8x8_avg, vpx_variance8x8,
       vpx_sub_pixel_variance8x8, vpx_sub_pixel_avg_variance8x8, vpx_sad8x8x4d,
-      vpx_sad_skip_8x8x4d)
+      vpx_sad_skip_8x8x4d, vpx_sad8x8x8d)
 
   BFP(BLOCK_8X4, vpx_sad8x4, vpx_sad_skip_8x4, vpx_sad8x4_avg, vpx_variance8x4,
       vpx_sub_pixel_variance8x4, vpx_sub_pixel_avg_variance8x4, vpx_sad8x4x4d,
-      vpx_sad_skip_8x4x4d)
+      vpx_sad_skip_8x4x4d, vpx_sad8x4x8d)
 
   BFP(BLOCK_4X8, vpx_sad4x8, vpx_sad_skip_4x8, vpx_sad4x8_avg, vpx_variance4x8,
       vpx_sub_pixel_variance4x8, vpx_sub_pixel_avg_variance4x8, vpx_sad4x8x4d,
-      vpx_sad_skip_4x8x4d)
+      vpx_sad_skip_4x8x4d, vpx_sad4x8x8d)
 
   BFP(BLOCK_4X4, vpx_sad4x4, vpx_sad_skip_4x4, vpx_sad4x4_avg, vpx_variance4x4,
       vpx_sub_pixel_variance4x4, vpx_sub_pixel_avg_variance4x4, vpx_sad4x4x4d,
-      vpx_sad_skip_4x4x4d)
+      vpx_sad_skip_4x4x4d, vpx_sad4x4x8d)
 
 #if CONFIG_VP9_HIGHBITDEPTH
   highbd_set_var_fns(cpi);
@@ -2859,6 +2958,9 @@ void vp9_remove_compressor(VP9_COMP *cpi) {
   vp9_bitstream_encode_tiles_buffer_dealloc(cpi);
   vp9_row_mt_mem_dealloc(cpi);
   vp9_encode_free_mt_data(cpi);
+  vp9_token_pool_free(&cpi->token_pool);
+  vp9_subpel_cache_free(&cpi->subpel_cache);
+  vp9_temporal_mv_map_free(&cpi->temporal_mv_map);
 
 #if !CONFIG_REALTIME_ONLY
   vp9_alt_ref_aq_destroy(cpi->alt_ref_aq);
@@ -2914,10 +3016,13 @@ void vp9_remove_compressor(VP9_COMP *cpi) {
 int vp9_get_psnr(const VP9_COMP *cpi, PSNR_STATS *psnr) {
   if (is_psnr_calc_enabled(cpi)) {
 #if CONFIG_VP9_HIGHBITDEPTH
-    vpx_calc_highbd_psnr(cpi->raw_source_frame, cpi->common.frame_to_show, psnr,
-                         cpi->td.mb.e_mbd.bd, cpi->oxcf.input_bit_depth);
+    vpx_calc_highbd_psnr_mt(cpi->raw_source_frame, cpi->common.frame_to_show,
+                            psnr, cpi->td.mb.e_mbd.bd,
+                            cpi->oxcf.input_bit_depth, cpi->workers,
+                            cpi->num_workers);
 #else
-    vpx_calc_psnr(cpi->raw_source_frame, cpi->common.frame_to_show, psnr);
+    vpx_calc_psnr_mt(cpi->raw_source_frame, cpi->common.frame_to_show, psnr,
+                     cpi->workers, cpi->num_workers);
 #endif
     return 1;
   } else {
@@ -3888,8 +3993,8 @@ static INLINE void set_raw_source_frame(VP9_COMP *cpi) {
 #ifdef ENABLE_KF_DENOISE
   if (is_spatial_denoise_enabled(cpi)) {
     cpi->raw_source_frame = vp9_scale_if_required(
-        cm, &cpi->raw_unscaled_source, &cpi->raw_scaled_source,
-        (oxcf->pass == 0), EIGHTTAP, 0);
+        &cpi->common, &cpi->raw_unscaled_source, &cpi->raw_scaled_source,
+        (cpi->oxcf.pass == 0), EIGHTTAP, 0);
   } else {
     cpi->raw_source_frame = cpi->Source;
   }
@@ -4397,6 +4502,30 @@ static void rq_model_update(const RATE_QINDEX_HISTORY *rq_history,
 }
 #endif  // CONFIG_RATE_CTRL
 
+// Decides whether the next recode iteration, encoded at |q|, can skip the
+// partition search and reuse the partitioning of the last full search. Only
+// the mode decisions, quantization and tokenization are then redone.
+static void setup_recode_partition_reuse(VP9_COMP *cpi, int q) {
+  VP9_COMMON *const cm = &cpi->common;
+  const SPEED_FEATURES *const sf = &cpi->sf;
+
+  cpi->recode_partition_reuse = 0;
+  if (sf->recode_partition_reuse_qthresh <= 0 ||
+      sf->partition_search_type != SEARCH_PARTITION || sf->use_nonrd_pick_mode)
+    return;
+
+  if (cpi->recode_partition == NULL) {
+    CHECK_MEM_ERROR(cm, cpi->recode_partition,
+                    (BLOCK_SIZE *)vpx_calloc(cm->mi_stride * cm->mi_rows,
+                                             sizeof(*cpi->recode_partition)));
+    cpi->recode_partition_q = -1;
+  }
+
+  cpi->recode_partition_reuse =
+      cpi->recode_partition_q >= 0 &&
+      abs(q - cpi->recode_partition_q) <= sf->recode_partition_reuse_qthresh;
+}
+
 static void encode_with_recode_loop(VP9_COMP *cpi, size_t *size, uint8_t *dest
 #if CONFIG_RATE_CTRL
                                     ,
@@ -4497,6 +4626,9 @@ static void encode_with_recode_loop(VP9_COMP *cpi, size_t *size, uint8_t *dest
       q_high = top_index;
 
       loop_at_this_size = 0;
+
+      // Partitionings searched at another frame size cannot be reused.
+      cpi->recode_partition_q = -1;
     }
 
     // Decide frame size bounds first time through.
@@ -4603,8 +4735,13 @@ static void encode_with_recode_loop(VP9_COMP *cpi, size_t *size, uint8_t *dest
       vp9_psnr_aq_mode_setup(&cm->seg);
     }
 
+    setup_recode_partition_reuse(cpi, q);
+
     vp9_encode_frame(cpi);
 
+    if (cpi->recode_partition != NULL && !cpi->recode_partition_reuse)
+      cpi->recode_partition_q = q;
+
     // Update the skip mb flag probabilities based on the distribution
     // seen in the last encoder iteration.
     // update_base_skip_probs(cpi);
@@ -4878,6 +5015,9 @@ static void encode_with_recode_loop(VP9_COMP *cpi, size_t *size, uint8_t *dest
     }
   }
 
+  // The final encode searches with the adapted context models.
+  cpi->recode_partition_reuse = 0;
+
   if (enable_acl) {
     // Skip recoding, if model diff is below threshold
     const int thresh = compute_context_model_thresh(cpi);
@@ -5008,162 +5148,6 @@ static int setup_interp_filter_search_mask(VP9_COMP *cpi) {
   return mask;
 }
 
-#ifdef ENABLE_KF_DENOISE
-// Baseline kernel weights for denoise
-static uint8_t dn_kernal_3[9] = { 1, 2, 1, 2, 4, 2, 1, 2, 1 };
-static uint8_t dn_kernal_5[25] = { 1, 1, 1, 1, 1, 1, 1, 2, 1, 1, 1, 2, 4,
-                                   2, 1, 1, 1, 2, 1, 1, 1, 1, 1, 1, 1 };
-
-static INLINE void add_denoise_point(int centre_val, int data_val, int thresh,
-                                     uint8_t point_weight, int *sum_val,
-                                     int *sum_weight) {
-  if (abs(centre_val - data_val) <= thresh) {
-    *sum_weight += point_weight;
-    *sum_val += (int)data_val * (int)point_weight;
-  }
-}
-
-static void spatial_denoise_point(uint8_t *src_ptr, const int stride,
-                                  const int strength) {
-  int sum_weight = 0;
-  int sum_val = 0;
-  int thresh = strength;
-  int kernal_size = 5;
-  int half_k_size = 2;
-  int i, j;
-  int max_diff = 0;
-  uint8_t *tmp_ptr;
-  uint8_t *kernal_ptr;
-
-  // Find the maximum deviation from the source point in the locale.
-  tmp_ptr = src_ptr - (stride * (half_k_size + 1)) - (half_k_size + 1);
-  for (i = 0; i < kernal_size + 2; ++i) {
-    for (j = 0; j < kernal_size + 2; ++j) {
-      max_diff = VPXMAX(max_diff, abs((int)*src_ptr - (int)tmp_ptr[j]));
-    }
-    tmp_ptr += stride;
-  }
-
-  // Select the kernel size.
-  if (max_diff > (strength + (strength >> 1))) {
-    kernal_size = 3;
-    half_k_size = 1;
-    thresh = thresh >> 1;
-  }
-  kernal_ptr = (kernal_size == 3) ? dn_kernal_3 : dn_kernal_5;
-
-  // Apply the kernel
-  tmp_ptr = src_ptr - (stride * half_k_size) - half_k_size;
-  for (i = 0; i < kernal_size; ++i) {
-    for (j = 0; j < kernal_size; ++j) {
-      add_denoise_point((int)*src_ptr, (int)tmp_ptr[j], thresh, *kernal_ptr,
-                        &sum_val, &sum_weight);
-      ++kernal_ptr;
-    }
-    tmp_ptr += stride;
-  }
-
-  // Update the source value with the new filtered value
-  *src_ptr = (uint8_t)((sum_val + (sum_weight >> 1)) / sum_weight);
-}
-
-#if CONFIG_VP9_HIGHBITDEPTH
-static void highbd_spatial_denoise_point(uint16_t *src_ptr, const int stride,
-                                         const int strength) {
-  int sum_weight = 0;
-  int sum_val = 0;
-  int thresh = strength;
-  int kernal_size = 5;
-  int half_k_size = 2;
-  int i, j;
-  int max_diff = 0;
-  uint16_t *tmp_ptr;
-  uint8_t *kernal_ptr;
-
-  // Find the maximum deviation from the source point in the locale.
-  tmp_ptr = src_ptr - (stride * (half_k_size + 1)) - (half_k_size + 1);
-  for (i = 0; i < kernal_size + 2; ++i) {
-    for (j = 0; j < kernal_size + 2; ++j) {
-      max_diff = VPXMAX(max_diff, abs((int)src_ptr - (int)tmp_ptr[j]));
-    }
-    tmp_ptr += stride;
-  }
-
-  // Select the kernel size.
-  if (max_diff > (strength + (strength >> 1))) {
-    kernal_size = 3;
-    half_k_size = 1;
-    thresh = thresh >> 1;
-  }
-  kernal_ptr = (kernal_size == 3) ? dn_kernal_3 : dn_kernal_5;
-
-  // Apply the kernel
-  tmp_ptr = src_ptr - (stride * half_k_size) - half_k_size;
-  for (i = 0; i < kernal_size; ++i) {
-    for (j = 0; j < kernal_size; ++j) {
-      add_denoise_point((int)*src_ptr, (int)tmp_ptr[j], thresh, *kernal_ptr,
-                        &sum_val, &sum_weight);
-      ++kernal_ptr;
-    }
-    tmp_ptr += stride;
-  }
-
-  // Update the source value with the new filtered value
-  *src_ptr = (uint16_t)((sum_val + (sum_weight >> 1)) / sum_weight);
-}
-#endif  // CONFIG_VP9_HIGHBITDEPTH
-
-// Apply thresholded spatial noise suppression to a given buffer.
-static void spatial_denoise_buffer(VP9_COMP *cpi, uint8_t *buffer,
-                                   const int stride, const int width,
-                                   const int height, const int strength) {
-  VP9_COMMON *const cm = &cpi->common;
-  uint8_t *src_ptr = buffer;
-  int row;
-  int col;
-
-  for (row = 0; row < height; ++row) {
-    for (col = 0; col < width; ++col) {
-#if CONFIG_VP9_HIGHBITDEPTH
-      if (cm->use_highbitdepth)
-        highbd_spatial_denoise_point(CONVERT_TO_SHORTPTR(&src_ptr[col]), stride,
-                                     strength);
-      else
-        spatial_denoise_point(&src_ptr[col], stride, strength);
-#else
-      spatial_denoise_point(&src_ptr[col], stride, strength);
-#endif  // CONFIG_VP9_HIGHBITDEPTH
-    }
-    src_ptr += stride;
-  }
-}
-
-// Apply thresholded spatial noise suppression to source.
-static void spatial_denoise_frame(VP9_COMP *cpi) {
-  YV12_BUFFER_CONFIG *src = cpi->Source;
-  const VP9EncoderConfig *const oxcf = &cpi->oxcf;
-  TWO_PASS *const twopass = &cpi->twopass;
-  VP9_COMMON *const cm = &cpi->common;
-
-  // Base the filter strength on the current active max Q.
-  const int q = (int)(vp9_convert_qindex_to_q(twopass->active_worst_quality,
-                                              cm->bit_depth));
-  int strength =
-      VPXMAX(oxcf->arnr_strength >> 2, VPXMIN(oxcf->arnr_strength, (q >> 4)));
-
-  // Denoise each of Y,U and V buffers.
-  spatial_denoise_buffer(cpi, src->y_buffer, src->y_stride, src->y_width,
-                         src->y_height, strength);
-
-  strength += (strength >> 1);
-  spatial_denoise_buffer(cpi, src->u_buffer, src->uv_stride, src->uv_width,
-                         src->uv_height, strength << 1);
-
-  spatial_denoise_buffer(cpi, src->v_buffer, src->uv_stride, src->uv_width,
-                         src->uv_height, strength << 1);
-}
-#endif  // ENABLE_KF_DENOISE
-
 #if !CONFIG_REALTIME_ONLY
 static void vp9_try_disable_lookahead_aq(VP9_COMP *cpi, size_t *size,
                                          uint8_t *dest) {
@@ -5503,7 +5487,7 @@ static void encode_frame_to_data_rate(
 
 #ifdef ENABLE_KF_DENOISE
   // Spatial denoise of key frame.
-  if (is_spatial_denoise_enabled(cpi)) spatial_denoise_frame(cpi);
+  if (is_spatial_denoise_enabled(cpi)) vp9_spatial_denoise_frame(cpi);
 #endif
 
   if (cm->show_existing_frame == 0) {
@@ -5666,7 +5650,9 @@ static void encode_frame_to_data_rate(
   start_timing(cpi, loopfilter_frame_time);
 #endif
   // Pick the loop filter level for the frame.
+  start_stage_timing(cpi, VPX_STAGE_LOOPFILTER);
   loopfilter_frame(cpi, cm);
+  end_stage_timing(cpi, VPX_STAGE_LOOPFILTER);
 #if CONFIG_COLLECT_COMPONENT_TIMING
   end_timing(cpi, loopfilter_frame_time);
 #endif
@@ -5768,6 +5754,13 @@ static void encode_frame_to_data_rate(
   }
   vp9_update_reference_frames(cpi);
 
+  // LAST now holds the frame the next dirty rectangles are relative to.
+  if (cpi->refresh_last_frame && cpi->dirty_map.stale_map != NULL) {
+    memset(cpi->dirty_map.stale_map, 0,
+           cpi->dirty_map.mi_rows * cpi->dirty_map.mi_cols);
+    cpi->dirty_map.all_stale = 0;
+  }
+
   if (!cm->show_existing_frame) {
     for (t = TX_4X4; t <= TX_32X32; ++t) {
       full_to_model_counts(cpi->td.counts->coef[t],
@@ -5799,7 +5792,9 @@ static void encode_frame_to_data_rate(
 
   cm->last_frame_type = cm->frame_type;
 
+  start_stage_timing(cpi, VPX_STAGE_RATE_CONTROL);
   vp9_rc_postencode_update(cpi, *size);
+  end_stage_timing(cpi, VPX_STAGE_RATE_CONTROL);
 
   if (cpi->compute_frame_low_motion_onepass && oxcf->pass == 0 &&
       !frame_is_intra_only(cm) &&
@@ -5868,18 +5863,22 @@ static void encode_frame_to_data_rate(
 
 static void SvcEncode(VP9_COMP *cpi, size_t *size, uint8_t *dest,
                       unsigned int *frame_flags) {
+  start_stage_timing(cpi, VPX_STAGE_RATE_CONTROL);
   vp9_rc_get_svc_params(cpi);
+  end_stage_timing(cpi, VPX_STAGE_RATE_CONTROL);
   encode_frame_to_data_rate(cpi, size, dest, frame_flags,
                             /*encode_frame_result = */ NULL);
 }
 
 static void Pass0Encode(VP9_COMP *cpi, size_t *size, uint8_t *dest,
                         unsigned int *frame_flags) {
+  start_stage_timing(cpi, VPX_STAGE_RATE_CONTROL);
   if (cpi->oxcf.rc_mode == VPX_CBR) {
     vp9_rc_get_one_pass_cbr_params(cpi);
   } else {
     vp9_rc_get_one_pass_vbr_params(cpi);
   }
+  end_stage_timing(cpi, VPX_STAGE_RATE_CONTROL);
   encode_frame_to_data_rate(cpi, size, dest, frame_flags,
                             /*encode_frame_result = */ NULL);
 }
@@ -5896,12 +5895,87 @@ static void Pass2Encode(VP9_COMP *cpi, size_t *size, uint8_t *dest,
 }
 #endif  // !CONFIG_REALTIME_ONLY
 
+// Builds the map of the blocks of |sd| in the pending dirty rectangles, and
+// returns it, or NULL if the whole frame is dirty.
+static const unsigned char *setup_dirty_map(VP9_COMP *cpi,
+                                            const YV12_BUFFER_CONFIG *sd) {
+  VP9_COMMON *const cm = &cpi->common;
+  DirtyMap *const dirty = &cpi->dirty_map;
+  const int width = sd->y_crop_width;
+  const int height = sd->y_crop_height;
+  const int mi_rows = (height + MI_SIZE - 1) >> MI_SIZE_LOG2;
+  const int mi_cols = (width + MI_SIZE - 1) >> MI_SIZE_LOG2;
+  const int sb_rows = (mi_rows + MI_BLOCK_SIZE - 1) >> MI_BLOCK_SIZE_LOG2;
+  const int sb_cols = (mi_cols + MI_BLOCK_SIZE - 1) >> MI_BLOCK_SIZE_LOG2;
+  const int pending = dirty->pending;
+  int i, r;
+
+  dirty->pending = 0;
+  dirty->enabled = 0;
+  dirty->stats.num_blocks = sb_rows * sb_cols;
+  dirty->stats.num_skipped_blocks = 0;
+  dirty->stats.num_pixels = (uint64_t)width * height;
+  dirty->stats.num_copied_pixels = dirty->stats.num_pixels;
+
+  if (mi_rows != dirty->mi_rows || mi_cols != dirty->mi_cols) {
+    vpx_free(dirty->map);
+    dirty->map = NULL;
+    vpx_free(dirty->stale_map);
+    dirty->stale_map = NULL;
+    dirty->mi_rows = 0;
+    dirty->mi_cols = 0;
+    CHECK_MEM_ERROR(cm, dirty->map, vpx_calloc(mi_rows * mi_cols, 1));
+    CHECK_MEM_ERROR(cm, dirty->stale_map, vpx_calloc(mi_rows * mi_cols, 1));
+    dirty->mi_rows = mi_rows;
+    dirty->mi_cols = mi_cols;
+    dirty->all_stale = 1;
+  }
+
+  if (!pending || cpi->oxcf.lag_in_frames > 0 || cpi->use_svc) {
+    dirty->all_stale = 1;
+    return NULL;
+  }
+
+  memset(dirty->map, 0, mi_rows * mi_cols);
+  for (i = 0; i < dirty->num_rects; ++i) {
+    const vpx_dirty_rect_t *const rect = &dirty->rects[i];
+    int col_start, col_end, row_start, row_end;
+    if (rect->w == 0 || rect->h == 0 || rect->x >= (unsigned int)width ||
+        rect->y >= (unsigned int)height)
+      continue;
+    col_start = (int)rect->x >> MI_SIZE_LOG2;
+    row_start = (int)rect->y >> MI_SIZE_LOG2;
+    col_end = (int)(rect->x + VPXMIN(rect->w, width - rect->x) - 1) >>
+              MI_SIZE_LOG2;
+    row_end = (int)(rect->y + VPXMIN(rect->h, height - rect->y) - 1) >>
+              MI_SIZE_LOG2;
+    for (r = row_start; r <= row_end; ++r) {
+      memset(dirty->map + r * mi_cols + col_start, 1, col_end - col_start + 1);
+    }
+  }
+  return dirty->map;
+}
+
+// Adds to the dirty map of the frame received the blocks that changed since
+// the frame in LAST.
+static void merge_stale_dirty_map(VP9_COMP *cpi, int has_dirty_map) {
+  DirtyMap *const dirty = &cpi->dirty_map;
+  const int num_blocks = dirty->mi_rows * dirty->mi_cols;
+  int i;
+
+  if (!has_dirty_map || dirty->all_stale) return;
+  for (i = 0; i < num_blocks; ++i) dirty->map[i] |= dirty->stale_map[i];
+  memcpy(dirty->stale_map, dirty->map, num_blocks);
+  dirty->enabled = 1;
+}
+
 int vp9_receive_raw_frame(VP9_COMP *cpi, vpx_enc_frame_flags_t frame_flags,
                           YV12_BUFFER_CONFIG *sd, int64_t time_stamp,
                           int64_t end_time) {
   VP9_COMMON *const cm = &cpi->common;
   struct vpx_usec_timer timer;
   int res = 0;
+  const unsigned char *dirty_map;
   const int subsampling_x = sd->subsampling_x;
   const int subsampling_y = sd->subsampling_y;
 #if CONFIG_VP9_HIGHBITDEPTH
@@ -5916,12 +5990,21 @@ int vp9_receive_raw_frame(VP9_COMP *cpi, vpx_enc_frame_flags_t frame_flags,
 #endif
 
   alloc_raw_frame_buffers(cpi);
+  dirty_map = setup_dirty_map(cpi, sd);
 
   vpx_usec_timer_start(&timer);
+  start_stage_timing(cpi, VPX_STAGE_LOOKAHEAD);
 
+  // The source is denoised in place when noise_sensitivity is set, so the
+  // buffers of the lookahead no longer hold what was copied into them.
   if (vp9_lookahead_push(cpi->lookahead, sd, time_stamp, end_time,
-                         use_highbitdepth, frame_flags))
+                         use_highbitdepth, frame_flags,
+                         cpi->oxcf.noise_sensitivity > 0 ? NULL : dirty_map))
     res = -1;
+  else
+    cpi->dirty_map.stats.num_copied_pixels = cpi->lookahead->copied_pixels;
+  merge_stale_dirty_map(cpi, dirty_map != NULL);
+  end_stage_timing(cpi, VPX_STAGE_LOOKAHEAD);
   vpx_usec_timer_mark(&timer);
   cpi->time_receive_data += vpx_usec_timer_elapsed(&timer);
 
@@ -6330,6 +6413,9 @@ int vp9_get_compressed_data(VP9_COMP *cpi, unsigned int *frame_flags,
 
   vpx_usec_timer_start(&cmptimer);
 
+  // A frame aborted by an error may have left its references in the cache.
+  vp9_subpel_cache_clear(&cpi->subpel_cache);
+
   vp9_set_high_precision_mv(cpi, ALTREF_HIGH_PRECISION_MV);
 
   // Is multi-arf enabled.
@@ -6391,9 +6477,11 @@ int vp9_get_compressed_data(VP9_COMP *cpi, unsigned int *frame_flags,
 #if CONFIG_COLLECT_COMPONENT_TIMING
         start_timing(cpi, vp9_temporal_filter_time);
 #endif
+        start_stage_timing(cpi, VPX_STAGE_TEMPORAL_FILTER);
         // Produce the filtered ARF frame.
         vp9_temporal_filter(cpi, arf_src_index);
         vpx_extend_frame_borders(&cpi->alt_ref_buffer);
+        end_stage_timing(cpi, VPX_STAGE_TEMPORAL_FILTER);
 #if CONFIG_COLLECT_COMPONENT_TIMING
         end_timing(cpi, vp9_temporal_filter_time);
 #endif
@@ -6426,10 +6514,12 @@ int vp9_get_compressed_data(VP9_COMP *cpi, unsigned int *frame_flags,
     }
 
     // Read in the source frame.
+    start_stage_timing(cpi, VPX_STAGE_LOOKAHEAD);
     if (cpi->use_svc || cpi->svc.set_intra_only_frame)
       source = vp9_svc_lookahead_pop(cpi, cpi->lookahead, flush);
     else
       source = vp9_lookahead_pop(cpi->lookahead, flush);
+    end_stage_timing(cpi, VPX_STAGE_LOOKAHEAD);
 
     if (source != NULL) {
       cm->show_frame = 1;
@@ -6513,7 +6603,9 @@ int vp9_get_compressed_data(VP9_COMP *cpi, unsigned int *frame_flags,
 #if CONFIG_COLLECT_COMPONENT_TIMING
     start_timing(cpi, vp9_rc_get_second_pass_params_time);
 #endif
+    start_stage_timing(cpi, VPX_STAGE_RATE_CONTROL);
     vp9_rc_get_second_pass_params(cpi);
+    end_stage_timing(cpi, VPX_STAGE_RATE_CONTROL);
 #if CONFIG_COLLECT_COMPONENT_TIMING
     end_timing(cpi, vp9_rc_get_second_pass_params_time);
 #endif
@@ -6562,9 +6654,11 @@ int vp9_get_compressed_data(VP9_COMP *cpi, unsigned int *frame_flags,
   if (gf_group_index == 1 &&
       cpi->twopass.gf_group.update_type[gf_group_index] == ARF_UPDATE &&
       cpi->sf.enable_tpl_model) {
+    start_stage_timing(cpi, VPX_STAGE_TPL);
     vp9_init_tpl_buffer(cpi);
     vp9_estimate_qp_gop(cpi);
     vp9_setup_tpl_stats(cpi);
+    end_stage_timing(cpi, VPX_STAGE_TPL);
   }
 #if CONFIG_COLLECT_COMPONENT_TIMING
   end_timing(cpi, setup_tpl_stats_time);
@@ -6603,14 +6697,18 @@ int vp9_get_compressed_data(VP9_COMP *cpi, unsigned int *frame_flags,
     cpi->td.mb.fwd_txfm4x4 = lossless ? vp9_fwht4x4 : vpx_fdct4x4;
 #endif  // CONFIG_VP9_HIGHBITDEPTH
     cpi->td.mb.inv_txfm_add = lossless ? vp9_iwht4x4_add : vp9_idct4x4_add;
+    start_stage_timing(cpi, VPX_STAGE_FIRST_PASS);
     vp9_first_pass(cpi, source);
+    end_stage_timing(cpi, VPX_STAGE_FIRST_PASS);
   } else if (oxcf->pass == 2 && !cpi->use_svc) {
 #if CONFIG_COLLECT_COMPONENT_TIMING
     // Accumulate 2nd pass time in 2-pass case.
     start_timing(cpi, Pass2Encode_time);
 #endif
     Pass2Encode(cpi, size, dest, frame_flags, encode_frame_result);
+    start_stage_timing(cpi, VPX_STAGE_RATE_CONTROL);
     vp9_twopass_postencode_update(cpi);
+    end_stage_timing(cpi, VPX_STAGE_RATE_CONTROL);
 #if CONFIG_COLLECT_COMPONENT_TIMING
     end_timing(cpi, Pass2Encode_time);
 #endif
@@ -6635,6 +6733,7 @@ int vp9_get_compressed_data(VP9_COMP *cpi, unsigned int *frame_flags,
   if (*size > 0) {
     cpi->droppable = !frame_is_reference(cpi);
   }
+  if (*size > 0 || oxcf->pass == 1) ++cpi->stage_timing.frame_count;
 
   // Save layer specific state.
   if (is_one_pass_svc(cpi) || ((cpi->svc.number_temporal_layers > 1 ||
@@ -6675,10 +6774,10 @@ int vp9_get_compressed_data(VP9_COMP *cpi, unsigned int *frame_flags,
         YV12_BUFFER_CONFIG *pp = &cm->post_proc_buffer;
         PSNR_STATS psnr;
 #if CONFIG_VP9_HIGHBITDEPTH
-        vpx_calc_highbd_psnr(orig, recon, &psnr, cpi->td.mb.e_mbd.bd,
-                             in_bit_depth);
+        vpx_calc_highbd_psnr_mt(orig, recon, &psnr, cpi->td.mb.e_mbd.bd,
+                                in_bit_depth, cpi->workers, cpi->num_workers);
 #else
-        vpx_calc_psnr(orig, recon, &psnr);
+        vpx_calc_psnr_mt(orig, recon, &psnr, cpi->workers, cpi->num_workers);
 #endif  // CONFIG_VP9_HIGHBITDEPTH
 
         adjust_image_stat(psnr.psnr[1], psnr.psnr[2], psnr.psnr[3],
@@ -6713,10 +6812,11 @@ int vp9_get_compressed_data(VP9_COMP *cpi, unsigned int *frame_flags,
           vpx_clear_system_state();
 
 #if CONFIG_VP9_HIGHBITDEPTH
-          vpx_calc_highbd_psnr(orig, pp, &psnr2, cpi->td.mb.e_mbd.bd,
-                               cpi->oxcf.input_bit_depth);
+          vpx_calc_highbd_psnr_mt(orig, pp, &psnr2, cpi->td.mb.e_mbd.bd,
+                                  cpi->oxcf.input_bit_depth, cpi->workers,
+                                  cpi->num_workers);
 #else
-          vpx_calc_psnr(orig, pp, &psnr2);
+          vpx_calc_psnr_mt(orig, pp, &psnr2, cpi->workers, cpi->num_workers);
 #endif  // CONFIG_VP9_HIGHBITDEPTH
 
           cpi->totalp_sq_error += psnr2.sse[0];
@@ -6726,13 +6826,16 @@ int vp9_get_compressed_data(VP9_COMP *cpi, unsigned int *frame_flags,
 
 #if CONFIG_VP9_HIGHBITDEPTH
           if (cm->use_highbitdepth) {
-            frame_ssim2 = vpx_highbd_calc_ssim(orig, recon, &weight, bit_depth,
-                                               in_bit_depth);
+            frame_ssim2 = vpx_highbd_calc_ssim_mt(
+                orig, recon, &weight, bit_depth, in_bit_depth, cpi->workers,
+                cpi->num_workers);
           } else {
-            frame_ssim2 = vpx_calc_ssim(orig, recon, &weight);
+            frame_ssim2 = vpx_calc_ssim_mt(orig, recon, &weight, cpi->workers,
+                                           cpi->num_workers);
           }
 #else
-          frame_ssim2 = vpx_calc_ssim(orig, recon, &weight);
+          frame_ssim2 = vpx_calc_ssim_mt(orig, recon, &weight, cpi->workers,
+                                         cpi->num_workers);
 #endif  // CONFIG_VP9_HIGHBITDEPTH
 
           cpi->worst_ssim = VPXMIN(cpi->worst_ssim, frame_ssim2);
@@ -6741,13 +6844,16 @@ int vp9_get_compressed_data(VP9_COMP *cpi, unsigned int *frame_flags,
 
 #if CONFIG_VP9_HIGHBITDEPTH
           if (cm->use_highbitdepth) {
-            frame_ssim2 = vpx_highbd_calc_ssim(orig, pp, &weight, bit_depth,
-                                               in_bit_depth);
+            frame_ssim2 = vpx_highbd_calc_ssim_mt(orig, pp, &weight, bit_depth,
+                                                  in_bit_depth, cpi->workers,
+                                                  cpi->num_workers);
           } else {
-            frame_ssim2 = vpx_calc_ssim(orig, pp, &weight);
+            frame_ssim2 = vpx_calc_ssim_mt(orig, pp, &weight, cpi->workers,
+                                           cpi->num_workers);
           }
 #else
-          frame_ssim2 = vpx_calc_ssim(orig, pp, &weight);
+          frame_ssim2 = vpx_calc_ssim_mt(orig, pp, &weight, cpi->workers,
+                                         cpi->num_workers);
 #endif  // CONFIG_VP9_HIGHBITDEPTH
 
           cpi->summedp_quality += frame_ssim2 * weight;
@@ -6801,8 +6907,9 @@ int vp9_get_compressed_data(VP9_COMP *cpi, unsigned int *frame_flags,
 
       {
         double y, u, v, frame_all;
-        frame_all = vpx_calc_fastssim(cpi->Source, cm->frame_to_show, &y, &u,
-                                      &v, bit_depth, in_bit_depth);
+        frame_all = vpx_calc_fastssim_mt(cpi->Source, cm->frame_to_show, &y,
+                                         &u, &v, bit_depth, in_bit_depth,
+                                         cpi->workers, cpi->num_workers);
         adjust_image_stat(y, u, v, frame_all, &cpi->fastssim);
       }
       {
@@ -6961,6 +7068,46 @@ void vp9_set_svc(VP9_COMP *cpi, int use_svc) {
 
 int vp9_get_quantizer(const VP9_COMP *cpi) { return cpi->common.base_qindex; }
 
+size_t vp9_get_pc_tree_mem_usage(const VP9_COMP *cpi) {
+  size_t size = vp9_pc_tree_mem_usage(&cpi->td);
+  int i;
+  // The last worker uses the thread data of cpi.
+  for (i = 0; i < cpi->num_workers - 1; ++i)
+    size += vp9_pc_tree_mem_usage(cpi->tile_thr_data[i].td);
+  return size;
+}
+
+static void reset_stage_timing(vpx_stage_timing_t *timing) {
+  int i;
+  timing->frame_start_us = -1;
+  timing->frame_duration_us = 0;
+  timing->frame_count = 0;
+  for (i = 0; i < VPX_STAGE_COUNT; ++i) {
+    timing->start_us[i] = -1;
+    timing->duration_us[i] = 0;
+  }
+}
+
+void vp9_set_stage_timing(VP9_COMP *cpi, int enable) {
+  cpi->stage_timing_enabled = enable;
+  reset_stage_timing(&cpi->stage_timing);
+  reset_stage_timing(&cpi->last_stage_timing);
+  if (enable) vpx_usec_timer_start(&cpi->stage_timing_epoch);
+}
+
+void vp9_stage_timing_begin_frame(VP9_COMP *cpi) {
+  if (!cpi->stage_timing_enabled) return;
+  reset_stage_timing(&cpi->stage_timing);
+  cpi->stage_timing.frame_start_us = stage_timing_now(cpi);
+}
+
+void vp9_stage_timing_end_frame(VP9_COMP *cpi) {
+  if (!cpi->stage_timing_enabled) return;
+  cpi->stage_timing.frame_duration_us =
+      stage_timing_now(cpi) - cpi->stage_timing.frame_start_us;
+  cpi->last_stage_timing = cpi->stage_timing;
+}
+
 void vp9_apply_encoding_flags(VP9_COMP *cpi, vpx_enc_frame_flags_t flags) {
   if (flags &
       (VP8_EFLAG_NO_REF_LAST | VP8_EFLAG_NO_REF_GF | VP8_EFLAG_NO_REF_ARF)) {
@@ -24,6 +24,7 @@
 #include "vpx_dsp/variance.h"
 #include "vpx_dsp/psnr.h"
 #include "vpx_ports/system_state.h"
+#include "vpx_ports/vpx_timer.h"
 #include "vpx_util/vpx_thread.h"
 #include "vpx_util/vpx_timestamp.h"
 
@@ -51,6 +52,8 @@
 #include "vp9/encoder/vp9_ratectrl.h"
 #include "vp9/encoder/vp9_rd.h"
 #include "vp9/encoder/vp9_speed_features.h"
+#include "vp9/encoder/vp9_subpel_cache.h"
+#include "vp9/encoder/vp9_temporal_mv.h"
 #include "vp9/encoder/vp9_svc_layercontext.h"
 #include "vp9/encoder/vp9_tokenize.h"
 
@@ -279,6 +282,7 @@ typedef struct VP9EncoderConfig {
   VP9E_TEMPORAL_LAYERING_MODE temporal_layering_mode;
 
   int row_mt;
+  SUBPEL_CACHE_LEVEL subpel_cache;
   unsigned int motion_vector_unit_test;
   int delta_q_uv;
   int use_simple_encode_api;  // Use SimpleEncode APIs or not
@@ -362,10 +366,13 @@ typedef struct RowMTInfo {
 #endif
 } RowMTInfo;
 
+// The tokens of a superblock row of a tile. They start in |chunk| and continue
+// in the next chunks up to |stop| in |stop_chunk|.
 typedef struct {
   TOKENEXTRA *start;
   TOKENEXTRA *stop;
-  unsigned int count;
+  TokenChunk *chunk;
+  TokenChunk *stop_chunk;
 } TOKENLIST;
 
 typedef struct MultiThreadHandle {
@@ -399,6 +406,10 @@ typedef struct ThreadData {
   PICK_MODE_CONTEXT *leaf_tree;
   PC_TREE *pc_tree;
   PC_TREE *pc_root;
+
+  // The token chunk the thread writes to. The next superblock row it encodes
+  // continues after the tokens of the previous one.
+  TokenChunk *tok_chunk;
 } ThreadData;
 
 struct EncWorkerData;
@@ -409,6 +420,31 @@ typedef struct ActiveMap {
   unsigned char *map;
 } ActiveMap;
 
+// The dirty rectangles given with VP8E_SET_DIRTY_RECTS. The blocks outside of
+// them are coded as skipped, like the inactive blocks of the active map.
+typedef struct DirtyMap {
+  // The rectangles of the next frame received, if |pending|.
+  vpx_dirty_rect_t *rects;
+  int num_rects;
+  int rects_size;
+  int pending;
+  // Whether |map| applies to the frame being encoded, and whether it was
+  // applied to its segmentation map.
+  int enabled;
+  int applied;
+  // 1 for each 8x8 block of the source that may differ from the LAST
+  // reference, i.e. that is dirty in this frame or in one received since
+  // LAST was refreshed.
+  unsigned char *map;
+  // The same for the next frame, before its own rectangles are added, unless
+  // |all_stale| is set.
+  unsigned char *stale_map;
+  int all_stale;
+  int mi_rows;
+  int mi_cols;
+  vpx_dirty_rect_stats_t stats;
+} DirtyMap;
+
 typedef enum { Y, U, V, ALL } STAT_TYPE;
 
 typedef struct IMAGE_STAT {
@@ -668,7 +704,6 @@ static INLINE int get_num_unit_16x16(int size) { return (size + 15) >> 4; }
 #endif  // CONFIG_RATE_CTRL
 
 #if CONFIG_COLLECT_COMPONENT_TIMING
-#include "vpx_ports/vpx_timer.h"
 // Adjust the following to add new components.
 typedef enum {
   vp9_get_compressed_data_time,
@@ -808,9 +843,9 @@ typedef struct VP9_COMP {
   int mb_wiener_var_cols;
   double *mi_ssim_rdmult_scaling_factors;
 
-  YV12_BUFFER_CONFIG last_frame_uf;
-
-  TOKENEXTRA *tile_tok[4][1 << 6];
+  TokenPool token_pool;
+  SubpelCache subpel_cache;
+  TemporalMvMap temporal_mv_map;
   TOKENLIST *tplist[4][1 << 6];
 
   // Ambient reconstruction err target for force key frames
@@ -865,6 +900,7 @@ typedef struct VP9_COMP {
 
   CYCLIC_REFRESH *cyclic_refresh;
   ActiveMap active_map;
+  DirtyMap dirty_map;
 
   fractional_mv_step_fp *find_fractional_mv_step;
   struct scale_factors me_sf;
@@ -1002,6 +1038,7 @@ typedef struct VP9_COMP {
   void (*row_mt_sync_read_ptr)(VP9RowMTSync *const, int, int);
   void (*row_mt_sync_write_ptr)(VP9RowMTSync *const, int, int, const int);
   ARNRFilterData arnr_filter_data;
+  MBGraphFrameData mbgraph_frame_data;
 
   int row_mt;
   unsigned int row_mt_bit_exact;
@@ -1018,6 +1055,13 @@ typedef struct VP9_COMP {
   uint8_t *copied_frame_cnt;
   uint8_t max_copied_frame;
   // If the last frame is dropped, we don't copy partition.
+
+  // Partitioning chosen by the last full partition search of the recode loop,
+  // the q index it was searched at (-1 if none) and whether the current
+  // encode iteration reuses it.
+  BLOCK_SIZE *recode_partition;
+  int recode_partition_q;
+  int recode_partition_reuse;
   uint8_t last_frame_dropped;
 
   // For each superblock: keeps track of the last time (in frame distance) the
@@ -1065,6 +1109,15 @@ typedef struct VP9_COMP {
    */
   uint64_t frame_component_time[kTimingComponents];
 #endif
+
+  // Runtime stage timing, see VP9E_SET_STAGE_TIMING. stage_timing collects
+  // the current vpx_codec_encode() call and is copied to last_stage_timing
+  // when the call completes.
+  int stage_timing_enabled;
+  struct vpx_usec_timer stage_timing_epoch;
+  int64_t stage_start_us[VPX_STAGE_COUNT];
+  vpx_stage_timing_t stage_timing;
+  vpx_stage_timing_t last_stage_timing;
 } VP9_COMP;
 
 #if CONFIG_RATE_CTRL
@@ -1246,6 +1299,10 @@ int vp9_set_active_map(VP9_COMP *cpi, unsigned char *new_map_16x16, int rows,
 int vp9_get_active_map(VP9_COMP *cpi, unsigned char *new_map_16x16, int rows,
                        int cols);
 
+// Sets the dirty rectangles of the next frame received, or marks the whole
+// frame as dirty if |rects| is NULL.
+int vp9_set_dirty_rects(VP9_COMP *cpi, const vpx_dirty_rects_t *rects);
+
 int vp9_set_internal_size(VP9_COMP *cpi, VPX_SCALING_MODE horiz_mode,
                           VPX_SCALING_MODE vert_mode);
 
@@ -1285,6 +1342,35 @@ static INLINE void stack_init(int *stack, int length) {
 
 int vp9_get_quantizer(const VP9_COMP *cpi);
 
+// Returns the number of bytes held by the context trees of all the encoder
+// threads.
+size_t vp9_get_pc_tree_mem_usage(const VP9_COMP *cpi);
+
+void vp9_set_stage_timing(VP9_COMP *cpi, int enable);
+void vp9_stage_timing_begin_frame(VP9_COMP *cpi);
+void vp9_stage_timing_end_frame(VP9_COMP *cpi);
+
+// Returns the time in microseconds since the stage timing was enabled.
+static INLINE int64_t stage_timing_now(VP9_COMP *cpi) {
+  vpx_usec_timer_mark(&cpi->stage_timing_epoch);
+  return vpx_usec_timer_elapsed(&cpi->stage_timing_epoch);
+}
+
+static INLINE void start_stage_timing(VP9_COMP *cpi,
+                                      vpx_encoder_stage_t stage) {
+  if (cpi->stage_timing_enabled)
+    cpi->stage_start_us[stage] = stage_timing_now(cpi);
+}
+
+static INLINE void end_stage_timing(VP9_COMP *cpi, vpx_encoder_stage_t stage) {
+  if (cpi->stage_timing_enabled) {
+    vpx_stage_timing_t *const timing = &cpi->stage_timing;
+    const int64_t start = cpi->stage_start_us[stage];
+    if (timing->start_us[stage] < 0) timing->start_us[stage] = start;
+    timing->duration_us[stage] += stage_timing_now(cpi) - start;
+  }
+}
+
 static INLINE int frame_is_kf_gf_arf(const VP9_COMP *cpi) {
   return frame_is_intra_only(&cpi->common) || cpi->refresh_alt_ref_frame ||
          (cpi->refresh_golden_frame && !cpi->rc.is_src_frame_alt_ref);
@@ -1339,38 +1425,6 @@ static INLINE YV12_BUFFER_CONFIG *get_ref_frame_buffer(
                                 : NULL;
 }
 
-static INLINE int get_token_alloc(int mb_rows, int mb_cols) {
-  // TODO(JBB): double check we can't exceed this token count if we have a
-  // 32x32 transform crossing a boundary at a multiple of 16.
-  // mb_rows, cols are in units of 16 pixels. We assume 3 planes all at full
-  // resolution. We assume up to 1 token per pixel, and then allow
-  // a head room of 4.
-  return mb_rows * mb_cols * (16 * 16 * 3 + 4);
-}
-
-// Get the allocated token size for a tile. It does the same calculation as in
-// the frame token allocation.
-static INLINE int allocated_tokens(TileInfo tile) {
-  int tile_mb_rows = (tile.mi_row_end - tile.mi_row_start + 1) >> 1;
-  int tile_mb_cols = (tile.mi_col_end - tile.mi_col_start + 1) >> 1;
-
-  return get_token_alloc(tile_mb_rows, tile_mb_cols);
-}
-
-static INLINE void get_start_tok(VP9_COMP *cpi, int tile_row, int tile_col,
-                                 int mi_row, TOKENEXTRA **tok) {
-  VP9_COMMON *const cm = &cpi->common;
-  const int tile_cols = 1 << cm->log2_tile_cols;
-  TileDataEnc *this_tile = &cpi->tile_data[tile_row * tile_cols + tile_col];
-  const TileInfo *const tile_info = &this_tile->tile_info;
-
-  int tile_mb_cols = (tile_info->mi_col_end - tile_info->mi_col_start + 1) >> 1;
-  const int mb_row = (mi_row - tile_info->mi_row_start) >> 1;
-
-  *tok =
-      cpi->tile_tok[tile_row][tile_col] + get_token_alloc(mb_row, tile_mb_cols);
-}
-
 int64_t vp9_get_y_sse(const YV12_BUFFER_CONFIG *a, const YV12_BUFFER_CONFIG *b);
 #if CONFIG_VP9_HIGHBITDEPTH
 int64_t vp9_highbd_get_y_sse(const YV12_BUFFER_CONFIG *a,
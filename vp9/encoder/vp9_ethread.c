@@ -14,6 +14,7 @@
 #include "vp9/encoder/vp9_encoder.h"
 #include "vp9/encoder/vp9_ethread.h"
 #include "vp9/encoder/vp9_firstpass.h"
+#include "vp9/encoder/vp9_mbgraph.h"
 #include "vp9/encoder/vp9_multi_thread.h"
 #include "vp9/encoder/vp9_temporal_filter.h"
 #include "vpx_dsp/vpx_dsp_common.h"
@@ -580,8 +581,111 @@ void vp9_temporal_filter_row_mt(VP9_COMP *cpi) {
   launch_enc_workers(cpi, temporal_filter_worker_hook, multi_thread_ctxt,
                      num_workers);
 }
+
+static int mbgraph_worker_hook(void *arg1, void *arg2) {
+  EncWorkerData *const thread_data = (EncWorkerData *)arg1;
+  MultiThreadHandle *multi_thread_ctxt = (MultiThreadHandle *)arg2;
+  VP9_COMP *const cpi = thread_data->cpi;
+  int end_of_frame;
+  int thread_id = thread_data->thread_id;
+  int cur_tile_id = multi_thread_ctxt->thread_id_to_tile_id[thread_id];
+  JobNode *proc_job = NULL;
+
+  end_of_frame = 0;
+  while (0 == end_of_frame) {
+    // Get the next job in the queue
+    proc_job =
+        (JobNode *)vp9_enc_grp_get_next_job(multi_thread_ctxt, cur_tile_id);
+    if (NULL == proc_job) {
+      // All the rows are in the single queue of the first tile column.
+      end_of_frame = vp9_get_tiles_proc_status(
+          multi_thread_ctxt, thread_data->tile_completion_status, &cur_tile_id,
+          1);
+    } else {
+      vp9_update_mbgraph_mb_row(cpi, thread_data->td,
+                                &cpi->tile_data[0].row_mt_sync,
+                                proc_job->vert_unit_row_num);
+    }
+  }
+  return 0;
+}
+
+void vp9_mbgraph_row_mt(VP9_COMP *cpi) {
+  VP9_COMMON *const cm = &cpi->common;
+  const int tile_cols = 1 << cm->log2_tile_cols;
+  const int tile_rows = 1 << cm->log2_tile_rows;
+  MultiThreadHandle *multi_thread_ctxt = &cpi->multi_thread_ctxt;
+  int num_workers = cpi->num_workers ? cpi->num_workers : 1;
+  int i;
+
+  if (multi_thread_ctxt->allocated_tile_cols < tile_cols ||
+      multi_thread_ctxt->allocated_tile_rows < tile_rows ||
+      multi_thread_ctxt->allocated_vert_unit_rows < cm->mb_rows) {
+    vp9_row_mt_mem_dealloc(cpi);
+    vp9_init_tile_data(cpi);
+    vp9_row_mt_mem_alloc(cpi);
+  } else {
+    vp9_init_tile_data(cpi);
+  }
+
+  create_enc_workers(cpi, num_workers);
+
+  vp9_assign_tile_to_thread(multi_thread_ctxt, 1, cpi->num_workers);
+
+  vp9_prepare_job_queue(cpi, MBGRAPH_JOB);
+
+  // Initialize cur_col to -1 for all MB rows.
+  memset(cpi->tile_data[0].row_mt_sync.cur_col, -1,
+         sizeof(*cpi->tile_data[0].row_mt_sync.cur_col) * cm->mb_rows);
+
+  for (i = 0; i < num_workers; i++) {
+    EncWorkerData *thread_data;
+    thread_data = &cpi->tile_thr_data[i];
+
+    // Before analyzing a frame, copy the thread data from cpi.
+    if (thread_data->td != &cpi->td) {
+      thread_data->td->mb = cpi->td.mb;
+    }
+  }
+
+  launch_enc_workers(cpi, mbgraph_worker_hook, multi_thread_ctxt, num_workers);
+}
 #endif  // !CONFIG_REALTIME_ONLY
 
+typedef struct RowJobs {
+  VP9RowJobFn fn;
+  void *data;
+  int num_jobs;
+} RowJobs;
+
+static int row_jobs_worker_hook(void *arg1, void *arg2) {
+  EncWorkerData *const thread_data = (EncWorkerData *)arg1;
+  const RowJobs *const jobs = (const RowJobs *)arg2;
+  const int num_workers = thread_data->cpi->num_workers;
+  int job;
+
+  for (job = thread_data->start; job < jobs->num_jobs; job += num_workers)
+    jobs->fn(jobs->data, job);
+
+  return 0;
+}
+
+void vp9_run_row_jobs_mt(VP9_COMP *cpi, VP9RowJobFn fn, void *data,
+                         int num_jobs) {
+  RowJobs jobs;
+
+  if (cpi->num_workers <= 1 || num_jobs <= 1) {
+    int job;
+    for (job = 0; job < num_jobs; ++job) fn(data, job);
+    return;
+  }
+
+  jobs.fn = fn;
+  jobs.data = data;
+  jobs.num_jobs = num_jobs;
+  launch_enc_workers(cpi, row_jobs_worker_hook, &jobs, cpi->num_workers);
+}
+
 static int enc_row_mt_worker_hook(void *arg1, void *arg2) {
   EncWorkerData *const thread_data = (EncWorkerData *)arg1;
   MultiThreadHandle *multi_thread_ctxt = (MultiThreadHandle *)arg2;
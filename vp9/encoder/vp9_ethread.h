@@ -70,6 +70,16 @@ void vp9_row_mt_sync_mem_dealloc(VP9RowMTSync *row_mt_sync);
 
 void vp9_temporal_filter_row_mt(struct VP9_COMP *cpi);
 
+void vp9_mbgraph_row_mt(struct VP9_COMP *cpi);
+
+typedef void (*VP9RowJobFn)(void *data, int job);
+
+// Calls |fn| for the jobs 0 to |num_jobs| - 1, spread over the encoder workers
+// that are already created. The jobs must be independent of each other; with
+// at most one worker they run in order on the calling thread.
+void vp9_run_row_jobs_mt(struct VP9_COMP *cpi, VP9RowJobFn fn, void *data,
+                         int num_jobs);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -166,28 +166,56 @@ void vp9_copy_and_extend_frame(const YV12_BUFFER_CONFIG *src,
 void vp9_copy_and_extend_frame_with_rect(const YV12_BUFFER_CONFIG *src,
                                          YV12_BUFFER_CONFIG *dst, int srcy,
                                          int srcx, int srch, int srcw) {
-  // If the side is not touching the bounder then don't extend.
-  const int et_y = srcy ? 0 : dst->border;
-  const int el_y = srcx ? 0 : dst->border;
-  const int eb_y = srcy + srch != src->y_height
-                       ? 0
-                       : dst->border + dst->y_height - src->y_height;
-  const int er_y = srcx + srcw != src->y_width
-                       ? 0
-                       : dst->border + dst->y_width - src->y_width;
+  // The sides of the rectangle on the edges of the frame are extended as
+  // vp9_copy_and_extend_frame() extends them.
+  const int et_y = srcy ? 0 : 16;
+  const int el_y = srcx ? 0 : 16;
+  const int eb_y =
+      srcy + srch != src->y_crop_height
+          ? 0
+          : VPXMAX(src->y_height + 16, ALIGN_POWER_OF_TWO(src->y_height, 6)) -
+                src->y_crop_height;
+  const int er_y =
+      srcx + srcw != src->y_crop_width
+          ? 0
+          : VPXMAX(src->y_width + 16, ALIGN_POWER_OF_TWO(src->y_width, 6)) -
+                src->y_crop_width;
+  const int uv_width_subsampling = (src->uv_width != src->y_width);
+  const int uv_height_subsampling = (src->uv_height != src->y_height);
+  const int et_uv = et_y >> uv_height_subsampling;
+  const int el_uv = el_y >> uv_width_subsampling;
+  const int eb_uv = eb_y >> uv_height_subsampling;
+  const int er_uv = er_y >> uv_width_subsampling;
+  const int srcy_uv = srcy >> uv_height_subsampling;
+  const int srcx_uv = srcx >> uv_width_subsampling;
+  const int srch_uv =
+      ((srcy + srch + uv_height_subsampling) >> uv_height_subsampling) -
+      srcy_uv;
+  const int srcw_uv =
+      ((srcx + srcw + uv_width_subsampling) >> uv_width_subsampling) - srcx_uv;
   const int src_y_offset = srcy * src->y_stride + srcx;
   const int dst_y_offset = srcy * dst->y_stride + srcx;
-
-  const int et_uv = ROUND_POWER_OF_TWO(et_y, 1);
-  const int el_uv = ROUND_POWER_OF_TWO(el_y, 1);
-  const int eb_uv = ROUND_POWER_OF_TWO(eb_y, 1);
-  const int er_uv = ROUND_POWER_OF_TWO(er_y, 1);
-  const int src_uv_offset = ((srcy * src->uv_stride) >> 1) + (srcx >> 1);
-  const int dst_uv_offset = ((srcy * dst->uv_stride) >> 1) + (srcx >> 1);
-  const int srch_uv = ROUND_POWER_OF_TWO(srch, 1);
-  const int srcw_uv = ROUND_POWER_OF_TWO(srcw, 1);
+  const int dst_uv_offset = srcy_uv * dst->uv_stride + srcx_uv;
   // detect nv12 colorspace
   const int chroma_step = src->v_buffer - src->u_buffer == 1 ? 2 : 1;
+  const int src_uv_offset = srcy_uv * src->uv_stride + srcx_uv * chroma_step;
+
+#if CONFIG_VP9_HIGHBITDEPTH
+  if (src->flags & YV12_FLAG_HIGHBITDEPTH) {
+    highbd_copy_and_extend_plane(src->y_buffer + src_y_offset, src->y_stride,
+                                 dst->y_buffer + dst_y_offset, dst->y_stride,
+                                 srcw, srch, et_y, el_y, eb_y, er_y);
+
+    highbd_copy_and_extend_plane(src->u_buffer + src_uv_offset, src->uv_stride,
+                                 dst->u_buffer + dst_uv_offset, dst->uv_stride,
+                                 srcw_uv, srch_uv, et_uv, el_uv, eb_uv, er_uv);
+
+    highbd_copy_and_extend_plane(src->v_buffer + src_uv_offset, src->uv_stride,
+                                 dst->v_buffer + dst_uv_offset, dst->uv_stride,
+                                 srcw_uv, srch_uv, et_uv, el_uv, eb_uv, er_uv);
+    return;
+  }
+#endif  // CONFIG_VP9_HIGHBITDEPTH
 
   copy_and_extend_plane(src->y_buffer + src_y_offset, src->y_stride,
                         dst->y_buffer + dst_y_offset, dst->y_stride, srcw, srch,
@@ -21,6 +21,10 @@ extern "C" {
 void vp9_copy_and_extend_frame(const YV12_BUFFER_CONFIG *src,
                                YV12_BUFFER_CONFIG *dst);
 
+// Copies the rectangle of luma pixels (srcx, srcy, srcw, srch) of |src| and
+// the chroma pixels under it, and extends the sides of the rectangle on the
+// edges of the frame. The corners of the rectangle must be on even pixels
+// unless they are on the edges.
 void vp9_copy_and_extend_frame_with_rect(const YV12_BUFFER_CONFIG *src,
                                          YV12_BUFFER_CONFIG *dst, int srcy,
                                          int srcx, int srch, int srcw);
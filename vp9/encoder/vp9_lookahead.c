@@ -34,7 +34,10 @@ void vp9_lookahead_destroy(struct lookahead_ctx *ctx) {
     if (ctx->buf) {
       int i;
 
-      for (i = 0; i < ctx->max_sz; i++) vpx_free_frame_buffer(&ctx->buf[i].img);
+      for (i = 0; i < ctx->max_sz; i++) {
+        vpx_free_frame_buffer(&ctx->buf[i].img);
+        free(ctx->buf[i].stale_map);
+      }
       free(ctx->buf);
     }
     free(ctx);
@@ -65,8 +68,10 @@ struct lookahead_ctx *vp9_lookahead_init(unsigned int width,
     ctx->max_sz = depth;
     ctx->buf = calloc(depth, sizeof(*ctx->buf));
     ctx->next_show_idx = 0;
+    ctx->mi_rows = (height + MI_SIZE - 1) >> MI_SIZE_LOG2;
+    ctx->mi_cols = (width + MI_SIZE - 1) >> MI_SIZE_LOG2;
     if (!ctx->buf) goto bail;
-    for (i = 0; i < depth; i++)
+    for (i = 0; i < depth; i++) {
       if (vpx_alloc_frame_buffer(
               &ctx->buf[i].img, width, height, subsampling_x, subsampling_y,
 #if CONFIG_VP9_HIGHBITDEPTH
@@ -74,6 +79,10 @@ struct lookahead_ctx *vp9_lookahead_init(unsigned int width,
 #endif
               VP9_ENC_BORDER_IN_PIXELS, legacy_byte_alignment))
         goto bail;
+      ctx->buf[i].stale_map = calloc(ctx->mi_rows * ctx->mi_cols, 1);
+      if (!ctx->buf[i].stale_map) goto bail;
+      ctx->buf[i].all_stale = 1;
+    }
   }
   return ctx;
 bail:
@@ -81,7 +90,6 @@ bail:
   return NULL;
 }
 
-#define USE_PARTIAL_COPY 0
 int vp9_lookahead_full(const struct lookahead_ctx *ctx) {
   return ctx->sz + 1 + MAX_PRE_FRAMES > ctx->max_sz;
 }
@@ -90,22 +98,54 @@ int vp9_lookahead_next_show_idx(const struct lookahead_ctx *ctx) {
   return ctx->next_show_idx;
 }
 
+// Copies the runs of stale blocks of each row of 8x8 blocks, and returns the
+// number of luma pixels copied.
+static int64_t copy_stale_blocks(const struct lookahead_ctx *ctx,
+                                 const YV12_BUFFER_CONFIG *src,
+                                 YV12_BUFFER_CONFIG *dst,
+                                 const unsigned char *stale_map) {
+  int64_t copied_pixels = 0;
+  int row, col, end;
+
+  for (row = 0; row < ctx->mi_rows; ++row) {
+    const int y = row << MI_SIZE_LOG2;
+    const int h = VPXMIN(MI_SIZE, src->y_crop_height - y);
+    col = 0;
+    while (1) {
+      int x, w;
+      // Find the first stale block of the row and the end of its run.
+      for (; col < ctx->mi_cols; ++col) {
+        if (stale_map[col]) break;
+      }
+      if (col == ctx->mi_cols) break;
+      for (end = col; end < ctx->mi_cols; ++end) {
+        if (!stale_map[end]) break;
+      }
+      x = col << MI_SIZE_LOG2;
+      w = VPXMIN(end << MI_SIZE_LOG2, src->y_crop_width) - x;
+      vp9_copy_and_extend_frame_with_rect(src, dst, y, x, h, w);
+      copied_pixels += w * h;
+      col = end;
+    }
+    stale_map += ctx->mi_cols;
+  }
+  return copied_pixels;
+}
+
 int vp9_lookahead_push(struct lookahead_ctx *ctx, YV12_BUFFER_CONFIG *src,
                        int64_t ts_start, int64_t ts_end, int use_highbitdepth,
-                       vpx_enc_frame_flags_t flags) {
+                       vpx_enc_frame_flags_t flags,
+                       const unsigned char *dirty_map) {
   struct lookahead_entry *buf;
-#if USE_PARTIAL_COPY
-  int row, col, active_end;
-  int mb_rows = (src->y_height + 15) >> 4;
-  int mb_cols = (src->y_width + 15) >> 4;
-#endif
   int width = src->y_crop_width;
   int height = src->y_crop_height;
   int uv_width = src->uv_crop_width;
   int uv_height = src->uv_crop_height;
   int subsampling_x = src->subsampling_x;
   int subsampling_y = src->subsampling_y;
+  const int num_blocks = ctx->mi_rows * ctx->mi_cols;
   int larger_dimensions, new_dimensions;
+  int i, j;
 #if !CONFIG_VP9_HIGHBITDEPTH
   (void)use_highbitdepth;
   assert(use_highbitdepth == 0);
@@ -124,46 +164,28 @@ int vp9_lookahead_push(struct lookahead_ctx *ctx, YV12_BUFFER_CONFIG *src,
                       uv_height > buf->img.uv_height;
   assert(!larger_dimensions || new_dimensions);
 
-#if USE_PARTIAL_COPY
-  // TODO(jkoleszar): This is disabled for now, as
-  // vp9_copy_and_extend_frame_with_rect is not subsampling/alpha aware.
-
-  // Only do this partial copy if the following conditions are all met:
-  // 1. Lookahead queue has has size of 1.
-  // 2. Active map is provided.
-  // 3. This is not a key frame, golden nor altref frame.
-  if (!new_dimensions && ctx->max_sz == 1 && active_map && !flags) {
-    for (row = 0; row < mb_rows; ++row) {
-      col = 0;
-
-      while (1) {
-        // Find the first active macroblock in this row.
-        for (; col < mb_cols; ++col) {
-          if (active_map[col]) break;
-        }
-
-        // No more active macroblock in this row.
-        if (col == mb_cols) break;
-
-        // Find the end of active region in this row.
-        active_end = col;
-
-        for (; active_end < mb_cols; ++active_end) {
-          if (!active_map[active_end]) break;
-        }
-
-        // Only copy this active region.
-        vp9_copy_and_extend_frame_with_rect(src, &buf->img, row << 4, col << 4,
-                                            16, (active_end - col) << 4);
-
-        // Start again from the end of this active region.
-        col = active_end;
-      }
-
-      active_map += mb_cols;
+  // The dirty map only applies to frames of the size of the stale maps.
+  if (((height + MI_SIZE - 1) >> MI_SIZE_LOG2) != ctx->mi_rows ||
+      ((width + MI_SIZE - 1) >> MI_SIZE_LOG2) != ctx->mi_cols)
+    dirty_map = NULL;
+
+  // The other buffers now hold older frames than this one.
+  for (i = 0; i < ctx->max_sz; ++i) {
+    struct lookahead_entry *const entry = &ctx->buf[i];
+    if (entry == buf || entry->all_stale) continue;
+    if (dirty_map == NULL) {
+      entry->all_stale = 1;
+    } else {
+      for (j = 0; j < num_blocks; ++j) entry->stale_map[j] |= dirty_map[j];
     }
+  }
+
+  // Only copy the blocks that changed since the frame in the buffer if it is
+  // of the same size.
+  if (dirty_map != NULL && !new_dimensions && !buf->all_stale) {
+    for (j = 0; j < num_blocks; ++j) buf->stale_map[j] |= dirty_map[j];
+    ctx->copied_pixels = copy_stale_blocks(ctx, src, &buf->img, buf->stale_map);
   } else {
-#endif
     if (larger_dimensions) {
       YV12_BUFFER_CONFIG new_img;
       memset(&new_img, 0, sizeof(new_img));
@@ -184,11 +206,11 @@ int vp9_lookahead_push(struct lookahead_ctx *ctx, YV12_BUFFER_CONFIG *src,
       buf->img.subsampling_x = src->subsampling_x;
       buf->img.subsampling_y = src->subsampling_y;
     }
-    // Partial copy not implemented yet
     vp9_copy_and_extend_frame(src, &buf->img);
-#if USE_PARTIAL_COPY
+    ctx->copied_pixels = (int64_t)width * height;
   }
-#endif
+  memset(buf->stale_map, 0, num_blocks);
+  buf->all_stale = 0;
 
   buf->ts_start = ts_start;
   buf->ts_end = ts_end;
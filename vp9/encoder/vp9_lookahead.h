@@ -27,6 +27,10 @@ struct lookahead_entry {
   int64_t ts_end;
   int show_idx; /*The show_idx of this frame*/
   vpx_enc_frame_flags_t flags;
+  // 1 for each 8x8 block of |img| that may differ from the last frame pushed,
+  // unless |all_stale| is set.
+  unsigned char *stale_map;
+  int all_stale;
 };
 
 // The max of past frames we want to keep in the queue.
@@ -40,6 +44,9 @@ struct lookahead_ctx {
   int next_show_idx; /* The show_idx that will be assigned to the next frame
                         being pushed in the queue*/
   struct lookahead_entry *buf; /* Buffer list */
+  int mi_rows;                 /* Size of the stale maps, in 8x8 blocks */
+  int mi_cols;
+  int64_t copied_pixels; /* Luma pixels copied by the last push */
 };
 
 /**\brief Initializes the lookahead stage
@@ -82,15 +89,21 @@ int vp9_lookahead_next_show_idx(const struct lookahead_ctx *ctx);
  * This function will copy the source image into a new framebuffer with
  * the expected stride/border.
  *
+ * If dirty_map is non-NULL, only the 8x8 blocks it marks and the blocks in
+ * which the framebuffer is older than the last frame pushed are copied.
+ *
  * \param[in] ctx         Pointer to the lookahead context
  * \param[in] src         Pointer to the image to enqueue
  * \param[in] ts_start    Timestamp for the start of this frame
  * \param[in] ts_end      Timestamp for the end of this frame
  * \param[in] flags       Flags set on this frame
+ * \param[in] dirty_map   1 for each 8x8 block that may differ from the last
+ *                        frame pushed
  */
 int vp9_lookahead_push(struct lookahead_ctx *ctx, YV12_BUFFER_CONFIG *src,
                        int64_t ts_start, int64_t ts_end, int use_highbitdepth,
-                       vpx_enc_frame_flags_t flags);
+                       vpx_enc_frame_flags_t flags,
+                       const unsigned char *dirty_map);
 
 /**\brief Get the next source buffer to encode
  *
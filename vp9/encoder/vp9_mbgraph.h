@@ -29,10 +29,26 @@ typedef struct {
   MBGRAPH_MB_STATS *mb_stats;
 } MBGRAPH_FRAME_STATS;
 
+// The frame whose stats are being gathered, shared by the row workers.
+typedef struct MBGraphFrameData {
+  MBGRAPH_FRAME_STATS *stats;
+  struct yv12_buffer_config *buf;
+  struct yv12_buffer_config *golden_ref;
+  struct yv12_buffer_config *alt_ref;
+} MBGraphFrameData;
+
 struct VP9_COMP;
+struct ThreadData;
+struct VP9RowMTSyncData;
 
 void vp9_update_mbgraph_stats(struct VP9_COMP *cpi);
 
+// Gathers the stats of one MB row of cpi->mbgraph_frame_data. The first MB
+// of a row depends on the first MB of the row above.
+void vp9_update_mbgraph_mb_row(struct VP9_COMP *cpi, struct ThreadData *td,
+                               struct VP9RowMTSyncData *row_mt_sync,
+                               int mb_row);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
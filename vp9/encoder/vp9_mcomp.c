@@ -140,6 +140,31 @@ static INLINE const uint8_t *pre(const uint8_t *buf, int stride, int r, int c) {
   return &buf[(r >> 3) * stride + (c >> 3)];
 }
 
+// Returns the variance at the sub-pixel position (xoffset, yoffset) of the
+// block at |pre|, reading the interpolated block from the sub-pixel cache when
+// it holds it.
+static INLINE unsigned int subpel_variance(
+    const MACROBLOCK *x, const vp9_variance_fn_ptr_t *vfp, const uint8_t *pre,
+    int pre_stride, int xoffset, int yoffset, const uint8_t *src,
+    int src_stride, const uint8_t *second_pred, int w, int h,
+    unsigned int *sse) {
+  const uint8_t *const cached =
+      vp9_subpel_cache_get(x->subpel_cache, pre, pre_stride, xoffset, yoffset);
+  if (cached != NULL) {
+    if (second_pred != NULL) {
+      DECLARE_ALIGNED(16, uint8_t, comp_pred[64 * 64]);
+      vpx_comp_avg_pred(comp_pred, second_pred, w, h, cached, pre_stride);
+      return vfp->vf(comp_pred, w, src, src_stride, sse);
+    }
+    return vfp->vf(cached, pre_stride, src, src_stride, sse);
+  }
+  if (second_pred != NULL) {
+    return vfp->svaf(pre, pre_stride, xoffset, yoffset, src, src_stride, sse,
+                     second_pred);
+  }
+  return vfp->svf(pre, pre_stride, xoffset, yoffset, src, src_stride, sse);
+}
+
 #if CONFIG_VP9_HIGHBITDEPTH
 /* checks if (r, c) has better score than previous best */
 #define CHECK_BETTER(v, r, c)                                                  \
@@ -148,13 +173,9 @@ static INLINE const uint8_t *pre(const uint8_t *buf, int stride, int r, int c) {
       int64_t tmpmse;                                                          \
       const MV cb_mv = { r, c };                                               \
       const MV cb_ref_mv = { rr, rc };                                         \
-      if (second_pred == NULL) {                                               \
-        thismse = vfp->svf(pre(y, y_stride, r, c), y_stride, sp(c), sp(r), z,  \
-                           src_stride, &sse);                                  \
-      } else {                                                                 \
-        thismse = vfp->svaf(pre(y, y_stride, r, c), y_stride, sp(c), sp(r), z, \
-                            src_stride, &sse, second_pred);                    \
-      }                                                                        \
+      thismse = subpel_variance(x, vfp, pre(y, y_stride, r, c), y_stride,      \
+                                sp(c), sp(r), z, src_stride, second_pred, w,   \
+                                h, &sse);                                      \
       tmpmse = thismse;                                                        \
       tmpmse +=                                                                \
           mv_err_cost(&cb_mv, &cb_ref_mv, mvjcost, mvcost, error_per_bit);     \
@@ -178,12 +199,9 @@ static INLINE const uint8_t *pre(const uint8_t *buf, int stride, int r, int c) {
     if (c >= minc && c <= maxc && r >= minr && r <= maxr) {                    \
       const MV cb_mv = { r, c };                                               \
       const MV cb_ref_mv = { rr, rc };                                         \
-      if (second_pred == NULL)                                                 \
-        thismse = vfp->svf(pre(y, y_stride, r, c), y_stride, sp(c), sp(r), z,  \
-                           src_stride, &sse);                                  \
-      else                                                                     \
-        thismse = vfp->svaf(pre(y, y_stride, r, c), y_stride, sp(c), sp(r), z, \
-                            src_stride, &sse, second_pred);                    \
+      thismse = subpel_variance(x, vfp, pre(y, y_stride, r, c), y_stride,      \
+                                sp(c), sp(r), z, src_stride, second_pred, w,   \
+                                h, &sse);                                      \
       if ((v = mv_err_cost(&cb_mv, &cb_ref_mv, mvjcost, mvcost,                \
                            error_per_bit) +                                    \
                thismse) < besterr) {                                           \
@@ -797,12 +815,9 @@ uint32_t vp9_find_best_sub_pixel_tree(
         } else {
           const uint8_t *const pre_address =
               y + (tr >> 3) * y_stride + (tc >> 3);
-          if (second_pred == NULL)
-            thismse = vfp->svf(pre_address, y_stride, sp(tc), sp(tr),
-                               src_address, src_stride, &sse);
-          else
-            thismse = vfp->svaf(pre_address, y_stride, sp(tc), sp(tr),
-                                src_address, src_stride, &sse, second_pred);
+          thismse = subpel_variance(x, vfp, pre_address, y_stride, sp(tc),
+                                    sp(tr), src_address, src_stride,
+                                    second_pred, w, h, &sse);
         }
 
         cost_array[idx] = thismse + mv_err_cost(&this_mv, ref_mv, mvjcost,
@@ -833,12 +848,9 @@ uint32_t vp9_find_best_sub_pixel_tree(
                                           second_pred, w, h, &sse);
       } else {
         const uint8_t *const pre_address = y + (tr >> 3) * y_stride + (tc >> 3);
-        if (second_pred == NULL)
-          thismse = vfp->svf(pre_address, y_stride, sp(tc), sp(tr), src_address,
-                             src_stride, &sse);
-        else
-          thismse = vfp->svaf(pre_address, y_stride, sp(tc), sp(tr),
-                              src_address, src_stride, &sse, second_pred);
+        thismse = subpel_variance(x, vfp, pre_address, y_stride, sp(tc),
+                                  sp(tr), src_address, src_stride, second_pred,
+                                  w, h, &sse);
       }
 
       cost_array[4] = thismse + mv_err_cost(&this_mv, ref_mv, mvjcost, mvcost,
@@ -999,6 +1011,32 @@ static INLINE void calc_int_cost_list(const MACROBLOCK *x, const MV *ref_mv,
   }
 }
 
+// Computes the sads of the num (at most MAX_PATTERN_CANDIDATES) candidates
+// around (br, bc) with the multi-reference sad functions, which share the
+// loads of the source block between the candidates.
+static INLINE void pattern_sads(const struct buf_2d *what,
+                                const struct buf_2d *in_what,
+                                const vp9_variance_fn_ptr_t *vfp, int br,
+                                int bc, const MV *candidates, int num,
+                                unsigned int *sads) {
+  const uint8_t *addrs[MAX_PATTERN_CANDIDATES];
+  int i;
+  for (i = 0; i < MAX_PATTERN_CANDIDATES; ++i) {
+    // The unused slots repeat the first candidate.
+    const MV mv = i < num ? candidates[i] : candidates[0];
+    const MV this_mv = { br + mv.row, bc + mv.col };
+    addrs[i] = get_buf_from_mv(in_what, &this_mv);
+  }
+  if (num <= 4) {
+    vfp->sdx4df(what->buf, what->stride, addrs, in_what->stride, sads);
+  } else if (vfp->sdx8df != NULL) {
+    vfp->sdx8df(what->buf, what->stride, addrs, in_what->stride, sads);
+  } else {
+    vfp->sdx4df(what->buf, what->stride, addrs, in_what->stride, sads);
+    vfp->sdx4df(what->buf, what->stride, addrs + 4, in_what->stride, sads + 4);
+  }
+}
+
 // Generic pattern search function that searches over multiple scales.
 // Each scale can have a different number of candidates and shape of
 // candidates as indicated in the num_candidates and candidates arrays
@@ -1043,12 +1081,13 @@ static int vp9_pattern_search(
     for (t = 0; t <= s; ++t) {
       int best_site = -1;
       if (check_bounds(&x->mv_limits, br, bc, 1 << t)) {
+        unsigned int sads[MAX_PATTERN_CANDIDATES];
+        pattern_sads(what, in_what, vfp, br, bc, candidates[t],
+                     num_candidates[t], sads);
         for (i = 0; i < num_candidates[t]; i++) {
           const MV this_mv = { br + candidates[t][i].row,
                                bc + candidates[t][i].col };
-          thissad =
-              vfp->sdf(what->buf, what->stride,
-                       get_buf_from_mv(in_what, &this_mv), in_what->stride);
+          thissad = sads[i];
           CHECK_BETTER
         }
       } else {
@@ -1085,12 +1124,13 @@ static int vp9_pattern_search(
       // No need to search all 6 points the 1st time if initial search was used
       if (!do_init_search || s != best_init_s) {
         if (check_bounds(&x->mv_limits, br, bc, 1 << s)) {
+          unsigned int sads[MAX_PATTERN_CANDIDATES];
+          pattern_sads(what, in_what, vfp, br, bc, candidates[s],
+                       num_candidates[s], sads);
           for (i = 0; i < num_candidates[s]; i++) {
             const MV this_mv = { br + candidates[s][i].row,
                                  bc + candidates[s][i].col };
-            thissad =
-                vfp->sdf(what->buf, what->stride,
-                         get_buf_from_mv(in_what, &this_mv), in_what->stride);
+            thissad = sads[i];
             CHECK_BETTER
           }
         } else {
@@ -1217,12 +1257,13 @@ static int vp9_pattern_search_sad(
     for (t = 0; t <= s; ++t) {
       int best_site = -1;
       if (check_bounds(&x->mv_limits, br, bc, 1 << t)) {
+        unsigned int sads[MAX_PATTERN_CANDIDATES];
+        pattern_sads(what, in_what, vfp, br, bc, candidates[t],
+                     num_candidates[t], sads);
         for (i = 0; i < num_candidates[t]; i++) {
           const MV this_mv = { br + candidates[t][i].row,
                                bc + candidates[t][i].col };
-          thissad =
-              vfp->sdf(what->buf, what->stride,
-                       get_buf_from_mv(in_what, &this_mv), in_what->stride);
+          thissad = sads[i];
           CHECK_BETTER
         }
       } else {
@@ -1259,12 +1300,13 @@ static int vp9_pattern_search_sad(
     for (; s >= do_sad; s--) {
       if (!do_init_search || s != best_init_s) {
         if (check_bounds(&x->mv_limits, br, bc, 1 << s)) {
+          unsigned int sads[MAX_PATTERN_CANDIDATES];
+          pattern_sads(what, in_what, vfp, br, bc, candidates[s],
+                       num_candidates[s], sads);
           for (i = 0; i < num_candidates[s]; i++) {
             const MV this_mv = { br + candidates[s][i].row,
                                  bc + candidates[s][i].col };
-            thissad =
-                vfp->sdf(what->buf, what->stride,
-                         get_buf_from_mv(in_what, &this_mv), in_what->stride);
+            thissad = sads[i];
             CHECK_BETTER
           }
         } else {
@@ -1333,12 +1375,13 @@ static int vp9_pattern_search_sad(
       cost_list[0] = bestsad;
       if (!do_init_search || s != best_init_s) {
         if (check_bounds(&x->mv_limits, br, bc, 1 << s)) {
+          unsigned int sads[MAX_PATTERN_CANDIDATES];
+          pattern_sads(what, in_what, vfp, br, bc, candidates[s],
+                       num_candidates[s], sads);
           for (i = 0; i < num_candidates[s]; i++) {
             const MV this_mv = { br + candidates[s][i].row,
                                  bc + candidates[s][i].col };
-            cost_list[i + 1] = thissad =
-                vfp->sdf(what->buf, what->stride,
-                         get_buf_from_mv(in_what, &this_mv), in_what->stride);
+            cost_list[i + 1] = thissad = sads[i];
             CHECK_BETTER
           }
         } else {
@@ -1677,17 +1720,24 @@ static int exhaustive_mesh_search(const MACROBLOCK *x, MV *ref_mv, MV *best_mv,
           }
         }
       } else {
-        // 4 sads in a single call if we are checking every location
+        // 8 or 4 sads in a single call if we are checking every location
         if (c + 3 <= end_col) {
-          unsigned int sads[4];
-          const uint8_t *addrs[4];
-          for (i = 0; i < 4; ++i) {
+          unsigned int sads[8];
+          const uint8_t *addrs[8];
+          const int num = (c + 7 <= end_col && fn_ptr->sdx8df) ? 8 : 4;
+          for (i = 0; i < num; ++i) {
             const MV mv = { fcenter_mv.row + r, fcenter_mv.col + c + i };
             addrs[i] = get_buf_from_mv(in_what, &mv);
           }
-          fn_ptr->sdx4df(what->buf, what->stride, addrs, in_what->stride, sads);
+          if (num == 8) {
+            fn_ptr->sdx8df(what->buf, what->stride, addrs, in_what->stride,
+                           sads);
+          } else {
+            fn_ptr->sdx4df(what->buf, what->stride, addrs, in_what->stride,
+                           sads);
+          }
 
-          for (i = 0; i < 4; ++i) {
+          for (i = 0; i < num; ++i) {
             if (sads[i] < best_sad) {
               const MV mv = { fcenter_mv.row + r, fcenter_mv.col + c + i };
               const unsigned int sad =
@@ -1698,6 +1748,8 @@ static int exhaustive_mesh_search(const MACROBLOCK *x, MV *ref_mv, MV *best_mv,
               }
             }
           }
+          // The 8 sads cover the columns of the next step too.
+          if (num == 8) c += 4;
         } else {
           for (i = 0; i < end_col - c; ++i) {
             const MV mv = { fcenter_mv.row + r, fcenter_mv.col + c + i };
@@ -231,14 +231,18 @@ void vp9_prepare_job_queue(VP9_COMP *cpi, JOB_TYPE job_type) {
   VP9_COMMON *const cm = &cpi->common;
   MultiThreadHandle *multi_thread_ctxt = &cpi->multi_thread_ctxt;
   JobQueue *job_queue = multi_thread_ctxt->job_queue;
-  const int tile_cols = 1 << cm->log2_tile_cols;
+  // The MB graph rows depend on each other across the whole frame width, so
+  // they are queued as a single column.
+  const int tile_cols =
+      (job_type == MBGRAPH_JOB) ? 1 : (1 << cm->log2_tile_cols);
   int job_row_num, jobs_per_tile, jobs_per_tile_col = 0, total_jobs;
   const int sb_rows = mi_cols_aligned_to_sb(cm->mi_rows) >> MI_BLOCK_SIZE_LOG2;
   int tile_col, i;
 
   switch (job_type) {
     case ENCODE_JOB: jobs_per_tile_col = sb_rows; break;
-    case FIRST_PASS_JOB: jobs_per_tile_col = cm->mb_rows; break;
+    case FIRST_PASS_JOB:
+    case MBGRAPH_JOB: jobs_per_tile_col = cm->mb_rows; break;
     case ARNR_JOB:
       jobs_per_tile_col = ((cm->mi_rows + TF_ROUND) >> TF_SHIFT);
       break;
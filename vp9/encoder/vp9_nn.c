@@ -0,0 +1,79 @@
+/*
+ *  Copyright (c) 2023 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <assert.h>
+
+#include "./vp9_rtcd.h"
+#include "vpx_dsp/vpx_dsp_common.h"
+#include "vp9/encoder/vp9_nn.h"
+
+void vp9_nn_fc_layer_c(const float *input, int num_inputs, int num_samples,
+                       const float *weights, const float *bias,
+                       int num_outputs, int relu, float *output) {
+  int s, node, i;
+  for (s = 0; s < num_samples; ++s) {
+    const float *w = weights;
+    for (node = 0; node < num_outputs; ++node) {
+      float val = 0.0f;
+      for (i = 0; i < num_inputs; ++i) val += w[i] * input[i];
+      val += bias[node];
+      // ReLU as activation function.
+      output[node] = relu ? VPXMAX(val, 0.0f) : val;
+      w += num_inputs;
+    }
+    input += num_inputs;
+    output += num_outputs;
+  }
+}
+
+static void nn_predict_batch(const float *features, int num_samples,
+                             const NN_CONFIG *nn_config, float *output) {
+  float buf[2][NN_MAX_BATCH * NN_MAX_NODES_PER_LAYER];
+  const float *input_nodes = features;
+  int num_input_nodes = nn_config->num_inputs;
+  int buf_index = 0;
+  const int num_layers = nn_config->num_hidden_layers;
+  int layer;
+  assert(num_samples <= NN_MAX_BATCH);
+  assert(num_layers <= NN_MAX_HIDDEN_LAYERS);
+
+  // Propagate hidden layers.
+  for (layer = 0; layer < num_layers; ++layer) {
+    const int num_output_nodes = nn_config->num_hidden_nodes[layer];
+    assert(num_output_nodes < NN_MAX_NODES_PER_LAYER);
+    vp9_nn_fc_layer(input_nodes, num_input_nodes, num_samples,
+                    nn_config->weights[layer], nn_config->bias[layer],
+                    num_output_nodes, 1, buf[buf_index]);
+    num_input_nodes = num_output_nodes;
+    input_nodes = buf[buf_index];
+    buf_index = 1 - buf_index;
+  }
+
+  // Final output layer.
+  vp9_nn_fc_layer(input_nodes, num_input_nodes, num_samples,
+                  nn_config->weights[num_layers], nn_config->bias[num_layers],
+                  nn_config->num_outputs, 0, output);
+}
+
+void vp9_nn_predict(const float *features, const NN_CONFIG *nn_config,
+                    float *output) {
+  nn_predict_batch(features, 1, nn_config, output);
+}
+
+void vp9_nn_predict_batch(const float *features, int num_samples,
+                          const NN_CONFIG *nn_config, float *output) {
+  while (num_samples > 0) {
+    const int n = VPXMIN(num_samples, NN_MAX_BATCH);
+    nn_predict_batch(features, n, nn_config, output);
+    features += n * nn_config->num_inputs;
+    output += n * nn_config->num_outputs;
+    num_samples -= n;
+  }
+}
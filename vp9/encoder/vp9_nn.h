@@ -0,0 +1,54 @@
+/*
+ *  Copyright (c) 2023 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef VPX_VP9_ENCODER_VP9_NN_H_
+#define VPX_VP9_ENCODER_VP9_NN_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NN_MAX_HIDDEN_LAYERS 10
+#define NN_MAX_NODES_PER_LAYER 128
+// Maximum number of feature vectors evaluated together by one pass of
+// vp9_nn_predict_batch(). Larger batches are split.
+#define NN_MAX_BATCH 16
+
+// Neural net model config. It defines the layout of a neural net model, such as
+// the number of inputs/outputs, number of layers, the number of nodes in each
+// layer, as well as the weights and bias of each node.
+typedef struct {
+  int num_inputs;         // Number of input nodes, i.e. features.
+  int num_outputs;        // Number of output nodes.
+  int num_hidden_layers;  // Number of hidden layers, maximum 10.
+  // Number of nodes for each hidden layer.
+  int num_hidden_nodes[NN_MAX_HIDDEN_LAYERS];
+  // Weight parameters, indexed by layer.
+  const float *weights[NN_MAX_HIDDEN_LAYERS + 1];
+  // Bias parameters, indexed by layer.
+  const float *bias[NN_MAX_HIDDEN_LAYERS + 1];
+} NN_CONFIG;
+
+// Calculates the output nodes of the fully-connected network |nn_config| with
+// ReLU activated hidden layers for the input nodes |features|.
+void vp9_nn_predict(const float *features, const NN_CONFIG *nn_config,
+                    float *output);
+
+// Batched version of vp9_nn_predict(). |features| holds |num_samples| input
+// vectors of nn_config->num_inputs values each and |output| receives
+// |num_samples| vectors of nn_config->num_outputs values each.
+void vp9_nn_predict_batch(const float *features, int num_samples,
+                          const NN_CONFIG *nn_config, float *output);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // VPX_VP9_ENCODER_VP9_NN_H_
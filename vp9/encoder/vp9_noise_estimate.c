@@ -16,10 +16,12 @@
 #include "vpx_dsp/vpx_dsp_common.h"
 #include "vpx_scale/yv12config.h"
 #include "vpx/vpx_integer.h"
+#include "vpx_mem/vpx_mem.h"
 #include "vp9/common/vp9_reconinter.h"
 #include "vp9/encoder/vp9_context_tree.h"
 #include "vp9/encoder/vp9_noise_estimate.h"
 #include "vp9/encoder/vp9_encoder.h"
+#include "vp9/encoder/vp9_ethread.h"
 
 #if CONFIG_VP9_TEMPORAL_DENOISING
 // For SVC: only do noise estimation on top spatial layer.
@@ -106,6 +108,75 @@ NOISE_LEVEL vp9_noise_estimate_extract_level(NOISE_ESTIMATE *const ne) {
   return noise_level;
 }
 
+typedef struct NoiseHistJob {
+  VP9_COMP *cpi;
+  const YV12_BUFFER_CONFIG *last_source;
+  int thresh_consec_zeromv;
+  unsigned int bin_size;
+  // MAX_VAR_HIST_BINS counts per job.
+  unsigned int *hist;
+} NoiseHistJob;
+
+// Loop over sub-sample of 16x16 blocks of a block row, and for blocks that
+// have been encoded as zero/small mv at least x consecutive frames, compute
+// the variance to update estimate of noise in the source.
+static void noise_hist_row(void *data, int job_index) {
+  const NoiseHistJob *const job = (const NoiseHistJob *)data;
+  VP9_COMP *const cpi = job->cpi;
+  const VP9_COMMON *const cm = &cpi->common;
+  const YV12_BUFFER_CONFIG *const src = cpi->Source;
+  const YV12_BUFFER_CONFIG *const last_src = job->last_source;
+  const int bsize = BLOCK_16X16;
+  // 16x16 blocks, 1/4 sample of frame.
+  const int mi_row = job_index << 2;
+  unsigned int *const hist = job->hist + job_index * MAX_VAR_HIST_BINS;
+  int mi_col;
+
+  if (mi_row >= cm->mi_rows - 1) return;
+
+  for (mi_col = 0; mi_col < cm->mi_cols - 1; mi_col += 4) {
+    int bl_index = mi_row * cm->mi_cols + mi_col;
+    int bl_index1 = bl_index + 1;
+    int bl_index2 = bl_index + cm->mi_cols;
+    int bl_index3 = bl_index2 + 1;
+    int consec_zeromv =
+        VPXMIN(cpi->consec_zero_mv[bl_index],
+               VPXMIN(cpi->consec_zero_mv[bl_index1],
+                      VPXMIN(cpi->consec_zero_mv[bl_index2],
+                             cpi->consec_zero_mv[bl_index3])));
+    // Only consider blocks that are likely steady background. i.e, have
+    // been encoded as zero/low motion x (= thresh_consec_zeromv) frames
+    // in a row. consec_zero_mv[] defined for 8x8 blocks, so consider all
+    // 4 sub-blocks for 16x16 block.
+    if (consec_zeromv > job->thresh_consec_zeromv) {
+      const uint8_t *src_y =
+          src->y_buffer + (mi_row << 3) * src->y_stride + (mi_col << 3);
+      const uint8_t *last_src_y = last_src->y_buffer +
+                                  (mi_row << 3) * last_src->y_stride +
+                                  (mi_col << 3);
+      int is_skin = 0;
+      if (cpi->use_skin_detection) {
+        const int uv_offset = (mi_row << 2) * src->uv_stride + (mi_col << 2);
+        is_skin = vp9_compute_skin_block(
+            src_y, src->u_buffer + uv_offset, src->v_buffer + uv_offset,
+            src->y_stride, src->uv_stride, bsize, consec_zeromv, 0);
+      }
+      if (!is_skin) {
+        unsigned int sse;
+        // Compute variance between co-located blocks from current and
+        // last input frames.
+        unsigned int variance = cpi->fn_ptr[bsize].vf(
+            src_y, src->y_stride, last_src_y, last_src->y_stride, &sse);
+        unsigned int hist_index = variance / job->bin_size;
+        if (hist_index < MAX_VAR_HIST_BINS)
+          hist[hist_index]++;
+        else if (hist_index < 3 * (MAX_VAR_HIST_BINS >> 1))
+          hist[MAX_VAR_HIST_BINS - 1]++;  // Account for the tail
+      }
+    }
+  }
+}
+
 void vp9_update_noise_estimate(VP9_COMP *const cpi) {
   const VP9_COMMON *const cm = &cpi->common;
   NOISE_ESTIMATE *const ne = &cpi->noise_estimate;
@@ -165,17 +236,6 @@ void vp9_update_noise_estimate(VP9_COMP *const cpi) {
     unsigned int max_bin = 0;
     unsigned int max_bin_count = 0;
     unsigned int bin_cnt;
-    int bsize = BLOCK_16X16;
-    // Loop over sub-sample of 16x16 blocks of frame, and for blocks that have
-    // been encoded as zero/small mv at least x consecutive frames, compute
-    // the variance to update estimate of noise in the source.
-    const uint8_t *src_y = cpi->Source->y_buffer;
-    const int src_ystride = cpi->Source->y_stride;
-    const uint8_t *last_src_y = last_source->y_buffer;
-    const int last_src_ystride = last_source->y_stride;
-    const uint8_t *src_u = cpi->Source->u_buffer;
-    const uint8_t *src_v = cpi->Source->v_buffer;
-    const int src_uvstride = cpi->Source->uv_stride;
     int mi_row, mi_col;
     int num_low_motion = 0;
     int frame_low_motion = 1;
@@ -188,57 +248,26 @@ void vp9_update_noise_estimate(VP9_COMP *const cpi) {
     }
     if (num_low_motion < ((3 * cm->mi_rows * cm->mi_cols) >> 3))
       frame_low_motion = 0;
-    for (mi_row = 0; mi_row < cm->mi_rows; mi_row++) {
-      for (mi_col = 0; mi_col < cm->mi_cols; mi_col++) {
-        // 16x16 blocks, 1/4 sample of frame.
-        if (mi_row % 4 == 0 && mi_col % 4 == 0 && mi_row < cm->mi_rows - 1 &&
-            mi_col < cm->mi_cols - 1) {
-          int bl_index = mi_row * cm->mi_cols + mi_col;
-          int bl_index1 = bl_index + 1;
-          int bl_index2 = bl_index + cm->mi_cols;
-          int bl_index3 = bl_index2 + 1;
-          int consec_zeromv =
-              VPXMIN(cpi->consec_zero_mv[bl_index],
-                     VPXMIN(cpi->consec_zero_mv[bl_index1],
-                            VPXMIN(cpi->consec_zero_mv[bl_index2],
-                                   cpi->consec_zero_mv[bl_index3])));
-          // Only consider blocks that are likely steady background. i.e, have
-          // been encoded as zero/low motion x (= thresh_consec_zeromv) frames
-          // in a row. consec_zero_mv[] defined for 8x8 blocks, so consider all
-          // 4 sub-blocks for 16x16 block. And exclude this frame if
-          // high_source_sad is true (i.e., scene/content change).
-          if (frame_low_motion && consec_zeromv > thresh_consec_zeromv &&
-              !cpi->rc.high_source_sad &&
-              !cpi->svc.high_source_sad_superframe) {
-            int is_skin = 0;
-            if (cpi->use_skin_detection) {
-              is_skin =
-                  vp9_compute_skin_block(src_y, src_u, src_v, src_ystride,
-                                         src_uvstride, bsize, consec_zeromv, 0);
-            }
-            if (!is_skin) {
-              unsigned int sse;
-              // Compute variance between co-located blocks from current and
-              // last input frames.
-              unsigned int variance = cpi->fn_ptr[bsize].vf(
-                  src_y, src_ystride, last_src_y, last_src_ystride, &sse);
-              unsigned int hist_index = variance / bin_size;
-              if (hist_index < MAX_VAR_HIST_BINS)
-                hist[hist_index]++;
-              else if (hist_index < 3 * (MAX_VAR_HIST_BINS >> 1))
-                hist[MAX_VAR_HIST_BINS - 1]++;  // Account for the tail
-            }
-          }
-        }
-        src_y += 8;
-        last_src_y += 8;
-        src_u += 4;
-        src_v += 4;
+    if (frame_low_motion && !cpi->rc.high_source_sad &&
+        !cpi->svc.high_source_sad_superframe) {
+      // One job per row of 16x16 blocks, each with its own histogram. The
+      // histograms are summed in row order afterwards.
+      NoiseHistJob job;
+      const int num_jobs = (cm->mi_rows + 3) >> 2;
+      int i;
+      job.cpi = cpi;
+      job.last_source = last_source;
+      job.thresh_consec_zeromv = thresh_consec_zeromv;
+      job.bin_size = bin_size;
+      CHECK_MEM_ERROR(&cpi->common, job.hist,
+                      vpx_calloc(num_jobs * MAX_VAR_HIST_BINS,
+                                 sizeof(*job.hist)));
+      vp9_run_row_jobs_mt(cpi, noise_hist_row, &job, num_jobs);
+      for (i = 0; i < num_jobs; ++i) {
+        for (bin_cnt = 0; bin_cnt < MAX_VAR_HIST_BINS; bin_cnt++)
+          hist[bin_cnt] += job.hist[i * MAX_VAR_HIST_BINS + bin_cnt];
       }
-      src_y += (src_ystride << 3) - (cm->mi_cols << 3);
-      last_src_y += (last_src_ystride << 3) - (cm->mi_cols << 3);
-      src_u += (src_uvstride << 2) - (cm->mi_cols << 2);
-      src_v += (src_uvstride << 2) - (cm->mi_cols << 2);
+      vpx_free(job.hist);
     }
     ne->last_w = cm->width;
     ne->last_h = cm->height;
@@ -10,9 +10,10 @@
 
 #include <assert.h>
 #include <limits.h>
+#include <string.h>
 
-#include "./vpx_scale_rtcd.h"
 #include "vpx_dsp/psnr.h"
+#include "vpx_dsp/vpx_dsp_common.h"
 #include "vpx_mem/vpx_mem.h"
 #include "vpx_ports/mem.h"
 
@@ -21,6 +22,7 @@
 #include "vp9/common/vp9_quant_common.h"
 
 #include "vp9/encoder/vp9_encoder.h"
+#include "vp9/encoder/vp9_ethread.h"
 #include "vp9/encoder/vp9_picklpf.h"
 #include "vp9/encoder/vp9_quantize.h"
 
@@ -43,36 +45,239 @@ static int get_max_filter_level(const VP9_COMP *cpi) {
   }
 }
 
-static int64_t try_filter_frame(const YV12_BUFFER_CONFIG *sd,
-                                VP9_COMP *const cpi, int filt_level,
-                                int partial_frame) {
-  VP9_COMMON *const cm = &cpi->common;
-  int64_t filt_err;
+// The filter level search does not filter the frame in place. Each candidate
+// level is applied to a stripe that holds one superblock row of the
+// reconstruction plus the LPF_CARRY_ROWS rows above it, which the horizontal
+// filtering of the superblock row's top edge can still modify. Superblocks are
+// filtered in the same order as vp9_loop_filter_frame(), so the error of each
+// level matches filtering the whole frame, and the rows are scored as soon as
+// no later superblock row can change them.
+#define LPF_CARRY_ROWS 8
+#define LPF_STRIPE_BORDER 32
+#define LPF_STRIPE_ROWS (LPF_CARRY_ROWS + (MI_BLOCK_SIZE << MI_SIZE_LOG2))
+// A search step scores at most the middle, low and high levels.
+#define LPF_MAX_LEVELS 3
+
+typedef struct LpfSearch {
+  VP9_COMMON *cm;
+  const YV12_BUFFER_CONFIG *sd;
+  int start_mi_row;
+  int end_mi_row;
+  // Pixel rows that the filter can modify. The rows outside have the same
+  // error for all levels.
+  int top;
+  int bottom;
+  int64_t outside_err;
+  int highbd;
+  int stripe_stride;
+  uint8_t *stripes[LPF_MAX_LEVELS];
+  int levels[LPF_MAX_LEVELS];
+  int64_t errs[LPF_MAX_LEVELS];
+} LpfSearch;
+
+// Returns the position of (row, col) in a plane, keeping the
+// CONVERT_TO_BYTEPTR() form for high bitdepth.
+static uint8_t *plane_pos(uint8_t *buf, int stride, int row, int col,
+                          int highbd) {
+#if CONFIG_VP9_HIGHBITDEPTH
+  if (highbd)
+    return CONVERT_TO_BYTEPTR(CONVERT_TO_SHORTPTR(buf) + row * stride + col);
+#else
+  (void)highbd;
+#endif  // CONFIG_VP9_HIGHBITDEPTH
+  return buf + row * stride + col;
+}
+
+static void copy_rows(uint8_t *src, int src_stride, uint8_t *dst,
+                      int dst_stride, int width, int rows, int highbd) {
+  int r;
+#if !CONFIG_VP9_HIGHBITDEPTH
+  (void)highbd;
+#endif  // !CONFIG_VP9_HIGHBITDEPTH
+  for (r = 0; r < rows; ++r) {
+#if CONFIG_VP9_HIGHBITDEPTH
+    if (highbd) {
+      memcpy(CONVERT_TO_SHORTPTR(dst) + r * dst_stride,
+             CONVERT_TO_SHORTPTR(src) + r * src_stride,
+             width * sizeof(uint16_t));
+      continue;
+    }
+#endif  // CONFIG_VP9_HIGHBITDEPTH
+    memcpy(dst + r * dst_stride, src + r * src_stride, width);
+  }
+}
 
-  vp9_build_mask_frame(cm, filt_level, partial_frame);
+// Returns the error of |rows| rows of |buf| against the source rows starting
+// at |row|. Rows below the visible frame are not counted.
+static int64_t get_rows_err(const LpfSearch *search, int row, uint8_t *buf,
+                            int stride, int rows) {
+  const YV12_BUFFER_CONFIG *const sd = search->sd;
+  uint8_t *src;
+  rows = VPXMIN(rows, sd->y_crop_height - row);
+  if (rows <= 0) return 0;
+  src = plane_pos(sd->y_buffer, sd->y_stride, row, 0, search->highbd);
+#if CONFIG_VP9_HIGHBITDEPTH
+  if (search->highbd)
+    return vpx_highbd_get_sse(src, sd->y_stride, buf, stride,
+                              sd->y_crop_width, rows);
+#endif  // CONFIG_VP9_HIGHBITDEPTH
+  return vpx_get_sse(src, sd->y_stride, buf, stride, sd->y_crop_width, rows);
+}
 
-  if (cpi->num_workers > 1)
-    vp9_loop_filter_frame_mt(cm->frame_to_show, cm, cpi->td.mb.e_mbd.plane,
-                             filt_level, 1, partial_frame, cpi->workers,
-                             cpi->num_workers, &cpi->lf_row_sync);
-  else
-    vp9_loop_filter_frame(cm->frame_to_show, cm, &cpi->td.mb.e_mbd, filt_level,
-                          1, partial_frame);
+static void filter_level_job(void *data, int job) {
+  LpfSearch *const search = (LpfSearch *)data;
+  VP9_COMMON *const cm = search->cm;
+  YV12_BUFFER_CONFIG *const frame = cm->frame_to_show;
+  const int highbd = search->highbd;
+  const int stride = search->stripe_stride;
+  const int width = cm->mi_cols << MI_SIZE_LOG2;
+  // Row 0 of the superblock row being filtered. The carried rows are above it.
+  uint8_t *const sb_buf = plane_pos(search->stripes[job], stride,
+                                    LPF_CARRY_ROWS, LPF_STRIPE_BORDER, highbd);
+  int carry = (search->start_mi_row << MI_SIZE_LOG2) - search->top;
+  int64_t err = search->outside_err;
+  loop_filter_info_n lfi;
+  struct macroblockd_plane plane;
+  int mi_row, mi_col;
+
+  if (search->levels[job] == 0) {
+    search->errs[job] =
+        err + get_rows_err(search, search->top,
+                           plane_pos(frame->y_buffer, frame->y_stride,
+                                     search->top, 0, highbd),
+                           frame->y_stride, search->bottom - search->top);
+    return;
+  }
+
+  vp9_loop_filter_set_levels(cm, search->levels[job], &lfi);
+  memset(&plane, 0, sizeof(plane));
+  plane.dst.stride = stride;
+
+  copy_rows(plane_pos(frame->y_buffer, frame->y_stride, search->top, 0, highbd),
+            frame->y_stride, plane_pos(sb_buf, stride, -carry, 0, highbd),
+            stride, width, carry, highbd);
+
+  for (mi_row = search->start_mi_row; mi_row < search->end_mi_row;
+       mi_row += MI_BLOCK_SIZE) {
+    MODE_INFO **const mi = cm->mi_grid_visible + mi_row * cm->mi_stride;
+    const int row = mi_row << MI_SIZE_LOG2;
+    const int rows = VPXMIN(MI_BLOCK_SIZE, cm->mi_rows - mi_row)
+                     << MI_SIZE_LOG2;
+    const int last = mi_row + MI_BLOCK_SIZE >= search->end_mi_row;
+    // Rows that the following superblock row cannot modify any more.
+    const int done = last ? rows : rows - LPF_CARRY_ROWS;
+
+    copy_rows(plane_pos(frame->y_buffer, frame->y_stride, row, 0, highbd),
+              frame->y_stride, sb_buf, stride, width, rows, highbd);
+
+    for (mi_col = 0; mi_col < cm->mi_cols; mi_col += MI_BLOCK_SIZE) {
+      LOOP_FILTER_MASK lfm;
+      vp9_setup_mask_lfi(cm, &lfi, mi_row, mi_col, mi + mi_col, cm->mi_stride,
+                         &lfm);
+      vp9_adjust_mask(cm, mi_row, mi_col, &lfm);
+      plane.dst.buf =
+          plane_pos(sb_buf, stride, 0, mi_col << MI_SIZE_LOG2, highbd);
+      vp9_filter_block_plane_ss00(cm, &plane, mi_row, &lfm);
+    }
 
+    err += get_rows_err(search, row - carry,
+                        plane_pos(sb_buf, stride, -carry, 0, highbd), stride,
+                        carry + done);
+
+    if (!last) {
+      copy_rows(plane_pos(sb_buf, stride, done, 0, highbd), stride,
+                plane_pos(sb_buf, stride, -LPF_CARRY_ROWS, 0, highbd), stride,
+                width, LPF_CARRY_ROWS, highbd);
+      carry = LPF_CARRY_ROWS;
+    }
+  }
+
+  search->errs[job] = err;
+}
+
+static void init_lpf_search(LpfSearch *search, const YV12_BUFFER_CONFIG *sd,
+                            VP9_COMP *cpi, int partial_frame) {
+  VP9_COMMON *const cm = &cpi->common;
+  YV12_BUFFER_CONFIG *const frame = cm->frame_to_show;
+  int mi_rows_to_filter = cm->mi_rows;
+  int bytes_per_sample = 1;
+  int i;
+
+  memset(search, 0, sizeof(*search));
+  search->cm = cm;
+  search->sd = sd;
 #if CONFIG_VP9_HIGHBITDEPTH
-  if (cm->use_highbitdepth) {
-    filt_err = vpx_highbd_get_y_sse(sd, cm->frame_to_show);
-  } else {
-    filt_err = vpx_get_y_sse(sd, cm->frame_to_show);
+  search->highbd = cm->use_highbitdepth;
+  if (search->highbd) bytes_per_sample = sizeof(uint16_t);
+#endif  // CONFIG_VP9_HIGHBITDEPTH
+
+  // Same rows as vp9_loop_filter_frame().
+  if (partial_frame && cm->mi_rows > 8) {
+    search->start_mi_row = (cm->mi_rows >> 1) & 0xfffffff8;
+    mi_rows_to_filter = VPXMAX(cm->mi_rows / 8, 8);
   }
-#else
-  filt_err = vpx_get_y_sse(sd, cm->frame_to_show);
+  search->end_mi_row = search->start_mi_row + mi_rows_to_filter;
+  search->top = VPXMAX((search->start_mi_row << MI_SIZE_LOG2) - LPF_CARRY_ROWS,
+                       0);
+  search->bottom = search->end_mi_row << MI_SIZE_LOG2;
+
+  search->outside_err =
+      get_rows_err(search, 0, frame->y_buffer, frame->y_stride, search->top) +
+      get_rows_err(search, search->bottom,
+                   plane_pos(frame->y_buffer, frame->y_stride, search->bottom,
+                             0, search->highbd),
+                   frame->y_stride, sd->y_crop_height - search->bottom);
+
+  search->stripe_stride = ALIGN_POWER_OF_TWO(
+      (cm->mi_cols << MI_SIZE_LOG2) + 2 * LPF_STRIPE_BORDER, 5);
+  for (i = 0; i < LPF_MAX_LEVELS; ++i) {
+    const size_t size =
+        (size_t)search->stripe_stride * LPF_STRIPE_ROWS * bytes_per_sample;
+    CHECK_MEM_ERROR(cm, search->stripes[i], (uint8_t *)vpx_memalign(32, size));
+    // Keep the columns around the frame defined for the SIMD filters.
+    memset(search->stripes[i], 0, size);
+#if CONFIG_VP9_HIGHBITDEPTH
+    if (search->highbd)
+      search->stripes[i] = CONVERT_TO_BYTEPTR(search->stripes[i]);
 #endif  // CONFIG_VP9_HIGHBITDEPTH
+  }
 
-  // Re-instate the unfiltered frame
-  vpx_yv12_copy_y(&cpi->last_frame_uf, cm->frame_to_show);
+  // Keep the limits in cm->lf_info up to date with the sharpness level.
+  vp9_loop_filter_frame_init(cm, cm->lf.last_filt_level);
+}
 
-  return filt_err;
+static void free_lpf_search(LpfSearch *search) {
+  int i;
+  for (i = 0; i < LPF_MAX_LEVELS; ++i) {
+#if CONFIG_VP9_HIGHBITDEPTH
+    if (search->highbd && search->stripes[i] != NULL) {
+      vpx_free(CONVERT_TO_SHORTPTR(search->stripes[i]));
+      continue;
+    }
+#endif  // CONFIG_VP9_HIGHBITDEPTH
+    vpx_free(search->stripes[i]);
+  }
+}
+
+// Adds |level| to the levels to score in the next pass unless its error is
+// already known.
+static void add_level(LpfSearch *search, int *num_levels, const int64_t *ss_err,
+                      int level) {
+  int i;
+  if (ss_err[level] >= 0) return;
+  for (i = 0; i < *num_levels; ++i)
+    if (search->levels[i] == level) return;
+  assert(*num_levels < LPF_MAX_LEVELS);
+  search->levels[(*num_levels)++] = level;
+}
+
+// Scores the pending levels, one level per worker, and stores their errors in
+// |ss_err|.
+static void try_filter_levels(VP9_COMP *cpi, LpfSearch *search, int num_levels,
+                              int64_t *ss_err) {
+  int i;
+  vp9_run_row_jobs_mt(cpi, filter_level_job, search, num_levels);
+  for (i = 0; i < num_levels; ++i) ss_err[search->levels[i]] = search->errs[i];
 }
 
 static int search_filter_level(const YV12_BUFFER_CONFIG *sd, VP9_COMP *cpi,
@@ -84,6 +289,8 @@ static int search_filter_level(const YV12_BUFFER_CONFIG *sd, VP9_COMP *cpi,
   int filt_direction = 0;
   int64_t best_err;
   int filt_best;
+  LpfSearch search;
+  int num_levels = 0;
 
   // Start the search at the previous frame filter level unless it is now out of
   // range.
@@ -96,12 +303,19 @@ static int search_filter_level(const YV12_BUFFER_CONFIG *sd, VP9_COMP *cpi,
   // Set each entry to -1
   memset(ss_err, 0xFF, sizeof(ss_err));
 
-  //  Make a copy of the unfiltered / processed recon buffer
-  vpx_yv12_copy_y(cm->frame_to_show, &cpi->last_frame_uf);
+  init_lpf_search(&search, sd, cpi, partial_frame);
+
+  // The first step scores both neighbours of the middle level, so score all
+  // three in one pass.
+  add_level(&search, &num_levels, ss_err, filt_mid);
+  add_level(&search, &num_levels, ss_err,
+            VPXMAX(filt_mid - filter_step, min_filter_level));
+  add_level(&search, &num_levels, ss_err,
+            VPXMIN(filt_mid + filter_step, max_filter_level));
+  try_filter_levels(cpi, &search, num_levels, ss_err);
 
-  best_err = try_filter_frame(sd, cpi, filt_mid, partial_frame);
+  best_err = ss_err[filt_mid];
   filt_best = filt_mid;
-  ss_err[filt_mid] = best_err;
 
   while (filter_step > 0) {
     const int filt_high = VPXMIN(filt_mid + filter_step, max_filter_level);
@@ -116,11 +330,15 @@ static int search_filter_level(const YV12_BUFFER_CONFIG *sd, VP9_COMP *cpi,
     // yx, bias less for large block size
     if (cm->tx_mode != ONLY_4X4) bias >>= 1;
 
+    // Get the error scores of the levels this step looks at.
+    num_levels = 0;
+    if (filt_direction <= 0 && filt_low != filt_mid)
+      add_level(&search, &num_levels, ss_err, filt_low);
+    if (filt_direction >= 0 && filt_high != filt_mid)
+      add_level(&search, &num_levels, ss_err, filt_high);
+    try_filter_levels(cpi, &search, num_levels, ss_err);
+
     if (filt_direction <= 0 && filt_low != filt_mid) {
-      // Get Low filter error score
-      if (ss_err[filt_low] < 0) {
-        ss_err[filt_low] = try_filter_frame(sd, cpi, filt_low, partial_frame);
-      }
       // If value is close to the best so far then bias towards a lower loop
       // filter value.
       if ((ss_err[filt_low] - bias) < best_err) {
@@ -133,9 +351,6 @@ static int search_filter_level(const YV12_BUFFER_CONFIG *sd, VP9_COMP *cpi,
 
     // Now look at filt_high
     if (filt_direction >= 0 && filt_high != filt_mid) {
-      if (ss_err[filt_high] < 0) {
-        ss_err[filt_high] = try_filter_frame(sd, cpi, filt_high, partial_frame);
-      }
       // Was it better than the previous best?
       if (ss_err[filt_high] < (best_err - bias)) {
         best_err = ss_err[filt_high];
@@ -153,6 +368,7 @@ static int search_filter_level(const YV12_BUFFER_CONFIG *sd, VP9_COMP *cpi,
     }
   }
 
+  free_lpf_search(&search);
   return filt_best;
 }
 
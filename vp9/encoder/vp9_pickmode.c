@@ -34,6 +34,7 @@
 #include "vp9/encoder/vp9_pickmode.h"
 #include "vp9/encoder/vp9_ratectrl.h"
 #include "vp9/encoder/vp9_rd.h"
+#include "vp9/encoder/vp9_temporal_mv.h"
 
 typedef struct {
   uint8_t *data;
@@ -190,11 +191,13 @@ static int combined_motion_search(VP9_COMP *cpi, MACROBLOCK *x,
     x->mv_limits.row_max = VPXMIN(x->mv_limits.row_max, 10);
   }
 
-  assert(x->mv_best_ref_index[ref] <= 2);
+  assert(x->mv_best_ref_index[ref] <= 3);
   if (x->mv_best_ref_index[ref] < 2)
     mvp_full = x->mbmi_ext->ref_mvs[ref][x->mv_best_ref_index[ref]].as_mv;
-  else
+  else if (x->mv_best_ref_index[ref] == 2)
     mvp_full = x->pred_mv[ref];
+  else
+    mvp_full = x->temporal_pred_mv;
 
   mvp_full.col >>= 3;
   mvp_full.row >>= 3;
@@ -1255,6 +1258,32 @@ static const REF_MODE ref_mode_set_svc[RT_INTER_MODES_SVC] = {
   { LAST_FRAME, NEWMV },       { GOLDEN_FRAME, NEWMV }
 };
 
+// Starts the motion search relative to LAST from the motion predicted from the
+// previous frame if it matches better than the candidates of vp9_mv_pred().
+static void temporal_mv_pred(VP9_COMP *cpi, MACROBLOCK *x,
+                             const uint8_t *ref_y_buffer, int ref_y_stride,
+                             BLOCK_SIZE bsize, int mi_row, int mi_col) {
+  const int_mv mv =
+      vp9_temporal_mv_get(&cpi->temporal_mv_map, mi_row, mi_col, bsize);
+  MV full_mv;
+  unsigned int sad;
+
+  if (mv.as_int == INVALID_MV) return;
+  full_mv.row = (mv.as_mv.row + 4) >> 3;
+  full_mv.col = (mv.as_mv.col + 4) >> 3;
+  clamp_mv(&full_mv, x->mv_limits.col_min, x->mv_limits.col_max,
+           x->mv_limits.row_min, x->mv_limits.row_max);
+  sad = cpi->fn_ptr[bsize].sdf(
+      x->plane[0].src.buf, x->plane[0].src.stride,
+      ref_y_buffer + full_mv.row * ref_y_stride + full_mv.col, ref_y_stride);
+  if (sad < (unsigned int)x->pred_mv_sad[LAST_FRAME]) {
+    x->pred_mv_sad[LAST_FRAME] = (int)sad;
+    x->mv_best_ref_index[LAST_FRAME] = 3;
+    x->temporal_pred_mv.row = full_mv.row * 8;
+    x->temporal_pred_mv.col = full_mv.col * 8;
+  }
+}
+
 static INLINE void find_predictors(
     VP9_COMP *cpi, MACROBLOCK *x, MV_REFERENCE_FRAME ref_frame,
     int_mv frame_mv[MB_MODE_COUNT][MAX_REF_FRAMES],
@@ -1292,6 +1321,9 @@ static INLINE void find_predictors(
         !(force_skip_low_temp_var && ref_frame == GOLDEN_FRAME)) {
       vp9_mv_pred(cpi, x, yv12_mb[ref_frame][0].buf, yv12->y_stride, ref_frame,
                   bsize);
+      if (ref_frame == LAST_FRAME && cpi->temporal_mv_map.valid)
+        temporal_mv_pred(cpi, x, yv12_mb[ref_frame][0].buf, yv12->y_stride,
+                         bsize, mi_row, mi_col);
     }
   } else {
     *ref_frame_skip_mask |= (1 << ref_frame);
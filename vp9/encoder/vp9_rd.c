@@ -11,6 +11,7 @@
 #include <assert.h>
 #include <math.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "./vp9_rtcd.h"
 
@@ -89,51 +90,85 @@ static const uint8_t rd_thresh_block_size_factor[BLOCK_SIZES] = {
   2, 3, 3, 4, 6, 6, 8, 12, 12, 16, 24, 24, 32
 };
 
+// Returns whether the n probabilities differ from the cached copy the cost
+// tables were built from, and updates the copy.
+static int probs_changed(vpx_prob *cached, const vpx_prob *probs, size_t n,
+                         int cache_valid) {
+  if (cache_valid && !memcmp(cached, probs, n)) return 0;
+  memcpy(cached, probs, n);
+  return 1;
+}
+
 static void fill_mode_costs(VP9_COMP *cpi) {
   const FRAME_CONTEXT *const fc = cpi->common.fc;
+  RD_COST_CACHE *const cache = &cpi->rd.cost_cache;
+  const int valid = cache->mode_costs_valid;
   int i, j;
 
-  for (i = 0; i < INTRA_MODES; ++i) {
-    for (j = 0; j < INTRA_MODES; ++j) {
-      vp9_cost_tokens(cpi->y_mode_costs[i][j], vp9_kf_y_mode_prob[i][j],
-                      vp9_intra_mode_tree);
+  // The key frame probabilities are constant.
+  if (!valid) {
+    for (i = 0; i < INTRA_MODES; ++i) {
+      for (j = 0; j < INTRA_MODES; ++j) {
+        vp9_cost_tokens(cpi->y_mode_costs[i][j], vp9_kf_y_mode_prob[i][j],
+                        vp9_intra_mode_tree);
+      }
+      vp9_cost_tokens(cpi->intra_uv_mode_cost[KEY_FRAME][i],
+                      vp9_kf_uv_mode_prob[i], vp9_intra_mode_tree);
     }
   }
 
-  vp9_cost_tokens(cpi->mbmode_cost, fc->y_mode_prob[1], vp9_intra_mode_tree);
+  if (probs_changed(cache->y_mode_prob, fc->y_mode_prob[1],
+                    sizeof(cache->y_mode_prob), valid)) {
+    vp9_cost_tokens(cpi->mbmode_cost, fc->y_mode_prob[1], vp9_intra_mode_tree);
+  }
   for (i = 0; i < INTRA_MODES; ++i) {
-    vp9_cost_tokens(cpi->intra_uv_mode_cost[KEY_FRAME][i],
-                    vp9_kf_uv_mode_prob[i], vp9_intra_mode_tree);
-    vp9_cost_tokens(cpi->intra_uv_mode_cost[INTER_FRAME][i],
-                    fc->uv_mode_prob[i], vp9_intra_mode_tree);
+    if (probs_changed(cache->uv_mode_prob[i], fc->uv_mode_prob[i],
+                      sizeof(cache->uv_mode_prob[i]), valid)) {
+      vp9_cost_tokens(cpi->intra_uv_mode_cost[INTER_FRAME][i],
+                      fc->uv_mode_prob[i], vp9_intra_mode_tree);
+    }
   }
 
   for (i = 0; i < SWITCHABLE_FILTER_CONTEXTS; ++i) {
-    vp9_cost_tokens(cpi->switchable_interp_costs[i],
-                    fc->switchable_interp_prob[i], vp9_switchable_interp_tree);
+    if (probs_changed(cache->switchable_interp_prob[i],
+                      fc->switchable_interp_prob[i],
+                      sizeof(cache->switchable_interp_prob[i]), valid)) {
+      vp9_cost_tokens(cpi->switchable_interp_costs[i],
+                      fc->switchable_interp_prob[i],
+                      vp9_switchable_interp_tree);
+    }
   }
 
-  for (i = TX_8X8; i < TX_SIZES; ++i) {
-    for (j = 0; j < TX_SIZE_CONTEXTS; ++j) {
-      const vpx_prob *tx_probs = get_tx_probs(i, j, &fc->tx_probs);
-      int k;
-      for (k = 0; k <= i; ++k) {
-        int cost = 0;
-        int m;
-        for (m = 0; m <= k - (k == i); ++m) {
-          if (m == k)
-            cost += vp9_cost_zero(tx_probs[m]);
-          else
-            cost += vp9_cost_one(tx_probs[m]);
+  if (probs_changed((vpx_prob *)&cache->tx_probs,
+                    (const vpx_prob *)&fc->tx_probs, sizeof(cache->tx_probs),
+                    valid)) {
+    for (i = TX_8X8; i < TX_SIZES; ++i) {
+      for (j = 0; j < TX_SIZE_CONTEXTS; ++j) {
+        const vpx_prob *tx_probs = get_tx_probs(i, j, &fc->tx_probs);
+        int k;
+        for (k = 0; k <= i; ++k) {
+          int cost = 0;
+          int m;
+          for (m = 0; m <= k - (k == i); ++m) {
+            if (m == k)
+              cost += vp9_cost_zero(tx_probs[m]);
+            else
+              cost += vp9_cost_one(tx_probs[m]);
+          }
+          cpi->tx_size_cost[i - 1][j][k] = cost;
         }
-        cpi->tx_size_cost[i - 1][j][k] = cost;
       }
     }
   }
+
+  cache->mode_costs_valid = 1;
 }
 
+// Only the contexts whose probabilities changed since the last call are
+// rebuilt.
 static void fill_token_costs(vp9_coeff_cost *c,
-                             vp9_coeff_probs_model (*p)[PLANE_TYPES]) {
+                             vp9_coeff_probs_model (*p)[PLANE_TYPES],
+                             RD_COST_CACHE *cache) {
   int i, j, k, l;
   TX_SIZE t;
   for (t = TX_4X4; t <= TX_32X32; ++t)
@@ -142,6 +177,11 @@ static void fill_token_costs(vp9_coeff_cost *c,
         for (k = 0; k < COEF_BANDS; ++k)
           for (l = 0; l < BAND_COEFF_CONTEXTS(k); ++l) {
             vpx_prob probs[ENTROPY_NODES];
+            if (!probs_changed(cache->coef_probs[t][i][j][k][l],
+                               p[t][i][j][k][l], UNCONSTRAINED_NODES,
+                               cache->token_costs_valid)) {
+              continue;
+            }
             vp9_model_to_full_probs(p[t][i][j][k][l], probs);
             vp9_cost_tokens((int *)c[t][i][j][k][0][l], probs, vp9_coef_tree);
             vp9_cost_tokens_skip((int *)c[t][i][j][k][1][l], probs,
@@ -149,6 +189,7 @@ static void fill_token_costs(vp9_coeff_cost *c,
             assert(c[t][i][j][k][0][l][EOB_TOKEN] ==
                    c[t][i][j][k][1][l][EOB_TOKEN]);
           }
+  cache->token_costs_valid = 1;
 }
 
 // Values are now correlated to quantizer.
@@ -386,11 +427,35 @@ static void set_block_thresholds(const VP9_COMMON *cm, RD_OPT *rd) {
 
 void vp9_build_inter_mode_cost(VP9_COMP *cpi) {
   const VP9_COMMON *const cm = &cpi->common;
+  RD_COST_CACHE *const cache = &cpi->rd.cost_cache;
   int i;
   for (i = 0; i < INTER_MODE_CONTEXTS; ++i) {
-    vp9_cost_tokens((int *)cpi->inter_mode_cost[i], cm->fc->inter_mode_probs[i],
-                    vp9_inter_mode_tree);
+    if (probs_changed(cache->inter_mode_probs[i], cm->fc->inter_mode_probs[i],
+                      sizeof(cache->inter_mode_probs[i]),
+                      cache->inter_mode_costs_valid)) {
+      vp9_cost_tokens((int *)cpi->inter_mode_cost[i],
+                      cm->fc->inter_mode_probs[i], vp9_inter_mode_tree);
+    }
+  }
+  cache->inter_mode_costs_valid = 1;
+}
+
+static void build_mv_costs(VP9_COMP *cpi) {
+  const VP9_COMMON *const cm = &cpi->common;
+  MACROBLOCK *const x = &cpi->td.mb;
+  RD_COST_CACHE *const cache = &cpi->rd.cost_cache;
+  const int usehp = cm->allow_high_precision_mv;
+
+  if (cache->mv_costs_valid && cache->mv_allow_hp == usehp &&
+      !memcmp(&cache->nmvc, &cm->fc->nmvc, sizeof(cache->nmvc))) {
+    return;
   }
+  vp9_build_nmv_cost_table(x->nmvjointcost,
+                           usehp ? x->nmvcost_hp : x->nmvcost, &cm->fc->nmvc,
+                           usehp);
+  cache->nmvc = cm->fc->nmvc;
+  cache->mv_allow_hp = usehp;
+  cache->mv_costs_valid = 1;
 }
 
 void vp9_initialize_rd_consts(VP9_COMP *cpi) {
@@ -416,14 +481,10 @@ void vp9_initialize_rd_consts(VP9_COMP *cpi) {
   set_partition_probs(cm, xd);
 
   if (cpi->oxcf.pass == 1) {
-    if (!frame_is_intra_only(cm))
-      vp9_build_nmv_cost_table(
-          x->nmvjointcost,
-          cm->allow_high_precision_mv ? x->nmvcost_hp : x->nmvcost,
-          &cm->fc->nmvc, cm->allow_high_precision_mv);
+    if (!frame_is_intra_only(cm)) build_mv_costs(cpi);
   } else {
     if (!cpi->sf.use_nonrd_pick_mode || cm->frame_type == KEY_FRAME)
-      fill_token_costs(x->token_costs, cm->fc->coef_probs);
+      fill_token_costs(x->token_costs, cm->fc->coef_probs, &rd->cost_cache);
 
     if (cpi->sf.partition_search_type != VAR_BASED_PARTITION ||
         cm->frame_type == KEY_FRAME) {
@@ -437,10 +498,7 @@ void vp9_initialize_rd_consts(VP9_COMP *cpi) {
       fill_mode_costs(cpi);
 
       if (!frame_is_intra_only(cm)) {
-        vp9_build_nmv_cost_table(
-            x->nmvjointcost,
-            cm->allow_high_precision_mv ? x->nmvcost_hp : x->nmvcost,
-            &cm->fc->nmvc, cm->allow_high_precision_mv);
+        build_mv_costs(cpi);
         vp9_build_inter_mode_cost(cpi);
       }
     }
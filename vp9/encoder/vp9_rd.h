@@ -108,6 +108,27 @@ typedef struct {
   double rd_mult_key_qp_fac;
 } RD_CONTROL;
 
+// The probabilities the rate cost tables were last built from. The tables only
+// depend on these, so each part is rebuilt only when its probabilities change.
+typedef struct RD_COST_CACHE {
+  int token_costs_valid;
+  vp9_coeff_probs_model coef_probs[TX_SIZES][PLANE_TYPES];
+
+  int mode_costs_valid;
+  vpx_prob y_mode_prob[INTRA_MODES - 1];
+  vpx_prob uv_mode_prob[INTRA_MODES][INTRA_MODES - 1];
+  vpx_prob switchable_interp_prob[SWITCHABLE_FILTER_CONTEXTS]
+                                 [SWITCHABLE_FILTERS - 1];
+  struct tx_probs tx_probs;
+
+  int inter_mode_costs_valid;
+  vpx_prob inter_mode_probs[INTER_MODE_CONTEXTS][INTER_MODES - 1];
+
+  int mv_costs_valid;
+  int mv_allow_hp;
+  nmv_context nmvc;
+} RD_COST_CACHE;
+
 typedef struct RD_OPT {
   // Thresh_mult is used to set a threshold for the rd score. A higher value
   // means that we will accept the best mode so far more often. This number
@@ -127,6 +148,8 @@ typedef struct RD_OPT {
   int RDMULT;
   int RDDIV;
   double r0;
+
+  RD_COST_CACHE cost_cache;
 } RD_OPT;
 
 typedef struct RD_COST {
@@ -0,0 +1,259 @@
+/*
+ *  Copyright (c) 2023 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "./vp9_rtcd.h"
+#include "./vpx_config.h"
+#include "vpx_dsp/vpx_dsp_common.h"
+#include "vpx_mem/vpx_mem.h"
+#include "vpx_ports/mem.h"
+#include "vp9/encoder/vp9_encoder.h"
+#include "vp9/encoder/vp9_ethread.h"
+#include "vp9/encoder/vp9_ratectrl.h"
+#include "vp9/encoder/vp9_spatial_denoise.h"
+
+// Number of pixels read around each filtered pixel.
+#define DENOISE_BORDER 3
+#define DENOISE_BAND_ROWS 16
+
+// Baseline kernel weights for denoise
+static const uint8_t dn_kernal_3[9] = { 1, 2, 1, 2, 4, 2, 1, 2, 1 };
+static const uint8_t dn_kernal_5[25] = { 1, 1, 1, 1, 1, 1, 1, 2, 1, 1, 1, 2, 4,
+                                         2, 1, 1, 1, 2, 1, 1, 1, 1, 1, 1, 1 };
+
+static INLINE void add_denoise_point(int centre_val, int data_val, int thresh,
+                                     uint8_t point_weight, int *sum_val,
+                                     int *sum_weight) {
+  if (abs(centre_val - data_val) <= thresh) {
+    *sum_weight += point_weight;
+    *sum_val += (int)data_val * (int)point_weight;
+  }
+}
+
+static INLINE int spatial_denoise_point(const uint8_t *src_ptr,
+                                        const int stride, const int strength) {
+  int sum_weight = 0;
+  int sum_val = 0;
+  int thresh = strength;
+  int kernal_size = 5;
+  int half_k_size = 2;
+  int i, j;
+  int max_diff = 0;
+  const uint8_t *tmp_ptr;
+  const uint8_t *kernal_ptr;
+
+  // Find the maximum deviation from the source point in the locale.
+  tmp_ptr = src_ptr - (stride * (half_k_size + 1)) - (half_k_size + 1);
+  for (i = 0; i < kernal_size + 2; ++i) {
+    for (j = 0; j < kernal_size + 2; ++j) {
+      max_diff = VPXMAX(max_diff, abs((int)*src_ptr - (int)tmp_ptr[j]));
+    }
+    tmp_ptr += stride;
+  }
+
+  // Select the kernel size.
+  if (max_diff > (strength + (strength >> 1))) {
+    kernal_size = 3;
+    half_k_size = 1;
+    thresh = thresh >> 1;
+  }
+  kernal_ptr = (kernal_size == 3) ? dn_kernal_3 : dn_kernal_5;
+
+  // Apply the kernel
+  tmp_ptr = src_ptr - (stride * half_k_size) - half_k_size;
+  for (i = 0; i < kernal_size; ++i) {
+    for (j = 0; j < kernal_size; ++j) {
+      add_denoise_point((int)*src_ptr, (int)tmp_ptr[j], thresh, *kernal_ptr,
+                        &sum_val, &sum_weight);
+      ++kernal_ptr;
+    }
+    tmp_ptr += stride;
+  }
+
+  // The new filtered value.
+  return (sum_val + (sum_weight >> 1)) / sum_weight;
+}
+
+void vp9_spatial_denoise_row_c(const uint8_t *src, int src_stride,
+                               uint8_t *dst, int width, int strength) {
+  int col;
+  for (col = 0; col < width; ++col)
+    dst[col] = (uint8_t)spatial_denoise_point(&src[col], src_stride, strength);
+}
+
+#if CONFIG_VP9_HIGHBITDEPTH
+static int highbd_spatial_denoise_point(const uint16_t *src_ptr,
+                                        const int stride, const int strength) {
+  int sum_weight = 0;
+  int sum_val = 0;
+  int thresh = strength;
+  int kernal_size = 5;
+  int half_k_size = 2;
+  int i, j;
+  int max_diff = 0;
+  const uint16_t *tmp_ptr;
+  const uint8_t *kernal_ptr;
+
+  // Find the maximum deviation from the source point in the locale.
+  tmp_ptr = src_ptr - (stride * (half_k_size + 1)) - (half_k_size + 1);
+  for (i = 0; i < kernal_size + 2; ++i) {
+    for (j = 0; j < kernal_size + 2; ++j) {
+      max_diff = VPXMAX(max_diff, abs((int)*src_ptr - (int)tmp_ptr[j]));
+    }
+    tmp_ptr += stride;
+  }
+
+  // Select the kernel size.
+  if (max_diff > (strength + (strength >> 1))) {
+    kernal_size = 3;
+    half_k_size = 1;
+    thresh = thresh >> 1;
+  }
+  kernal_ptr = (kernal_size == 3) ? dn_kernal_3 : dn_kernal_5;
+
+  // Apply the kernel
+  tmp_ptr = src_ptr - (stride * half_k_size) - half_k_size;
+  for (i = 0; i < kernal_size; ++i) {
+    for (j = 0; j < kernal_size; ++j) {
+      add_denoise_point((int)*src_ptr, (int)tmp_ptr[j], thresh, *kernal_ptr,
+                        &sum_val, &sum_weight);
+      ++kernal_ptr;
+    }
+    tmp_ptr += stride;
+  }
+
+  // The new filtered value.
+  return (sum_val + (sum_weight >> 1)) / sum_weight;
+}
+#endif  // CONFIG_VP9_HIGHBITDEPTH
+
+typedef struct DenoisePlaneJob {
+  // Unfiltered copy of the plane including DENOISE_BORDER pixels on each side,
+  // holding uint16_t samples for high bitdepth.
+  uint8_t *copy;
+  int copy_stride;
+  // Plane to filter, in the CONVERT_TO_BYTEPTR() form for high bitdepth.
+  uint8_t *buf;
+  int stride;
+  int width;
+  int height;
+  int strength;
+  int use_highbitdepth;
+} DenoisePlaneJob;
+
+static void copy_plane_band(void *data, int band) {
+  const DenoisePlaneJob *const job = (const DenoisePlaneJob *)data;
+  const int rows = job->height + 2 * DENOISE_BORDER;
+  const int cols = job->width + 2 * DENOISE_BORDER;
+  const int row_end = VPXMIN((band + 1) * DENOISE_BAND_ROWS, rows);
+  int row;
+
+  for (row = band * DENOISE_BAND_ROWS; row < row_end; ++row) {
+    const int src_offset =
+        (row - DENOISE_BORDER) * job->stride - DENOISE_BORDER;
+#if CONFIG_VP9_HIGHBITDEPTH
+    if (job->use_highbitdepth) {
+      memcpy((uint16_t *)job->copy + row * job->copy_stride,
+             CONVERT_TO_SHORTPTR(job->buf) + src_offset,
+             cols * sizeof(uint16_t));
+      continue;
+    }
+#endif  // CONFIG_VP9_HIGHBITDEPTH
+    memcpy(job->copy + row * job->copy_stride, job->buf + src_offset, cols);
+  }
+}
+
+static void denoise_plane_band(void *data, int band) {
+  const DenoisePlaneJob *const job = (const DenoisePlaneJob *)data;
+  const int row_end = VPXMIN((band + 1) * DENOISE_BAND_ROWS, job->height);
+  const int copy_offset = DENOISE_BORDER * job->copy_stride + DENOISE_BORDER;
+  int row;
+
+  for (row = band * DENOISE_BAND_ROWS; row < row_end; ++row) {
+#if CONFIG_VP9_HIGHBITDEPTH
+    if (job->use_highbitdepth) {
+      const uint16_t *const src =
+          (const uint16_t *)job->copy + copy_offset + row * job->copy_stride;
+      uint16_t *const dst = CONVERT_TO_SHORTPTR(job->buf) + row * job->stride;
+      int col;
+      for (col = 0; col < job->width; ++col) {
+        dst[col] = (uint16_t)highbd_spatial_denoise_point(
+            &src[col], job->copy_stride, job->strength);
+      }
+      continue;
+    }
+#endif  // CONFIG_VP9_HIGHBITDEPTH
+    vp9_spatial_denoise_row(job->copy + copy_offset + row * job->copy_stride,
+                            job->copy_stride, job->buf + row * job->stride,
+                            job->width, job->strength);
+  }
+}
+
+// Apply thresholded spatial noise suppression to a given buffer. Every pixel is
+// filtered from the unfiltered values of its neighbours, so the row bands can
+// be processed in any order.
+static void spatial_denoise_buffer(VP9_COMP *cpi, uint8_t *buffer,
+                                   const int stride, const int width,
+                                   const int height, const int strength) {
+  VP9_COMMON *const cm = &cpi->common;
+  DenoisePlaneJob job;
+  int bytes_per_sample = 1;
+#if CONFIG_VP9_HIGHBITDEPTH
+  if (cm->use_highbitdepth) bytes_per_sample = sizeof(uint16_t);
+  job.use_highbitdepth = cm->use_highbitdepth;
+#else
+  job.use_highbitdepth = 0;
+#endif  // CONFIG_VP9_HIGHBITDEPTH
+
+  job.copy_stride = width + 2 * DENOISE_BORDER;
+  job.buf = buffer;
+  job.stride = stride;
+  job.width = width;
+  job.height = height;
+  job.strength = strength;
+  CHECK_MEM_ERROR(cm, job.copy,
+                  (uint8_t *)vpx_malloc(job.copy_stride *
+                                        (height + 2 * DENOISE_BORDER) *
+                                        bytes_per_sample));
+
+  vp9_run_row_jobs_mt(cpi, copy_plane_band, &job,
+                      (height + 2 * DENOISE_BORDER + DENOISE_BAND_ROWS - 1) /
+                          DENOISE_BAND_ROWS);
+  vp9_run_row_jobs_mt(cpi, denoise_plane_band, &job,
+                      (height + DENOISE_BAND_ROWS - 1) / DENOISE_BAND_ROWS);
+
+  vpx_free(job.copy);
+}
+
+void vp9_spatial_denoise_frame(VP9_COMP *cpi) {
+  YV12_BUFFER_CONFIG *src = cpi->Source;
+  const VP9EncoderConfig *const oxcf = &cpi->oxcf;
+  TWO_PASS *const twopass = &cpi->twopass;
+  VP9_COMMON *const cm = &cpi->common;
+
+  // Base the filter strength on the current active max Q.
+  const int q = (int)(vp9_convert_qindex_to_q(twopass->active_worst_quality,
+                                              cm->bit_depth));
+  int strength =
+      VPXMAX(oxcf->arnr_strength >> 2, VPXMIN(oxcf->arnr_strength, (q >> 4)));
+
+  // Denoise each of Y,U and V buffers.
+  spatial_denoise_buffer(cpi, src->y_buffer, src->y_stride, src->y_width,
+                         src->y_height, strength);
+
+  strength += (strength >> 1);
+  spatial_denoise_buffer(cpi, src->u_buffer, src->uv_stride, src->uv_width,
+                         src->uv_height, strength << 1);
+
+  spatial_denoise_buffer(cpi, src->v_buffer, src->uv_stride, src->uv_width,
+                         src->uv_height, strength << 1);
+}
@@ -0,0 +1,29 @@
+/*
+ *  Copyright (c) 2023 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef VPX_VP9_ENCODER_VP9_SPATIAL_DENOISE_H_
+#define VPX_VP9_ENCODER_VP9_SPATIAL_DENOISE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct VP9_COMP;
+
+// Applies thresholded spatial noise suppression to cpi->Source, with the
+// filter strength based on the current active max Q. The planes are split
+// into row bands that are filtered on the encoder workers.
+void vp9_spatial_denoise_frame(struct VP9_COMP *cpi);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // VPX_VP9_ENCODER_VP9_SPATIAL_DENOISE_H_
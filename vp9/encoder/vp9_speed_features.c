@@ -335,6 +335,7 @@ static void set_good_speed_feature_framesize_independent(VP9_COMP *cpi,
     sf->comp_inter_joint_search_iter_level = 2;
     sf->auto_min_max_partition_size = RELAXED_NEIGHBORING_MIN_MAX;
     sf->recode_tolerance_high = 45;
+    sf->recode_partition_reuse_qthresh = 16;
     sf->enhanced_full_pixel_motion_search = 0;
     sf->prune_ref_frame_for_rect_partitions = 0;
     sf->rd_ml_partition.prune_rect_thresh[1] = -1;
@@ -657,6 +658,9 @@ static void set_rt_speed_feature_framesize_independent(
     }
     if (cm->width * cm->height > 1280 * 720) sf->cb_pred_filter_search = 2;
     if (!cpi->external_resize) sf->use_source_sad = 1;
+    // The motion of the previous frame is only used without layers, where
+    // LAST is the previous frame.
+    if (!cpi->use_svc) sf->temporal_mv_pred = 1;
   }
 
   if (speed >= 6) {
@@ -793,6 +797,7 @@ static void set_rt_speed_feature_framesize_independent(
   }
 
   if (speed >= 9) {
+    sf->temporal_mv_pred = 0;
     // Only keep INTRA_DC mode for speed 9.
     if (!is_keyframe) {
       int i = 0;
@@ -997,6 +1002,7 @@ void vp9_set_speed_features_framesize_independent(VP9_COMP *cpi, int speed) {
   // Recode loop tolerance %.
   sf->recode_tolerance_low = 12;
   sf->recode_tolerance_high = 25;
+  sf->recode_partition_reuse_qthresh = 0;
   sf->default_interp_filter = SWITCHABLE;
   sf->simple_model_rd_from_var = 0;
   sf->short_circuit_flat_blocks = 0;
@@ -1004,6 +1010,7 @@ void vp9_set_speed_features_framesize_independent(VP9_COMP *cpi, int speed) {
   sf->limit_newmv_early_exit = 0;
   sf->bias_golden = 0;
   sf->base_mv_aggressive = 0;
+  sf->temporal_mv_pred = 0;
   sf->rd_ml_partition.prune_rect_thresh[0] = -1;
   sf->rd_ml_partition.prune_rect_thresh[1] = -1;
   sf->rd_ml_partition.prune_rect_thresh[2] = -1;
@@ -512,6 +512,12 @@ typedef struct SPEED_FEATURES {
   int recode_tolerance_low;
   int recode_tolerance_high;
 
+  // When a frame is recoded with a q index that differs from the one of the
+  // last full partition search by at most this amount, the partitioning of
+  // that search is reused and only the mode decisions, quantization and
+  // tokenization are redone. 0 disables the reuse.
+  int recode_partition_reuse_qthresh;
+
   // This variable controls the maximum block size where intra blocks can be
   // used in inter frames.
   // TODO(aconverse): Fold this into one of the other many mode skips
@@ -596,6 +602,10 @@ typedef struct SPEED_FEATURES {
   // enhancement layer.
   int base_mv_aggressive;
 
+  // Predict the motion of each block from the motion field of the previous
+  // frame, as an extra start for the motion search relative to LAST.
+  int temporal_mv_pred;
+
   // Global flag to enable partition copy from the previous frame.
   int copy_partition_flag;
 
@@ -0,0 +1,231 @@
+/*
+ *  Copyright (c) 2023 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <string.h>
+
+#include "vpx_dsp/vpx_dsp_common.h"
+#include "vpx_dsp/vpx_filter.h"
+#include "vpx_mem/vpx_mem.h"
+
+#include "vp9/common/vp9_common.h"
+#include "vp9/common/vp9_onyxc_int.h"
+#include "vp9/encoder/vp9_subpel_cache.h"
+
+// Distance in 1/8 pel between the cached positions.
+static INLINE int position_step(SUBPEL_CACHE_LEVEL level) {
+  return level == SUBPEL_CACHE_HALF_PEL ? 4 : 2;
+}
+
+static INLINE int position_index(int xoffset, int yoffset) {
+  return (yoffset >> 1) * 4 + (xoffset >> 1);
+}
+
+static void free_ref(SubpelCacheRef *ref) {
+  int i;
+  for (i = 0; i < SUBPEL_CACHE_POSITIONS; ++i) {
+    vpx_free(ref->planes[i]);
+    ref->planes[i] = NULL;
+  }
+  vpx_free(ref->band_ready);
+  ref->band_ready = NULL;
+  ref->plane_size = 0;
+  ref->num_bands = 0;
+}
+
+static void alloc_ref(SubpelCacheRef *ref, SUBPEL_CACHE_LEVEL level,
+                      int stride, int rows, VP9_COMMON *cm) {
+  const size_t plane_size = (size_t)stride * rows;
+  const int num_bands =
+      (rows + SUBPEL_CACHE_BAND_ROWS - 1) / SUBPEL_CACHE_BAND_ROWS;
+  const int step = position_step(level);
+  int xoffset, yoffset;
+
+  if (ref->plane_size != plane_size) free_ref(ref);
+  if (ref->num_bands != num_bands) {
+    vpx_free(ref->band_ready);
+    ref->band_ready = NULL;
+    ref->num_bands = 0;
+    CHECK_MEM_ERROR(cm, ref->band_ready,
+                    vpx_malloc(num_bands * SUBPEL_CACHE_POSITIONS *
+                               sizeof(*ref->band_ready)));
+    ref->num_bands = num_bands;
+  }
+  for (yoffset = 0; yoffset < 8; yoffset += step) {
+    for (xoffset = 0; xoffset < 8; xoffset += step) {
+      uint8_t **const plane = &ref->planes[position_index(xoffset, yoffset)];
+      if ((xoffset | yoffset) == 0 || *plane != NULL) continue;
+      CHECK_MEM_ERROR(cm, *plane, vpx_malloc(plane_size));
+    }
+  }
+  ref->plane_size = plane_size;
+}
+
+// Builds the rows of |band| of the plane of the position (xoffset, yoffset)
+// in the same two passes as vpx_sub_pixel_variance(). The last pixel of a row
+// and the last row of the buffer are interpolated with themselves, which no
+// block reads.
+static void build_band(SubpelCache *cache, const SubpelCacheRef *ref,
+                       int band, int xoffset, int yoffset) {
+  const int stride = ref->stride;
+  const int row_start = band * SUBPEL_CACHE_BAND_ROWS;
+  const int rows = VPXMIN(SUBPEL_CACHE_BAND_ROWS, ref->rows - row_start);
+  // The second pass reads one row past the band.
+  const int first_pass_rows =
+      yoffset > 0 ? VPXMIN(rows + 1, ref->rows - row_start) : rows;
+  const uint8_t *const src = ref->base + (size_t)row_start * stride;
+  uint8_t *const dst = ref->planes[position_index(xoffset, yoffset)] +
+                       (size_t)row_start * stride;
+  const uint8_t *first_pass = src;
+  int r, c;
+
+  if (xoffset > 0) {
+    const int f1 = xoffset << 4;
+    const int f0 = (1 << FILTER_BITS) - f1;
+    uint8_t *const out = yoffset > 0 ? cache->scratch : dst;
+    for (r = 0; r < first_pass_rows; ++r) {
+      const uint8_t *const s = src + r * stride;
+      uint8_t *const d = out + r * stride;
+      for (c = 0; c < stride - 1; ++c) {
+        d[c] = ROUND_POWER_OF_TWO(s[c] * f0 + s[c + 1] * f1, FILTER_BITS);
+      }
+      d[c] = s[c];
+    }
+    first_pass = out;
+  }
+
+  if (yoffset > 0) {
+    const int f1 = yoffset << 4;
+    const int f0 = (1 << FILTER_BITS) - f1;
+    for (r = 0; r < rows; ++r) {
+      const uint8_t *const a = first_pass + r * stride;
+      const uint8_t *const b = r + 1 < first_pass_rows ? a + stride : a;
+      uint8_t *const d = dst + r * stride;
+      for (c = 0; c < stride; ++c) {
+        d[c] = ROUND_POWER_OF_TWO(a[c] * f0 + b[c] * f1, FILTER_BITS);
+      }
+    }
+  }
+}
+
+// The first thread to read a band of a plane builds it, so the interpolation
+// is spread over the threads encoding the frame and the planes of the
+// positions and references no search reaches are never built.
+static void ensure_band(SubpelCache *cache, SubpelCacheRef *ref, int band,
+                        int xoffset, int yoffset) {
+  vpx_atomic_int *const ready =
+      &ref->band_ready[band * SUBPEL_CACHE_POSITIONS +
+                       position_index(xoffset, yoffset)];
+  if (vpx_atomic_load_acquire(ready)) return;
+#if CONFIG_MULTITHREAD
+  pthread_mutex_lock(&cache->mutex);
+#endif
+  if (!vpx_atomic_load_acquire(ready)) {
+    build_band(cache, ref, band, xoffset, yoffset);
+    vpx_atomic_store_release(ready, 1);
+  }
+#if CONFIG_MULTITHREAD
+  pthread_mutex_unlock(&cache->mutex);
+#endif
+}
+
+void vp9_subpel_cache_init(SubpelCache *cache) {
+  memset(cache, 0, sizeof(*cache));
+#if CONFIG_MULTITHREAD
+  pthread_mutex_init(&cache->mutex, NULL);
+#endif
+}
+
+void vp9_subpel_cache_free(SubpelCache *cache) {
+  int i;
+  for (i = 0; i < SUBPEL_CACHE_MAX_REFS; ++i) free_ref(&cache->refs[i]);
+  vpx_free(cache->scratch);
+  cache->scratch = NULL;
+  cache->scratch_size = 0;
+  cache->num_refs = 0;
+#if CONFIG_MULTITHREAD
+  pthread_mutex_destroy(&cache->mutex);
+#endif
+}
+
+void vp9_subpel_cache_setup(SubpelCache *cache, SUBPEL_CACHE_LEVEL level,
+                            const YV12_BUFFER_CONFIG *const *refs,
+                            int num_refs, VP9_COMMON *cm) {
+  int i, j, b;
+
+  cache->num_refs = 0;
+  cache->level = level;
+  if (level == SUBPEL_CACHE_OFF) return;
+
+  for (i = 0; i < num_refs; ++i) {
+    const YV12_BUFFER_CONFIG *const buf = refs[i];
+    const uint8_t *base;
+    SubpelCacheRef *ref;
+    size_t scratch_size;
+
+    if (buf == NULL) continue;
+#if CONFIG_VP9_HIGHBITDEPTH
+    if (buf->flags & YV12_FLAG_HIGHBITDEPTH) continue;
+#endif
+    base = buf->y_buffer - buf->border * buf->y_stride - buf->border;
+    // References sharing a buffer share its planes.
+    for (j = 0; j < cache->num_refs; ++j) {
+      if (cache->refs[j].base == base) break;
+    }
+    if (j < cache->num_refs) continue;
+
+    ref = &cache->refs[cache->num_refs];
+    ref->stride = buf->y_stride;
+    ref->rows = buf->y_height + 2 * buf->border;
+    alloc_ref(ref, level, ref->stride, ref->rows, cm);
+    ref->base = base;
+    ref->end = base + ref->plane_size;
+    for (b = 0; b < ref->num_bands * SUBPEL_CACHE_POSITIONS; ++b) {
+      vpx_atomic_init(&ref->band_ready[b], 0);
+    }
+
+    scratch_size = (size_t)(SUBPEL_CACHE_BAND_ROWS + 1) * ref->stride;
+    if (cache->scratch_size < scratch_size) {
+      vpx_free(cache->scratch);
+      cache->scratch = NULL;
+      cache->scratch_size = 0;
+      CHECK_MEM_ERROR(cm, cache->scratch, vpx_malloc(scratch_size));
+      cache->scratch_size = scratch_size;
+    }
+    ++cache->num_refs;
+  }
+}
+
+void vp9_subpel_cache_clear(SubpelCache *cache) { cache->num_refs = 0; }
+
+const uint8_t *vp9_subpel_cache_get(SubpelCache *cache, const uint8_t *pre,
+                                    int stride, int xoffset, int yoffset) {
+  int i;
+
+  if (cache == NULL || cache->num_refs == 0) return NULL;
+  if ((xoffset | yoffset) & (position_step(cache->level) - 1)) return NULL;
+
+  for (i = 0; i < cache->num_refs; ++i) {
+    SubpelCacheRef *const ref = &cache->refs[i];
+    if (ref->stride == stride && pre >= ref->base && pre < ref->end) {
+      const size_t offset = (size_t)(pre - ref->base);
+      const int row = (int)(offset / stride);
+      // The largest block is 64 rows high.
+      const int last_row = VPXMIN(row + 64, ref->rows) - 1;
+      int band;
+      if ((xoffset | yoffset) == 0) return pre;
+      for (band = row / SUBPEL_CACHE_BAND_ROWS;
+           band <= last_row / SUBPEL_CACHE_BAND_ROWS; ++band) {
+        ensure_band(cache, ref, band, xoffset, yoffset);
+      }
+      return ref->planes[position_index(xoffset, yoffset)] + offset;
+    }
+  }
+  return NULL;
+}
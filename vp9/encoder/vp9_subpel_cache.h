@@ -0,0 +1,95 @@
+/*
+ *  Copyright (c) 2023 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef VPX_VP9_ENCODER_VP9_SUBPEL_CACHE_H_
+#define VPX_VP9_ENCODER_VP9_SUBPEL_CACHE_H_
+
+#include "./vpx_config.h"
+#include "vpx/vpx_integer.h"
+#include "vpx_scale/yv12config.h"
+#include "vpx_util/vpx_atomics.h"
+#include "vpx_util/vpx_thread.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+  SUBPEL_CACHE_OFF = 0,
+  // Caches the 3 half-pel positions.
+  SUBPEL_CACHE_HALF_PEL = 1,
+  // Caches the 15 half-pel and quarter-pel positions.
+  SUBPEL_CACHE_QUARTER_PEL = 2,
+} SUBPEL_CACHE_LEVEL;
+
+// Each interpolated plane is built this many rows at a time, the first time a
+// motion search reads them.
+#define SUBPEL_CACHE_BAND_ROWS 64
+#define SUBPEL_CACHE_MAX_REFS 3
+// One plane per quarter-pel position, the full-pel one being left unused.
+#define SUBPEL_CACHE_POSITIONS 16
+
+// The bilinear interpolation of the luma plane of one reference, including
+// its border. The plane of the position (xoffset, yoffset) in 1/8 pel holds at
+// each pixel what vpx_sub_pixel_variance() computes for it, so the variance of
+// a block can be taken directly from the plane.
+typedef struct SubpelCacheRef {
+  // The start of the reference buffer, border included, and its end.
+  const uint8_t *base;
+  const uint8_t *end;
+  int stride;
+  int rows;
+  uint8_t *planes[SUBPEL_CACHE_POSITIONS];
+  size_t plane_size;
+  // Whether each band of each plane is built.
+  vpx_atomic_int *band_ready;
+  int num_bands;
+} SubpelCacheRef;
+
+typedef struct SubpelCache {
+  SUBPEL_CACHE_LEVEL level;
+  // The references of the frame being encoded. The cache holds no reference
+  // outside of the encoding of a frame.
+  int num_refs;
+  SubpelCacheRef refs[SUBPEL_CACHE_MAX_REFS];
+  // The horizontal pass of the band being built, for the diagonal positions.
+  uint8_t *scratch;
+  size_t scratch_size;
+#if CONFIG_MULTITHREAD
+  pthread_mutex_t mutex;
+#endif
+} SubpelCache;
+
+struct VP9Common;
+
+void vp9_subpel_cache_init(SubpelCache *cache);
+void vp9_subpel_cache_free(SubpelCache *cache);
+
+// Points the cache at the references of the frame about to be encoded. The
+// bands built for the previous frame are discarded.
+void vp9_subpel_cache_setup(SubpelCache *cache, SUBPEL_CACHE_LEVEL level,
+                            const YV12_BUFFER_CONFIG *const *refs,
+                            int num_refs, struct VP9Common *cm);
+
+// Releases the references once the frame is encoded.
+void vp9_subpel_cache_clear(SubpelCache *cache);
+
+// Returns the block at |pre| interpolated at the position (xoffset, yoffset)
+// in 1/8 pel, with the stride of |pre|, or NULL if |pre| is not in a cached
+// reference or the position is not cached. The rows of the largest block are
+// ready to be read, since the callers do not always know the block height.
+const uint8_t *vp9_subpel_cache_get(SubpelCache *cache, const uint8_t *pre,
+                                    int stride, int xoffset, int yoffset);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // VPX_VP9_ENCODER_VP9_SUBPEL_CACHE_H_
@@ -0,0 +1,142 @@
+/*
+ *  Copyright (c) 2023 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "vpx_mem/vpx_mem.h"
+
+#include "vp9/common/vp9_onyxc_int.h"
+#include "vp9/encoder/vp9_encoder.h"
+#include "vp9/encoder/vp9_temporal_mv.h"
+
+// Number of most common vectors counted in a superblock.
+#define SB_CANDIDATES 4
+
+void vp9_temporal_mv_map_free(TemporalMvMap *map) {
+  vpx_free(map->mvs);
+  map->mvs = NULL;
+  vpx_free(map->sb_mvs);
+  map->sb_mvs = NULL;
+  map->mi_rows = 0;
+  map->mi_cols = 0;
+  map->sb_cols = 0;
+  map->valid = 0;
+}
+
+static void alloc_map(TemporalMvMap *map, VP9_COMMON *cm) {
+  const int sb_rows = mi_cols_aligned_to_sb(cm->mi_rows) >> MI_BLOCK_SIZE_LOG2;
+  const int sb_cols = mi_cols_aligned_to_sb(cm->mi_cols) >> MI_BLOCK_SIZE_LOG2;
+  if (map->mi_rows == cm->mi_rows && map->mi_cols == cm->mi_cols) return;
+  vp9_temporal_mv_map_free(map);
+  CHECK_MEM_ERROR(cm, map->mvs,
+                  vpx_malloc(cm->mi_rows * cm->mi_cols * sizeof(*map->mvs)));
+  CHECK_MEM_ERROR(cm, map->sb_mvs,
+                  vpx_malloc(sb_rows * sb_cols * sizeof(*map->sb_mvs)));
+  map->mi_rows = cm->mi_rows;
+  map->mi_cols = cm->mi_cols;
+  map->sb_cols = sb_cols;
+}
+
+// Rounds a distance in 1/8 pel to the nearest number of 8x8 blocks.
+static INLINE int mv_to_mi(int v) {
+  return (v >= 0 ? v + 32 : v - 32) / (8 * MI_SIZE);
+}
+
+static void project_motion_field(TemporalMvMap *map, const MV_REF *prev_mvs) {
+  const int mi_rows = map->mi_rows;
+  const int mi_cols = map->mi_cols;
+  int r, c;
+
+  for (r = 0; r < mi_rows * mi_cols; ++r) map->mvs[r].as_int = INVALID_MV;
+
+  // The block at (r, c) of the previous frame came from (r, c) + mv in the
+  // frame before it, so it should now be at (r, c) - mv, moving by the same
+  // vector relative to the previous frame.
+  for (r = 0; r < mi_rows; ++r) {
+    for (c = 0; c < mi_cols; ++c) {
+      const MV_REF *const prev = &prev_mvs[r * mi_cols + c];
+      int row, col;
+      if (prev->ref_frame[0] != LAST_FRAME) continue;
+      row = r - mv_to_mi(prev->mv[0].as_mv.row);
+      col = c - mv_to_mi(prev->mv[0].as_mv.col);
+      if (row < 0 || row >= mi_rows || col < 0 || col >= mi_cols) continue;
+      map->mvs[row * mi_cols + col] = prev->mv[0];
+    }
+  }
+
+  for (r = 0; r < mi_rows * mi_cols; ++r) {
+    if (map->mvs[r].as_int == INVALID_MV &&
+        prev_mvs[r].ref_frame[0] == LAST_FRAME)
+      map->mvs[r] = prev_mvs[r].mv[0];
+  }
+}
+
+static void find_sb_mvs(TemporalMvMap *map) {
+  const int mi_rows = map->mi_rows;
+  const int mi_cols = map->mi_cols;
+  int mi_row, mi_col;
+
+  for (mi_row = 0; mi_row < mi_rows; mi_row += MI_BLOCK_SIZE) {
+    for (mi_col = 0; mi_col < mi_cols; mi_col += MI_BLOCK_SIZE) {
+      const int row_end = VPXMIN(mi_row + MI_BLOCK_SIZE, mi_rows);
+      const int col_end = VPXMIN(mi_col + MI_BLOCK_SIZE, mi_cols);
+      int_mv *const sb_mv =
+          &map->sb_mvs[(mi_row >> MI_BLOCK_SIZE_LOG2) * map->sb_cols +
+                       (mi_col >> MI_BLOCK_SIZE_LOG2)];
+      int_mv candidates[SB_CANDIDATES];
+      int counts[SB_CANDIDATES] = { 0 };
+      int num_candidates = 0;
+      int best = -1;
+      int r, c, i;
+
+      // Vectors not among the first ones seen are not counted, which is
+      // enough to find the motion shared by most of the superblock.
+      for (r = mi_row; r < row_end; ++r) {
+        for (c = mi_col; c < col_end; ++c) {
+          const int_mv mv = map->mvs[r * mi_cols + c];
+          if (mv.as_int == INVALID_MV) continue;
+          for (i = 0; i < num_candidates; ++i) {
+            if (candidates[i].as_int == mv.as_int) break;
+          }
+          if (i == num_candidates) {
+            if (num_candidates == SB_CANDIDATES) continue;
+            candidates[num_candidates++] = mv;
+          }
+          ++counts[i];
+        }
+      }
+      for (i = 0; i < num_candidates; ++i) {
+        if (best < 0 || counts[i] > counts[best]) best = i;
+      }
+      sb_mv->as_int = best < 0 ? INVALID_MV : candidates[best].as_int;
+    }
+  }
+}
+
+void vp9_temporal_mv_map_build(VP9_COMP *cpi) {
+  VP9_COMMON *const cm = &cpi->common;
+  TemporalMvMap *const map = &cpi->temporal_mv_map;
+  const RefCntBuffer *const prev_frame = cm->prev_frame;
+
+  map->valid = 0;
+  if (!cpi->sf.temporal_mv_pred || frame_is_intra_only(cm)) return;
+  // The vectors of the previous frame only predict the motion relative to
+  // LAST if LAST is the previous frame and both are of the size of this frame.
+  if (prev_frame == NULL || prev_frame->mvs == NULL || !cm->last_show_frame ||
+      cm->width != cm->last_width || cm->height != cm->last_height ||
+      prev_frame->mi_rows < cm->mi_rows || prev_frame->mi_cols < cm->mi_cols)
+    return;
+  if (!(cpi->ref_frame_flags & VP9_LAST_FLAG) ||
+      cm->frame_refs[LAST_FRAME - 1].buf != &prev_frame->buf)
+    return;
+
+  alloc_map(map, cm);
+  project_motion_field(map, prev_frame->mvs);
+  find_sb_mvs(map);
+  map->valid = 1;
+}
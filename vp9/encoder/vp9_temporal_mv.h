@@ -0,0 +1,80 @@
+/*
+ *  Copyright (c) 2023 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef VPX_VP9_ENCODER_VP9_TEMPORAL_MV_H_
+#define VPX_VP9_ENCODER_VP9_TEMPORAL_MV_H_
+
+#include "vp9/common/vp9_common_data.h"
+#include "vp9/common/vp9_mv.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The motion of the frame being encoded relative to LAST, predicted from the
+// motion field of the previous frame: each motion vector of the previous frame
+// is moved along itself to where its block is expected to be in this frame,
+// assuming the motion goes on at the same speed. The 8x8 blocks no vector lands
+// on take the vector of the co-located block. The map is only a predictor for
+// the start of the motion search, it is never signaled.
+typedef struct TemporalMvMap {
+  // The vector of each 8x8 block, in 1/8 pel, or INVALID_MV.
+  int_mv *mvs;
+  // The most common vector of the blocks of each superblock, or INVALID_MV.
+  int_mv *sb_mvs;
+  int mi_rows;
+  int mi_cols;
+  int sb_cols;
+  // Whether the map holds the motion of the frame being encoded.
+  int valid;
+} TemporalMvMap;
+
+struct VP9_COMP;
+
+void vp9_temporal_mv_map_free(TemporalMvMap *map);
+
+// Builds the map of the frame about to be encoded from the motion field of the
+// previous frame, if LAST is the previous frame and it is of the same size.
+void vp9_temporal_mv_map_build(struct VP9_COMP *cpi);
+
+// Returns the vector of the block of size |bsize| at (mi_row, mi_col), taken
+// at its center, or INVALID_MV.
+static INLINE int_mv vp9_temporal_mv_get(const TemporalMvMap *map, int mi_row,
+                                         int mi_col, BLOCK_SIZE bsize) {
+  int_mv mv;
+  int row, col;
+  if (!map->valid) {
+    mv.as_int = INVALID_MV;
+    return mv;
+  }
+  row = mi_row + (num_8x8_blocks_high_lookup[bsize] >> 1);
+  col = mi_col + (num_8x8_blocks_wide_lookup[bsize] >> 1);
+  if (row >= map->mi_rows) row = map->mi_rows - 1;
+  if (col >= map->mi_cols) col = map->mi_cols - 1;
+  return map->mvs[row * map->mi_cols + col];
+}
+
+// Returns the vector of the superblock at (mi_row, mi_col), or INVALID_MV.
+static INLINE int_mv vp9_temporal_mv_get_sb(const TemporalMvMap *map,
+                                            int mi_row, int mi_col) {
+  int_mv mv;
+  if (!map->valid) {
+    mv.as_int = INVALID_MV;
+    return mv;
+  }
+  return map->sb_mvs[(mi_row >> MI_BLOCK_SIZE_LOG2) * map->sb_cols +
+                     (mi_col >> MI_BLOCK_SIZE_LOG2)];
+}
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // VPX_VP9_ENCODER_VP9_TEMPORAL_MV_H_
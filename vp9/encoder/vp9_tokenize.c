@@ -488,3 +488,57 @@ void vp9_tokenize_sb(VP9_COMP *cpi, ThreadData *td, TOKENEXTRA **t, int dry_run,
     vp9_foreach_transformed_block(xd, bsize, set_entropy_context_b, &arg);
   }
 }
+
+void vp9_token_pool_init(TokenPool *pool) {
+  pool->chunks = NULL;
+  pool->free_chunks = NULL;
+#if CONFIG_MULTITHREAD
+  pthread_mutex_init(&pool->mutex, NULL);
+#endif
+}
+
+void vp9_token_pool_free(TokenPool *pool) {
+  while (pool->chunks != NULL) {
+    TokenChunk *const link = pool->chunks->link;
+    vpx_free(pool->chunks);
+    pool->chunks = link;
+  }
+  pool->free_chunks = NULL;
+#if CONFIG_MULTITHREAD
+  pthread_mutex_destroy(&pool->mutex);
+#endif
+}
+
+void vp9_token_pool_reset(TokenPool *pool) {
+  pool->free_chunks = pool->chunks;
+}
+
+TokenChunk *vp9_token_pool_get_chunk(TokenPool *pool, VP9_COMMON *cm) {
+  TokenChunk *chunk;
+
+#if CONFIG_MULTITHREAD
+  pthread_mutex_lock(&pool->mutex);
+#endif
+  chunk = pool->free_chunks;
+  if (chunk != NULL) pool->free_chunks = chunk->link;
+#if CONFIG_MULTITHREAD
+  pthread_mutex_unlock(&pool->mutex);
+#endif
+
+  if (chunk == NULL) {
+    CHECK_MEM_ERROR(cm, chunk, (TokenChunk *)vpx_malloc(sizeof(*chunk)));
+    // All the chunks are in use, so the new one goes in front of the free
+    // ones.
+#if CONFIG_MULTITHREAD
+    pthread_mutex_lock(&pool->mutex);
+#endif
+    chunk->link = pool->chunks;
+    pool->chunks = chunk;
+#if CONFIG_MULTITHREAD
+    pthread_mutex_unlock(&pool->mutex);
+#endif
+  }
+  chunk->next = NULL;
+  chunk->stop = chunk->tokens;
+  return chunk;
+}
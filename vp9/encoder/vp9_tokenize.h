@@ -11,6 +11,8 @@
 #ifndef VPX_VP9_ENCODER_VP9_TOKENIZE_H_
 #define VPX_VP9_ENCODER_VP9_TOKENIZE_H_
 
+#include "./vpx_config.h"
+#include "vpx_util/vpx_thread.h"
 #include "vp9/common/vp9_entropy.h"
 
 #include "vp9/encoder/vp9_block.h"
@@ -39,6 +41,49 @@ typedef struct {
   EXTRABIT extra;
 } TOKENEXTRA;
 
+// Number of tokens of a 64x64 superblock, assuming up to 1 token per pixel in
+// 3 full resolution planes and a head room of 4 per macroblock.
+#define MAX_SB_TOKENS \
+  ((MI_BLOCK_SIZE >> 1) * (MI_BLOCK_SIZE >> 1) * (16 * 16 * 3 + 4))
+
+// Tokens are written to chunks taken from a pool as the superblocks are
+// encoded. A chunk holds the tokens of several superblocks, but the tokens of
+// a superblock never span 2 chunks.
+#define TOKEN_CHUNK_SIZE (4 * MAX_SB_TOKENS)
+
+typedef struct TokenChunk {
+  // The chunk the encoding thread moved on to once this one was full.
+  struct TokenChunk *next;
+  // Links all the chunks of the pool.
+  struct TokenChunk *link;
+  // End of the tokens written to this chunk.
+  TOKENEXTRA *stop;
+  TOKENEXTRA tokens[TOKEN_CHUNK_SIZE];
+} TokenChunk;
+
+// The chunks of the pool are kept from frame to frame, so the memory held
+// follows the number of tokens of the largest frame instead of the worst case
+// of every coefficient of the frame.
+typedef struct TokenPool {
+  TokenChunk *chunks;
+  // The chunks from this one on are unused in the current frame.
+  TokenChunk *free_chunks;
+#if CONFIG_MULTITHREAD
+  pthread_mutex_t mutex;
+#endif
+} TokenPool;
+
+struct VP9Common;
+
+void vp9_token_pool_init(TokenPool *pool);
+void vp9_token_pool_free(TokenPool *pool);
+
+// Makes all the chunks available for a new frame.
+void vp9_token_pool_reset(TokenPool *pool);
+
+// Returns an empty chunk. The pool grows if all the chunks are in use.
+TokenChunk *vp9_token_pool_get_chunk(TokenPool *pool, struct VP9Common *cm);
+
 extern const vpx_tree_index vp9_coef_tree[];
 extern const vpx_tree_index vp9_coef_con_tree[];
 extern const struct vp9_token vp9_coef_encodings[];
@@ -0,0 +1,230 @@
+/*
+ *  Copyright (c) 2023 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <immintrin.h>
+#include <stdlib.h>
+
+#include "./vpx_config.h"
+#include "./vp9_rtcd.h"
+
+#include "vpx/vpx_integer.h"
+#include "vp9/common/vp9_reconinter.h"
+#include "vp9/encoder/vp9_context_tree.h"
+#include "vp9/encoder/vp9_denoiser.h"
+
+typedef struct {
+  __m256i k_4;
+  __m256i k_8;
+  __m256i k_16;
+  __m256i l3;
+  __m256i l32;
+  __m256i l21;
+} DenoiserLevels;
+
+// Loads 32 pixels: one row of a block at least 32 wide, or 2 rows of a 16
+// wide block, or 4 rows of an 8 wide block.
+static INLINE __m256i load_pixels(const uint8_t *p, int stride, int width) {
+  if (width >= 32) {
+    return _mm256_loadu_si256((const __m256i *)p);
+  } else if (width == 16) {
+    return _mm256_inserti128_si256(
+        _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)p)),
+        _mm_loadu_si128((const __m128i *)(p + stride)), 1);
+  } else {
+    const __m128i lo =
+        _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)p),
+                           _mm_loadl_epi64((const __m128i *)(p + stride)));
+    const __m128i hi = _mm_unpacklo_epi64(
+        _mm_loadl_epi64((const __m128i *)(p + 2 * stride)),
+        _mm_loadl_epi64((const __m128i *)(p + 3 * stride)));
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+  }
+}
+
+static INLINE void store_pixels(uint8_t *p, int stride, int width,
+                                const __m256i v) {
+  const __m128i lo = _mm256_castsi256_si128(v);
+  const __m128i hi = _mm256_extracti128_si256(v, 1);
+  if (width >= 32) {
+    _mm256_storeu_si256((__m256i *)p, v);
+  } else if (width == 16) {
+    _mm_storeu_si128((__m128i *)p, lo);
+    _mm_storeu_si128((__m128i *)(p + stride), hi);
+  } else {
+    _mm_storel_epi64((__m128i *)p, lo);
+    _mm_storel_epi64((__m128i *)(p + stride), _mm_srli_si128(lo, 8));
+    _mm_storel_epi64((__m128i *)(p + 2 * stride), hi);
+    _mm_storel_epi64((__m128i *)(p + 3 * stride), _mm_srli_si128(hi, 8));
+  }
+}
+
+// Adds the sum of the positive adjustments and subtracts the sum of the
+// negative ones. The sums are kept in 64-bit lanes so they cannot saturate.
+static INLINE __m256i accumulate_adj(const __m256i acc, const __m256i padj,
+                                     const __m256i nadj) {
+  const __m256i zero = _mm256_setzero_si256();
+  return _mm256_add_epi64(
+      acc, _mm256_sub_epi64(_mm256_sad_epu8(padj, zero),
+                            _mm256_sad_epu8(nadj, zero)));
+}
+
+static INLINE int sum_diff_4x64(const __m256i acc) {
+  const __m128i sum = _mm_add_epi64(_mm256_castsi256_si128(acc),
+                                    _mm256_extracti128_si256(acc, 1));
+  // The total fits in 32 bits, so the low half of the 64-bit sum is enough.
+  return _mm_cvtsi128_si32(_mm_add_epi64(sum, _mm_srli_si128(sum, 8)));
+}
+
+// Denoise 32 pixels.
+static INLINE __m256i denoiser_32x1(const __m256i v_sig, const __m256i v_mc,
+                                    const DenoiserLevels *lv, __m256i *acc) {
+  const __m256i pdiff = _mm256_subs_epu8(v_mc, v_sig);
+  const __m256i ndiff = _mm256_subs_epu8(v_sig, v_mc);
+  // Obtain the sign. FF if diff is negative.
+  const __m256i diff_sign = _mm256_cmpeq_epi8(pdiff, _mm256_setzero_si256());
+  // Clamp absolute difference to 16 to be used to get mask. Doing this
+  // allows us to use _mm256_cmpgt_epi8, which operates on signed byte.
+  const __m256i clamped_absdiff =
+      _mm256_min_epu8(_mm256_or_si256(pdiff, ndiff), lv->k_16);
+  // Get masks for l2 l1 and l0 adjustments.
+  const __m256i mask2 = _mm256_cmpgt_epi8(lv->k_16, clamped_absdiff);
+  const __m256i mask1 = _mm256_cmpgt_epi8(lv->k_8, clamped_absdiff);
+  const __m256i mask0 = _mm256_cmpgt_epi8(lv->k_4, clamped_absdiff);
+  // Get adjustments for l2, l1, and l0.
+  const __m256i adj2 = _mm256_add_epi8(_mm256_and_si256(mask2, lv->l32),
+                                       _mm256_and_si256(mask1, lv->l21));
+  const __m256i adj0 = _mm256_and_si256(mask0, clamped_absdiff);
+  // Combine the adjustments and get absolute adjustments.
+  const __m256i adj = _mm256_or_si256(
+      _mm256_andnot_si256(mask0, _mm256_sub_epi8(lv->l3, adj2)), adj0);
+  // Restore the sign and get positive and negative adjustments.
+  const __m256i padj = _mm256_andnot_si256(diff_sign, adj);
+  const __m256i nadj = _mm256_and_si256(diff_sign, adj);
+
+  *acc = accumulate_adj(*acc, padj, nadj);
+  return _mm256_subs_epu8(_mm256_adds_epu8(v_sig, padj), nadj);
+}
+
+// Move 32 denoised pixels back towards the source with a weaker filter.
+static INLINE __m256i denoiser_adj_32x1(const __m256i v_sig,
+                                        const __m256i v_mc,
+                                        const __m256i v_avg,
+                                        const __m256i k_delta, __m256i *acc) {
+  const __m256i pdiff = _mm256_subs_epu8(v_mc, v_sig);
+  const __m256i ndiff = _mm256_subs_epu8(v_sig, v_mc);
+  // Obtain the sign. FF if diff is negative.
+  const __m256i diff_sign = _mm256_cmpeq_epi8(pdiff, _mm256_setzero_si256());
+  // Clamp absolute difference to delta to get the adjustment.
+  const __m256i adj = _mm256_min_epu8(_mm256_or_si256(pdiff, ndiff), k_delta);
+  const __m256i padj = _mm256_andnot_si256(diff_sign, adj);
+  const __m256i nadj = _mm256_and_si256(diff_sign, adj);
+
+  *acc = accumulate_adj(*acc, nadj, padj);
+  return _mm256_adds_epu8(_mm256_subs_epu8(v_avg, padj), nadj);
+}
+
+// Denoise a block of the given width, 32 pixels at a time. Blocks narrower
+// than 32 are processed several rows at a time.
+static INLINE int denoiser_NxM_avx2(const uint8_t *sig, int sig_stride,
+                                    const uint8_t *mc_avg, int mc_avg_stride,
+                                    uint8_t *avg, int avg_stride,
+                                    int increase_denoising, BLOCK_SIZE bs,
+                                    int motion_magnitude, int width) {
+  const int height = 4 << b_height_log2_lookup[bs];
+  const int rows = width >= 32 ? 1 : 32 / width;
+  const int shift_inc =
+      (increase_denoising && motion_magnitude <= MOTION_MAGNITUDE_THRESHOLD)
+          ? 1
+          : 0;
+  const int sum_diff_thresh = total_adj_strong_thresh(bs, increase_denoising);
+  __m256i acc = _mm256_setzero_si256();
+  DenoiserLevels lv;
+  int r, c, sum_diff;
+
+  lv.k_4 = _mm256_set1_epi8(4 + shift_inc);
+  lv.k_8 = _mm256_set1_epi8(8);
+  lv.k_16 = _mm256_set1_epi8(16);
+  // Modify each level's adjustment according to motion_magnitude.
+  lv.l3 = _mm256_set1_epi8(
+      (motion_magnitude <= MOTION_MAGNITUDE_THRESHOLD) ? 7 + shift_inc : 6);
+  // Difference between level 3 and level 2 is 2.
+  lv.l32 = _mm256_set1_epi8(2);
+  // Difference between level 2 and level 1 is 1.
+  lv.l21 = _mm256_set1_epi8(1);
+
+  for (r = 0; r < height; r += rows) {
+    for (c = 0; c < width; c += 32) {
+      const __m256i v_sig =
+          load_pixels(sig + r * sig_stride + c, sig_stride, width);
+      const __m256i v_mc =
+          load_pixels(mc_avg + r * mc_avg_stride + c, mc_avg_stride, width);
+      store_pixels(avg + r * avg_stride + c, avg_stride, width,
+                   denoiser_32x1(v_sig, v_mc, &lv, &acc));
+    }
+  }
+
+  sum_diff = sum_diff_4x64(acc);
+  if (abs(sum_diff) > sum_diff_thresh) {
+    // Before returning to copy the block (i.e., apply no denoising), check
+    // if we can still apply some (weaker) temporal filtering to this block,
+    // that would otherwise not be denoised at all. The delta is set by the
+    // excess of absolute pixel diff over the threshold.
+    const int delta =
+        ((abs(sum_diff) - sum_diff_thresh) >> num_pels_log2_lookup[bs]) + 1;
+    // Only apply the adjustment for max delta up to 3.
+    if (delta < 4) {
+      const __m256i k_delta = _mm256_set1_epi8(delta);
+      for (r = 0; r < height; r += rows) {
+        for (c = 0; c < width; c += 32) {
+          uint8_t *const avg_ptr = avg + r * avg_stride + c;
+          const __m256i v_sig =
+              load_pixels(sig + r * sig_stride + c, sig_stride, width);
+          const __m256i v_mc = load_pixels(mc_avg + r * mc_avg_stride + c,
+                                           mc_avg_stride, width);
+          const __m256i v_avg = load_pixels(avg_ptr, avg_stride, width);
+          store_pixels(avg_ptr, avg_stride, width,
+                       denoiser_adj_32x1(v_sig, v_mc, v_avg, k_delta, &acc));
+        }
+      }
+      sum_diff = sum_diff_4x64(acc);
+      if (abs(sum_diff) > sum_diff_thresh) return COPY_BLOCK;
+    } else {
+      return COPY_BLOCK;
+    }
+  }
+  return FILTER_BLOCK;
+}
+
+int vp9_denoiser_filter_avx2(const uint8_t *sig, int sig_stride,
+                             const uint8_t *mc_avg, int mc_avg_stride,
+                             uint8_t *avg, int avg_stride,
+                             int increase_denoising, BLOCK_SIZE bs,
+                             int motion_magnitude) {
+  // Rank by frequency of the block type to have an early termination.
+  if (bs == BLOCK_16X16 || bs == BLOCK_16X32 || bs == BLOCK_16X8) {
+    return denoiser_NxM_avx2(sig, sig_stride, mc_avg, mc_avg_stride, avg,
+                             avg_stride, increase_denoising, bs,
+                             motion_magnitude, 16);
+  } else if (bs == BLOCK_32X32 || bs == BLOCK_32X16 || bs == BLOCK_32X64) {
+    return denoiser_NxM_avx2(sig, sig_stride, mc_avg, mc_avg_stride, avg,
+                             avg_stride, increase_denoising, bs,
+                             motion_magnitude, 32);
+  } else if (bs == BLOCK_64X64 || bs == BLOCK_64X32) {
+    return denoiser_NxM_avx2(sig, sig_stride, mc_avg, mc_avg_stride, avg,
+                             avg_stride, increase_denoising, bs,
+                             motion_magnitude, 64);
+  } else if (bs == BLOCK_8X8 || bs == BLOCK_8X16) {
+    return denoiser_NxM_avx2(sig, sig_stride, mc_avg, mc_avg_stride, avg,
+                             avg_stride, increase_denoising, bs,
+                             motion_magnitude, 8);
+  } else {
+    return COPY_BLOCK;
+  }
+}
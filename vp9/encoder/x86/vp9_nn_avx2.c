@@ -0,0 +1,90 @@
+/*
+ *  Copyright (c) 2023 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <immintrin.h>
+
+#include "./vp9_rtcd.h"
+#include "vpx_dsp/vpx_dsp_common.h"
+
+// Returns the sums of the lanes of |a0|, |a1|, |a2| and |a3| in lanes 0 to 3.
+static INLINE __m128 hadd4_ps(const __m128 a0, const __m128 a1,
+                              const __m128 a2, const __m128 a3) {
+  return _mm_hadd_ps(_mm_hadd_ps(a0, a1), _mm_hadd_ps(a2, a3));
+}
+
+static INLINE __m128 fold_ps(const __m256 v) {
+  return _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+}
+
+void vp9_nn_fc_layer_avx2(const float *input, int num_inputs, int num_samples,
+                          const float *weights, const float *bias,
+                          int num_outputs, int relu, float *output) {
+  const __m128 zero = _mm_setzero_ps();
+  int s, node, i;
+  for (s = 0; s < num_samples; ++s) {
+    // Four output nodes at a time, eight inputs per step where possible.
+    for (node = 0; node + 4 <= num_outputs; node += 4) {
+      const float *w0 = weights + node * num_inputs;
+      const float *w1 = w0 + num_inputs;
+      const float *w2 = w1 + num_inputs;
+      const float *w3 = w2 + num_inputs;
+      __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+      __m256 acc2 = _mm256_setzero_ps(), acc3 = _mm256_setzero_ps();
+      __m128 sum0, sum1, sum2, sum3, val;
+      float tail[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+      for (i = 0; i + 8 <= num_inputs; i += 8) {
+        const __m256 in = _mm256_loadu_ps(input + i);
+        acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(_mm256_loadu_ps(w0 + i), in));
+        acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(_mm256_loadu_ps(w1 + i), in));
+        acc2 = _mm256_add_ps(acc2, _mm256_mul_ps(_mm256_loadu_ps(w2 + i), in));
+        acc3 = _mm256_add_ps(acc3, _mm256_mul_ps(_mm256_loadu_ps(w3 + i), in));
+      }
+      sum0 = fold_ps(acc0);
+      sum1 = fold_ps(acc1);
+      sum2 = fold_ps(acc2);
+      sum3 = fold_ps(acc3);
+      if (i + 4 <= num_inputs) {
+        const __m128 in = _mm_loadu_ps(input + i);
+        sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(w0 + i), in));
+        sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(w1 + i), in));
+        sum2 = _mm_add_ps(sum2, _mm_mul_ps(_mm_loadu_ps(w2 + i), in));
+        sum3 = _mm_add_ps(sum3, _mm_mul_ps(_mm_loadu_ps(w3 + i), in));
+        i += 4;
+      }
+      for (; i < num_inputs; ++i) {
+        tail[0] += w0[i] * input[i];
+        tail[1] += w1[i] * input[i];
+        tail[2] += w2[i] * input[i];
+        tail[3] += w3[i] * input[i];
+      }
+      val = _mm_add_ps(hadd4_ps(sum0, sum1, sum2, sum3), _mm_loadu_ps(tail));
+      val = _mm_add_ps(val, _mm_loadu_ps(bias + node));
+      if (relu) val = _mm_max_ps(val, zero);
+      _mm_storeu_ps(output + node, val);
+    }
+    for (; node < num_outputs; ++node) {
+      const float *w = weights + node * num_inputs;
+      __m128 acc = zero;
+      float val;
+      for (i = 0; i + 4 <= num_inputs; i += 4) {
+        acc = _mm_add_ps(acc,
+                         _mm_mul_ps(_mm_loadu_ps(w + i), _mm_loadu_ps(input + i)));
+      }
+      acc = _mm_hadd_ps(acc, acc);
+      acc = _mm_hadd_ps(acc, acc);
+      val = _mm_cvtss_f32(acc);
+      for (; i < num_inputs; ++i) val += w[i] * input[i];
+      val += bias[node];
+      output[node] = relu ? VPXMAX(val, 0.0f) : val;
+    }
+    input += num_inputs;
+    output += num_outputs;
+  }
+}
@@ -0,0 +1,82 @@
+/*
+ *  Copyright (c) 2023 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <emmintrin.h>
+
+#include "./vp9_rtcd.h"
+#include "vpx_dsp/vpx_dsp_common.h"
+
+// Returns the sums of the lanes of |a0|, |a1|, |a2| and |a3| in lanes 0 to 3.
+static INLINE __m128 hadd4_ps(const __m128 a0, const __m128 a1,
+                              const __m128 a2, const __m128 a3) {
+  const __m128 t0 =
+      _mm_add_ps(_mm_unpacklo_ps(a0, a1), _mm_unpackhi_ps(a0, a1));
+  const __m128 t1 =
+      _mm_add_ps(_mm_unpacklo_ps(a2, a3), _mm_unpackhi_ps(a2, a3));
+  return _mm_add_ps(_mm_movelh_ps(t0, t1), _mm_movehl_ps(t1, t0));
+}
+
+static INLINE float dot_product(const float *w, const float *in, int n) {
+  __m128 acc = _mm_setzero_ps();
+  float sum;
+  int i;
+  for (i = 0; i + 4 <= n; i += 4) {
+    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(w + i), _mm_loadu_ps(in + i)));
+  }
+  acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+  acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+  sum = _mm_cvtss_f32(acc);
+  for (; i < n; ++i) sum += w[i] * in[i];
+  return sum;
+}
+
+void vp9_nn_fc_layer_sse2(const float *input, int num_inputs, int num_samples,
+                          const float *weights, const float *bias,
+                          int num_outputs, int relu, float *output) {
+  const __m128 zero = _mm_setzero_ps();
+  int s, node, i;
+  for (s = 0; s < num_samples; ++s) {
+    // Four output nodes at a time.
+    for (node = 0; node + 4 <= num_outputs; node += 4) {
+      const float *w0 = weights + node * num_inputs;
+      const float *w1 = w0 + num_inputs;
+      const float *w2 = w1 + num_inputs;
+      const float *w3 = w2 + num_inputs;
+      __m128 acc0 = zero, acc1 = zero, acc2 = zero, acc3 = zero;
+      __m128 val;
+      float tail[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+      for (i = 0; i + 4 <= num_inputs; i += 4) {
+        const __m128 in = _mm_loadu_ps(input + i);
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(w0 + i), in));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(w1 + i), in));
+        acc2 = _mm_add_ps(acc2, _mm_mul_ps(_mm_loadu_ps(w2 + i), in));
+        acc3 = _mm_add_ps(acc3, _mm_mul_ps(_mm_loadu_ps(w3 + i), in));
+      }
+      for (; i < num_inputs; ++i) {
+        tail[0] += w0[i] * input[i];
+        tail[1] += w1[i] * input[i];
+        tail[2] += w2[i] * input[i];
+        tail[3] += w3[i] * input[i];
+      }
+      val = _mm_add_ps(hadd4_ps(acc0, acc1, acc2, acc3), _mm_loadu_ps(tail));
+      val = _mm_add_ps(val, _mm_loadu_ps(bias + node));
+      if (relu) val = _mm_max_ps(val, zero);
+      _mm_storeu_ps(output + node, val);
+    }
+    for (; node < num_outputs; ++node) {
+      const float val =
+          dot_product(weights + node * num_inputs, input, num_inputs) +
+          bias[node];
+      output[node] = relu ? VPXMAX(val, 0.0f) : val;
+    }
+    input += num_inputs;
+    output += num_outputs;
+  }
+}
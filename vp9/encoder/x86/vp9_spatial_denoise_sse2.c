@@ -0,0 +1,111 @@
+/*
+ *  Copyright (c) 2023 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <emmintrin.h>
+
+#include "./vp9_rtcd.h"
+#include "vpx/vpx_integer.h"
+#include "vpx_ports/mem.h"
+
+// Same kernels as the C version, one row per entry.
+static const int16_t dn_kernal_3[3][3] = { { 1, 2, 1 },
+                                           { 2, 4, 2 },
+                                           { 1, 2, 1 } };
+static const int16_t dn_kernal_5[5][5] = { { 1, 1, 1, 1, 1 },
+                                           { 1, 1, 2, 1, 1 },
+                                           { 1, 2, 4, 2, 1 },
+                                           { 1, 1, 2, 1, 1 },
+                                           { 1, 1, 1, 1, 1 } };
+
+static INLINE __m128i load_u8_to_s16(const uint8_t *p) {
+  return _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)p),
+                           _mm_setzero_si128());
+}
+
+// Adds |weight| and |weight| * |val| to the sums in the lanes where |diff| is
+// not above |thresh|.
+static INLINE void add_denoise_points(const __m128i val, const __m128i diff,
+                                      const __m128i thresh, int16_t weight,
+                                      __m128i *sum_val, __m128i *sum_weight) {
+  const __m128i w = _mm_set1_epi16(weight);
+  const __m128i skip = _mm_cmpgt_epi16(diff, thresh);
+  *sum_val =
+      _mm_add_epi16(*sum_val, _mm_andnot_si128(skip, _mm_mullo_epi16(val, w)));
+  *sum_weight = _mm_add_epi16(*sum_weight, _mm_andnot_si128(skip, w));
+}
+
+// Returns (num + den / 2) / den for the 16-bit lanes. The float division is
+// exact after truncation as num < 2^14 and den <= 32.
+static INLINE __m128i round_div_epi16(const __m128i num, const __m128i den) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i n = _mm_add_epi16(num, _mm_srli_epi16(den, 1));
+  const __m128 n_lo = _mm_cvtepi32_ps(_mm_unpacklo_epi16(n, zero));
+  const __m128 n_hi = _mm_cvtepi32_ps(_mm_unpackhi_epi16(n, zero));
+  const __m128 d_lo = _mm_cvtepi32_ps(_mm_unpacklo_epi16(den, zero));
+  const __m128 d_hi = _mm_cvtepi32_ps(_mm_unpackhi_epi16(den, zero));
+  const __m128 q_lo = _mm_div_ps(n_lo, d_lo);
+  const __m128 q_hi = _mm_div_ps(n_hi, d_hi);
+  return _mm_packs_epi32(_mm_cvttps_epi32(q_lo), _mm_cvttps_epi32(q_hi));
+}
+
+void vp9_spatial_denoise_row_sse2(const uint8_t *src, int src_stride,
+                                  uint8_t *dst, int width, int strength) {
+  const __m128i kernel_thresh = _mm_set1_epi16(strength + (strength >> 1));
+  const __m128i thresh_5 = _mm_set1_epi16(strength);
+  const __m128i thresh_3 = _mm_set1_epi16(strength >> 1);
+  int col;
+
+  // 8 pixels at a time, with both kernels applied and the result selected per
+  // pixel.
+  for (col = 0; col + 8 <= width; col += 8) {
+    const uint8_t *const p = src + col;
+    const __m128i centre = load_u8_to_s16(p);
+    __m128i max_diff = _mm_setzero_si128();
+    __m128i sum_val_5 = _mm_setzero_si128();
+    __m128i sum_weight_5 = _mm_setzero_si128();
+    __m128i sum_val_3 = _mm_setzero_si128();
+    __m128i sum_weight_3 = _mm_setzero_si128();
+    __m128i use_3, sum_val, sum_weight;
+    int i, j;
+
+    for (i = -3; i <= 3; ++i) {
+      for (j = -3; j <= 3; ++j) {
+        const __m128i val = load_u8_to_s16(p + i * src_stride + j);
+        const __m128i diff = _mm_or_si128(_mm_subs_epu16(centre, val),
+                                          _mm_subs_epu16(val, centre));
+        max_diff = _mm_max_epi16(max_diff, diff);
+        if (i >= -2 && i <= 2 && j >= -2 && j <= 2) {
+          add_denoise_points(val, diff, thresh_5, dn_kernal_5[i + 2][j + 2],
+                             &sum_val_5, &sum_weight_5);
+        }
+        if (i >= -1 && i <= 1 && j >= -1 && j <= 1) {
+          add_denoise_points(val, diff, thresh_3, dn_kernal_3[i + 1][j + 1],
+                             &sum_val_3, &sum_weight_3);
+        }
+      }
+    }
+
+    // The 3x3 kernel is used where the local deviation is large.
+    use_3 = _mm_cmpgt_epi16(max_diff, kernel_thresh);
+    sum_val = _mm_or_si128(_mm_and_si128(use_3, sum_val_3),
+                           _mm_andnot_si128(use_3, sum_val_5));
+    sum_weight = _mm_or_si128(_mm_and_si128(use_3, sum_weight_3),
+                              _mm_andnot_si128(use_3, sum_weight_5));
+
+    {
+      const __m128i res = round_div_epi16(sum_val, sum_weight);
+      _mm_storel_epi64((__m128i *)(dst + col), _mm_packus_epi16(res, res));
+    }
+  }
+
+  if (col < width)
+    vp9_spatial_denoise_row_c(src + col, src_stride, dst + col, width - col,
+                              strength);
+}
@@ -901,7 +901,8 @@ void SimpleEncode::ComputeFirstPassStats() {
           timebase_units_to_ticks(&oxcf.g_timebase_in_ts, next_show_idx + 1);
       YV12_BUFFER_CONFIG sd;
       image2yuvconfig(&img, &sd);
-      vp9_lookahead_push(lookahead, &sd, ts_start, ts_end, use_highbitdepth, 0);
+      vp9_lookahead_push(lookahead, &sd, ts_start, ts_end, use_highbitdepth, 0,
+                         NULL);
       {
         int64_t time_stamp;
         int64_t time_end;
@@ -1175,7 +1176,8 @@ void SimpleEncode::EncodeFrame(EncodeFrameResult *encode_frame_result) {
                                                next_show_idx + 1);
       YV12_BUFFER_CONFIG sd;
       image2yuvconfig(&impl_ptr_->tmp_img, &sd);
-      vp9_lookahead_push(lookahead, &sd, ts_start, ts_end, use_highbitdepth, 0);
+      vp9_lookahead_push(lookahead, &sd, ts_start, ts_end, use_highbitdepth, 0,
+                         NULL);
     } else {
       break;
     }
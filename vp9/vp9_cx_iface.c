@@ -62,6 +62,7 @@ typedef struct vp9_extracfg {
   unsigned int row_mt;
   unsigned int motion_vector_unit_test;
   int delta_q_uv;
+  int subpel_cache;
 } vp9_extracfg;
 
 static struct vp9_extracfg default_extra_cfg = {
@@ -101,8 +102,17 @@ static struct vp9_extracfg default_extra_cfg = {
   0,                     // row_mt
   0,                     // motion_vector_unit_test
   0,                     // delta_q_uv
+  0,                     // subpel_cache
 };
 
+// A compressed data buffer that was outgrown during an encode call. The
+// packets returned by that call may still point into it, so it is only freed
+// by the next call.
+typedef struct RetiredCxData {
+  unsigned char *buf;
+  struct RetiredCxData *next;
+} RetiredCxData;
+
 struct vpx_codec_alg_priv {
   vpx_codec_priv_t base;
   vpx_codec_enc_cfg_t cfg;
@@ -114,6 +124,10 @@ struct vpx_codec_alg_priv {
   VP9_COMP *cpi;
   unsigned char *cx_data;
   size_t cx_data_sz;
+  // Space to reserve for each frame in cx_data, as the bitstream writer does
+  // not check the end of its buffer.
+  size_t cx_frame_sz;
+  RetiredCxData *retired_cx_data;
   unsigned char *pending_cx_data;
   size_t pending_cx_data_sz;
   int pending_frame_count;
@@ -264,6 +278,7 @@ static vpx_codec_err_t validate_config(vpx_codec_alg_priv_t *ctx,
         "or kf_max_dist instead.");
 
   RANGE_CHECK(extra_cfg, row_mt, 0, 1);
+  RANGE_CHECK(extra_cfg, subpel_cache, 0, 2);
   RANGE_CHECK(extra_cfg, motion_vector_unit_test, 0, 2);
   RANGE_CHECK(extra_cfg, enable_auto_alt_ref, 0, MAX_ARF_LAYERS);
   RANGE_CHECK(extra_cfg, cpu_used, -9, 9);
@@ -632,6 +647,7 @@ static vpx_codec_err_t set_encoder_config(
   oxcf->motion_vector_unit_test = extra_cfg->motion_vector_unit_test;
 
   oxcf->delta_q_uv = extra_cfg->delta_q_uv;
+  oxcf->subpel_cache = (SUBPEL_CACHE_LEVEL)extra_cfg->subpel_cache;
 
   for (sl = 0; sl < oxcf->ss_number_layers; ++sl) {
     for (tl = 0; tl < oxcf->ts_number_layers; ++tl) {
@@ -862,6 +878,29 @@ static vpx_codec_err_t ctrl_get_loopfilter_level(vpx_codec_alg_priv_t *ctx,
   return VPX_CODEC_OK;
 }
 
+static vpx_codec_err_t ctrl_get_mode_context_memory(vpx_codec_alg_priv_t *ctx,
+                                                    va_list args) {
+  size_t *const arg = va_arg(args, size_t *);
+  if (arg == NULL) return VPX_CODEC_INVALID_PARAM;
+  *arg = vp9_get_pc_tree_mem_usage(ctx->cpi);
+  return VPX_CODEC_OK;
+}
+
+static vpx_codec_err_t ctrl_set_stage_timing(vpx_codec_alg_priv_t *ctx,
+                                             va_list args) {
+  vp9_set_stage_timing(ctx->cpi, CAST(VP9E_SET_STAGE_TIMING, args) != 0);
+  return VPX_CODEC_OK;
+}
+
+static vpx_codec_err_t ctrl_get_stage_timing(vpx_codec_alg_priv_t *ctx,
+                                             va_list args) {
+  vpx_stage_timing_t *const arg = va_arg(args, vpx_stage_timing_t *);
+  if (arg == NULL) return VPX_CODEC_INVALID_PARAM;
+  if (!ctx->cpi->stage_timing_enabled) return VPX_CODEC_ERROR;
+  *arg = ctx->cpi->last_stage_timing;
+  return VPX_CODEC_OK;
+}
+
 static vpx_codec_err_t update_extra_cfg(vpx_codec_alg_priv_t *ctx,
                                         const struct vp9_extracfg *extra_cfg) {
   const vpx_codec_err_t res = validate_config(ctx, &ctx->cfg, extra_cfg);
@@ -1133,7 +1172,17 @@ static vpx_codec_err_t encoder_init(vpx_codec_ctx_t *ctx,
   return res;
 }
 
+static void free_retired_cx_data(vpx_codec_alg_priv_t *ctx) {
+  while (ctx->retired_cx_data != NULL) {
+    RetiredCxData *const next = ctx->retired_cx_data->next;
+    free(ctx->retired_cx_data->buf);
+    free(ctx->retired_cx_data);
+    ctx->retired_cx_data = next;
+  }
+}
+
 static vpx_codec_err_t encoder_destroy(vpx_codec_alg_priv_t *ctx) {
+  free_retired_cx_data(ctx);
   free(ctx->cx_data);
   vp9_remove_compressor(ctx->cpi);
   vpx_free(ctx->buffer_pool);
@@ -1208,7 +1257,8 @@ static int write_superframe_index(vpx_codec_alg_priv_t *ctx) {
 
   // Write the index
   index_sz = 2 + (mag + 1) * ctx->pending_frame_count;
-  if (ctx->pending_cx_data_sz + index_sz < ctx->cx_data_sz) {
+  if (ctx->pending_cx_data + ctx->pending_cx_data_sz + index_sz <=
+      ctx->cx_data + ctx->cx_data_sz) {
     uint8_t *x = ctx->pending_cx_data + ctx->pending_cx_data_sz;
     int i, j;
 #ifdef TEST_SUPPLEMENTAL_SUPERFRAME_DATA
@@ -1283,6 +1333,57 @@ get_first_pass_stats_pkt(FIRSTPASS_STATS *stats) {
 #endif
 
 const size_t kMinCompressedSize = 8192;
+// Size of the index of a superframe of 8 frames of up to 4 bytes each.
+const size_t kMaxSuperframeIndexSize = 2 + 4 * 8;
+
+// Makes sure that one more frame and the superframe index fit at |*cx_data|.
+// The buffer grows on demand, so its size follows the size of the frames kept
+// in it instead of the number of frames a superframe could hold. Only the
+// pending invisible frames move to the new buffer. If |in_use| is set, the
+// frames already returned by this call keep the old buffer alive until the
+// next call.
+static void reserve_cx_data(vpx_codec_alg_priv_t *ctx, unsigned char **cx_data,
+                            int in_use) {
+  struct vpx_internal_error_info *const error = &ctx->cpi->common.error;
+  const size_t frame_sz =
+      VPXMAX(ctx->cx_frame_sz, kMinCompressedSize) + kMaxSuperframeIndexSize;
+  size_t new_sz;
+  unsigned char *buf;
+
+  if (*cx_data != NULL &&
+      (size_t)(ctx->cx_data + ctx->cx_data_sz - *cx_data) >= frame_sz)
+    return;
+
+  new_sz = VPXMAX(ctx->pending_cx_data_sz + frame_sz,
+                  ctx->cx_data_sz + ctx->cx_data_sz / 2);
+  buf = (unsigned char *)malloc(new_sz);
+  if (buf == NULL) {
+    vpx_internal_error(error, VPX_CODEC_MEM_ERROR,
+                       "Failed to allocate compressed data buffer");
+  }
+  if (ctx->pending_cx_data != NULL) {
+    memcpy(buf, ctx->pending_cx_data, ctx->pending_cx_data_sz);
+    ctx->pending_cx_data = buf;
+  }
+  if (in_use && ctx->cx_data != NULL) {
+    RetiredCxData *const retired =
+        (RetiredCxData *)malloc(sizeof(*retired));
+    if (retired == NULL) {
+      free(buf);
+      vpx_internal_error(error, VPX_CODEC_MEM_ERROR,
+                         "Failed to allocate compressed data buffer");
+    }
+    retired->buf = ctx->cx_data;
+    retired->next = ctx->retired_cx_data;
+    ctx->retired_cx_data = retired;
+  } else {
+    free(ctx->cx_data);
+  }
+  ctx->cx_data = buf;
+  ctx->cx_data_sz = new_sz;
+  *cx_data = buf + ctx->pending_cx_data_sz;
+}
+
 static vpx_codec_err_t encoder_encode(vpx_codec_alg_priv_t *ctx,
                                       const vpx_image_t *img,
                                       vpx_codec_pts_t pts_val,
@@ -1294,7 +1395,6 @@ static vpx_codec_err_t encoder_encode(vpx_codec_alg_priv_t *ctx,
   volatile vpx_codec_pts_t pts = pts_val;
   VP9_COMP *const cpi = ctx->cpi;
   const vpx_rational64_t *const timestamp_ratio = &ctx->timestamp_ratio;
-  size_t data_sz;
   vpx_codec_cx_pkt_t pkt;
   memset(&pkt, 0, sizeof(pkt));
 
@@ -1303,19 +1403,10 @@ static vpx_codec_err_t encoder_encode(vpx_codec_alg_priv_t *ctx,
   if (img != NULL) {
     res = validate_img(ctx, img);
     if (res == VPX_CODEC_OK) {
-      // There's no codec control for multiple alt-refs so check the encoder
-      // instance for its status to determine the compressed data size.
-      data_sz = ctx->cfg.g_w * ctx->cfg.g_h * get_image_bps(img) / 8 *
-                (cpi->multi_layer_arf ? 8 : 2);
-      if (data_sz < kMinCompressedSize) data_sz = kMinCompressedSize;
-      if (ctx->cx_data == NULL || ctx->cx_data_sz < data_sz) {
-        ctx->cx_data_sz = data_sz;
-        free(ctx->cx_data);
-        ctx->cx_data = (unsigned char *)malloc(ctx->cx_data_sz);
-        if (ctx->cx_data == NULL) {
-          return VPX_CODEC_MEM_ERROR;
-        }
-      }
+      // Allow a frame twice the size of the raw image. The invisible frames
+      // of a superframe are only given the space they use.
+      ctx->cx_frame_sz =
+          (size_t)ctx->cfg.g_w * ctx->cfg.g_h * get_image_bps(img) / 8 * 2;
     }
   }
 
@@ -1327,6 +1418,8 @@ static vpx_codec_err_t encoder_encode(vpx_codec_alg_priv_t *ctx,
 
   pick_quickcompress_mode(ctx, duration, deadline);
   vpx_codec_pkt_list_init(&ctx->pkt_list);
+  // The packets of the previous call are no longer valid.
+  free_retired_cx_data(ctx);
 
   // Handle Flags
   if (((flags & VP8_EFLAG_NO_UPD_GF) && (flags & VP8_EFLAG_FORCE_GF)) ||
@@ -1342,6 +1435,7 @@ static vpx_codec_err_t encoder_encode(vpx_codec_alg_priv_t *ctx,
     return res;
   }
   cpi->common.error.setjmp = 1;
+  vp9_stage_timing_begin_frame(cpi);
 
   if (res == VPX_CODEC_OK) vp9_apply_encoding_flags(cpi, flags);
 
@@ -1358,8 +1452,9 @@ static vpx_codec_err_t encoder_encode(vpx_codec_alg_priv_t *ctx,
     unsigned int lib_flags = 0;
     YV12_BUFFER_CONFIG sd;
     int64_t dst_time_stamp = timebase_units_to_ticks(timestamp_ratio, pts);
-    size_t size, cx_data_sz;
+    size_t size;
     unsigned char *cx_data;
+    int frames_out = 0;
 
     cpi->svc.timebase_fac = timebase_units_to_ticks(timestamp_ratio, 1);
     cpi->svc.time_stamp_superframe = dst_time_stamp;
@@ -1381,25 +1476,10 @@ static vpx_codec_err_t encoder_encode(vpx_codec_alg_priv_t *ctx,
       ctx->next_frame_flags = 0;
     }
 
-    cx_data = ctx->cx_data;
-    cx_data_sz = ctx->cx_data_sz;
-
-    /* Any pending invisible frames? */
-    if (ctx->pending_cx_data) {
-      memmove(cx_data, ctx->pending_cx_data, ctx->pending_cx_data_sz);
-      ctx->pending_cx_data = cx_data;
-      cx_data += ctx->pending_cx_data_sz;
-      cx_data_sz -= ctx->pending_cx_data_sz;
-
-      /* TODO: this is a minimal check, the underlying codec doesn't respect
-       * the buffer size anyway.
-       */
-      if (cx_data_sz < ctx->cx_data_sz / 2) {
-        vpx_internal_error(&cpi->common.error, VPX_CODEC_ERROR,
-                           "Compressed data buffer too small");
-        return VPX_CODEC_ERROR;
-      }
-    }
+    // Any pending invisible frames are continued in place.
+    cx_data = ctx->pending_cx_data
+                  ? ctx->pending_cx_data + ctx->pending_cx_data_sz
+                  : ctx->cx_data;
 
     if (cpi->oxcf.pass == 1 && !cpi->use_svc) {
 #if !CONFIG_REALTIME_ONLY
@@ -1434,10 +1514,13 @@ static vpx_codec_err_t encoder_encode(vpx_codec_alg_priv_t *ctx,
       ENCODE_FRAME_RESULT encode_frame_result;
       int64_t dst_end_time_stamp;
       vp9_init_encode_frame_result(&encode_frame_result);
-      while (cx_data_sz >= ctx->cx_data_sz / 2 &&
-             -1 != vp9_get_compressed_data(cpi, &lib_flags, &size, cx_data,
-                                           &dst_time_stamp, &dst_end_time_stamp,
-                                           !img, &encode_frame_result)) {
+      for (;;) {
+        reserve_cx_data(ctx, &cx_data, frames_out > 0);
+        if (vp9_get_compressed_data(cpi, &lib_flags, &size, cx_data,
+                                    &dst_time_stamp, &dst_end_time_stamp, !img,
+                                    &encode_frame_result) == -1)
+          break;
+
         // Pack psnr pkt
         if (size > 0 && !cpi->use_svc) {
           // TODO(angiebird): Figure out while we don't need psnr pkt when
@@ -1460,7 +1543,6 @@ static vpx_codec_err_t encoder_encode(vpx_codec_alg_priv_t *ctx,
               ctx->pending_frame_sizes[ctx->pending_frame_count++] = size;
             ctx->pending_frame_magnitude |= size;
             cx_data += size;
-            cx_data_sz -= size;
             pkt.data.frame.width[cpi->svc.spatial_layer_id] = cpi->common.width;
             pkt.data.frame.height[cpi->svc.spatial_layer_id] =
                 cpi->common.height;
@@ -1483,6 +1565,7 @@ static vpx_codec_err_t encoder_encode(vpx_codec_alg_priv_t *ctx,
               ctx->pending_frame_magnitude = 0;
               ctx->output_cx_pkt_cb.output_cx_pkt(
                   &pkt, ctx->output_cx_pkt_cb.user_priv);
+              ++frames_out;
             }
             continue;
           }
@@ -1525,9 +1608,9 @@ static vpx_codec_err_t encoder_encode(vpx_codec_alg_priv_t *ctx,
                 &pkt, ctx->output_cx_pkt_cb.user_priv);
           else
             vpx_codec_pkt_list_add(&ctx->pkt_list.head, &pkt);
+          ++frames_out;
 
           cx_data += size;
-          cx_data_sz -= size;
           if (is_one_pass_svc(cpi) && (cpi->svc.spatial_layer_id ==
                                        cpi->svc.number_spatial_layers - 1)) {
             // Encoded all spatial layers; exit loop.
@@ -1538,6 +1621,7 @@ static vpx_codec_err_t encoder_encode(vpx_codec_alg_priv_t *ctx,
     }
   }
 
+  vp9_stage_timing_end_frame(cpi);
   cpi->common.error.setjmp = 0;
   return res;
 }
@@ -1670,6 +1754,24 @@ static vpx_codec_err_t ctrl_get_active_map(vpx_codec_alg_priv_t *ctx,
   return VPX_CODEC_INVALID_PARAM;
 }
 
+static vpx_codec_err_t ctrl_set_dirty_rects(vpx_codec_alg_priv_t *ctx,
+                                            va_list args) {
+  const vpx_dirty_rects_t *const rects = va_arg(args, vpx_dirty_rects_t *);
+
+  if (vp9_set_dirty_rects(ctx->cpi, rects)) return VPX_CODEC_INVALID_PARAM;
+  return VPX_CODEC_OK;
+}
+
+static vpx_codec_err_t ctrl_get_dirty_rect_stats(vpx_codec_alg_priv_t *ctx,
+                                                 va_list args) {
+  vpx_dirty_rect_stats_t *const stats =
+      va_arg(args, vpx_dirty_rect_stats_t *);
+
+  if (stats == NULL) return VPX_CODEC_INVALID_PARAM;
+  *stats = ctx->cpi->dirty_map.stats;
+  return VPX_CODEC_OK;
+}
+
 static vpx_codec_err_t ctrl_set_scale_mode(vpx_codec_alg_priv_t *ctx,
                                            va_list args) {
   vpx_scaling_mode_t *const mode = va_arg(args, vpx_scaling_mode_t *);
@@ -1857,6 +1959,13 @@ static vpx_codec_err_t ctrl_set_delta_q_uv(vpx_codec_alg_priv_t *ctx,
   return update_extra_cfg(ctx, &extra_cfg);
 }
 
+static vpx_codec_err_t ctrl_set_subpel_cache(vpx_codec_alg_priv_t *ctx,
+                                             va_list args) {
+  struct vp9_extracfg extra_cfg = ctx->extra_cfg;
+  extra_cfg.subpel_cache = CAST(VP9E_SET_SUBPEL_CACHE, args);
+  return update_extra_cfg(ctx, &extra_cfg);
+}
+
 static vpx_codec_err_t ctrl_register_cx_callback(vpx_codec_alg_priv_t *ctx,
                                                  va_list args) {
   vpx_codec_priv_output_cx_pkt_cb_pair_t *cbp =
@@ -2024,12 +2133,18 @@ static vpx_codec_ctrl_fn_map_t encoder_ctrl_maps[] = {
   { VP9E_SET_RTC_EXTERNAL_RATECTRL, ctrl_set_rtc_external_ratectrl },
   { VP9E_SET_EXTERNAL_RATE_CONTROL, ctrl_set_external_rate_control },
   { VP9E_SET_QUANTIZER_ONE_PASS, ctrl_set_quantizer_one_pass },
+  { VP9E_SET_STAGE_TIMING, ctrl_set_stage_timing },
+  { VP9E_SET_SUBPEL_CACHE, ctrl_set_subpel_cache },
+  { VP8E_SET_DIRTY_RECTS, ctrl_set_dirty_rects },
 
   // Getters
   { VP8E_GET_LAST_QUANTIZER, ctrl_get_quantizer },
   { VP8E_GET_LAST_QUANTIZER_64, ctrl_get_quantizer64 },
   { VP9E_GET_LAST_QUANTIZER_SVC_LAYERS, ctrl_get_quantizer_svc_layers },
   { VP9E_GET_LOOPFILTER_LEVEL, ctrl_get_loopfilter_level },
+  { VP9E_GET_MODE_CONTEXT_MEMORY, ctrl_get_mode_context_memory },
+  { VP9E_GET_STAGE_TIMING, ctrl_get_stage_timing },
+  { VP8E_GET_DIRTY_RECT_STATS, ctrl_get_dirty_rect_stats },
   { VP9_GET_REFERENCE, ctrl_get_reference },
   { VP9E_GET_SVC_LAYER_ID, ctrl_get_svc_layer_id },
   { VP9E_GET_ACTIVEMAP, ctrl_get_active_map },
@@ -2352,6 +2467,7 @@ void vp9_dump_encoder_config(const VP9EncoderConfig *oxcf, FILE *fp) {
   DUMP_STRUCT_VALUE(fp, oxcf, row_mt);
   DUMP_STRUCT_VALUE(fp, oxcf, motion_vector_unit_test);
   DUMP_STRUCT_VALUE(fp, oxcf, delta_q_uv);
+  DUMP_STRUCT_VALUE(fp, oxcf, subpel_cache);
   DUMP_STRUCT_VALUE(fp, oxcf, use_simple_encode_api);
 }
 
@@ -19,6 +19,7 @@
 #include "vpx/vpx_decoder.h"
 #include "vpx_dsp/bitreader_buffer.h"
 #include "vpx_dsp/vpx_dsp_common.h"
+#include "vpx_ports/vpx_timer.h"
 #include "vpx_util/vpx_thread.h"
 
 #include "vp9/common/vp9_alloccommon.h"
@@ -296,6 +297,8 @@ static INLINE void check_resync(vpx_codec_alg_priv_t *const ctx,
 static vpx_codec_err_t decode_one(vpx_codec_alg_priv_t *ctx,
                                   const uint8_t **data, unsigned int data_sz,
                                   void *user_priv, int64_t deadline) {
+  struct vpx_usec_timer timer;
+  int failed;
   (void)deadline;
 
   // Determine the stream parameters. Note that we rely on peek_si to
@@ -318,7 +321,11 @@ static vpx_codec_err_t decode_one(vpx_codec_alg_priv_t *ctx,
   ctx->pbi->decrypt_cb = ctx->decrypt_cb;
   ctx->pbi->decrypt_state = ctx->decrypt_state;
 
-  if (vp9_receive_compressed_data(ctx->pbi, data_sz, data)) {
+  vpx_usec_timer_start(&timer);
+  failed = vp9_receive_compressed_data(ctx->pbi, data_sz, data);
+  vpx_usec_timer_mark(&timer);
+  ctx->pbi->profile.frame_us += vpx_usec_timer_elapsed(&timer);
+  if (failed) {
     ctx->pbi->cur_buf->buf.corrupted = 1;
     ctx->pbi->need_resync = 1;
     ctx->need_resync = 1;
@@ -351,6 +358,7 @@ static vpx_codec_err_t decoder_decode(vpx_codec_alg_priv_t *ctx,
     res = init_decoder(ctx);
     if (res != VPX_CODEC_OK) return res;
   }
+  vp9_zero(ctx->pbi->profile);
 
   res = vp9_parse_superframe_index(data, data_sz, frame_sizes, &frame_count,
                                    ctx->decrypt_cb, ctx->decrypt_state);
@@ -516,6 +524,15 @@ static vpx_codec_err_t ctrl_get_quantizer(vpx_codec_alg_priv_t *ctx,
   return VPX_CODEC_OK;
 }
 
+static vpx_codec_err_t ctrl_get_decode_profile(vpx_codec_alg_priv_t *ctx,
+                                               va_list args) {
+  vpx_decode_profile_t *const arg = va_arg(args, vpx_decode_profile_t *);
+  if (arg == NULL) return VPX_CODEC_INVALID_PARAM;
+  if (ctx->pbi == NULL) return VPX_CODEC_ERROR;
+  *arg = ctx->pbi->profile;
+  return VPX_CODEC_OK;
+}
+
 static vpx_codec_err_t ctrl_get_last_ref_updates(vpx_codec_alg_priv_t *ctx,
                                                  va_list args) {
   int *const update_info = va_arg(args, int *);
@@ -695,6 +712,7 @@ static vpx_codec_ctrl_fn_map_t decoder_ctrl_maps[] = {
   { VP9D_GET_DISPLAY_SIZE, ctrl_get_render_size },
   { VP9D_GET_BIT_DEPTH, ctrl_get_bit_depth },
   { VP9D_GET_FRAME_SIZE, ctrl_get_frame_size },
+  { VPXD_GET_DECODE_PROFILE, ctrl_get_decode_profile },
 
   { -1, NULL },
 };
@@ -767,6 +767,68 @@ enum vp8e_enc_control_id {
    *
    */
   VP9E_SET_QUANTIZER_ONE_PASS,
+
+  /*!\brief Codec control to get the memory held by the mode decision
+   * contexts of the partition search, in bytes.
+   *
+   * The contexts of all encoder threads are counted. Their coefficient
+   * buffers are only allocated for the block sizes a search evaluates, so
+   * the value can grow as encoding proceeds.
+   *
+   * Supported in codecs: VP9
+   */
+  VP9E_GET_MODE_CONTEXT_MEMORY,
+
+  /*!\brief Codec control to enable the per-stage timing of the encoder.
+   *
+   * 0: off (default), 1: on. Enabling the timing restarts the clock the
+   * stage start times of #VP9E_GET_STAGE_TIMING are relative to.
+   *
+   * Supported in codecs: VP9
+   */
+  VP9E_SET_STAGE_TIMING,
+
+  /*!\brief Codec control to get the per-stage timing of the last
+   * vpx_codec_encode() call, see #vpx_stage_timing_t.
+   *
+   * Requires #VP9E_SET_STAGE_TIMING to be enabled.
+   *
+   * Supported in codecs: VP9
+   */
+  VP9E_GET_STAGE_TIMING,
+
+  /*!\brief Codec control to cache the bilinear sub-pixel interpolation of
+   * the references for the motion search.
+   *
+   * 0: off (default), 1: half-pel positions, 2: half-pel and quarter-pel
+   * positions. The cache needs up to 3 (1) or 15 (2) extra luma planes per
+   * reference and leaves the output unchanged. Only the speeds that search
+   * sub-pixel motion vectors with the bilinear filter read it.
+   *
+   * Supported in codecs: VP9
+   */
+  VP9E_SET_SUBPEL_CACHE,
+
+  /*!\brief Codec control to pass the regions of the next input frame that
+   * may differ from the previous input frame, see #vpx_dirty_rects_t.
+   *
+   * The rectangles apply to the next frame passed to vpx_codec_encode() only.
+   * The encoder copies only these regions of the frame into its lookahead
+   * buffer, and codes the blocks outside of them as skipped, without any
+   * motion search or partitioning. Passing NULL marks the whole frame as
+   * dirty, which is also the default. Requires lag_in_frames to be 0 and a
+   * single spatial layer.
+   *
+   * Supported in codecs: VP8, VP9
+   */
+  VP8E_SET_DIRTY_RECTS,
+
+  /*!\brief Codec control to get the work saved on the last frame by its
+   * dirty rectangles, see #vpx_dirty_rect_stats_t.
+   *
+   * Supported in codecs: VP8, VP9
+   */
+  VP8E_GET_DIRTY_RECT_STATS,
 };
 
 /*!\brief vpx 1-D scaling mode
@@ -844,6 +906,41 @@ typedef struct vpx_active_map {
   unsigned int cols; /**< number of cols */
 } vpx_active_map_t;
 
+/*!\brief vpx dirty rectangle
+ *
+ * A region of an input frame, in pixels. Rectangles outside of the frame are
+ * clipped to it.
+ */
+typedef struct vpx_dirty_rect {
+  unsigned int x; /**< Left column */
+  unsigned int y; /**< Top row */
+  unsigned int w; /**< Width */
+  unsigned int h; /**< Height */
+} vpx_dirty_rect_t;
+
+/*!\brief vpx dirty rectangles
+ *
+ * The regions of the next input frame that may differ from the previous
+ * input frame. Used with the #VP8E_SET_DIRTY_RECTS control.
+ */
+typedef struct vpx_dirty_rects {
+  const vpx_dirty_rect_t *rects; /**< The rectangles, which may overlap */
+  unsigned int num_rects; /**< Number of rectangles, 0 if nothing changed */
+} vpx_dirty_rects_t;
+
+/*!\brief Work saved on a frame by its dirty rectangles
+ *
+ * The blocks are 64x64 superblocks in VP9 and 16x16 macroblocks in VP8. A
+ * frame without dirty rectangles is copied whole, and only the blocks turned
+ * off by the active map are skipped.
+ */
+typedef struct vpx_dirty_rect_stats {
+  unsigned int num_blocks; /**< Blocks of the frame */
+  unsigned int num_skipped_blocks; /**< Blocks coded as skipped unsearched */
+  uint64_t num_pixels;             /**< Luma pixels of the frame */
+  uint64_t num_copied_pixels; /**< Luma pixels copied into the lookahead */
+} vpx_dirty_rect_stats_t;
+
 /*!\brief  vpx image scaling mode
  *
  * This defines the data structure for image scaling mode
@@ -958,6 +1055,37 @@ typedef struct vpx_svc_spatial_layer_sync {
   int base_layer_intra_only; /**< Flag for setting Intra-only frame on base */
 } vpx_svc_spatial_layer_sync_t;
 
+/*!\brief Encoder stages timed by #VP9E_SET_STAGE_TIMING. */
+typedef enum vpx_encoder_stage {
+  VPX_STAGE_LOOKAHEAD,       /**< Lookahead queue push and pop */
+  VPX_STAGE_FIRST_PASS,      /**< First pass analysis */
+  VPX_STAGE_TPL,             /**< Temporal dependency model */
+  VPX_STAGE_TEMPORAL_FILTER, /**< Alt-ref (ARNR) temporal filter */
+  VPX_STAGE_ENCODE_FRAME,    /**< Partition and mode search */
+  VPX_STAGE_LOOPFILTER,      /**< Loop filter level pick and filtering */
+  VPX_STAGE_PACK_BITSTREAM,  /**< Bitstream packing */
+  VPX_STAGE_RATE_CONTROL,    /**< Rate control frame setup and update */
+  VPX_STAGE_COUNT            /**< Number of stages */
+} vpx_encoder_stage_t;
+
+/*!\brief Per-stage timing of one vpx_codec_encode() call
+ *
+ * A call codes one frame, together with its hidden alt-ref if any, except
+ * when flushing the lookahead, which may code several frames in one call.
+ * All times are in microseconds. Start times are relative to the moment the
+ * timing was enabled. A stage that ran several times, e.g. the partition
+ * search of a recoded frame, reports the start of its first run and the
+ * total time of all its runs. Stages that did not run have a start time of
+ * -1 and a duration of 0.
+ */
+typedef struct vpx_stage_timing {
+  int64_t frame_start_us;    /**< Start of the vpx_codec_encode() call */
+  int64_t frame_duration_us; /**< Duration of the vpx_codec_encode() call */
+  int64_t start_us[VPX_STAGE_COUNT];    /**< Start of each stage */
+  int64_t duration_us[VPX_STAGE_COUNT]; /**< Total time of each stage */
+  int frame_count; /**< Frames coded by the call, including hidden ones */
+} vpx_stage_timing_t;
+
 /*!\cond */
 /*!\brief VP8 encoder control function parameter type
  *
@@ -1097,6 +1225,18 @@ VPX_CTRL_USE_TYPE(VP8E_SET_RTC_EXTERNAL_RATECTRL, int)
 #define VPX_CTRL_VP8E_SET_RTC_EXTERNAL_RATECTRL
 VPX_CTRL_USE_TYPE(VP9E_SET_QUANTIZER_ONE_PASS, int)
 #define VPX_CTRL_VP9E_SET_QUANTIZER_ONE_PASS
+VPX_CTRL_USE_TYPE(VP9E_GET_MODE_CONTEXT_MEMORY, size_t *)
+#define VPX_CTRL_VP9E_GET_MODE_CONTEXT_MEMORY
+VPX_CTRL_USE_TYPE(VP9E_SET_STAGE_TIMING, int)
+#define VPX_CTRL_VP9E_SET_STAGE_TIMING
+VPX_CTRL_USE_TYPE(VP9E_GET_STAGE_TIMING, vpx_stage_timing_t *)
+#define VPX_CTRL_VP9E_GET_STAGE_TIMING
+VPX_CTRL_USE_TYPE(VP9E_SET_SUBPEL_CACHE, int)
+#define VPX_CTRL_VP9E_SET_SUBPEL_CACHE
+VPX_CTRL_USE_TYPE(VP8E_SET_DIRTY_RECTS, vpx_dirty_rects_t *)
+#define VPX_CTRL_VP8E_SET_DIRTY_RECTS
+VPX_CTRL_USE_TYPE(VP8E_GET_DIRTY_RECT_STATS, vpx_dirty_rect_stats_t *)
+#define VPX_CTRL_VP8E_GET_DIRTY_RECT_STATS
 
 /*!\endcond */
 /*! @} - end defgroup vp8_encoder */
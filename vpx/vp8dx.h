@@ -158,6 +158,17 @@ enum vp8_dec_control_id {
    */
   VP9D_SET_LOOP_FILTER_OPT,
 
+  /*!\brief Codec control function to get the profiling counters of the last
+   * decode call, vpx_decode_profile_t* parameter.
+   *
+   * The counters are reset by every call to vpx_codec_decode(). Time spent
+   * in post-processing is added when the frame is fetched with
+   * vpx_codec_get_frame().
+   *
+   * Supported in codecs: VP8, VP9
+   */
+  VPXD_GET_DECODE_PROFILE,
+
   VP8_DECODER_CTRL_ID_MAX
 };
 
@@ -179,6 +190,36 @@ typedef struct vpx_decrypt_init {
   void *decrypt_state;
 } vpx_decrypt_init;
 
+/*!\brief Maximum number of tiles reported in vpx_decode_profile_t. */
+#define VPX_DECODE_PROFILE_MAX_TILES 256
+
+/*!\brief Decoder profiling counters
+ *
+ * Filled in by VPXD_GET_DECODE_PROFILE. All times are in microseconds. Work
+ * done by several threads is summed over the threads, so with multithreading
+ * the parts may add up to more than frame_us.
+ *
+ * Where blocks are parsed and reconstructed in a single pass, which is the
+ * case for VP8 tokens and for VP9 without row based multithreading, the time
+ * of that pass is counted in recon_us. Multithreaded VP8 filters each
+ * macroblock right after reconstructing it, so its loop filter time is also
+ * part of recon_us.
+ */
+typedef struct vpx_decode_profile {
+  int frame_count;       /**< Frames decoded by the call */
+  int64_t frame_us;      /**< Elapsed time of the call */
+  int64_t header_us;     /**< Frame header parsing and frame setup */
+  int64_t parse_us;      /**< Separate parsing of modes and coefficients */
+  int64_t recon_us;      /**< Prediction and reconstruction */
+  int64_t loopfilter_us; /**< Loop filtering */
+  int64_t postproc_us;   /**< Post-processing in vpx_codec_get_frame() */
+  int64_t wait_us;       /**< Time threads spent blocked on other threads */
+  /*!\brief Number of entries of tile_bytes: the tiles (VP9) or the token
+   * partitions (VP8) of the last decoded frame. */
+  int tile_count;
+  uint32_t tile_bytes[VPX_DECODE_PROFILE_MAX_TILES]; /**< Size of each tile */
+} vpx_decode_profile_t;
+
 /*!\cond */
 /*!\brief VP8 decoder control function parameter type
  *
@@ -217,6 +258,8 @@ VPX_CTRL_USE_TYPE(VP9D_SET_ROW_MT, int)
 #define VPX_CTRL_VP9_DECODE_SET_ROW_MT
 VPX_CTRL_USE_TYPE(VP9D_SET_LOOP_FILTER_OPT, int)
 #define VPX_CTRL_VP9_SET_LOOP_FILTER_OPT
+VPX_CTRL_USE_TYPE(VPXD_GET_DECODE_PROFILE, vpx_decode_profile_t *)
+#define VPX_CTRL_VPXD_GET_DECODE_PROFILE
 
 /*!\endcond */
 /*! @} - end defgroup vp8_decoder */
@@ -309,6 +309,35 @@ SAD_WXH_4D_NEON(64, 64)
 
 #undef SAD_WXH_4D_NEON
 
+// The 8 references are compared as two groups of 4.
+#define SAD_WXH_8D_NEON(w, h)                                                  \
+  void vpx_sad##w##x##h##x8d_neon(const uint8_t *src, int src_stride,          \
+                                  const uint8_t *const ref[8], int ref_stride, \
+                                  uint32_t res[8]) {                           \
+    sad##w##xhx4d_neon(src, src_stride, ref, ref_stride, res, (h));            \
+    sad##w##xhx4d_neon(src, src_stride, ref + 4, ref_stride, res + 4, (h));    \
+  }
+
+SAD_WXH_8D_NEON(4, 4)
+SAD_WXH_8D_NEON(4, 8)
+
+SAD_WXH_8D_NEON(8, 4)
+SAD_WXH_8D_NEON(8, 8)
+SAD_WXH_8D_NEON(8, 16)
+
+SAD_WXH_8D_NEON(16, 8)
+SAD_WXH_8D_NEON(16, 16)
+SAD_WXH_8D_NEON(16, 32)
+
+SAD_WXH_8D_NEON(32, 16)
+SAD_WXH_8D_NEON(32, 32)
+SAD_WXH_8D_NEON(32, 64)
+
+SAD_WXH_8D_NEON(64, 32)
+SAD_WXH_8D_NEON(64, 64)
+
+#undef SAD_WXH_8D_NEON
+
 #define SAD_SKIP_WXH_4D_NEON(w, h)                                          \
   void vpx_sad_skip_##w##x##h##x4d_neon(const uint8_t *src, int src_stride, \
                                         const uint8_t *const ref[4],        \
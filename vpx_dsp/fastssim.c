@@ -16,6 +16,7 @@
 #include <string.h>
 #include "./vpx_config.h"
 #include "./vpx_dsp_rtcd.h"
+#include "vpx_dsp/metrics_mt.h"
 #include "vpx_dsp/ssim.h"
 #include "vpx_ports/system_state.h"
 
@@ -496,3 +497,54 @@ double vpx_calc_fastssim(const YV12_BUFFER_CONFIG *source,
   ssimv = (*ssim_y) * .8 + .1 * ((*ssim_u) + (*ssim_v));
   return convert_ssim_db(ssimv, 1.0);
 }
+
+typedef struct {
+  const YV12_BUFFER_CONFIG *source;
+  const YV12_BUFFER_CONFIG *dest;
+  uint32_t in_bd;
+  uint32_t bd_shift;
+  double ssim[3];
+} FastSsimJobData;
+
+// The planes are independent, so each one is a job of its own.
+static void fastssim_job(void *arg, int plane) {
+  FastSsimJobData *const fd = (FastSsimJobData *)arg;
+  const YV12_BUFFER_CONFIG *const src = fd->source;
+  const YV12_BUFFER_CONFIG *const dst = fd->dest;
+  if (plane == 0) {
+    fd->ssim[0] = calc_ssim(src->y_buffer, src->y_stride, dst->y_buffer,
+                            dst->y_stride, src->y_crop_width,
+                            src->y_crop_height, fd->in_bd, fd->bd_shift);
+  } else {
+    fd->ssim[plane] =
+        calc_ssim(plane == 1 ? src->u_buffer : src->v_buffer, src->uv_stride,
+                  plane == 1 ? dst->u_buffer : dst->v_buffer, dst->uv_stride,
+                  src->uv_crop_width, src->uv_crop_height, fd->in_bd,
+                  fd->bd_shift);
+  }
+}
+
+double vpx_calc_fastssim_mt(const YV12_BUFFER_CONFIG *source,
+                            const YV12_BUFFER_CONFIG *dest, double *ssim_y,
+                            double *ssim_u, double *ssim_v, uint32_t bd,
+                            uint32_t in_bd, VPxWorker *workers,
+                            int num_workers) {
+  FastSsimJobData fd;
+  double ssimv;
+  if (num_workers <= 1) {
+    return vpx_calc_fastssim(source, dest, ssim_y, ssim_u, ssim_v, bd, in_bd);
+  }
+  vpx_clear_system_state();
+  assert(bd >= in_bd);
+  fd.source = source;
+  fd.dest = dest;
+  fd.in_bd = in_bd;
+  fd.bd_shift = bd - in_bd;
+  vpx_metrics_run_jobs(fastssim_job, &fd, 3, workers, num_workers);
+  *ssim_y = fd.ssim[0];
+  *ssim_u = fd.ssim[1];
+  *ssim_v = fd.ssim[2];
+
+  ssimv = (*ssim_y) * .8 + .1 * ((*ssim_u) + (*ssim_v));
+  return convert_ssim_db(ssimv, 1.0);
+}
@@ -0,0 +1,86 @@
+/*
+ *  Copyright (c) 2023 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "vpx_dsp/metrics_mt.h"
+#include "vpx_dsp/vpx_dsp_common.h"
+#include "vpx_ports/system_state.h"
+
+typedef struct {
+  VpxMetricsJobFn fn;
+  void *data;
+  int start;
+  int step;
+  int num_jobs;
+} MetricsWorkerData;
+
+static int metrics_worker_hook(void *arg1, void *unused) {
+  const MetricsWorkerData *const wd = (const MetricsWorkerData *)arg1;
+  int job;
+  (void)unused;
+  vpx_clear_system_state();
+  for (job = wd->start; job < wd->num_jobs; job += wd->step)
+    wd->fn(wd->data, job);
+  return 1;
+}
+
+void vpx_metrics_run_jobs(VpxMetricsJobFn fn, void *data, int num_jobs,
+                          VPxWorker *workers, int num_workers) {
+  const VPxWorkerInterface *const winterface = vpx_get_worker_interface();
+  VPxWorker local_workers[MAX_METRICS_WORKERS];
+  MetricsWorkerData worker_data[MAX_METRICS_WORKERS];
+  int own_workers = 0;
+  int i;
+
+  num_workers = VPXMIN(num_workers, VPXMIN(num_jobs, MAX_METRICS_WORKERS));
+  if (num_workers <= 1) {
+    for (i = 0; i < num_jobs; ++i) fn(data, i);
+    return;
+  }
+
+  if (workers == NULL) {
+    // The last worker runs on the calling thread and needs no thread of its
+    // own. Fall back to fewer workers if thread creation fails.
+    workers = local_workers;
+    own_workers = 1;
+    for (i = 0; i < num_workers; ++i) {
+      winterface->init(&workers[i]);
+      if (i < num_workers - 1 && !winterface->reset(&workers[i])) {
+        num_workers = i + 1;
+        break;
+      }
+    }
+  }
+
+  for (i = 0; i < num_workers; ++i) {
+    VPxWorker *const worker = &workers[i];
+    MetricsWorkerData *const wd = &worker_data[i];
+    wd->fn = fn;
+    wd->data = data;
+    wd->start = i;
+    wd->step = num_workers;
+    wd->num_jobs = num_jobs;
+    worker->hook = metrics_worker_hook;
+    worker->data1 = wd;
+    worker->data2 = NULL;
+  }
+
+  for (i = 0; i < num_workers; ++i) {
+    if (i == num_workers - 1)
+      winterface->execute(&workers[i]);
+    else
+      winterface->launch(&workers[i]);
+  }
+
+  for (i = 0; i < num_workers; ++i) winterface->sync(&workers[i]);
+
+  if (own_workers) {
+    for (i = 0; i < num_workers; ++i) winterface->end(&workers[i]);
+  }
+}
@@ -0,0 +1,44 @@
+/*
+ *  Copyright (c) 2023 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef VPX_VPX_DSP_METRICS_MT_H_
+#define VPX_VPX_DSP_METRICS_MT_H_
+
+#include "vpx_util/vpx_thread.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MAX_METRICS_WORKERS 64
+
+// Computes job |job| of a metric. Jobs must be independent of each other and
+// write their results to job-indexed storage so that the caller can reduce
+// them in a fixed order, which keeps the metric bit-exact with the serial
+// computation regardless of the number of workers.
+typedef void (*VpxMetricsJobFn)(void *data, int job);
+
+// Runs |num_jobs| jobs on up to |num_workers| workers and returns once all of
+// them are done. Worker i handles jobs i, i + num_workers, ...
+//
+// |workers| may be an already running pool (e.g. the encoder's), in which
+// case the last worker is executed on the calling thread as is done by the
+// VP9 encoder. The hook and data pointers of those workers are overwritten.
+// If |workers| is NULL and |num_workers| > 1, temporary threads are created
+// for the duration of the call. With |num_workers| <= 1 the jobs run on the
+// calling thread.
+void vpx_metrics_run_jobs(VpxMetricsJobFn fn, void *data, int num_jobs,
+                          VPxWorker *workers, int num_workers);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // VPX_VPX_DSP_METRICS_MT_H_
@@ -8,6 +8,7 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include "./vpx_dsp_rtcd.h"
 #include "./prob.h"
 
 const uint8_t vpx_norm[256] = {
@@ -45,3 +46,36 @@ void vpx_tree_merge_probs(const vpx_tree_index *tree, const vpx_prob *pre_probs,
                           const unsigned int *counts, vpx_prob *probs) {
   tree_merge_probs_impl(0, tree, pre_probs, counts, probs);
 }
+
+static unsigned int tree_branch_counts_impl(unsigned int i,
+                                            const vpx_tree_index *tree,
+                                            const unsigned int *counts,
+                                            unsigned int *branch_ct) {
+  const int l = tree[i];
+  const unsigned int left_count =
+      (l <= 0) ? counts[-l]
+               : tree_branch_counts_impl(l, tree, counts, branch_ct);
+  const int r = tree[i + 1];
+  const unsigned int right_count =
+      (r <= 0) ? counts[-r]
+               : tree_branch_counts_impl(r, tree, counts, branch_ct);
+  branch_ct[i] = left_count;
+  branch_ct[i + 1] = right_count;
+  return left_count + right_count;
+}
+
+void vpx_tree_branch_counts(const vpx_tree_index *tree,
+                            const unsigned int *counts,
+                            unsigned int *branch_ct) {
+  tree_branch_counts_impl(0, tree, counts, branch_ct);
+}
+
+void vpx_merge_probs_c(const uint8_t *pre_probs, const unsigned int *branch_ct,
+                       int n, unsigned int count_sat,
+                       unsigned int max_update_factor, uint8_t *probs) {
+  int i;
+  for (i = 0; i < n; ++i) {
+    probs[i] = merge_probs(pre_probs[i], &branch_ct[2 * i], count_sat,
+                           max_update_factor);
+  }
+}
@@ -35,6 +35,7 @@ typedef int8_t vpx_tree_index;
 #define vpx_complement(x) (255 - (x))
 
 #define MODE_MV_COUNT_SAT 20
+#define MODE_MV_MAX_UPDATE_FACTOR 128
 
 /* We build coding trees compactly in arrays.
    Each node of the tree is a pair of vpx_tree_indices.
@@ -97,6 +98,14 @@ static INLINE vpx_prob mode_mv_merge_probs(vpx_prob pre_prob,
 void vpx_tree_merge_probs(const vpx_tree_index *tree, const vpx_prob *pre_probs,
                           const unsigned int *counts, vpx_prob *probs);
 
+// Writes the counts of the left and right branches of each node of |tree| to
+// |branch_ct| as pairs, in the order of the node probabilities. The result can
+// be passed to vpx_merge_probs() with MODE_MV_COUNT_SAT and
+// MODE_MV_MAX_UPDATE_FACTOR to get the vpx_tree_merge_probs() probabilities.
+void vpx_tree_branch_counts(const vpx_tree_index *tree,
+                            const unsigned int *counts,
+                            unsigned int *branch_ct);
+
 DECLARE_ALIGNED(16, extern const uint8_t, vpx_norm[256]);
 
 #ifdef __cplusplus
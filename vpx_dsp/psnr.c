@@ -11,7 +11,10 @@
 #include <math.h>
 #include <assert.h>
 #include "./vpx_dsp_rtcd.h"
+#include "vpx_dsp/metrics_mt.h"
 #include "vpx_dsp/psnr.h"
+#include "vpx_dsp/vpx_dsp_common.h"
+#include "vpx_mem/vpx_mem.h"
 #include "vpx_scale/yv12config.h"
 
 double vpx_sse_to_psnr(double samples, double peak, double sse) {
@@ -156,6 +159,18 @@ static int64_t highbd_get_sse(const uint8_t *a, int a_stride, const uint8_t *b,
 }
 #endif  // CONFIG_VP9_HIGHBITDEPTH
 
+int64_t vpx_get_sse(const uint8_t *a, int a_stride, const uint8_t *b,
+                    int b_stride, int width, int height) {
+  return get_sse(a, a_stride, b, b_stride, width, height);
+}
+
+#if CONFIG_VP9_HIGHBITDEPTH
+int64_t vpx_highbd_get_sse(const uint8_t *a, int a_stride, const uint8_t *b,
+                           int b_stride, int width, int height) {
+  return highbd_get_sse(a, a_stride, b, b_stride, width, height);
+}
+#endif  // CONFIG_VP9_HIGHBITDEPTH
+
 int64_t vpx_get_y_sse(const YV12_BUFFER_CONFIG *a,
                       const YV12_BUFFER_CONFIG *b) {
   assert(a->y_crop_width == b->y_crop_width);
@@ -260,3 +275,133 @@ void vpx_calc_psnr(const YV12_BUFFER_CONFIG *a, const YV12_BUFFER_CONFIG *b,
   psnr->psnr[0] =
       vpx_sse_to_psnr((double)total_samples, peak, (double)total_sse);
 }
+
+// Rows per job of the multithreaded PSNR. A multiple of 16 so that the bands
+// are made of the same 16x16 blocks as the whole plane.
+#define PSNR_JOB_ROWS 64
+
+typedef struct {
+  const uint8_t *a_planes[3];
+  const uint8_t *b_planes[3];
+  int a_strides[3];
+  int b_strides[3];
+  int widths[3];
+  int heights[3];
+  int first_job[4];
+  int use_highbitdepth;
+  unsigned int input_shift;
+  int64_t *job_sse;
+} PsnrJobData;
+
+static void psnr_job(void *arg, int job) {
+  PsnrJobData *const pd = (PsnrJobData *)arg;
+  int plane = 0;
+  int y0, h;
+  const uint8_t *a, *b;
+  while (job >= pd->first_job[plane + 1]) ++plane;
+  y0 = (job - pd->first_job[plane]) * PSNR_JOB_ROWS;
+  h = VPXMIN(PSNR_JOB_ROWS, pd->heights[plane] - y0);
+  a = pd->a_planes[plane] + y0 * pd->a_strides[plane];
+  b = pd->b_planes[plane] + y0 * pd->b_strides[plane];
+#if CONFIG_VP9_HIGHBITDEPTH
+  if (pd->use_highbitdepth) {
+    if (pd->input_shift) {
+      pd->job_sse[job] =
+          highbd_get_sse_shift(a, pd->a_strides[plane], b, pd->b_strides[plane],
+                               pd->widths[plane], h, pd->input_shift);
+    } else {
+      pd->job_sse[job] = highbd_get_sse(a, pd->a_strides[plane], b,
+                                        pd->b_strides[plane], pd->widths[plane],
+                                        h);
+    }
+    return;
+  }
+#endif  // CONFIG_VP9_HIGHBITDEPTH
+  pd->job_sse[job] = get_sse(a, pd->a_strides[plane], b, pd->b_strides[plane],
+                             pd->widths[plane], h);
+}
+
+// Splits the planes into bands of PSNR_JOB_ROWS rows and sums their SSE on
+// |num_workers| workers. Integer SSE sums do not depend on the split, so the
+// result is identical to the single-threaded one. Returns 0 if the job
+// storage cannot be allocated.
+static int calc_psnr_mt(const YV12_BUFFER_CONFIG *a,
+                        const YV12_BUFFER_CONFIG *b, PSNR_STATS *psnr,
+                        double peak, unsigned int input_shift,
+                        VPxWorker *workers, int num_workers) {
+  PsnrJobData pd;
+  int i;
+  uint64_t total_sse = 0;
+  uint32_t total_samples = 0;
+
+  pd.a_planes[0] = a->y_buffer;
+  pd.a_planes[1] = a->u_buffer;
+  pd.a_planes[2] = a->v_buffer;
+  pd.b_planes[0] = b->y_buffer;
+  pd.b_planes[1] = b->u_buffer;
+  pd.b_planes[2] = b->v_buffer;
+  pd.a_strides[0] = a->y_stride;
+  pd.a_strides[1] = pd.a_strides[2] = a->uv_stride;
+  pd.b_strides[0] = b->y_stride;
+  pd.b_strides[1] = pd.b_strides[2] = b->uv_stride;
+  pd.widths[0] = a->y_crop_width;
+  pd.widths[1] = pd.widths[2] = a->uv_crop_width;
+  pd.heights[0] = a->y_crop_height;
+  pd.heights[1] = pd.heights[2] = a->uv_crop_height;
+  pd.use_highbitdepth = (a->flags & YV12_FLAG_HIGHBITDEPTH) != 0;
+  pd.input_shift = input_shift;
+  pd.first_job[0] = 0;
+  for (i = 0; i < 3; ++i) {
+    pd.first_job[i + 1] = pd.first_job[i] +
+                          (pd.heights[i] + PSNR_JOB_ROWS - 1) / PSNR_JOB_ROWS;
+  }
+  pd.job_sse = (int64_t *)vpx_malloc(pd.first_job[3] * sizeof(*pd.job_sse));
+  if (pd.job_sse == NULL) return 0;
+
+  vpx_metrics_run_jobs(psnr_job, &pd, pd.first_job[3], workers, num_workers);
+
+  for (i = 0; i < 3; ++i) {
+    const uint32_t samples = pd.widths[i] * pd.heights[i];
+    uint64_t sse = 0;
+    int job;
+    for (job = pd.first_job[i]; job < pd.first_job[i + 1]; ++job)
+      sse += pd.job_sse[job];
+    psnr->sse[1 + i] = sse;
+    psnr->samples[1 + i] = samples;
+    psnr->psnr[1 + i] = vpx_sse_to_psnr(samples, peak, (double)sse);
+
+    total_sse += sse;
+    total_samples += samples;
+  }
+  vpx_free(pd.job_sse);
+
+  psnr->sse[0] = total_sse;
+  psnr->samples[0] = total_samples;
+  psnr->psnr[0] =
+      vpx_sse_to_psnr((double)total_samples, peak, (double)total_sse);
+  return 1;
+}
+
+#if CONFIG_VP9_HIGHBITDEPTH
+void vpx_calc_highbd_psnr_mt(const YV12_BUFFER_CONFIG *a,
+                             const YV12_BUFFER_CONFIG *b, PSNR_STATS *psnr,
+                             uint32_t bit_depth, uint32_t in_bit_depth,
+                             VPxWorker *workers, int num_workers) {
+  const double peak = (double)((1 << in_bit_depth) - 1);
+  const unsigned int input_shift = bit_depth - in_bit_depth;
+  if (num_workers > 1 && calc_psnr_mt(a, b, psnr, peak, input_shift, workers,
+                                      num_workers)) {
+    return;
+  }
+  vpx_calc_highbd_psnr(a, b, psnr, bit_depth, in_bit_depth);
+}
+#endif  // CONFIG_VP9_HIGHBITDEPTH
+
+void vpx_calc_psnr_mt(const YV12_BUFFER_CONFIG *a, const YV12_BUFFER_CONFIG *b,
+                      PSNR_STATS *psnr, VPxWorker *workers, int num_workers) {
+  if (num_workers > 1 &&
+      calc_psnr_mt(a, b, psnr, 255.0, 0, workers, num_workers)) {
+    return;
+  }
+  vpx_calc_psnr(a, b, psnr);
+}
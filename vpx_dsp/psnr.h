@@ -13,6 +13,7 @@
 
 #include "vpx_scale/yv12config.h"
 #include "vpx/vpx_encoder.h"
+#include "vpx_util/vpx_thread.h"
 
 #define MAX_PSNR 100.0
 
@@ -33,8 +34,14 @@ typedef struct vpx_psnr_pkt PSNR_STATS;
  * \param[in]    sse           Sum of squared errors
  */
 double vpx_sse_to_psnr(double samples, double peak, double sse);
+// Sum of squared errors between two width x height regions. For high bitdepth
+// the buffers are passed in the CONVERT_TO_BYTEPTR() form.
+int64_t vpx_get_sse(const uint8_t *a, int a_stride, const uint8_t *b,
+                    int b_stride, int width, int height);
 int64_t vpx_get_y_sse(const YV12_BUFFER_CONFIG *a, const YV12_BUFFER_CONFIG *b);
 #if CONFIG_VP9_HIGHBITDEPTH
+int64_t vpx_highbd_get_sse(const uint8_t *a, int a_stride, const uint8_t *b,
+                           int b_stride, int width, int height);
 int64_t vpx_highbd_get_y_sse(const YV12_BUFFER_CONFIG *a,
                              const YV12_BUFFER_CONFIG *b);
 void vpx_calc_highbd_psnr(const YV12_BUFFER_CONFIG *a,
@@ -44,6 +51,19 @@ void vpx_calc_highbd_psnr(const YV12_BUFFER_CONFIG *a,
 void vpx_calc_psnr(const YV12_BUFFER_CONFIG *a, const YV12_BUFFER_CONFIG *b,
                    PSNR_STATS *psnr);
 
+// Row-parallel versions of vpx_calc_psnr() and vpx_calc_highbd_psnr(). The
+// planes are split into row bands that are processed on |num_workers|
+// workers (see vpx_metrics_run_jobs()). The results are bit-exact with the
+// single-threaded functions.
+#if CONFIG_VP9_HIGHBITDEPTH
+void vpx_calc_highbd_psnr_mt(const YV12_BUFFER_CONFIG *a,
+                             const YV12_BUFFER_CONFIG *b, PSNR_STATS *psnr,
+                             unsigned int bit_depth, unsigned int in_bit_depth,
+                             VPxWorker *workers, int num_workers);
+#endif
+void vpx_calc_psnr_mt(const YV12_BUFFER_CONFIG *a, const YV12_BUFFER_CONFIG *b,
+                      PSNR_STATS *psnr, VPxWorker *workers, int num_workers);
+
 double vpx_psnrhvs(const YV12_BUFFER_CONFIG *source,
                    const YV12_BUFFER_CONFIG *dest, double *phvs_y,
                    double *phvs_u, double *phvs_v, uint32_t bd, uint32_t in_bd);
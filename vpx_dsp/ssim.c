@@ -11,7 +11,10 @@
 #include <assert.h>
 #include <math.h>
 #include "./vpx_dsp_rtcd.h"
+#include "vpx_dsp/metrics_mt.h"
 #include "vpx_dsp/ssim.h"
+#include "vpx_dsp/vpx_dsp_common.h"
+#include "vpx_mem/vpx_mem.h"
 #include "vpx_ports/mem.h"
 #include "vpx_ports/system_state.h"
 
@@ -459,3 +462,131 @@ double vpx_highbd_calc_ssim(const YV12_BUFFER_CONFIG *source,
 }
 
 #endif  // CONFIG_VP9_HIGHBITDEPTH
+
+typedef struct {
+  const uint8_t *src_planes[3];
+  const uint8_t *dst_planes[3];
+  int src_strides[3];
+  int dst_strides[3];
+  int cols[3];
+  int first_job[4];
+  int use_highbitdepth;
+  uint32_t bd;
+  uint32_t shift;
+  // One entry per 8x8 window, in raster order within each plane.
+  double *values;
+  int first_value[3];
+} SsimJobData;
+
+// Computes the windows of one row of 8x8 windows (4 pixel rows apart).
+static void ssim_job(void *arg, int job) {
+  SsimJobData *const sd = (SsimJobData *)arg;
+  int plane = 0;
+  int row, j;
+  const uint8_t *img1, *img2;
+  double *values;
+  while (job >= sd->first_job[plane + 1]) ++plane;
+  row = job - sd->first_job[plane];
+  img1 = sd->src_planes[plane] + row * 4 * sd->src_strides[plane];
+  img2 = sd->dst_planes[plane] + row * 4 * sd->dst_strides[plane];
+  values = sd->values + sd->first_value[plane] + row * sd->cols[plane];
+  for (j = 0; j < sd->cols[plane]; ++j) {
+#if CONFIG_VP9_HIGHBITDEPTH
+    if (sd->use_highbitdepth) {
+      values[j] = highbd_ssim_8x8(CONVERT_TO_SHORTPTR(img1 + j * 4),
+                                  sd->src_strides[plane],
+                                  CONVERT_TO_SHORTPTR(img2 + j * 4),
+                                  sd->dst_strides[plane], sd->bd, sd->shift);
+      continue;
+    }
+#endif  // CONFIG_VP9_HIGHBITDEPTH
+    values[j] = ssim_8x8(img1 + j * 4, sd->src_strides[plane], img2 + j * 4,
+                         sd->dst_strides[plane]);
+  }
+}
+
+// Computes the windows of all planes on |num_workers| workers and then sums
+// them on the calling thread in the same order as vpx_ssim2(), so the result
+// is bit-exact with the single-threaded version. Returns 0 if the window
+// storage cannot be allocated.
+static int calc_ssim_mt(const YV12_BUFFER_CONFIG *source,
+                        const YV12_BUFFER_CONFIG *dest, double *ssimv,
+                        int use_highbitdepth, uint32_t bd, uint32_t shift,
+                        VPxWorker *workers, int num_workers) {
+  SsimJobData sd;
+  double plane_ssim[3];
+  int widths[3], heights[3];
+  int i, num_values = 0;
+
+  sd.src_planes[0] = source->y_buffer;
+  sd.src_planes[1] = source->u_buffer;
+  sd.src_planes[2] = source->v_buffer;
+  sd.dst_planes[0] = dest->y_buffer;
+  sd.dst_planes[1] = dest->u_buffer;
+  sd.dst_planes[2] = dest->v_buffer;
+  sd.src_strides[0] = source->y_stride;
+  sd.src_strides[1] = sd.src_strides[2] = source->uv_stride;
+  sd.dst_strides[0] = dest->y_stride;
+  sd.dst_strides[1] = sd.dst_strides[2] = dest->uv_stride;
+  widths[0] = source->y_crop_width;
+  widths[1] = widths[2] = source->uv_crop_width;
+  heights[0] = source->y_crop_height;
+  heights[1] = heights[2] = source->uv_crop_height;
+  sd.use_highbitdepth = use_highbitdepth;
+  sd.bd = bd;
+  sd.shift = shift;
+  sd.first_job[0] = 0;
+  for (i = 0; i < 3; ++i) {
+    const int rows = heights[i] >= 8 ? (heights[i] - 8) / 4 + 1 : 0;
+    sd.cols[i] = widths[i] >= 8 ? (widths[i] - 8) / 4 + 1 : 0;
+    sd.first_job[i + 1] = sd.first_job[i] + rows;
+    sd.first_value[i] = num_values;
+    num_values += rows * sd.cols[i];
+  }
+  sd.values = (double *)vpx_malloc(VPXMAX(num_values, 1) * sizeof(*sd.values));
+  if (sd.values == NULL) return 0;
+
+  vpx_metrics_run_jobs(ssim_job, &sd, sd.first_job[3], workers, num_workers);
+
+  for (i = 0; i < 3; ++i) {
+    const int samples = (sd.first_job[i + 1] - sd.first_job[i]) * sd.cols[i];
+    const double *const values = sd.values + sd.first_value[i];
+    double ssim_total = 0;
+    int k;
+    for (k = 0; k < samples; ++k) ssim_total += values[k];
+    ssim_total /= samples;
+    plane_ssim[i] = ssim_total;
+  }
+  vpx_free(sd.values);
+
+  *ssimv = plane_ssim[0] * .8 + .1 * (plane_ssim[1] + plane_ssim[2]);
+  return 1;
+}
+
+double vpx_calc_ssim_mt(const YV12_BUFFER_CONFIG *source,
+                        const YV12_BUFFER_CONFIG *dest, double *weight,
+                        VPxWorker *workers, int num_workers) {
+  double ssimv;
+  if (num_workers > 1 &&
+      calc_ssim_mt(source, dest, &ssimv, 0, 8, 0, workers, num_workers)) {
+    *weight = 1;
+    return ssimv;
+  }
+  return vpx_calc_ssim(source, dest, weight);
+}
+
+#if CONFIG_VP9_HIGHBITDEPTH
+double vpx_highbd_calc_ssim_mt(const YV12_BUFFER_CONFIG *source,
+                               const YV12_BUFFER_CONFIG *dest, double *weight,
+                               uint32_t bd, uint32_t in_bd, VPxWorker *workers,
+                               int num_workers) {
+  double ssimv;
+  assert(bd >= in_bd);
+  if (num_workers > 1 && calc_ssim_mt(source, dest, &ssimv, 1, in_bd,
+                                      bd - in_bd, workers, num_workers)) {
+    *weight = 1;
+    return ssimv;
+  }
+  return vpx_highbd_calc_ssim(source, dest, weight, bd, in_bd);
+}
+#endif  // CONFIG_VP9_HIGHBITDEPTH
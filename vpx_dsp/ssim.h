@@ -19,6 +19,7 @@ extern "C" {
 
 #include "./vpx_config.h"
 #include "vpx_scale/yv12config.h"
+#include "vpx_util/vpx_thread.h"
 
 // metrics used for calculating ssim, ssim2, dssim, and ssimc
 typedef struct {
@@ -80,6 +81,26 @@ double vpx_highbd_calc_ssim(const YV12_BUFFER_CONFIG *source,
                             uint32_t bd, uint32_t in_bd);
 #endif  // CONFIG_VP9_HIGHBITDEPTH
 
+// Row-parallel versions of the functions above. The work is spread over
+// |num_workers| workers (see vpx_metrics_run_jobs()) and the results are
+// bit-exact with the single-threaded functions.
+double vpx_calc_ssim_mt(const YV12_BUFFER_CONFIG *source,
+                        const YV12_BUFFER_CONFIG *dest, double *weight,
+                        VPxWorker *workers, int num_workers);
+
+double vpx_calc_fastssim_mt(const YV12_BUFFER_CONFIG *source,
+                            const YV12_BUFFER_CONFIG *dest, double *ssim_y,
+                            double *ssim_u, double *ssim_v, uint32_t bd,
+                            uint32_t in_bd, VPxWorker *workers,
+                            int num_workers);
+
+#if CONFIG_VP9_HIGHBITDEPTH
+double vpx_highbd_calc_ssim_mt(const YV12_BUFFER_CONFIG *source,
+                               const YV12_BUFFER_CONFIG *dest, double *weight,
+                               uint32_t bd, uint32_t in_bd, VPxWorker *workers,
+                               int num_workers);
+#endif  // CONFIG_VP9_HIGHBITDEPTH
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
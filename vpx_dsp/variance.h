@@ -78,6 +78,9 @@ typedef struct vp9_variance_vtable {
   vpx_sad_multi_d_fn_t sdx4df;
   // Same as sadx4, but downsample the rows by a factor of 2.
   vpx_sad_multi_d_fn_t sdsx4df;
+  // Same as sadx4, but for 8 references. NULL if the block size has no such
+  // function, in which case the references are compared 4 at a time.
+  vpx_sad_multi_d_fn_t sdx8df;
 } vp9_variance_fn_ptr_t;
 #endif  // CONFIG_VP9
 
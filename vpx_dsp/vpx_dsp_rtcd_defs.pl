@@ -37,6 +37,12 @@ if ($opts{arch} eq "x86_64") {
   $avx512_x86_64 = 'avx512';
 }
 
+#
+# Probability adaptation
+#
+add_proto qw/void vpx_merge_probs/, "const uint8_t *pre_probs, const unsigned int *branch_ct, int n, unsigned int count_sat, unsigned int max_update_factor, uint8_t *probs";
+specialize qw/vpx_merge_probs sse2/;
+
 #
 # Intra prediction
 #
@@ -1006,6 +1012,47 @@ specialize qw/vpx_sad_skip_4x8x4d neon sse2/;
 add_proto qw/void vpx_sad_skip_4x4x4d/, "const uint8_t *src_ptr, int src_stride, const uint8_t * const ref_array[4], int ref_stride, uint32_t sad_array[4]";
 specialize qw/vpx_sad_skip_4x4x4d neon/;
 
+# Multi-candidate SAD: compares the source to 8 references in one call, for
+# the motion searches that evaluate up to 8 candidates per step.
+add_proto qw/void vpx_sad64x64x8d/, "const uint8_t *src_ptr, int src_stride, const uint8_t * const ref_array[8], int ref_stride, uint32_t sad_array[8]";
+specialize qw/vpx_sad64x64x8d avx512 avx2 neon/;
+
+add_proto qw/void vpx_sad64x32x8d/, "const uint8_t *src_ptr, int src_stride, const uint8_t * const ref_array[8], int ref_stride, uint32_t sad_array[8]";
+specialize qw/vpx_sad64x32x8d avx512 avx2 neon/;
+
+add_proto qw/void vpx_sad32x64x8d/, "const uint8_t *src_ptr, int src_stride, const uint8_t * const ref_array[8], int ref_stride, uint32_t sad_array[8]";
+specialize qw/vpx_sad32x64x8d avx2 neon/;
+
+add_proto qw/void vpx_sad32x32x8d/, "const uint8_t *src_ptr, int src_stride, const uint8_t * const ref_array[8], int ref_stride, uint32_t sad_array[8]";
+specialize qw/vpx_sad32x32x8d avx2 neon/;
+
+add_proto qw/void vpx_sad32x16x8d/, "const uint8_t *src_ptr, int src_stride, const uint8_t * const ref_array[8], int ref_stride, uint32_t sad_array[8]";
+specialize qw/vpx_sad32x16x8d avx2 neon/;
+
+add_proto qw/void vpx_sad16x32x8d/, "const uint8_t *src_ptr, int src_stride, const uint8_t * const ref_array[8], int ref_stride, uint32_t sad_array[8]";
+specialize qw/vpx_sad16x32x8d avx2 neon/;
+
+add_proto qw/void vpx_sad16x16x8d/, "const uint8_t *src_ptr, int src_stride, const uint8_t * const ref_array[8], int ref_stride, uint32_t sad_array[8]";
+specialize qw/vpx_sad16x16x8d avx2 neon/;
+
+add_proto qw/void vpx_sad16x8x8d/, "const uint8_t *src_ptr, int src_stride, const uint8_t * const ref_array[8], int ref_stride, uint32_t sad_array[8]";
+specialize qw/vpx_sad16x8x8d avx2 neon/;
+
+add_proto qw/void vpx_sad8x16x8d/, "const uint8_t *src_ptr, int src_stride, const uint8_t * const ref_array[8], int ref_stride, uint32_t sad_array[8]";
+specialize qw/vpx_sad8x16x8d avx2 neon/;
+
+add_proto qw/void vpx_sad8x8x8d/, "const uint8_t *src_ptr, int src_stride, const uint8_t * const ref_array[8], int ref_stride, uint32_t sad_array[8]";
+specialize qw/vpx_sad8x8x8d avx2 neon/;
+
+add_proto qw/void vpx_sad8x4x8d/, "const uint8_t *src_ptr, int src_stride, const uint8_t * const ref_array[8], int ref_stride, uint32_t sad_array[8]";
+specialize qw/vpx_sad8x4x8d avx2 neon/;
+
+add_proto qw/void vpx_sad4x8x8d/, "const uint8_t *src_ptr, int src_stride, const uint8_t * const ref_array[8], int ref_stride, uint32_t sad_array[8]";
+specialize qw/vpx_sad4x8x8d neon/;
+
+add_proto qw/void vpx_sad4x4x8d/, "const uint8_t *src_ptr, int src_stride, const uint8_t * const ref_array[8], int ref_stride, uint32_t sad_array[8]";
+specialize qw/vpx_sad4x4x8d neon/;
+
 add_proto qw/uint64_t vpx_sum_squares_2d_i16/, "const int16_t *src, int stride, int size";
 specialize qw/vpx_sum_squares_2d_i16 neon sse2 msa/;
 
@@ -1014,10 +1061,10 @@ specialize qw/vpx_sum_squares_2d_i16 neon sse2 msa/;
 #
 if (vpx_config("CONFIG_INTERNAL_STATS") eq "yes") {
     add_proto qw/void vpx_ssim_parms_8x8/, "const uint8_t *s, int sp, const uint8_t *r, int rp, uint32_t *sum_s, uint32_t *sum_r, uint32_t *sum_sq_s, uint32_t *sum_sq_r, uint32_t *sum_sxr";
-    specialize qw/vpx_ssim_parms_8x8/, "$sse2_x86_64";
+    specialize qw/vpx_ssim_parms_8x8 avx2/, "$sse2_x86_64";
 
     add_proto qw/void vpx_ssim_parms_16x16/, "const uint8_t *s, int sp, const uint8_t *r, int rp, uint32_t *sum_s, uint32_t *sum_r, uint32_t *sum_sq_s, uint32_t *sum_sq_r, uint32_t *sum_sxr";
-    specialize qw/vpx_ssim_parms_16x16/, "$sse2_x86_64";
+    specialize qw/vpx_ssim_parms_16x16 avx2/, "$sse2_x86_64";
 }
 
 if (vpx_config("CONFIG_VP9_HIGHBITDEPTH") eq "yes") {
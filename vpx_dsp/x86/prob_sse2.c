@@ -0,0 +1,103 @@
+/*
+ *  Copyright (c) 2023 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <emmintrin.h>
+
+#include "./vpx_dsp_rtcd.h"
+#include "vpx_dsp/prob.h"
+#include "vpx_dsp/x86/mem_sse2.h"
+
+// Converts the low two unsigned 32-bit lanes of |v| to double.
+static INLINE __m128d cvt_epu32_pd(const __m128i v) {
+  const __m128i sign = _mm_set1_epi32((int)0x80000000u);
+  return _mm_add_pd(_mm_cvtepi32_pd(_mm_xor_si128(v, sign)),
+                    _mm_set1_pd(2147483648.0));
+}
+
+// Returns the four truncated quotients of the doubles in |num| and |den|. The
+// numerators are integers below 2^53 and the denominators are integers below
+// 2^32, so the correctly rounded division never reaches the next integer and
+// the truncation matches the integer division.
+static INLINE __m128i div_trunc_pd(const __m128d num[2], const __m128d den[2]) {
+  return _mm_unpacklo_epi64(_mm_cvttpd_epi32(_mm_div_pd(num[0], den[0])),
+                            _mm_cvttpd_epi32(_mm_div_pd(num[1], den[1])));
+}
+
+void vpx_merge_probs_sse2(const uint8_t *pre_probs,
+                          const unsigned int *branch_ct, int n,
+                          unsigned int count_sat,
+                          unsigned int max_update_factor, uint8_t *probs) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i one = _mm_set1_epi32(1);
+  const __m128i sign = _mm_set1_epi32((int)0x80000000u);
+  const __m128i sat = _mm_set1_epi32((int)count_sat);
+  const __m128i sat_signed = _mm_xor_si128(sat, sign);
+  const __m128d sat_pd = _mm_set1_pd((double)count_sat);
+  const __m128d update_pd = _mm_set1_pd((double)max_update_factor);
+  const __m128d scale_pd = _mm_set1_pd(256.0);
+  int i;
+
+  for (i = 0; i + 4 <= n; i += 4) {
+    // Separate the 4 pairs of branch counts into n0 and n1.
+    const __m128i a = _mm_shuffle_epi32(
+        _mm_loadu_si128((const __m128i *)(branch_ct + 2 * i)), 0xd8);
+    const __m128i b = _mm_shuffle_epi32(
+        _mm_loadu_si128((const __m128i *)(branch_ct + 2 * i + 4)), 0xd8);
+    const __m128i n0 = _mm_unpacklo_epi64(a, b);
+    const __m128i den = _mm_add_epi32(n0, _mm_unpackhi_epi64(a, b));
+    // count = VPXMIN(den, count_sat) as unsigned values.
+    const __m128i den_gt_sat =
+        _mm_cmpgt_epi32(_mm_xor_si128(den, sign), sat_signed);
+    const __m128i count = _mm_or_si128(_mm_and_si128(den_gt_sat, sat),
+                                       _mm_andnot_si128(den_gt_sat, den));
+    // A zero count gives a zero factor, so any non-zero denominator can
+    // stand in for it.
+    const __m128i den_nz =
+        _mm_or_si128(den, _mm_and_si128(_mm_cmpeq_epi32(den, zero), one));
+    const __m128i half = _mm_srli_epi32(den, 1);
+    __m128d num_pd[2], den_pd[2];
+    __m128i p, factor, pre, w, x, sum;
+
+    // factor = max_update_factor * count / count_sat
+    num_pd[0] = _mm_mul_pd(_mm_cvtepi32_pd(count), update_pd);
+    num_pd[1] =
+        _mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(count, 8)), update_pd);
+    den_pd[0] = den_pd[1] = sat_pd;
+    factor = div_trunc_pd(num_pd, den_pd);
+
+    // p = (n0 * 256 + (den >> 1)) / den, clamped to [1, 255].
+    num_pd[0] = _mm_add_pd(_mm_mul_pd(cvt_epu32_pd(n0), scale_pd),
+                           _mm_cvtepi32_pd(half));
+    num_pd[1] =
+        _mm_add_pd(_mm_mul_pd(cvt_epu32_pd(_mm_srli_si128(n0, 8)), scale_pd),
+                   _mm_cvtepi32_pd(_mm_srli_si128(half, 8)));
+    den_pd[0] = cvt_epu32_pd(den_nz);
+    den_pd[1] = cvt_epu32_pd(_mm_srli_si128(den_nz, 8));
+    p = div_trunc_pd(num_pd, den_pd);
+    p = _mm_packs_epi32(p, p);
+    p = _mm_min_epi16(_mm_max_epi16(p, _mm_set1_epi16(1)),
+                      _mm_set1_epi16(255));
+
+    // weighted_prob(): (pre * (256 - factor) + p * factor + 128) >> 8
+    factor = _mm_packs_epi32(factor, factor);
+    pre = _mm_unpacklo_epi8(load_unaligned_u32(pre_probs + i), zero);
+    x = _mm_unpacklo_epi16(pre, p);
+    w = _mm_unpacklo_epi16(_mm_sub_epi16(_mm_set1_epi16(256), factor), factor);
+    sum = _mm_madd_epi16(x, w);
+    sum = _mm_srli_epi32(_mm_add_epi32(sum, _mm_set1_epi32(128)), 8);
+    sum = _mm_packs_epi32(sum, sum);
+    store_unaligned_u32(probs + i, _mm_packus_epi16(sum, sum));
+  }
+
+  for (; i < n; ++i) {
+    probs[i] = merge_probs(pre_probs[i], &branch_ct[2 * i], count_sat,
+                           max_update_factor);
+  }
+}
@@ -0,0 +1,172 @@
+/*
+ *  Copyright (c) 2023 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+#include <immintrin.h>  // AVX2
+#include "./vpx_dsp_rtcd.h"
+#include "vpx/vpx_integer.h"
+
+// Each of |sums| holds 4 64-bit partial sums whose high halves are zero.
+static INLINE void calc_final_8(const __m256i *const sums /*[8]*/,
+                                uint32_t sad_array[8]) {
+  const __m256i t0 = _mm256_hadd_epi32(sums[0], sums[1]);
+  const __m256i t1 = _mm256_hadd_epi32(sums[2], sums[3]);
+  const __m256i t2 = _mm256_hadd_epi32(sums[4], sums[5]);
+  const __m256i t3 = _mm256_hadd_epi32(sums[6], sums[7]);
+  // Sums 0-3 in t4 and 4-7 in t5, split across the two 128-bit lanes.
+  const __m256i t4 = _mm256_hadd_epi32(t0, t1);
+  const __m256i t5 = _mm256_hadd_epi32(t2, t3);
+  const __m256i sum =
+      _mm256_add_epi32(_mm256_permute2x128_si256(t4, t5, 0x20),
+                       _mm256_permute2x128_si256(t4, t5, 0x31));
+  _mm256_storeu_si256((__m256i *)sad_array, sum);
+}
+
+static INLINE void init_refs(const uint8_t *const ref_array[8],
+                             const uint8_t *refs[8], __m256i sums[8]) {
+  int j;
+  for (j = 0; j < 8; ++j) {
+    refs[j] = ref_array[j];
+    sums[j] = _mm256_setzero_si256();
+  }
+}
+
+// Loads 16 bytes from each of 2 rows.
+static INLINE __m256i load_16x2(const uint8_t *p, int stride) {
+  return _mm256_inserti128_si256(
+      _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)p)),
+      _mm_loadu_si128((const __m128i *)(p + stride)), 1);
+}
+
+// Loads 8 bytes from each of 4 rows.
+static INLINE __m256i load_8x4(const uint8_t *p, int stride) {
+  const __m128i lo =
+      _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)p),
+                         _mm_loadl_epi64((const __m128i *)(p + stride)));
+  const __m128i hi =
+      _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)(p + 2 * stride)),
+                         _mm_loadl_epi64((const __m128i *)(p + 3 * stride)));
+  return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+}
+
+static INLINE void sad64xhx8d_avx2(const uint8_t *src_ptr, int src_stride,
+                                   const uint8_t *const ref_array[8],
+                                   int ref_stride, int h,
+                                   uint32_t sad_array[8]) {
+  const uint8_t *refs[8];
+  __m256i sums[8];
+  int i, j;
+
+  init_refs(ref_array, refs, sums);
+  for (i = 0; i < h; ++i) {
+    const __m256i s_lo = _mm256_loadu_si256((const __m256i *)src_ptr);
+    const __m256i s_hi = _mm256_loadu_si256((const __m256i *)(src_ptr + 32));
+    for (j = 0; j < 8; ++j) {
+      const __m256i r_lo = _mm256_loadu_si256((const __m256i *)refs[j]);
+      const __m256i r_hi = _mm256_loadu_si256((const __m256i *)(refs[j] + 32));
+      sums[j] = _mm256_add_epi32(sums[j], _mm256_sad_epu8(r_lo, s_lo));
+      sums[j] = _mm256_add_epi32(sums[j], _mm256_sad_epu8(r_hi, s_hi));
+      refs[j] += ref_stride;
+    }
+    src_ptr += src_stride;
+  }
+
+  calc_final_8(sums, sad_array);
+}
+
+static INLINE void sad32xhx8d_avx2(const uint8_t *src_ptr, int src_stride,
+                                   const uint8_t *const ref_array[8],
+                                   int ref_stride, int h,
+                                   uint32_t sad_array[8]) {
+  const uint8_t *refs[8];
+  __m256i sums[8];
+  int i, j;
+
+  init_refs(ref_array, refs, sums);
+  for (i = 0; i < h; ++i) {
+    const __m256i s = _mm256_loadu_si256((const __m256i *)src_ptr);
+    for (j = 0; j < 8; ++j) {
+      const __m256i r = _mm256_loadu_si256((const __m256i *)refs[j]);
+      sums[j] = _mm256_add_epi32(sums[j], _mm256_sad_epu8(r, s));
+      refs[j] += ref_stride;
+    }
+    src_ptr += src_stride;
+  }
+
+  calc_final_8(sums, sad_array);
+}
+
+// Two rows per iteration.
+static INLINE void sad16xhx8d_avx2(const uint8_t *src_ptr, int src_stride,
+                                   const uint8_t *const ref_array[8],
+                                   int ref_stride, int h,
+                                   uint32_t sad_array[8]) {
+  const uint8_t *refs[8];
+  __m256i sums[8];
+  int i, j;
+
+  init_refs(ref_array, refs, sums);
+  for (i = 0; i < h; i += 2) {
+    const __m256i s = load_16x2(src_ptr, src_stride);
+    for (j = 0; j < 8; ++j) {
+      const __m256i r = load_16x2(refs[j], ref_stride);
+      sums[j] = _mm256_add_epi32(sums[j], _mm256_sad_epu8(r, s));
+      refs[j] += 2 * ref_stride;
+    }
+    src_ptr += 2 * src_stride;
+  }
+
+  calc_final_8(sums, sad_array);
+}
+
+// Four rows per iteration.
+static INLINE void sad8xhx8d_avx2(const uint8_t *src_ptr, int src_stride,
+                                  const uint8_t *const ref_array[8],
+                                  int ref_stride, int h,
+                                  uint32_t sad_array[8]) {
+  const uint8_t *refs[8];
+  __m256i sums[8];
+  int i, j;
+
+  init_refs(ref_array, refs, sums);
+  for (i = 0; i < h; i += 4) {
+    const __m256i s = load_8x4(src_ptr, src_stride);
+    for (j = 0; j < 8; ++j) {
+      const __m256i r = load_8x4(refs[j], ref_stride);
+      sums[j] = _mm256_add_epi32(sums[j], _mm256_sad_epu8(r, s));
+      refs[j] += 4 * ref_stride;
+    }
+    src_ptr += 4 * src_stride;
+  }
+
+  calc_final_8(sums, sad_array);
+}
+
+#define SAD_WXH_8D_AVX2(w, h)                                                  \
+  void vpx_sad##w##x##h##x8d_avx2(const uint8_t *src, int src_stride,          \
+                                  const uint8_t *const ref[8], int ref_stride, \
+                                  uint32_t res[8]) {                           \
+    sad##w##xhx8d_avx2(src, src_stride, ref, ref_stride, (h), res);            \
+  }
+
+SAD_WXH_8D_AVX2(64, 64)
+SAD_WXH_8D_AVX2(64, 32)
+
+SAD_WXH_8D_AVX2(32, 64)
+SAD_WXH_8D_AVX2(32, 32)
+SAD_WXH_8D_AVX2(32, 16)
+
+SAD_WXH_8D_AVX2(16, 32)
+SAD_WXH_8D_AVX2(16, 16)
+SAD_WXH_8D_AVX2(16, 8)
+
+SAD_WXH_8D_AVX2(8, 16)
+SAD_WXH_8D_AVX2(8, 8)
+SAD_WXH_8D_AVX2(8, 4)
+
+#undef SAD_WXH_8D_AVX2
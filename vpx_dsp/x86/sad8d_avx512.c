@@ -0,0 +1,51 @@
+/*
+ *  Copyright (c) 2023 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+#include <immintrin.h>  // AVX512
+#include "./vpx_dsp_rtcd.h"
+#include "vpx/vpx_integer.h"
+
+static INLINE void sad64xhx8d_avx512(const uint8_t *src_ptr, int src_stride,
+                                     const uint8_t *const ref_array[8],
+                                     int ref_stride, int h,
+                                     uint32_t sad_array[8]) {
+  const uint8_t *refs[8];
+  __m512i sums[8];
+  int i, j;
+
+  for (j = 0; j < 8; ++j) {
+    refs[j] = ref_array[j];
+    sums[j] = _mm512_setzero_si512();
+  }
+  for (i = 0; i < h; ++i) {
+    const __m512i s = _mm512_loadu_si512((const __m512i *)src_ptr);
+    for (j = 0; j < 8; ++j) {
+      const __m512i r = _mm512_loadu_si512((const __m512i *)refs[j]);
+      sums[j] = _mm512_add_epi64(sums[j], _mm512_sad_epu8(r, s));
+      refs[j] += ref_stride;
+    }
+    src_ptr += src_stride;
+  }
+
+  for (j = 0; j < 8; ++j) {
+    sad_array[j] = (uint32_t)_mm512_reduce_add_epi64(sums[j]);
+  }
+}
+
+void vpx_sad64x64x8d_avx512(const uint8_t *src_ptr, int src_stride,
+                            const uint8_t *const ref_array[8], int ref_stride,
+                            uint32_t sad_array[8]) {
+  sad64xhx8d_avx512(src_ptr, src_stride, ref_array, ref_stride, 64, sad_array);
+}
+
+void vpx_sad64x32x8d_avx512(const uint8_t *src_ptr, int src_stride,
+                            const uint8_t *const ref_array[8], int ref_stride,
+                            uint32_t sad_array[8]) {
+  sad64xhx8d_avx512(src_ptr, src_stride, ref_array, ref_stride, 32, sad_array);
+}
@@ -0,0 +1,101 @@
+/*
+ *  Copyright (c) 2023 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <immintrin.h>
+
+#include "./vpx_dsp_rtcd.h"
+#include "vpx/vpx_integer.h"
+
+// Adds the 16 zero-extended pixels of |s16| and |r16| into the 32-bit lane
+// accumulators. Each _mm256_madd_epi16 result lane holds the sum of two
+// products of 8-bit values, so the lanes cannot overflow for a 16x16 block.
+static INLINE void accumulate_parms(const __m256i s16, const __m256i r16,
+                                    __m256i *sum_s, __m256i *sum_r,
+                                    __m256i *sum_sq_s, __m256i *sum_sq_r,
+                                    __m256i *sum_sxr) {
+  const __m256i one = _mm256_set1_epi16(1);
+  *sum_s = _mm256_add_epi32(*sum_s, _mm256_madd_epi16(s16, one));
+  *sum_r = _mm256_add_epi32(*sum_r, _mm256_madd_epi16(r16, one));
+  *sum_sq_s = _mm256_add_epi32(*sum_sq_s, _mm256_madd_epi16(s16, s16));
+  *sum_sq_r = _mm256_add_epi32(*sum_sq_r, _mm256_madd_epi16(r16, r16));
+  *sum_sxr = _mm256_add_epi32(*sum_sxr, _mm256_madd_epi16(s16, r16));
+}
+
+static INLINE uint32_t hsum_epi32(const __m256i v) {
+  const __m128i lo = _mm256_castsi256_si128(v);
+  const __m128i hi = _mm256_extracti128_si256(v, 1);
+  __m128i sum = _mm_add_epi32(lo, hi);
+  sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 8));
+  sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 4));
+  return (uint32_t)_mm_cvtsi128_si32(sum);
+}
+
+static INLINE void store_parms(const __m256i sum_s, const __m256i sum_r,
+                               const __m256i sum_sq_s, const __m256i sum_sq_r,
+                               const __m256i sum_sxr, uint32_t *s_out,
+                               uint32_t *r_out, uint32_t *sq_s_out,
+                               uint32_t *sq_r_out, uint32_t *sxr_out) {
+  *s_out += hsum_epi32(sum_s);
+  *r_out += hsum_epi32(sum_r);
+  *sq_s_out += hsum_epi32(sum_sq_s);
+  *sq_r_out += hsum_epi32(sum_sq_r);
+  *sxr_out += hsum_epi32(sum_sxr);
+}
+
+void vpx_ssim_parms_16x16_avx2(const uint8_t *s, int sp, const uint8_t *r,
+                               int rp, uint32_t *sum_s, uint32_t *sum_r,
+                               uint32_t *sum_sq_s, uint32_t *sum_sq_r,
+                               uint32_t *sum_sxr) {
+  __m256i v_sum_s = _mm256_setzero_si256();
+  __m256i v_sum_r = _mm256_setzero_si256();
+  __m256i v_sum_sq_s = _mm256_setzero_si256();
+  __m256i v_sum_sq_r = _mm256_setzero_si256();
+  __m256i v_sum_sxr = _mm256_setzero_si256();
+  int i;
+
+  for (i = 0; i < 16; ++i, s += sp, r += rp) {
+    const __m256i s16 =
+        _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)s));
+    const __m256i r16 =
+        _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)r));
+    accumulate_parms(s16, r16, &v_sum_s, &v_sum_r, &v_sum_sq_s, &v_sum_sq_r,
+                     &v_sum_sxr);
+  }
+
+  store_parms(v_sum_s, v_sum_r, v_sum_sq_s, v_sum_sq_r, v_sum_sxr, sum_s,
+              sum_r, sum_sq_s, sum_sq_r, sum_sxr);
+}
+
+void vpx_ssim_parms_8x8_avx2(const uint8_t *s, int sp, const uint8_t *r,
+                             int rp, uint32_t *sum_s, uint32_t *sum_r,
+                             uint32_t *sum_sq_s, uint32_t *sum_sq_r,
+                             uint32_t *sum_sxr) {
+  __m256i v_sum_s = _mm256_setzero_si256();
+  __m256i v_sum_r = _mm256_setzero_si256();
+  __m256i v_sum_sq_s = _mm256_setzero_si256();
+  __m256i v_sum_sq_r = _mm256_setzero_si256();
+  __m256i v_sum_sxr = _mm256_setzero_si256();
+  int i;
+
+  // Two 8-pixel rows are packed into each 256-bit register.
+  for (i = 0; i < 8; i += 2, s += 2 * sp, r += 2 * rp) {
+    const __m128i s8 =
+        _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)s),
+                           _mm_loadl_epi64((const __m128i *)(s + sp)));
+    const __m128i r8 =
+        _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)r),
+                           _mm_loadl_epi64((const __m128i *)(r + rp)));
+    accumulate_parms(_mm256_cvtepu8_epi16(s8), _mm256_cvtepu8_epi16(r8),
+                     &v_sum_s, &v_sum_r, &v_sum_sq_s, &v_sum_sq_r, &v_sum_sxr);
+  }
+
+  store_parms(v_sum_s, v_sum_r, v_sum_sq_s, v_sum_sq_r, v_sum_sxr, sum_s,
+              sum_r, sum_sq_s, sum_sq_r, sum_sxr);
+}
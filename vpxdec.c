@@ -22,6 +22,7 @@
 #endif
 
 #include "./args.h"
+#include "./frame_queue.h"
 #include "./ivfdec.h"
 
 #include "vpx/vpx_decoder.h"
@@ -72,6 +73,8 @@ static const arg_def_t postprocarg =
     ARG_DEF(NULL, "postproc", 0, "Postprocess decoded frames");
 static const arg_def_t summaryarg =
     ARG_DEF(NULL, "summary", 0, "Show timing summary");
+static const arg_def_t profilearg =
+    ARG_DEF(NULL, "profile", 0, "Show decoder profiling counters");
 static const arg_def_t outputfile =
     ARG_DEF("o", "output", 1, "Output file name pattern (see below)");
 static const arg_def_t threadsarg =
@@ -103,6 +106,9 @@ static const arg_def_t rowmtarg =
 static const arg_def_t lpfoptarg =
     ARG_DEF(NULL, "lpf-opt", 1,
             "Do loopfilter without waiting for all threads to sync.");
+static const arg_def_t threadedioarg =
+    ARG_DEF(NULL, "threaded-io", 0,
+            "Read the input and write the output on separate threads");
 
 static const arg_def_t *all_args[] = { &help,
                                        &codecarg,
@@ -116,6 +122,7 @@ static const arg_def_t *all_args[] = { &help,
                                        &skiparg,
                                        &postprocarg,
                                        &summaryarg,
+                                       &profilearg,
                                        &outputfile,
                                        &threadsarg,
                                        &frameparallelarg,
@@ -132,6 +139,7 @@ static const arg_def_t *all_args[] = { &help,
                                        &framestatsarg,
                                        &rowmtarg,
                                        &lpfoptarg,
+                                       &threadedioarg,
                                        NULL };
 
 #if CONFIG_VP8_DECODER
@@ -324,6 +332,241 @@ static void write_image_file(const vpx_image_t *img, const int planes[3],
   }
 }
 
+/* Writes the y4m headers, if any, and the image, if not NULL, to |outfile|, or
+ * adds them to the MD5 sum if |md5| is not NULL.
+ */
+static void write_output_frame(const char *header, size_t header_len,
+                               const vpx_image_t *img, const int planes[3],
+                               MD5Context *md5, FILE *outfile) {
+  if (md5) {
+    if (header_len) {
+      MD5Update(md5, (const md5byte *)header, (unsigned int)header_len);
+    }
+    if (img) update_image_md5(img, planes, md5);
+  } else {
+    if (header_len) fwrite(header, 1, header_len, outfile);
+    if (img) write_image_file(img, planes, outfile);
+  }
+}
+
+struct io_threads;
+
+#if CONFIG_MULTITHREAD
+/* With --threaded-io the compressed frames are read by a reader thread, and
+ * the decoded frames of a single output file written out, or hashed, by a
+ * writer thread. Each thread is a frame queue ahead of or behind the decoder.
+ */
+
+struct input_frame {
+  uint8_t *buf;
+  size_t bytes;
+  size_t buf_size;
+};
+
+struct output_frame {
+  char header[2 * Y4M_BUFFER_SIZE];
+  size_t header_len;
+  int planes[3];
+  vpx_image_t img;
+  int img_allocated;
+  int has_img;
+};
+
+struct io_threads {
+  struct VpxDecInputContext *input;
+  int max_frames;
+  /* The read buffer, which the webm reader reuses from one frame to the next,
+   * taken over from the decoder loop while the reader runs.
+   */
+  uint8_t *buf;
+  size_t bytes_in_buffer;
+  size_t buffer_size;
+  struct input_frame inputs[FRAME_QUEUE_SIZE];
+  int input_index;
+  struct frame_queue input_queue;
+  pthread_t reader;
+  int writing;
+  MD5Context *md5;
+  FILE *outfile;
+  struct output_frame outputs[FRAME_QUEUE_SIZE];
+  struct frame_queue output_queue;
+  pthread_t writer;
+};
+
+static THREADFN input_reader(void *arg) {
+  struct io_threads *const io = (struct io_threads *)arg;
+  int frames = 0;
+
+  while (!io->max_frames || frames < io->max_frames) {
+    const int index = frame_queue_get_free(&io->input_queue);
+    struct input_frame *frame;
+
+    if (index < 0) break;
+    if (dec_read_frame(io->input, &io->buf, &io->bytes_in_buffer,
+                       &io->buffer_size))
+      break;
+    frame = &io->inputs[index];
+    if (io->bytes_in_buffer > frame->buf_size) {
+      free(frame->buf);
+      frame->buf = (uint8_t *)malloc(io->bytes_in_buffer);
+      if (!frame->buf) fatal("Failed to allocate input frame");
+      frame->buf_size = io->bytes_in_buffer;
+    }
+    memcpy(frame->buf, io->buf, io->bytes_in_buffer);
+    frame->bytes = io->bytes_in_buffer;
+    frame_queue_push(&io->input_queue);
+    frames++;
+  }
+  frame_queue_close(&io->input_queue);
+  return THREAD_RETURN(NULL);
+}
+
+static THREADFN output_writer(void *arg) {
+  struct io_threads *const io = (struct io_threads *)arg;
+  int index;
+
+  while ((index = frame_queue_get_filled(&io->output_queue)) >= 0) {
+    const struct output_frame *const output = &io->outputs[index];
+    write_output_frame(output->header, output->header_len,
+                       output->has_img ? &output->img : NULL, output->planes,
+                       io->md5, io->outfile);
+    frame_queue_pop(&io->output_queue);
+  }
+  return THREAD_RETURN(NULL);
+}
+
+/* Returns the next compressed frame in |*buf|, releasing the previous one, or
+ * 1 at the end of the input, like dec_read_frame().
+ */
+static int read_queued_frame(struct io_threads *io, uint8_t **buf,
+                             size_t *bytes_in_buffer) {
+  if (io->input_index >= 0) frame_queue_pop(&io->input_queue);
+  io->input_index = frame_queue_get_filled(&io->input_queue);
+  if (io->input_index < 0) return 1;
+  *buf = io->inputs[io->input_index].buf;
+  *bytes_in_buffer = io->inputs[io->input_index].bytes;
+  return 0;
+}
+
+static void queue_output_frame(struct io_threads *io, const char *header,
+                               size_t header_len, const vpx_image_t *img,
+                               const int planes[3]) {
+  const int index = frame_queue_get_free(&io->output_queue);
+  struct output_frame *const output = &io->outputs[index];
+
+  assert(index >= 0);
+  assert(header_len <= sizeof(output->header));
+  memcpy(output->header, header, header_len);
+  output->header_len = header_len;
+  memcpy(output->planes, planes, sizeof(output->planes));
+  output->has_img = img != NULL;
+  if (img) {
+    if (output->img_allocated &&
+        (output->img.fmt != img->fmt || output->img.d_w != img->d_w ||
+         output->img.d_h != img->d_h)) {
+      vpx_img_free(&output->img);
+      output->img_allocated = 0;
+    }
+    if (!output->img_allocated) {
+      if (!vpx_img_alloc(&output->img, img->fmt, img->d_w, img->d_h, 16))
+        fatal("Failed to allocate output frame");
+      output->img_allocated = 1;
+    }
+    vpx_img_copy(&output->img, img);
+  }
+  frame_queue_push(&io->output_queue);
+}
+
+/* Starts the reader, reading up to |max_frames| frames if not 0 into the read
+ * buffer taken over from the caller.
+ */
+static void start_input_reader(struct io_threads *io,
+                               struct VpxDecInputContext *input, int max_frames,
+                               uint8_t **buf, size_t *bytes_in_buffer,
+                               size_t *buffer_size) {
+  memset(io, 0, sizeof(*io));
+  io->input = input;
+  io->max_frames = max_frames;
+  io->buf = *buf;
+  io->bytes_in_buffer = *bytes_in_buffer;
+  io->buffer_size = *buffer_size;
+  *buf = NULL;
+  *bytes_in_buffer = *buffer_size = 0;
+  io->input_index = -1;
+  frame_queue_init(&io->input_queue);
+  if (pthread_create(&io->reader, NULL, input_reader, io))
+    fatal("Failed to create input reader thread");
+}
+
+/* Starts the writer of the single output file, or of its MD5 sum if |md5| is
+ * not NULL.
+ */
+static void start_output_writer(struct io_threads *io, MD5Context *md5,
+                                FILE *outfile) {
+  io->writing = 1;
+  io->md5 = md5;
+  io->outfile = outfile;
+  frame_queue_init(&io->output_queue);
+  if (pthread_create(&io->writer, NULL, output_writer, io))
+    fatal("Failed to create output writer thread");
+}
+
+/* Stops the reader, handing the read buffer back, and waits for the writer to
+ * write the queued frames.
+ */
+static void stop_io_threads(struct io_threads *io, uint8_t **buf,
+                            size_t *bytes_in_buffer, size_t *buffer_size) {
+  int i;
+
+  frame_queue_close(&io->input_queue);
+  pthread_join(io->reader, NULL);
+  frame_queue_destroy(&io->input_queue);
+  for (i = 0; i < FRAME_QUEUE_SIZE; ++i) free(io->inputs[i].buf);
+  *buf = io->buf;
+  *bytes_in_buffer = io->bytes_in_buffer;
+  *buffer_size = io->buffer_size;
+
+  if (!io->writing) return;
+  frame_queue_close(&io->output_queue);
+  pthread_join(io->writer, NULL);
+  frame_queue_destroy(&io->output_queue);
+  for (i = 0; i < FRAME_QUEUE_SIZE; ++i) {
+    if (io->outputs[i].img_allocated) vpx_img_free(&io->outputs[i].img);
+  }
+}
+#endif  // CONFIG_MULTITHREAD
+
+/* Reads the next compressed frame, from the reader thread if |io| is not
+ * NULL.
+ */
+static int read_input_frame(struct VpxDecInputContext *input,
+                            struct io_threads *io, uint8_t **buf,
+                            size_t *bytes_in_buffer, size_t *buffer_size) {
+#if CONFIG_MULTITHREAD
+  if (io) return read_queued_frame(io, buf, bytes_in_buffer);
+#else
+  (void)io;
+#endif
+  return dec_read_frame(input, buf, bytes_in_buffer, buffer_size);
+}
+
+/* Writes a frame of the single output file, from the writer thread if |io|
+ * has one.
+ */
+static void output_frame(struct io_threads *io, const char *header,
+                         size_t header_len, const vpx_image_t *img,
+                         const int planes[3], MD5Context *md5, FILE *outfile) {
+#if CONFIG_MULTITHREAD
+  if (io && io->writing) {
+    queue_output_frame(io, header, header_len, img, planes);
+    return;
+  }
+#else
+  (void)io;
+#endif
+  write_output_frame(header, header_len, img, planes, md5, outfile);
+}
+
 static int file_is_raw(struct VpxInputContext *input) {
   uint8_t buf[32];
   int is_raw = 0;
@@ -362,6 +605,66 @@ static void show_progress(int frame_in, int frame_out, uint64_t dx_time) {
           (double)frame_out * 1000000.0 / (double)dx_time);
 }
 
+// Decoder profiling counters summed over the decode calls.
+struct DecodeProfile {
+  int calls;
+  int frames;
+  int64_t frame_us;
+  int64_t header_us;
+  int64_t parse_us;
+  int64_t recon_us;
+  int64_t loopfilter_us;
+  int64_t postproc_us;
+  int64_t wait_us;
+  int tile_count;
+  uint64_t tile_bytes[VPX_DECODE_PROFILE_MAX_TILES];
+};
+
+static void add_decode_profile(struct DecodeProfile *total,
+                               const vpx_decode_profile_t *profile) {
+  int i;
+  ++total->calls;
+  total->frames += profile->frame_count;
+  total->frame_us += profile->frame_us;
+  total->header_us += profile->header_us;
+  total->parse_us += profile->parse_us;
+  total->recon_us += profile->recon_us;
+  total->loopfilter_us += profile->loopfilter_us;
+  total->postproc_us += profile->postproc_us;
+  total->wait_us += profile->wait_us;
+  if (profile->tile_count > total->tile_count) {
+    total->tile_count = profile->tile_count;
+  }
+  for (i = 0; i < profile->tile_count; ++i) {
+    total->tile_bytes[i] += profile->tile_bytes[i];
+  }
+}
+
+static void show_decode_profile(const struct DecodeProfile *total) {
+  const int frames = total->frames > 0 ? total->frames : 1;
+  const struct {
+    const char *name;
+    int64_t us;
+  } parts[] = { { "decode", total->frame_us },
+                { "header", total->header_us },
+                { "parse", total->parse_us },
+                { "recon", total->recon_us },
+                { "loopfilter", total->loopfilter_us },
+                { "postproc", total->postproc_us },
+                { "wait", total->wait_us } };
+  int i;
+
+  fprintf(stderr, "Decoder profile over %d frames:\n", total->frames);
+  for (i = 0; i < (int)(sizeof(parts) / sizeof(parts[0])); ++i) {
+    fprintf(stderr, "  %-10s %10" PRId64 " us %10.1f us/frame\n",
+            parts[i].name, parts[i].us, (double)parts[i].us / frames);
+  }
+  for (i = 0; i < total->tile_count; ++i) {
+    fprintf(stderr, "  tile %-5d %10.1f bytes/call\n", i,
+            (double)total->tile_bytes[i] / total->calls);
+  }
+}
+
 struct ExternalFrameBuffer {
   uint8_t *data;
   size_t size;
@@ -525,11 +828,14 @@ static int main_loop(int argc, const char **argv_) {
   int frame_in = 0, frame_out = 0, flipuv = 0, noblit = 0;
   int do_md5 = 0, progress = 0;
   int stop_after = 0, postproc = 0, summary = 0, quiet = 1;
+  int profile = 0;
+  struct DecodeProfile profile_total;
   int arg_skip = 0;
   int ec_enabled = 0;
   int keep_going = 0;
   int enable_row_mt = 0;
   int enable_lpf_opt = 0;
+  int threaded_io = 0;
   const VpxInterface *interface = NULL;
   const VpxInterface *fourcc_interface = NULL;
   uint64_t dx_time = 0;
@@ -571,12 +877,17 @@ static int main_loop(int argc, const char **argv_) {
 
   struct VpxDecInputContext input = { NULL, NULL };
   struct VpxInputContext vpx_input_ctx;
+#if CONFIG_MULTITHREAD
+  struct io_threads io_threads;
+#endif
+  struct io_threads *io = NULL;
 #if CONFIG_WEBM_IO
   struct WebmInputContext webm_ctx;
   memset(&(webm_ctx), 0, sizeof(webm_ctx));
   input.webm_ctx = &webm_ctx;
 #endif
   input.vpx_input_ctx = &vpx_input_ctx;
+  memset(&profile_total, 0, sizeof(profile_total));
 
   /* Parse command line */
   exec_name = argv_[0];
@@ -626,6 +937,8 @@ static int main_loop(int argc, const char **argv_) {
       do_md5 = 1;
     else if (arg_match(&arg, &summaryarg, argi))
       summary = 1;
+    else if (arg_match(&arg, &profilearg, argi))
+      profile = 1;
     else if (arg_match(&arg, &threadsarg, argi))
       cfg.threads = arg_parse_uint(&arg);
 #if CONFIG_VP9_DECODER
@@ -659,6 +972,8 @@ static int main_loop(int argc, const char **argv_) {
       enable_row_mt = arg_parse_uint(&arg);
     } else if (arg_match(&arg, &lpfoptarg, argi)) {
       enable_lpf_opt = arg_parse_uint(&arg);
+    } else if (arg_match(&arg, &threadedioarg, argi)) {
+      threaded_io = 1;
     }
 #if CONFIG_VP8_DECODER
     else if (arg_match(&arg, &addnoise_level, argi)) {
@@ -688,6 +1003,11 @@ static int main_loop(int argc, const char **argv_) {
     if (argi[0][0] == '-' && strlen(argi[0]) > 1)
       die("Error: Unrecognized option %s\n", *argi);
 
+#if !CONFIG_MULTITHREAD
+  if (threaded_io)
+    die("Error: --threaded-io requires multithreading support\n");
+#endif
+
   /* Handle non-option arguments */
   fn = argv[0];
 
@@ -831,6 +1151,16 @@ static int main_loop(int argc, const char **argv_) {
     }
   }
 
+#if CONFIG_MULTITHREAD
+  if (threaded_io) {
+    start_input_reader(&io_threads, &input, stop_after, &buf, &bytes_in_buffer,
+                       &buffer_size);
+    if (!noblit && single_file)
+      start_output_writer(&io_threads, do_md5 ? &md5_ctx : NULL, outfile);
+    io = &io_threads;
+  }
+#endif
+
   frame_avail = 1;
   got_data = 0;
 
@@ -845,7 +1175,8 @@ static int main_loop(int argc, const char **argv_) {
 
     frame_avail = 0;
     if (!stop_after || frame_in < stop_after) {
-      if (!dec_read_frame(&input, &buf, &bytes_in_buffer, &buffer_size)) {
+      if (!read_input_frame(&input, io, &buf, &bytes_in_buffer,
+                            &buffer_size)) {
         frame_avail = 1;
         frame_in++;
 
@@ -900,6 +1231,19 @@ static int main_loop(int argc, const char **argv_) {
     vpx_usec_timer_mark(&timer);
     dx_time += (unsigned int)vpx_usec_timer_elapsed(&timer);
 
+    // Post-processing happens in vpx_codec_get_frame(), so the counters are
+    // read once the frame has been fetched.
+    if (profile && frame_avail) {
+      vpx_decode_profile_t frame_profile;
+      if (vpx_codec_control(&decoder, VPXD_GET_DECODE_PROFILE,
+                            &frame_profile)) {
+        warn("Failed VPXD_GET_DECODE_PROFILE: %s", vpx_codec_error(&decoder));
+        profile = 0;
+      } else {
+        add_decode_profile(&profile_total, &frame_profile);
+      }
+    }
+
     if (!corrupted &&
         vpx_codec_control(&decoder, VP8D_GET_FRAME_CORRUPTED, &corrupted)) {
       warn("Failed VP8_GET_FRAME_CORRUPTED: %s", vpx_codec_error(&decoder));
@@ -995,9 +1339,9 @@ static int main_loop(int argc, const char **argv_) {
 #endif
 
       if (single_file) {
+        char y4m_buf[2 * Y4M_BUFFER_SIZE] = { 0 };
+        size_t len = 0;
         if (use_y4m) {
-          char y4m_buf[Y4M_BUFFER_SIZE] = { 0 };
-          size_t len = 0;
           if (img->fmt == VPX_IMG_FMT_I440 || img->fmt == VPX_IMG_FMT_I44016) {
             fprintf(stderr, "Cannot produce y4m output for 440 sampling.\n");
             goto fail;
@@ -1008,20 +1352,10 @@ static int main_loop(int argc, const char **argv_) {
                 y4m_buf, sizeof(y4m_buf), vpx_input_ctx.width,
                 vpx_input_ctx.height, &vpx_input_ctx.framerate, img->fmt,
                 img->bit_depth);
-            if (do_md5) {
-              MD5Update(&md5_ctx, (md5byte *)y4m_buf, (unsigned int)len);
-            } else {
-              fputs(y4m_buf, outfile);
-            }
           }
 
           // Y4M frame header
-          len = y4m_write_frame_header(y4m_buf, sizeof(y4m_buf));
-          if (do_md5) {
-            MD5Update(&md5_ctx, (md5byte *)y4m_buf, (unsigned int)len);
-          } else {
-            fputs(y4m_buf, outfile);
-          }
+          len += y4m_write_frame_header(y4m_buf + len, sizeof(y4m_buf) - len);
         } else {
           if (frame_out == 1) {
             // Check if --yv12 or --i420 options are consistent with the
@@ -1044,11 +1378,8 @@ static int main_loop(int argc, const char **argv_) {
           }
         }
 
-        if (do_md5) {
-          update_image_md5(img, planes, &md5_ctx);
-        } else {
-          if (!corrupted) write_image_file(img, planes, outfile);
-        }
+        output_frame(io, y4m_buf, len, do_md5 || !corrupted ? img : NULL,
+                     planes, do_md5 ? &md5_ctx : NULL, outfile);
       } else {
         generate_filename(outfile_pattern, outfile_name, PATH_MAX, img->d_w,
                           img->d_h, frame_in);
@@ -1071,6 +1402,8 @@ static int main_loop(int argc, const char **argv_) {
     fprintf(stderr, "\n");
   }
 
+  if (profile) show_decode_profile(&profile_total);
+
   if (frames_corrupted) {
     fprintf(stderr, "WARNING: %d frames corrupted.\n", frames_corrupted);
   } else {
@@ -1079,6 +1412,10 @@ static int main_loop(int argc, const char **argv_) {
 
 fail:
 
+#if CONFIG_MULTITHREAD
+  if (io) stop_io_threads(io, &buf, &bytes_in_buffer, &buffer_size);
+#endif
+
   if (vpx_codec_destroy(&decoder)) {
     fprintf(stderr, "Failed to destroy decoder: %s\n",
             vpx_codec_error(&decoder));
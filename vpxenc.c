@@ -29,6 +29,7 @@
 #endif
 
 #include "./args.h"
+#include "./frame_queue.h"
 #include "./ivfenc.h"
 #include "./tools_common.h"
 
@@ -42,6 +43,7 @@
 #include "vpx/vpx_integer.h"
 #include "vpx_ports/mem_ops.h"
 #include "vpx_ports/vpx_timer.h"
+#include "vpx_util/vpx_thread.h"
 #include "./rate_hist.h"
 #include "./vpxstats.h"
 #include "./warnings.h"
@@ -116,6 +118,14 @@ static const arg_def_t pass_arg =
     ARG_DEF(NULL, "pass", 1, "Pass to execute (1/2)");
 static const arg_def_t fpf_name =
     ARG_DEF(NULL, "fpf", 1, "First pass statistics file name");
+static const arg_def_t chunks_arg =
+    ARG_DEF(NULL, "chunks", 1,
+            "Encode the second pass in n parallel chunks (VP9 only)");
+static const arg_def_t parallel_streams = ARG_DEF(
+    NULL, "parallel-streams", 0, "Encode each stream on its own thread");
+static const arg_def_t threaded_io =
+    ARG_DEF(NULL, "threaded-io", 0,
+            "Read the input and write the output on separate threads");
 static const arg_def_t limit =
     ARG_DEF(NULL, "limit", 1, "Stop encoding after n input frames");
 static const arg_def_t skip =
@@ -174,6 +184,9 @@ static const arg_def_t *main_args[] = { &help,
                                         &passes,
                                         &pass_arg,
                                         &fpf_name,
+                                        &chunks_arg,
+                                        &parallel_streams,
+                                        &threaded_io,
                                         &limit,
                                         &skip,
                                         &deadline,
@@ -522,6 +535,16 @@ static const arg_def_t row_mt =
     ARG_DEF(NULL, "row-mt", 1,
             "Enable row based non-deterministic multi-threading in VP9");
 
+static const arg_def_t subpel_cache =
+    ARG_DEF(NULL, "subpel-cache", 1,
+            "Cache the bilinear sub-pixel references in VP9:\n"
+            "                                          "
+            "0: off (default)\n"
+            "                                          "
+            "1: half-pel positions\n"
+            "                                          "
+            "2: half-pel and quarter-pel positions");
+
 static const arg_def_t disable_loopfilter =
     ARG_DEF(NULL, "disable-loopfilter", 1,
             "Control Loopfilter in VP9:\n"
@@ -531,6 +554,10 @@ static const arg_def_t disable_loopfilter =
             "1: Loopfilter off for non reference frames\n"
             "                                          "
             "2: Loopfilter off for all frames");
+
+static const arg_def_t stage_timing =
+    ARG_DEF(NULL, "stage-timing", 1,
+            "Write per-stage encoder timing to a Chrome trace JSON file");
 #endif
 
 #if CONFIG_VP9_ENCODER
@@ -562,9 +589,11 @@ static const arg_def_t *vp9_args[] = { &cpu_used_vp9,
                                        &target_level,
                                        &row_mt,
                                        &disable_loopfilter,
+                                       &subpel_cache,
 // NOTE: The entries above have a corresponding entry in vp9_arg_ctrl_map. The
 // entries below do not have a corresponding entry in vp9_arg_ctrl_map. They
 // must be listed at the end of vp9_args.
+                                       &stage_timing,
 #if CONFIG_VP9_HIGHBITDEPTH
                                        &bitdeptharg,
                                        &inbitdeptharg,
@@ -598,6 +627,7 @@ static const int vp9_arg_ctrl_map[] = { VP8E_SET_CPUUSED,
                                         VP9E_SET_TARGET_LEVEL,
                                         VP9E_SET_ROW_MT,
                                         VP9E_SET_DISABLE_LOOPFILTER,
+                                        VP9E_SET_SUBPEL_CACHE,
                                         0 };
 #endif
 
@@ -675,6 +705,7 @@ struct stream_config {
   struct vpx_codec_enc_cfg cfg;
   const char *out_fn;
   const char *stats_fn;
+  const char *stage_timing_fn;
   stereo_format_t stereo_fmt;
   int arg_ctrls[ARG_CTRL_CNT_MAX][2];
   int arg_ctrl_cnt;
@@ -705,6 +736,15 @@ struct stream_state {
   struct vpx_image *img;
   vpx_codec_ctx_t decoder;
   int mismatch_seen;
+  FILE *stage_timing_file;
+  int stage_timing_events;
+  int stage_timing_pass;
+  int64_t stage_timing_offset;
+  int64_t stage_timing_end;
+  FileOffset ivf_header_pos;
+  size_t ivf_frame_sz;
+  /* The I/O threads writing the output, if any. */
+  struct io_threads *io;
 };
 
 static void validate_positive_rational(const char *msg,
@@ -754,6 +794,12 @@ static void parse_global_config(struct VpxEncoderConfig *global, char **argv) {
 
       if (global->pass < 1 || global->pass > 2)
         die("Error: Invalid pass selected (%d)\n", global->pass);
+    } else if (arg_match(&arg, &chunks_arg, argi)) {
+      global->chunks = arg_parse_uint(&arg);
+    } else if (arg_match(&arg, &parallel_streams, argi)) {
+      global->parallel_streams = 1;
+    } else if (arg_match(&arg, &threaded_io, argi)) {
+      global->threaded_io = 1;
     } else if (arg_match(&arg, &usage, argi))
       global->usage = arg_parse_uint(&arg);
     else if (arg_match(&arg, &deadline, argi))
@@ -835,6 +881,24 @@ static void parse_global_config(struct VpxEncoderConfig *global, char **argv) {
     warn("Enforcing one-pass encoding in realtime mode\n");
     global->passes = 1;
   }
+
+  if (global->chunks > 1) {
+    if (strcmp(global->codec->name, "vp9") != 0)
+      die("Error: --chunks is only supported by vp9\n");
+    if (global->passes != 2 || global->pass)
+      die("Error: --chunks requires --passes=2 without --pass\n");
+    if (global->test_decode != TEST_DECODE_OFF)
+      die("Error: --chunks does not support --test-decode\n");
+    if (global->threaded_io)
+      die("Error: --chunks does not support --threaded-io\n");
+  }
+
+#if !CONFIG_MULTITHREAD
+  if (global->parallel_streams)
+    die("Error: --parallel-streams requires multithreading support\n");
+  if (global->threaded_io)
+    die("Error: --threaded-io requires multithreading support\n");
+#endif
 }
 
 static struct stream_state *new_stream(struct VpxEncoderConfig *global,
@@ -1035,6 +1099,8 @@ static int parse_stream_params(struct VpxEncoderConfig *global,
     } else if (arg_match(&arg, &kf_disabled, argi)) {
       config->cfg.kf_mode = VPX_KF_DISABLED;
 #if CONFIG_VP9_ENCODER
+    } else if (arg_match(&arg, &stage_timing, argi)) {
+      config->stage_timing_fn = arg.val;
     } else if (arg_match(&arg, &use_vizier_rc_params, argi)) {
       config->cfg.use_vizier_rc_params = arg_parse_int(&arg);
     } else if (arg_match(&arg, &active_wq_factor, argi)) {
@@ -1160,6 +1226,15 @@ static void validate_stream_config(const struct stream_state *stream,
         fatal("Stream %d: duplicate stats file (from stream %d)",
               streami->index, stream->index);
     }
+
+    /* Check for two streams sharing a stage timing file. */
+    if (streami != stream) {
+      const char *a = stream->config.stage_timing_fn;
+      const char *b = streami->config.stage_timing_fn;
+      if (a && b && !strcmp(a, b))
+        fatal("Stream %d: duplicate stage timing file (from stream %d)",
+              streami->index, stream->index);
+    }
   }
 }
 
@@ -1367,75 +1442,101 @@ static void initialize_encoder(struct stream_state *stream,
 #endif
 }
 
-static void encode_frame(struct stream_state *stream,
-                         struct VpxEncoderConfig *global, struct vpx_image *img,
-                         unsigned int frames_in) {
-  vpx_codec_pts_t frame_start, next_frame_start;
-  struct vpx_codec_enc_cfg *cfg = &stream->config.cfg;
-  struct vpx_usec_timer timer;
+#if CONFIG_VP9_ENCODER
+static const char *const stage_names[VPX_STAGE_COUNT] = {
+  "lookahead",    "first_pass", "tpl",            "temporal_filter",
+  "encode_frame", "loopfilter", "pack_bitstream", "rate_control"
+};
 
-  frame_start =
-      (cfg->g_timebase.den * (int64_t)(frames_in - 1) * global->framerate.den) /
-      cfg->g_timebase.num / global->framerate.num;
-  next_frame_start =
-      (cfg->g_timebase.den * (int64_t)(frames_in)*global->framerate.den) /
-      cfg->g_timebase.num / global->framerate.num;
+// Enables the stage timing of the encoder and starts the trace file on the
+// first pass. Each pass is traced on its own thread id, after the previous
+// one.
+static void open_stage_timing(struct stream_state *stream, int pass) {
+  if (stream->config.stage_timing_fn == NULL) return;
 
-/* Scale if necessary */
-#if CONFIG_VP9_HIGHBITDEPTH
-  if (img) {
-    if ((img->fmt & VPX_IMG_FMT_HIGHBITDEPTH) &&
-        (img->d_w != cfg->g_w || img->d_h != cfg->g_h)) {
-      if (img->fmt != VPX_IMG_FMT_I42016) {
-        fprintf(stderr, "%s can only scale 4:2:0 inputs\n", exec_name);
-        exit(EXIT_FAILURE);
-      }
-#if CONFIG_LIBYUV
-      if (!stream->img) {
-        stream->img =
-            vpx_img_alloc(NULL, VPX_IMG_FMT_I42016, cfg->g_w, cfg->g_h, 16);
-      }
-      I420Scale_16(
-          (uint16_t *)img->planes[VPX_PLANE_Y], img->stride[VPX_PLANE_Y] / 2,
-          (uint16_t *)img->planes[VPX_PLANE_U], img->stride[VPX_PLANE_U] / 2,
-          (uint16_t *)img->planes[VPX_PLANE_V], img->stride[VPX_PLANE_V] / 2,
-          img->d_w, img->d_h, (uint16_t *)stream->img->planes[VPX_PLANE_Y],
-          stream->img->stride[VPX_PLANE_Y] / 2,
-          (uint16_t *)stream->img->planes[VPX_PLANE_U],
-          stream->img->stride[VPX_PLANE_U] / 2,
-          (uint16_t *)stream->img->planes[VPX_PLANE_V],
-          stream->img->stride[VPX_PLANE_V] / 2, stream->img->d_w,
-          stream->img->d_h, kFilterBox);
-      img = stream->img;
-#else
-      stream->encoder.err = 1;
-      ctx_exit_on_error(&stream->encoder,
-                        "Stream %d: Failed to encode frame.\n"
-                        "Scaling disabled in this configuration. \n"
-                        "To enable, configure with --enable-libyuv\n",
-                        stream->index);
-#endif
-    }
+  if (stream->stage_timing_file == NULL) {
+    stream->stage_timing_file = fopen(stream->config.stage_timing_fn, "w");
+    if (!stream->stage_timing_file) fatal("Failed to open stage timing file");
+    fprintf(stream->stage_timing_file, "{\"traceEvents\":[");
   }
-#endif
-  if (img && (img->d_w != cfg->g_w || img->d_h != cfg->g_h)) {
-    if (img->fmt != VPX_IMG_FMT_I420 && img->fmt != VPX_IMG_FMT_YV12) {
-      fprintf(stderr, "%s can only scale 4:2:0 8bpp inputs\n", exec_name);
+  stream->stage_timing_pass = pass;
+  stream->stage_timing_offset = stream->stage_timing_end;
+
+  vpx_codec_control(&stream->encoder, VP9E_SET_STAGE_TIMING, 1);
+  ctx_exit_on_error(&stream->encoder, "Failed to enable stage timing");
+}
+
+static void write_trace_event(struct stream_state *stream, const char *name,
+                              int64_t start, int64_t duration,
+                              unsigned int frames_in, int frame_count) {
+  start += stream->stage_timing_offset;
+  fprintf(stream->stage_timing_file,
+          "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%" PRId64
+          ",\"dur\":%" PRId64
+          ",\"pid\":%d,\"tid\":%d,"
+          "\"args\":{\"frames_in\":%u,\"frames_coded\":%d}}",
+          stream->stage_timing_events++ ? "," : "", name, start, duration,
+          stream->index, stream->stage_timing_pass, frames_in, frame_count);
+  if (start + duration > stream->stage_timing_end)
+    stream->stage_timing_end = start + duration;
+}
+
+static void write_stage_timing(struct stream_state *stream,
+                               unsigned int frames_in) {
+  vpx_stage_timing_t timing;
+  int i;
+
+  if (stream->stage_timing_file == NULL) return;
+  if (vpx_codec_control(&stream->encoder, VP9E_GET_STAGE_TIMING, &timing))
+    return;
+
+  write_trace_event(stream, "vpx_codec_encode", timing.frame_start_us,
+                    timing.frame_duration_us, frames_in, timing.frame_count);
+  for (i = 0; i < VPX_STAGE_COUNT; ++i) {
+    if (timing.start_us[i] < 0) continue;
+    write_trace_event(stream, stage_names[i], timing.start_us[i],
+                      timing.duration_us[i], frames_in, timing.frame_count);
+  }
+}
+
+static void close_stage_timing(struct stream_state *stream) {
+  if (stream->stage_timing_file == NULL) return;
+  fprintf(stream->stage_timing_file, "\n]}\n");
+  fclose(stream->stage_timing_file);
+  stream->stage_timing_file = NULL;
+}
+#endif  // CONFIG_VP9_ENCODER
+
+/* Scales |img| to the dimensions of the stream into |*scaled|, allocated on
+ * first use, and returns it.
+ */
+static struct vpx_image *scale_image(struct stream_state *stream,
+                                     struct vpx_image *img,
+                                     struct vpx_image **scaled) {
+  const struct vpx_codec_enc_cfg *cfg = &stream->config.cfg;
+
+#if CONFIG_VP9_HIGHBITDEPTH
+  if (img->fmt & VPX_IMG_FMT_HIGHBITDEPTH) {
+    if (img->fmt != VPX_IMG_FMT_I42016) {
+      fprintf(stderr, "%s can only scale 4:2:0 inputs\n", exec_name);
       exit(EXIT_FAILURE);
     }
 #if CONFIG_LIBYUV
-    if (!stream->img)
-      stream->img =
-          vpx_img_alloc(NULL, VPX_IMG_FMT_I420, cfg->g_w, cfg->g_h, 16);
-    I420Scale(
-        img->planes[VPX_PLANE_Y], img->stride[VPX_PLANE_Y],
-        img->planes[VPX_PLANE_U], img->stride[VPX_PLANE_U],
-        img->planes[VPX_PLANE_V], img->stride[VPX_PLANE_V], img->d_w, img->d_h,
-        stream->img->planes[VPX_PLANE_Y], stream->img->stride[VPX_PLANE_Y],
-        stream->img->planes[VPX_PLANE_U], stream->img->stride[VPX_PLANE_U],
-        stream->img->planes[VPX_PLANE_V], stream->img->stride[VPX_PLANE_V],
-        stream->img->d_w, stream->img->d_h, kFilterBox);
-    img = stream->img;
+    if (!*scaled) {
+      *scaled = vpx_img_alloc(NULL, VPX_IMG_FMT_I42016, cfg->g_w, cfg->g_h, 16);
+    }
+    I420Scale_16(
+        (uint16_t *)img->planes[VPX_PLANE_Y], img->stride[VPX_PLANE_Y] / 2,
+        (uint16_t *)img->planes[VPX_PLANE_U], img->stride[VPX_PLANE_U] / 2,
+        (uint16_t *)img->planes[VPX_PLANE_V], img->stride[VPX_PLANE_V] / 2,
+        img->d_w, img->d_h, (uint16_t *)(*scaled)->planes[VPX_PLANE_Y],
+        (*scaled)->stride[VPX_PLANE_Y] / 2,
+        (uint16_t *)(*scaled)->planes[VPX_PLANE_U],
+        (*scaled)->stride[VPX_PLANE_U] / 2,
+        (uint16_t *)(*scaled)->planes[VPX_PLANE_V],
+        (*scaled)->stride[VPX_PLANE_V] / 2, (*scaled)->d_w, (*scaled)->d_h,
+        kFilterBox);
+    return *scaled;
 #else
     stream->encoder.err = 1;
     ctx_exit_on_error(&stream->encoder,
@@ -1445,6 +1546,50 @@ static void encode_frame(struct stream_state *stream,
                       stream->index);
 #endif
   }
+#endif
+  if (img->fmt != VPX_IMG_FMT_I420 && img->fmt != VPX_IMG_FMT_YV12) {
+    fprintf(stderr, "%s can only scale 4:2:0 8bpp inputs\n", exec_name);
+    exit(EXIT_FAILURE);
+  }
+#if CONFIG_LIBYUV
+  if (!*scaled)
+    *scaled = vpx_img_alloc(NULL, VPX_IMG_FMT_I420, cfg->g_w, cfg->g_h, 16);
+  I420Scale(
+      img->planes[VPX_PLANE_Y], img->stride[VPX_PLANE_Y],
+      img->planes[VPX_PLANE_U], img->stride[VPX_PLANE_U],
+      img->planes[VPX_PLANE_V], img->stride[VPX_PLANE_V], img->d_w, img->d_h,
+      (*scaled)->planes[VPX_PLANE_Y], (*scaled)->stride[VPX_PLANE_Y],
+      (*scaled)->planes[VPX_PLANE_U], (*scaled)->stride[VPX_PLANE_U],
+      (*scaled)->planes[VPX_PLANE_V], (*scaled)->stride[VPX_PLANE_V],
+      (*scaled)->d_w, (*scaled)->d_h, kFilterBox);
+  return *scaled;
+#else
+  stream->encoder.err = 1;
+  ctx_exit_on_error(&stream->encoder,
+                    "Stream %d: Failed to encode frame.\n"
+                    "Scaling disabled in this configuration. \n"
+                    "To enable, configure with --enable-libyuv\n",
+                    stream->index);
+  return img;
+#endif
+}
+
+static void encode_frame(struct stream_state *stream,
+                         struct VpxEncoderConfig *global, struct vpx_image *img,
+                         unsigned int frames_in) {
+  vpx_codec_pts_t frame_start, next_frame_start;
+  struct vpx_codec_enc_cfg *cfg = &stream->config.cfg;
+  struct vpx_usec_timer timer;
+
+  frame_start =
+      (cfg->g_timebase.den * (int64_t)(frames_in - 1) * global->framerate.den) /
+      cfg->g_timebase.num / global->framerate.num;
+  next_frame_start =
+      (cfg->g_timebase.den * (int64_t)(frames_in)*global->framerate.den) /
+      cfg->g_timebase.num / global->framerate.num;
+
+  if (img && (img->d_w != cfg->g_w || img->d_h != cfg->g_h))
+    img = scale_image(stream, img, &stream->img);
 
   vpx_usec_timer_start(&timer);
   vpx_codec_encode(&stream->encoder, img, frame_start,
@@ -1454,6 +1599,9 @@ static void encode_frame(struct stream_state *stream,
   stream->cx_time += vpx_usec_timer_elapsed(&timer);
   ctx_exit_on_error(&stream->encoder, "Stream %d: Failed to encode frame",
                     stream->index);
+#if CONFIG_VP9_ENCODER
+  write_stage_timing(stream, frames_in);
+#endif
 }
 
 static void update_quantizer_histogram(struct stream_state *stream) {
@@ -1466,6 +1614,185 @@ static void update_quantizer_histogram(struct stream_state *stream) {
   }
 }
 
+static void write_frame(struct stream_state *stream,
+                        const vpx_codec_cx_pkt_t *pkt) {
+#if CONFIG_WEBM_IO
+  if (stream->config.write_webm) {
+    write_webm_block(&stream->webm_ctx, &stream->config.cfg, pkt);
+  }
+#endif
+  if (!stream->config.write_webm) {
+    if (pkt->data.frame.partition_id <= 0) {
+      stream->ivf_header_pos = ftello(stream->file);
+      stream->ivf_frame_sz = pkt->data.frame.sz;
+
+      ivf_write_frame_header(stream->file, pkt->data.frame.pts,
+                             stream->ivf_frame_sz);
+    } else {
+      stream->ivf_frame_sz += pkt->data.frame.sz;
+
+      if (!(pkt->data.frame.flags & VPX_FRAME_IS_FRAGMENT)) {
+        const FileOffset currpos = ftello(stream->file);
+        fseeko(stream->file, stream->ivf_header_pos, SEEK_SET);
+        ivf_write_frame_size(stream->file, stream->ivf_frame_sz);
+        fseeko(stream->file, currpos, SEEK_SET);
+      }
+    }
+
+    (void)fwrite(pkt->data.frame.buf, 1, pkt->data.frame.sz, stream->file);
+  }
+}
+
+#if CONFIG_MULTITHREAD
+/* With --threaded-io the input is read, and y4m input converted, by a reader
+ * thread, and the compressed frames are written out by a writer thread. Each
+ * thread is a frame queue ahead of or behind the encoder.
+ */
+
+struct output_frame {
+  struct stream_state *stream;
+  vpx_codec_cx_pkt_t pkt;
+  void *buf;
+  size_t buf_size;
+};
+
+struct io_threads {
+  struct VpxInputContext *input;
+  int max_frames;
+  /* The y4m reader returns its own buffers, which are copied to the queue. */
+  struct vpx_image y4m_frame;
+  struct vpx_image frames[FRAME_QUEUE_SIZE];
+  int frames_allocated[FRAME_QUEUE_SIZE];
+  int frame_index;
+  struct frame_queue input_queue;
+  pthread_t reader;
+  int writing;
+  struct output_frame outputs[FRAME_QUEUE_SIZE];
+  struct frame_queue output_queue;
+  pthread_t writer;
+};
+
+static THREADFN input_reader(void *arg) {
+  struct io_threads *const io = (struct io_threads *)arg;
+  struct VpxInputContext *const input = io->input;
+  int frames = 0;
+
+  while (!io->max_frames || frames < io->max_frames) {
+    const int index = frame_queue_get_free(&io->input_queue);
+    struct vpx_image *frame;
+
+    if (index < 0) break;
+    frame = &io->frames[index];
+    if (input->file_type == FILE_TYPE_Y4M) {
+      if (!read_frame(input, &io->y4m_frame)) break;
+      if (!io->frames_allocated[index]) {
+        if (!vpx_img_alloc(frame, io->y4m_frame.fmt, io->y4m_frame.d_w,
+                           io->y4m_frame.d_h, 32))
+          fatal("Failed to allocate input frame");
+        io->frames_allocated[index] = 1;
+      }
+      vpx_img_copy(frame, &io->y4m_frame);
+    } else {
+      if (!io->frames_allocated[index]) {
+        if (!vpx_img_alloc(frame, input->fmt, input->width, input->height, 32))
+          fatal("Failed to allocate input frame");
+        io->frames_allocated[index] = 1;
+      }
+      if (!read_frame(input, frame)) break;
+    }
+    frame_queue_push(&io->input_queue);
+    frames++;
+  }
+  frame_queue_close(&io->input_queue);
+  return THREAD_RETURN(NULL);
+}
+
+static THREADFN output_writer(void *arg) {
+  struct io_threads *const io = (struct io_threads *)arg;
+  int index;
+
+  while ((index = frame_queue_get_filled(&io->output_queue)) >= 0) {
+    write_frame(io->outputs[index].stream, &io->outputs[index].pkt);
+    frame_queue_pop(&io->output_queue);
+  }
+  return THREAD_RETURN(NULL);
+}
+
+/* Returns the next input frame in |*frame|, releasing the previous one, or
+ * 0 at the end of the input.
+ */
+static int read_queued_frame(struct io_threads *io, struct vpx_image **frame) {
+  if (io->frame_index >= 0) frame_queue_pop(&io->input_queue);
+  io->frame_index = frame_queue_get_filled(&io->input_queue);
+  if (io->frame_index < 0) return 0;
+  *frame = &io->frames[io->frame_index];
+  return 1;
+}
+
+static void queue_output_frame(struct io_threads *io,
+                               struct stream_state *stream,
+                               const vpx_codec_cx_pkt_t *pkt) {
+  const int index = frame_queue_get_free(&io->output_queue);
+  struct output_frame *const output = &io->outputs[index];
+
+  assert(index >= 0);
+  if (pkt->data.frame.sz > output->buf_size) {
+    free(output->buf);
+    output->buf = malloc(pkt->data.frame.sz);
+    if (!output->buf) fatal("Failed to allocate output frame");
+    output->buf_size = pkt->data.frame.sz;
+  }
+  memcpy(output->buf, pkt->data.frame.buf, pkt->data.frame.sz);
+  output->stream = stream;
+  output->pkt = *pkt;
+  output->pkt.data.frame.buf = output->buf;
+  frame_queue_push(&io->output_queue);
+}
+
+/* Starts the reader, and the writer if |streams| is not NULL. */
+static void start_io_threads(struct io_threads *io,
+                             struct VpxInputContext *input, int max_frames,
+                             struct stream_state *streams) {
+  struct stream_state *stream;
+
+  memset(io, 0, sizeof(*io));
+  io->input = input;
+  io->max_frames = max_frames;
+  io->frame_index = -1;
+  frame_queue_init(&io->input_queue);
+  if (pthread_create(&io->reader, NULL, input_reader, io))
+    fatal("Failed to create input reader thread");
+
+  if (!streams) return;
+  io->writing = 1;
+  frame_queue_init(&io->output_queue);
+  if (pthread_create(&io->writer, NULL, output_writer, io))
+    fatal("Failed to create output writer thread");
+  for (stream = streams; stream; stream = stream->next) stream->io = io;
+}
+
+/* Waits for the threads, once all output frames have been queued. */
+static void stop_io_threads(struct io_threads *io,
+                            struct stream_state *streams) {
+  struct stream_state *stream;
+  int i;
+
+  frame_queue_close(&io->input_queue);
+  pthread_join(io->reader, NULL);
+  frame_queue_destroy(&io->input_queue);
+  for (i = 0; i < FRAME_QUEUE_SIZE; ++i) {
+    if (io->frames_allocated[i]) vpx_img_free(&io->frames[i]);
+  }
+
+  if (!io->writing) return;
+  frame_queue_close(&io->output_queue);
+  pthread_join(io->writer, NULL);
+  frame_queue_destroy(&io->output_queue);
+  for (i = 0; i < FRAME_QUEUE_SIZE; ++i) free(io->outputs[i].buf);
+  for (stream = streams; stream; stream = stream->next) stream->io = NULL;
+}
+#endif  // CONFIG_MULTITHREAD
+
 static void get_cx_data(struct stream_state *stream,
                         struct VpxEncoderConfig *global, int *got_data) {
   const vpx_codec_cx_pkt_t *pkt;
@@ -1474,42 +1801,21 @@ static void get_cx_data(struct stream_state *stream,
 
   *got_data = 0;
   while ((pkt = vpx_codec_get_cx_data(&stream->encoder, &iter))) {
-    static size_t fsize = 0;
-    static FileOffset ivf_header_pos = 0;
-
     switch (pkt->kind) {
       case VPX_CODEC_CX_FRAME_PKT:
         if (!(pkt->data.frame.flags & VPX_FRAME_IS_FRAGMENT)) {
           stream->frames_out++;
         }
-        if (!global->quiet)
+        if (!global->quiet && !global->parallel_streams)
           fprintf(stderr, " %6luF", (unsigned long)pkt->data.frame.sz);
 
         update_rate_histogram(stream->rate_hist, cfg, pkt);
-#if CONFIG_WEBM_IO
-        if (stream->config.write_webm) {
-          write_webm_block(&stream->webm_ctx, cfg, pkt);
-        }
+        if (!stream->io) {
+          write_frame(stream, pkt);
+#if CONFIG_MULTITHREAD
+        } else {
+          queue_output_frame(stream->io, stream, pkt);
 #endif
-        if (!stream->config.write_webm) {
-          if (pkt->data.frame.partition_id <= 0) {
-            ivf_header_pos = ftello(stream->file);
-            fsize = pkt->data.frame.sz;
-
-            ivf_write_frame_header(stream->file, pkt->data.frame.pts, fsize);
-          } else {
-            fsize += pkt->data.frame.sz;
-
-            if (!(pkt->data.frame.flags & VPX_FRAME_IS_FRAGMENT)) {
-              const FileOffset currpos = ftello(stream->file);
-              fseeko(stream->file, ivf_header_pos, SEEK_SET);
-              ivf_write_frame_size(stream->file, fsize);
-              fseeko(stream->file, currpos, SEEK_SET);
-            }
-          }
-
-          (void)fwrite(pkt->data.frame.buf, 1, pkt->data.frame.sz,
-                       stream->file);
         }
         stream->nbytes += pkt->data.raw.sz;
 
@@ -1542,7 +1848,7 @@ static void get_cx_data(struct stream_state *stream,
           stream->psnr_sse_total += pkt->data.psnr.sse[0];
           stream->psnr_samples_total += pkt->data.psnr.samples[0];
           for (i = 0; i < 4; i++) {
-            if (!global->quiet)
+            if (!global->quiet && !global->parallel_streams)
               fprintf(stderr, "%.3f ", pkt->data.psnr.psnr[i]);
             stream->psnr_totals[i] += pkt->data.psnr.psnr[i];
           }
@@ -1673,6 +1979,660 @@ static void print_time(const char *label, int64_t etl) {
   }
 }
 
+#if CONFIG_MULTITHREAD
+/* With --parallel-streams each stream is encoded on a thread of its own. The
+ * input frames are copied into a ring of slots that every thread encodes in
+ * order, and a slot is reused once all threads are done with it. Streams of
+ * the same scaled size share the scaling of each frame, which is done by the
+ * first of their threads to get to it.
+ */
+
+/* Number of input frames read ahead of the slowest stream. */
+#define STREAM_FRAME_SLOTS 8
+
+enum scale_state { SCALE_PENDING, SCALE_RUNNING, SCALE_DONE };
+
+struct scaled_frame {
+  struct vpx_image *img;
+  enum scale_state state;
+};
+
+struct frame_slot {
+  struct vpx_image img;
+  int allocated;
+  unsigned int frames_in;
+  int eos;
+  /* Number of threads yet to encode the frame. */
+  int refs;
+  /* The frame scaled to each of the scaled stream sizes. */
+  struct scaled_frame *scaled;
+};
+
+struct stream_threads;
+
+struct stream_thread {
+  struct stream_threads *ctx;
+  struct stream_state *stream;
+  /* Index of the scaled size of the stream, or -1 if it is not scaled. */
+  int scale_index;
+  pthread_t thread;
+};
+
+struct stream_threads {
+  struct VpxEncoderConfig *global;
+  struct stream_thread *threads;
+  int thread_count;
+  int scale_count;
+  struct frame_slot slots[STREAM_FRAME_SLOTS];
+  unsigned int frames_queued;
+  int eos_queued;
+  pthread_mutex_t mutex;
+  pthread_cond_t frame_queued;
+  pthread_cond_t slot_free;
+  pthread_cond_t frame_scaled;
+};
+
+/* Queues the next input frame to all threads, or the end of the stream if
+ * |img| is NULL, once its slot has been released.
+ */
+static void queue_stream_frame(struct stream_threads *ctx,
+                               const struct vpx_image *img,
+                               unsigned int frames_in) {
+  struct frame_slot *const slot =
+      &ctx->slots[ctx->frames_queued % STREAM_FRAME_SLOTS];
+  int i;
+
+  assert(!ctx->eos_queued);
+  pthread_mutex_lock(&ctx->mutex);
+  while (slot->refs > 0) pthread_cond_wait(&ctx->slot_free, &ctx->mutex);
+  pthread_mutex_unlock(&ctx->mutex);
+
+  if (img) {
+    if (!slot->allocated) {
+      if (!vpx_img_alloc(&slot->img, img->fmt, img->d_w, img->d_h, 32))
+        fatal("Failed to allocate frame slot");
+      slot->allocated = 1;
+    }
+    vpx_img_copy(&slot->img, img);
+  }
+  slot->frames_in = frames_in;
+  slot->eos = img == NULL;
+  for (i = 0; i < ctx->scale_count; ++i) slot->scaled[i].state = SCALE_PENDING;
+
+  pthread_mutex_lock(&ctx->mutex);
+  slot->refs = ctx->thread_count;
+  ctx->frames_queued++;
+  ctx->eos_queued = slot->eos;
+  pthread_cond_broadcast(&ctx->frame_queued);
+  pthread_mutex_unlock(&ctx->mutex);
+}
+
+static struct vpx_image *get_stream_image(struct stream_thread *thread,
+                                          struct frame_slot *slot) {
+  struct stream_threads *const ctx = thread->ctx;
+  struct scaled_frame *scaled;
+
+  if (thread->scale_index < 0) return &slot->img;
+
+  scaled = &slot->scaled[thread->scale_index];
+  pthread_mutex_lock(&ctx->mutex);
+  while (scaled->state == SCALE_RUNNING)
+    pthread_cond_wait(&ctx->frame_scaled, &ctx->mutex);
+  if (scaled->state == SCALE_DONE) {
+    pthread_mutex_unlock(&ctx->mutex);
+    return scaled->img;
+  }
+  scaled->state = SCALE_RUNNING;
+  pthread_mutex_unlock(&ctx->mutex);
+
+  scale_image(thread->stream, &slot->img, &scaled->img);
+
+  pthread_mutex_lock(&ctx->mutex);
+  scaled->state = SCALE_DONE;
+  pthread_cond_broadcast(&ctx->frame_scaled);
+  pthread_mutex_unlock(&ctx->mutex);
+  return scaled->img;
+}
+
+static void encode_stream_frame(struct stream_state *stream,
+                                struct VpxEncoderConfig *global,
+                                struct vpx_image *img, unsigned int frames_in,
+                                int *got_data) {
+  encode_frame(stream, global, img, frames_in);
+  update_quantizer_histogram(stream);
+  get_cx_data(stream, global, got_data);
+  if (*got_data && global->test_decode != TEST_DECODE_OFF)
+    test_decode(stream, global->test_decode, global->codec);
+}
+
+static THREADFN stream_worker(void *arg) {
+  struct stream_thread *const thread = (struct stream_thread *)arg;
+  struct stream_threads *const ctx = thread->ctx;
+  unsigned int frame;
+  int eos = 0;
+
+  for (frame = 0; !eos; ++frame) {
+    struct frame_slot *const slot = &ctx->slots[frame % STREAM_FRAME_SLOTS];
+    int got_data;
+
+    pthread_mutex_lock(&ctx->mutex);
+    while (ctx->frames_queued == frame)
+      pthread_cond_wait(&ctx->frame_queued, &ctx->mutex);
+    pthread_mutex_unlock(&ctx->mutex);
+
+    eos = slot->eos;
+    if (!eos) {
+      encode_stream_frame(thread->stream, ctx->global,
+                          get_stream_image(thread, slot), slot->frames_in,
+                          &got_data);
+    } else {
+      do {
+        encode_stream_frame(thread->stream, ctx->global, NULL, slot->frames_in,
+                            &got_data);
+      } while (got_data);
+    }
+
+    pthread_mutex_lock(&ctx->mutex);
+    if (--slot->refs == 0) pthread_cond_signal(&ctx->slot_free);
+    pthread_mutex_unlock(&ctx->mutex);
+  }
+  return THREAD_RETURN(NULL);
+}
+
+static void start_stream_threads(struct stream_threads *ctx,
+                                 struct VpxEncoderConfig *global,
+                                 struct stream_state *streams,
+                                 unsigned int input_w, unsigned int input_h) {
+  struct stream_state *stream;
+  int i, j;
+
+  memset(ctx, 0, sizeof(*ctx));
+  ctx->global = global;
+  for (stream = streams; stream; stream = stream->next) ctx->thread_count++;
+  ctx->threads = calloc(ctx->thread_count, sizeof(*ctx->threads));
+  if (!ctx->threads) fatal("Failed to allocate stream threads");
+
+  for (i = 0, stream = streams; stream; stream = stream->next, ++i) {
+    struct stream_thread *const thread = &ctx->threads[i];
+    const struct vpx_codec_enc_cfg *const cfg = &stream->config.cfg;
+
+    thread->ctx = ctx;
+    thread->stream = stream;
+    thread->scale_index = -1;
+    if (cfg->g_w == input_w && cfg->g_h == input_h) continue;
+    for (j = 0; j < i; ++j) {
+      const struct vpx_codec_enc_cfg *const other =
+          &ctx->threads[j].stream->config.cfg;
+      if (ctx->threads[j].scale_index >= 0 && other->g_w == cfg->g_w &&
+          other->g_h == cfg->g_h)
+        break;
+    }
+    thread->scale_index =
+        j < i ? ctx->threads[j].scale_index : ctx->scale_count++;
+  }
+
+  if (ctx->scale_count) {
+    for (i = 0; i < STREAM_FRAME_SLOTS; ++i) {
+      ctx->slots[i].scaled =
+          calloc(ctx->scale_count, sizeof(*ctx->slots[i].scaled));
+      if (!ctx->slots[i].scaled) fatal("Failed to allocate frame slots");
+    }
+  }
+
+  pthread_mutex_init(&ctx->mutex, NULL);
+  pthread_cond_init(&ctx->frame_queued, NULL);
+  pthread_cond_init(&ctx->slot_free, NULL);
+  pthread_cond_init(&ctx->frame_scaled, NULL);
+  for (i = 0; i < ctx->thread_count; ++i) {
+    if (pthread_create(&ctx->threads[i].thread, NULL, stream_worker,
+                       &ctx->threads[i]))
+      fatal("Failed to create stream thread");
+  }
+}
+
+/* Flushes the streams and waits for their threads to finish. */
+static void stop_stream_threads(struct stream_threads *ctx,
+                                unsigned int frames_in) {
+  int i, j;
+
+  if (!ctx->eos_queued) queue_stream_frame(ctx, NULL, frames_in);
+  for (i = 0; i < ctx->thread_count; ++i)
+    pthread_join(ctx->threads[i].thread, NULL);
+
+  for (i = 0; i < STREAM_FRAME_SLOTS; ++i) {
+    struct frame_slot *const slot = &ctx->slots[i];
+
+    if (slot->allocated) vpx_img_free(&slot->img);
+    for (j = 0; j < ctx->scale_count; ++j) {
+      if (slot->scaled[j].img) vpx_img_free(slot->scaled[j].img);
+    }
+    free(slot->scaled);
+  }
+  free(ctx->threads);
+  pthread_cond_destroy(&ctx->frame_scaled);
+  pthread_cond_destroy(&ctx->slot_free);
+  pthread_cond_destroy(&ctx->frame_queued);
+  pthread_mutex_destroy(&ctx->mutex);
+}
+#endif  // CONFIG_MULTITHREAD
+
+#if CONFIG_VP9_ENCODER
+/* A chunked second pass splits the input at cut points chosen from the first
+ * pass stats. The chunks are encoded concurrently, each by its own encoder
+ * starting on a key frame, with the stats of its frames and the share of the
+ * bitrate the whole sequence would give them. The frames of each chunk are
+ * spooled to a temporary file and written out in order once all are done.
+ */
+
+/* Shortest chunk worth an encoder instance and a key frame of its own. */
+#define MIN_CHUNK_FRAMES 8
+
+struct chunk_context;
+
+struct chunk {
+  struct chunk_context *ctx;
+  int start;
+  int frames;
+  unsigned int target_bitrate;
+  vpx_fixed_buf_t stats;
+  FILE *spool;
+  struct stream_state state;
+#if CONFIG_MULTITHREAD
+  pthread_t thread;
+#endif
+};
+
+struct chunk_frame_header {
+  vpx_codec_pts_t pts;
+  unsigned long duration;
+  vpx_codec_frame_flags_t flags;
+  size_t sz;
+};
+
+struct chunk_context {
+  struct stream_state *stream;
+  struct VpxEncoderConfig *global;
+  struct VpxInputContext input;
+  /* Input file position of each frame coded by the first pass. */
+  FileOffset *frame_offsets;
+  int frame_count;
+  int frame_offsets_size;
+  struct chunk *chunks;
+  int chunk_count;
+#if CONFIG_VP9_HIGHBITDEPTH
+  int input_shift;
+  int use_16bit_internal;
+#endif
+};
+
+/* Returns the file position of the next frame of the input. */
+static FileOffset input_position(const struct VpxInputContext *input) {
+  FileOffset pos = ftello(input->file);
+  /* The first bytes of raw files are read ahead by the type detection. */
+  if (input->file_type == FILE_TYPE_RAW)
+    pos -= (FileOffset)(input->detect.buf_read - input->detect.position);
+  return pos;
+}
+
+static void add_chunk_frame(struct chunk_context *ctx, FileOffset pos) {
+  if (ctx->frame_count == ctx->frame_offsets_size) {
+    const int size = ctx->frame_offsets_size ? 2 * ctx->frame_offsets_size
+                                             : 1024;
+    FileOffset *const offsets =
+        realloc(ctx->frame_offsets, size * sizeof(*offsets));
+    if (!offsets) fatal("Failed to allocate frame offsets");
+    ctx->frame_offsets = offsets;
+    ctx->frame_offsets_size = size;
+  }
+  ctx->frame_offsets[ctx->frame_count++] = pos;
+}
+
+/* The VP9 first pass packets start with the fields of vpx_rc_frame_stats_t. */
+static const vpx_rc_frame_stats_t *get_frame_stats(
+    const vpx_fixed_buf_t *stats, size_t packet_sz, int frame) {
+  return (const vpx_rc_frame_stats_t *)((const char *)stats->buf +
+                                        frame * packet_sz);
+}
+
+/* A key frame costs little more than an inter frame where inter prediction
+ * does not do much better than intra prediction, as on scene cuts.
+ */
+static double get_cut_score(const vpx_rc_frame_stats_t *s) {
+  return s->coded_error / (s->intra_error + 1.0);
+}
+
+/* Splits the frames into chunks of about the same length, moving each cut to
+ * the best key frame within a quarter of a chunk of it.
+ */
+static void split_chunks(struct chunk_context *ctx,
+                         const vpx_fixed_buf_t *stats, size_t packet_sz) {
+  const int frames = ctx->frame_count;
+  int window;
+  int i, f;
+
+  ctx->chunk_count = ctx->global->chunks;
+  if (ctx->chunk_count > frames / MIN_CHUNK_FRAMES)
+    ctx->chunk_count = frames / MIN_CHUNK_FRAMES;
+  if (ctx->chunk_count < 1) ctx->chunk_count = 1;
+  ctx->chunks = calloc(ctx->chunk_count, sizeof(*ctx->chunks));
+  if (!ctx->chunks) fatal("Failed to allocate chunks");
+
+  window = frames / ctx->chunk_count / 4;
+  for (i = 0; i < ctx->chunk_count; ++i) {
+    const int nominal = (int)((int64_t)i * frames / ctx->chunk_count);
+    int start = nominal;
+    if (i > 0) {
+      double best_score =
+          get_cut_score(get_frame_stats(stats, packet_sz, nominal));
+      for (f = nominal - window; f <= nominal + window; ++f) {
+        const double score =
+            get_cut_score(get_frame_stats(stats, packet_sz, f));
+        if (score > best_score) {
+          best_score = score;
+          start = f;
+        }
+      }
+    }
+    ctx->chunks[i].ctx = ctx;
+    ctx->chunks[i].start = start;
+  }
+  for (i = 0; i < ctx->chunk_count; ++i) {
+    const int end =
+        i + 1 < ctx->chunk_count ? ctx->chunks[i + 1].start : frames;
+    ctx->chunks[i].frames = end - ctx->chunks[i].start;
+  }
+}
+
+/* Gives each chunk the share of the target bitrate the VP9 two-pass rate
+ * control would allocate to its frames over the whole sequence.
+ */
+static void allocate_chunk_bitrates(struct chunk_context *ctx,
+                                    const vpx_fixed_buf_t *stats,
+                                    size_t packet_sz) {
+  const struct vpx_codec_enc_cfg *const cfg = &ctx->stream->config.cfg;
+  const int frames = ctx->frame_count;
+  const double min_score = cfg->rc_2pass_vbr_minsection_pct / 100.0;
+  const double max_score = cfg->rc_2pass_vbr_maxsection_pct / 100.0;
+  double *const scores = malloc(frames * sizeof(*scores));
+  double av_err = 0.0;
+  double mean_score = 0.0;
+  double total_score = 0.0;
+  int i, f;
+
+  if (!scores) fatal("Failed to allocate frame scores");
+  for (f = 0; f < frames; ++f) {
+    const vpx_rc_frame_stats_t *const s =
+        get_frame_stats(stats, packet_sz, f);
+    av_err += s->coded_error * s->weight;
+  }
+  av_err /= frames;
+  for (f = 0; f < frames; ++f) {
+    const vpx_rc_frame_stats_t *const s =
+        get_frame_stats(stats, packet_sz, f);
+    scores[f] = pow((s->coded_error * s->weight + 1.0) / (av_err + 1.0),
+                    cfg->rc_2pass_vbr_bias_pct / 100.0);
+    mean_score += scores[f];
+  }
+  mean_score /= frames;
+  for (f = 0; f < frames; ++f) {
+    scores[f] /= mean_score;
+    if (scores[f] < min_score) scores[f] = min_score;
+    if (scores[f] > max_score) scores[f] = max_score;
+    total_score += scores[f];
+  }
+
+  for (i = 0; i < ctx->chunk_count; ++i) {
+    struct chunk *const chunk = &ctx->chunks[i];
+    double chunk_score = 0.0;
+    double bitrate;
+    for (f = chunk->start; f < chunk->start + chunk->frames; ++f)
+      chunk_score += scores[f];
+    bitrate = cfg->rc_target_bitrate * (chunk_score / total_score) * frames /
+              chunk->frames;
+    chunk->target_bitrate = bitrate < 1.0 ? 1 : (unsigned int)(bitrate + 0.5);
+  }
+  free(scores);
+}
+
+/* Copies the stats of the frames of the chunk and appends the end of sequence
+ * packet. It sums the fields of vpx_rc_frame_stats_t, which are all doubles,
+ * and takes the fields past them from the last frame as the encoder does.
+ */
+static void make_chunk_stats(struct chunk *chunk, const vpx_fixed_buf_t *stats,
+                             size_t packet_sz) {
+  const int num_fields = sizeof(vpx_rc_frame_stats_t) / sizeof(double);
+  char *const buf = malloc((chunk->frames + 1) * packet_sz);
+  double *total;
+  int f, i;
+
+  if (!buf) fatal("Failed to allocate chunk stats");
+  memcpy(buf, (const char *)stats->buf + chunk->start * packet_sz,
+         chunk->frames * packet_sz);
+  total = (double *)(buf + chunk->frames * packet_sz);
+  memcpy(total, buf + (chunk->frames - 1) * packet_sz, packet_sz);
+  for (i = 0; i < num_fields; ++i) {
+    total[i] = 0.0;
+    for (f = 0; f < chunk->frames; ++f)
+      total[i] += ((const double *)(buf + f * packet_sz))[i];
+  }
+  chunk->stats.buf = buf;
+  chunk->stats.sz = (chunk->frames + 1) * packet_sz;
+}
+
+static void spool_cx_data(struct chunk *chunk, int *got_data) {
+  struct stream_state *const stream = &chunk->state;
+  const vpx_codec_cx_pkt_t *pkt;
+  vpx_codec_iter_t iter = NULL;
+
+  *got_data = 0;
+  while ((pkt = vpx_codec_get_cx_data(&stream->encoder, &iter))) {
+    if (pkt->kind == VPX_CODEC_CX_FRAME_PKT) {
+      struct chunk_frame_header header;
+      memset(&header, 0, sizeof(header));
+      header.pts = pkt->data.frame.pts;
+      header.duration = pkt->data.frame.duration;
+      header.flags = pkt->data.frame.flags;
+      header.sz = pkt->data.frame.sz;
+      if (fwrite(&header, sizeof(header), 1, chunk->spool) != 1 ||
+          fwrite(pkt->data.frame.buf, 1, header.sz, chunk->spool) !=
+              header.sz)
+        fatal("Failed to write chunk spool file");
+      stream->frames_out++;
+      stream->nbytes += header.sz;
+      *got_data = 1;
+    } else if (pkt->kind == VPX_CODEC_PSNR_PKT &&
+               chunk->ctx->global->show_psnr) {
+      int i;
+      stream->psnr_sse_total += pkt->data.psnr.sse[0];
+      stream->psnr_samples_total += pkt->data.psnr.samples[0];
+      for (i = 0; i < 4; i++) stream->psnr_totals[i] += pkt->data.psnr.psnr[i];
+      stream->psnr_count++;
+    }
+  }
+}
+
+static void encode_chunk(struct chunk *chunk) {
+  struct chunk_context *const ctx = chunk->ctx;
+  struct VpxEncoderConfig *const global = ctx->global;
+  struct stream_state *const stream = &chunk->state;
+  struct VpxInputContext input = ctx->input;
+  unsigned int frames_in = global->skip_frames + chunk->start;
+  vpx_image_t raw;
+  vpx_image_t *img = &raw;
+#if CONFIG_VP9_HIGHBITDEPTH
+  vpx_image_t raw_shift;
+  int allocated_raw_shift = 0;
+#endif
+  int i, got_data;
+
+  /* The chunk is encoded with a copy of the stream keeping its own results. */
+  *stream = *ctx->stream;
+  stream->next = NULL;
+  stream->file = NULL;
+  stream->rate_hist = NULL;
+  stream->img = NULL;
+  stream->stage_timing_file = NULL;
+  stream->psnr_sse_total = 0;
+  stream->psnr_samples_total = 0;
+  memset(stream->psnr_totals, 0, sizeof(stream->psnr_totals));
+  stream->psnr_count = 0;
+  memset(stream->counts, 0, sizeof(stream->counts));
+  stream->frames_out = 0;
+  stream->cx_time = 0;
+  stream->nbytes = 0;
+  stream->config.cfg.rc_twopass_stats_in = chunk->stats;
+  stream->config.cfg.rc_target_bitrate = chunk->target_bitrate;
+  initialize_encoder(stream, global);
+
+  open_input_file(&input);
+  if (input.file_type == FILE_TYPE_RAW)
+    input.detect.position = input.detect.buf_read;
+  if (fseeko(input.file, ctx->frame_offsets[chunk->start], SEEK_SET))
+    fatal("Failed to seek in the input file");
+  memset(&raw, 0, sizeof(raw));
+  if (input.file_type != FILE_TYPE_Y4M) {
+    vpx_img_alloc(&raw, input.fmt, input.width, input.height, 32);
+  }
+
+  for (i = 0; i < chunk->frames; ++i) {
+    if (!read_frame(&input, &raw))
+      fatal("Failed to read frame %u of the input", frames_in + 1);
+#if CONFIG_VP9_HIGHBITDEPTH
+    if (ctx->input_shift || (ctx->use_16bit_internal && input.bit_depth == 8)) {
+      if (!allocated_raw_shift) {
+        vpx_img_alloc(&raw_shift, raw.fmt | VPX_IMG_FMT_HIGHBITDEPTH,
+                      input.width, input.height, 32);
+        allocated_raw_shift = 1;
+      }
+      vpx_img_upshift(&raw_shift, &raw, ctx->input_shift);
+      img = &raw_shift;
+    }
+#endif
+    encode_frame(stream, global, img, ++frames_in);
+    update_quantizer_histogram(stream);
+    spool_cx_data(chunk, &got_data);
+  }
+  do {
+    encode_frame(stream, global, NULL, frames_in);
+    update_quantizer_histogram(stream);
+    spool_cx_data(chunk, &got_data);
+  } while (got_data);
+
+  vpx_codec_destroy(&stream->encoder);
+  close_input_file(&input);
+  vpx_img_free(&raw);
+#if CONFIG_VP9_HIGHBITDEPTH
+  if (allocated_raw_shift) vpx_img_free(&raw_shift);
+#endif
+  if (stream->img) vpx_img_free(stream->img);
+  free(chunk->stats.buf);
+  chunk->stats.buf = NULL;
+
+  if (!global->quiet) {
+    fprintf(stderr,
+            "Pass 2/2 chunk %d/%d frame %4d-%-4d %7" PRId64 "B %7u kb/s"
+            " (%.2f fps)\n",
+            (int)(chunk - ctx->chunks) + 1, ctx->chunk_count, chunk->start + 1,
+            chunk->start + chunk->frames, (int64_t)stream->nbytes,
+            chunk->target_bitrate,
+            usec_to_fps(stream->cx_time, chunk->frames));
+  }
+}
+
+#if CONFIG_MULTITHREAD
+static THREADFN chunk_worker(void *arg) {
+  encode_chunk((struct chunk *)arg);
+  return THREAD_RETURN(NULL);
+}
+#endif
+
+static void write_chunk(struct stream_state *stream, struct chunk *chunk) {
+  const struct stream_state *const state = &chunk->state;
+  struct chunk_frame_header header;
+  vpx_codec_cx_pkt_t pkt;
+  char *buf = NULL;
+  size_t buf_size = 0;
+  int i;
+
+  memset(&pkt, 0, sizeof(pkt));
+  pkt.kind = VPX_CODEC_CX_FRAME_PKT;
+  pkt.data.frame.partition_id = -1;
+  rewind(chunk->spool);
+  while (fread(&header, sizeof(header), 1, chunk->spool) == 1) {
+    if (header.sz > buf_size) {
+      char *const new_buf = realloc(buf, header.sz);
+      if (!new_buf) fatal("Failed to allocate chunk frame buffer");
+      buf = new_buf;
+      buf_size = header.sz;
+    }
+    if (fread(buf, 1, header.sz, chunk->spool) != header.sz)
+      fatal("Failed to read chunk spool file");
+    pkt.data.frame.buf = buf;
+    pkt.data.frame.sz = header.sz;
+    pkt.data.frame.pts = header.pts;
+    pkt.data.frame.duration = header.duration;
+    pkt.data.frame.flags = header.flags;
+    update_rate_histogram(stream->rate_hist, &stream->config.cfg, &pkt);
+    write_frame(stream, &pkt);
+  }
+  free(buf);
+  fclose(chunk->spool);
+  chunk->spool = NULL;
+
+  stream->frames_out += state->frames_out;
+  stream->nbytes += state->nbytes;
+  stream->psnr_sse_total += state->psnr_sse_total;
+  stream->psnr_samples_total += state->psnr_samples_total;
+  for (i = 0; i < 4; i++) stream->psnr_totals[i] += state->psnr_totals[i];
+  stream->psnr_count += state->psnr_count;
+  for (i = 0; i < 64; i++) stream->counts[i] += state->counts[i];
+}
+
+/* Runs the second pass of the stream in chunks. The chunk encoders are given
+ * the timestamps of the whole sequence, so their frames are written out with
+ * the timestamps a single encoder would give them.
+ */
+static void encode_chunks(struct chunk_context *ctx) {
+  struct stream_state *const stream = ctx->stream;
+  const vpx_fixed_buf_t stats = stream->config.cfg.rc_twopass_stats_in;
+  const size_t packet_sz = stats.sz / (ctx->frame_count + 1);
+  struct vpx_usec_timer timer;
+  int i;
+
+  if (ctx->frame_count < 1 || packet_sz < sizeof(vpx_rc_frame_stats_t) ||
+      packet_sz * (ctx->frame_count + 1) != stats.sz)
+    fatal("First pass stats do not match the input frames");
+
+  vpx_usec_timer_start(&timer);
+  split_chunks(ctx, &stats, packet_sz);
+  allocate_chunk_bitrates(ctx, &stats, packet_sz);
+  for (i = 0; i < ctx->chunk_count; ++i) {
+    make_chunk_stats(&ctx->chunks[i], &stats, packet_sz);
+    ctx->chunks[i].spool = tmpfile();
+    if (!ctx->chunks[i].spool) fatal("Failed to create chunk spool file");
+  }
+
+#if CONFIG_MULTITHREAD
+  for (i = 0; i < ctx->chunk_count; ++i) {
+    if (pthread_create(&ctx->chunks[i].thread, NULL, chunk_worker,
+                       &ctx->chunks[i]))
+      fatal("Failed to create chunk encoder thread");
+  }
+  for (i = 0; i < ctx->chunk_count; ++i)
+    pthread_join(ctx->chunks[i].thread, NULL);
+#else
+  for (i = 0; i < ctx->chunk_count; ++i) encode_chunk(&ctx->chunks[i]);
+#endif
+
+  for (i = 0; i < ctx->chunk_count; ++i) write_chunk(stream, &ctx->chunks[i]);
+  vpx_usec_timer_mark(&timer);
+  stream->cx_time = vpx_usec_timer_elapsed(&timer);
+
+  free(ctx->chunks);
+  ctx->chunks = NULL;
+}
+#endif  // CONFIG_VP9_ENCODER
+
 int main(int argc, const char **argv_) {
   int pass;
   vpx_image_t raw;
@@ -1691,9 +2651,19 @@ int main(int argc, const char **argv_) {
   uint64_t cx_time = 0;
   int stream_cnt = 0;
   int res = 0;
+#if CONFIG_VP9_ENCODER
+  struct chunk_context chunk_ctx;
+#endif
+#if CONFIG_MULTITHREAD
+  struct stream_threads stream_threads;
+  struct io_threads io_threads;
+#endif
 
   memset(&input, 0, sizeof(input));
   memset(&raw, 0, sizeof(raw));
+#if CONFIG_VP9_ENCODER
+  memset(&chunk_ctx, 0, sizeof(chunk_ctx));
+#endif
   exec_name = argv_[0];
 
   /* Setup default input stream settings */
@@ -1754,6 +2724,13 @@ int main(int argc, const char **argv_) {
     usage_exit();
   }
 
+  if (global.chunks > 1) {
+    if (stream_cnt > 1) die("Error: --chunks supports a single stream\n");
+    if (!strcmp(input.filename, "-"))
+      die("Error: --chunks requires a seekable input file\n");
+  }
+  if (stream_cnt < 2) global.parallel_streams = 0;
+
   /* Decide if other chroma subsamplings than 4:2:0 are supported */
   if (global.codec->fourcc == VP9_FOURCC) input.only_i420 = 0;
 
@@ -1762,6 +2739,8 @@ int main(int argc, const char **argv_) {
     int64_t estimated_time_left = -1;
     int64_t average_rate = -1;
     int64_t lagged_count = 0;
+    const int use_chunks = global.chunks > 1 && pass == 1;
+    struct vpx_image *input_frame = &raw;
 
     open_input_file(&input);
 
@@ -1854,7 +2833,12 @@ int main(int argc, const char **argv_) {
     FOREACH_STREAM(setup_pass(stream, &global, pass));
     FOREACH_STREAM(
         open_output_file(stream, &global, &input.pixel_aspect_ratio));
-    FOREACH_STREAM(initialize_encoder(stream, &global));
+    if (!use_chunks) {
+      FOREACH_STREAM(initialize_encoder(stream, &global));
+#if CONFIG_VP9_ENCODER
+      FOREACH_STREAM(open_stage_timing(stream, pass));
+#endif
+    }
 
 #if CONFIG_VP9_HIGHBITDEPTH
     if (strcmp(global.codec->name, "vp9") == 0) {
@@ -1875,16 +2859,56 @@ int main(int argc, const char **argv_) {
     }
 #endif
 
-    frame_avail = 1;
+#if CONFIG_MULTITHREAD
+    if (global.parallel_streams) {
+      start_stream_threads(&stream_threads, &global, streams, input.width,
+                           input.height);
+    }
+    /* The stream threads write their own output. */
+    if (global.threaded_io) {
+      start_io_threads(&io_threads, &input, global.limit,
+                       global.parallel_streams ? NULL : streams);
+    }
+#endif
+    frame_avail = !use_chunks;
     got_data = 0;
 
+#if CONFIG_VP9_ENCODER
+    if (use_chunks) {
+      chunk_ctx.stream = streams;
+      chunk_ctx.global = &global;
+      chunk_ctx.input = input;
+#if CONFIG_VP9_HIGHBITDEPTH
+      chunk_ctx.input_shift = input_shift;
+      chunk_ctx.use_16bit_internal = use_16bit_internal;
+#endif
+      encode_chunks(&chunk_ctx);
+      frames_in = global.skip_frames + chunk_ctx.frame_count;
+      seen_frames = chunk_ctx.frame_count;
+    }
+#endif
+
     while (frame_avail || got_data) {
       struct vpx_usec_timer timer;
 
       if (!global.limit || frames_in < global.limit) {
-        frame_avail = read_frame(&input, &raw);
+#if CONFIG_VP9_ENCODER
+        const FileOffset frame_pos =
+            global.chunks > 1 ? input_position(&input) : 0;
+#endif
+        if (!global.threaded_io) {
+          frame_avail = read_frame(&input, &raw);
+#if CONFIG_MULTITHREAD
+        } else {
+          frame_avail = read_queued_frame(&io_threads, &input_frame);
+#endif
+        }
 
         if (frame_avail) frames_in++;
+#if CONFIG_VP9_ENCODER
+        if (frame_avail && global.chunks > 1 && frames_in > global.skip_frames)
+          add_chunk_frame(&chunk_ctx, frame_pos);
+#endif
         seen_frames =
             frames_in > global.skip_frames ? frames_in - global.skip_frames : 0;
 
@@ -1916,46 +2940,48 @@ int main(int argc, const char **argv_) {
           // Input bit depth and stream bit depth do not match, so up
           // shift frame to stream bit depth
           if (!allocated_raw_shift) {
-            vpx_img_alloc(&raw_shift, raw.fmt | VPX_IMG_FMT_HIGHBITDEPTH,
+            vpx_img_alloc(&raw_shift,
+                          input_frame->fmt | VPX_IMG_FMT_HIGHBITDEPTH,
                           input.width, input.height, 32);
             allocated_raw_shift = 1;
           }
-          vpx_img_upshift(&raw_shift, &raw, input_shift);
+          vpx_img_upshift(&raw_shift, input_frame, input_shift);
           frame_to_encode = &raw_shift;
         } else {
-          frame_to_encode = &raw;
+          frame_to_encode = input_frame;
         }
-        vpx_usec_timer_start(&timer);
         if (use_16bit_internal) {
           assert(frame_to_encode->fmt & VPX_IMG_FMT_HIGHBITDEPTH);
-          FOREACH_STREAM({
-            if (stream->config.use_16bit_internal)
-              encode_frame(stream, &global,
-                           frame_avail ? frame_to_encode : NULL, frames_in);
-            else
-              assert(0);
-          });
+          FOREACH_STREAM(assert(stream->config.use_16bit_internal));
         } else {
           assert((frame_to_encode->fmt & VPX_IMG_FMT_HIGHBITDEPTH) == 0);
-          FOREACH_STREAM(encode_frame(stream, &global,
-                                      frame_avail ? frame_to_encode : NULL,
-                                      frames_in));
         }
 #else
+        vpx_image_t *frame_to_encode = input_frame;
+#endif
         vpx_usec_timer_start(&timer);
-        FOREACH_STREAM(encode_frame(stream, &global, frame_avail ? &raw : NULL,
-                                    frames_in));
+        if (!global.parallel_streams) {
+          FOREACH_STREAM(encode_frame(stream, &global,
+                                      frame_avail ? frame_to_encode : NULL,
+                                      frames_in));
+#if CONFIG_MULTITHREAD
+        } else {
+          queue_stream_frame(&stream_threads,
+                             frame_avail ? frame_to_encode : NULL, frames_in);
 #endif
+        }
         vpx_usec_timer_mark(&timer);
         cx_time += vpx_usec_timer_elapsed(&timer);
 
-        FOREACH_STREAM(update_quantizer_histogram(stream));
-
+        /* The stream threads write their own output. */
         got_data = 0;
-        FOREACH_STREAM(get_cx_data(stream, &global, &got_data));
+        if (!global.parallel_streams) {
+          FOREACH_STREAM(update_quantizer_histogram(stream));
+          FOREACH_STREAM(get_cx_data(stream, &global, &got_data));
+        }
 
-        if (!got_data && input.length && streams != NULL &&
-            !streams->frames_out) {
+        if (!global.parallel_streams && !got_data && input.length &&
+            streams != NULL && !streams->frames_out) {
           lagged_count = global.limit ? seen_frames : ftello(input.file);
         } else if (input.length) {
           int64_t remaining;
@@ -1988,6 +3014,11 @@ int main(int argc, const char **argv_) {
       if (!global.quiet) fprintf(stderr, "\033[K");
     }
 
+#if CONFIG_MULTITHREAD
+    if (global.parallel_streams)
+      stop_stream_threads(&stream_threads, frames_in);
+    if (global.threaded_io) stop_io_threads(&io_threads, streams);
+#endif
     if (stream_cnt > 1) fprintf(stderr, "\n");
 
     if (!global.quiet) {
@@ -2042,6 +3073,9 @@ int main(int argc, const char **argv_) {
     FOREACH_STREAM(show_rate_histogram(stream->rate_hist, &stream->config.cfg,
                                        global.show_rate_hist_buckets));
   FOREACH_STREAM(destroy_rate_histogram(stream->rate_hist));
+#if CONFIG_VP9_ENCODER
+  FOREACH_STREAM(close_stage_timing(stream));
+#endif
 
 #if CONFIG_INTERNAL_STATS
   /* TODO(jkoleszar): This doesn't belong in this executable. Do it for now,
@@ -2064,6 +3098,9 @@ int main(int argc, const char **argv_) {
   if (allocated_raw_shift) vpx_img_free(&raw_shift);
 #endif
   vpx_img_free(&raw);
+#if CONFIG_VP9_ENCODER
+  free(chunk_ctx.frame_offsets);
+#endif
   free(argv);
   free(streams);
   return res ? EXIT_FAILURE : EXIT_SUCCESS;
@@ -38,6 +38,9 @@ struct VpxEncoderConfig {
   const struct VpxInterface *codec;
   int passes;
   int pass;
+  int chunks;
+  int parallel_streams;
+  int threaded_io;
   int usage;
   int deadline;
   ColorInputType color_type;
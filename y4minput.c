@@ -442,44 +442,32 @@ static void y4m_convert_42xpaldv_42xjpeg(y4m_input *_y4m, unsigned char *_dst,
 }
 
 /*Perform vertical filtering to reduce a single plane from 4:2:2 to 4:2:0.
-  This is used as a helper by several converation routines.*/
+  This is used as a helper by several converation routines.
+  The plane is filtered a row at a time, with the rows beyond its edges
+   clamped to the first and last, so that the inner loop runs along contiguous
+   samples and can be vectorized.*/
 static void y4m_422jpeg_420jpeg_helper(unsigned char *_dst,
                                        const unsigned char *_src, int _c_w,
                                        int _c_h) {
   int y;
   int x;
   /*Filter: [3 -17 78 78 -17 3]/128, derived from a 6-tap Lanczos window.*/
-  for (x = 0; x < _c_w; x++) {
-    for (y = 0; y < OC_MINI(_c_h, 2); y += 2) {
-      _dst[(y >> 1) * _c_w] =
-          OC_CLAMPI(0,
-                    (64 * _src[0] + 78 * _src[OC_MINI(1, _c_h - 1) * _c_w] -
-                     17 * _src[OC_MINI(2, _c_h - 1) * _c_w] +
-                     3 * _src[OC_MINI(3, _c_h - 1) * _c_w] + 64) >>
-                        7,
-                    255);
-    }
-    for (; y < _c_h - 3; y += 2) {
-      _dst[(y >> 1) * _c_w] =
-          OC_CLAMPI(0,
-                    (3 * (_src[(y - 2) * _c_w] + _src[(y + 3) * _c_w]) -
-                     17 * (_src[(y - 1) * _c_w] + _src[(y + 2) * _c_w]) +
-                     78 * (_src[y * _c_w] + _src[(y + 1) * _c_w]) + 64) >>
-                        7,
-                    255);
-    }
-    for (; y < _c_h; y += 2) {
-      _dst[(y >> 1) * _c_w] = OC_CLAMPI(
+  for (y = 0; y < _c_h; y += 2) {
+    const unsigned char *const src_m2 = _src + OC_MAXI(y - 2, 0) * _c_w;
+    const unsigned char *const src_m1 = _src + OC_MAXI(y - 1, 0) * _c_w;
+    const unsigned char *const src_0 = _src + y * _c_w;
+    const unsigned char *const src_p1 = _src + OC_MINI(y + 1, _c_h - 1) * _c_w;
+    const unsigned char *const src_p2 = _src + OC_MINI(y + 2, _c_h - 1) * _c_w;
+    const unsigned char *const src_p3 = _src + OC_MINI(y + 3, _c_h - 1) * _c_w;
+    for (x = 0; x < _c_w; x++) {
+      _dst[x] = (unsigned char)OC_CLAMPI(
           0,
-          (3 * (_src[(y - 2) * _c_w] + _src[(_c_h - 1) * _c_w]) -
-           17 * (_src[(y - 1) * _c_w] + _src[OC_MINI(y + 2, _c_h - 1) * _c_w]) +
-           78 * (_src[y * _c_w] + _src[OC_MINI(y + 1, _c_h - 1) * _c_w]) +
-           64) >>
+          (3 * (src_m2[x] + src_p3[x]) - 17 * (src_m1[x] + src_p2[x]) +
+           78 * (src_0[x] + src_p1[x]) + 64) >>
               7,
           255);
     }
-    _src++;
-    _dst++;
+    _dst += _c_w;
   }
 }
 